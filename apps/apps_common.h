@@ -24,6 +24,7 @@ DEFINE_uint64(process_id, SIZE_MAX, "The global ID of this process");
 DEFINE_uint64(numa_node, 0, "NUMA node for this process");
 DEFINE_string(numa_0_ports, "", "Fabric ports on NUMA node 0, CSV, no spaces");
 DEFINE_string(numa_1_ports, "", "Fabric ports on NUMA node 1, CSV, no spaces");
+DEFINE_string(netem, "", "Network emulation spec, needs cmake -DNETEM=on");
 
 /// Return the fabric ports for a NUMA node. The user must specify numa_0_ports
 /// and numa_1_ports, but they may be empty.
@@ -43,6 +44,14 @@ std::vector<size_t> flags_get_numa_ports(size_t numa_node) {
   return ret;
 }
 
+/// Apply the netem flag to Rpcs created after this call. See
+/// erpc::parse_netem_spec() for the format.
+void flags_set_netem() {
+  if (FLAGS_netem.empty()) return;
+  erpc::rt_assert(erpc::kIsNetem, "netem flag needs cmake -DNETEM=on");
+  erpc::set_netem_config(erpc::parse_netem_spec(FLAGS_netem));
+}
+
 /// A basic mempool for preallocated objects of type T. eRPC has a faster,
 /// hugepage-backed one.
 template <class T>
@@ -14,6 +14,9 @@
  *
  * Process 0 runs incast_threads_zero threads. Other processes run
  * (incast_threads_other + regular_threads_other) threads.
+ *
+ * By default, senders use Timely. With grant_cc_unsched_pkts, all threads use
+ * receiver-driven grant CC instead, so process 0 schedules the incast.
  */
 
 #include "congestion.h"
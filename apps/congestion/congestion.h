@@ -32,11 +32,32 @@ DEFINE_uint64(regular_concurrency, 0, "Concurrent requests per regular thread");
 DEFINE_uint64(regular_req_size, 0, "Reqular request data size");
 DEFINE_uint64(regular_resp_size, 0, "Regular response data size");
 DEFINE_double(regular_latency_divisor, 1.0, "Latency precision factor");
+DEFINE_bool(prioritize_regular, false,
+            "Send regular traffic at high priority and incast at low priority");
+
+// Congestion control flags
+DEFINE_uint64(grant_cc_unsched_pkts, 0,
+              "If not 0, use receiver-driven grant CC with this many "
+              "unscheduled packets per request");
+DEFINE_uint64(grant_cc_max_granted_pkts, 32,
+              "Granted packets in flight per receiver, with grant CC");
+DEFINE_bool(ecn, false, "Also use ECN marks as a congestion signal");
 
 size_t tot_threads_other() {
   return FLAGS_incast_threads_other + FLAGS_regular_threads_other;
 }
 
+/// Use receiver-driven grant CC instead of Timely, and ECN, if requested
+void set_cc_mode(erpc::Rpc<erpc::CTransport> *rpc) {
+  if (FLAGS_ecn) {
+    erpc::rt_assert(rpc->enable_ecn() == 0, "ECN unsupported");
+  }
+
+  if (FLAGS_grant_cc_unsched_pkts == 0) return;
+  rpc->enable_grant_cc(FLAGS_grant_cc_unsched_pkts,
+                       FLAGS_grant_cc_max_granted_pkts);
+}
+
 struct app_stats_t {
   double incast_gbps;         // All incast threads
   double incast_gbps_stddev;  // Only thread 0
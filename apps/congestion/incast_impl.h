@@ -31,10 +31,11 @@ void connect_sessions_func_incast(AppContext *c) {
   }
 
   if (FLAGS_incast_throttle != 0.0) {
-    erpc::Timely *timely_0 = c->rpc->get_timely(c->session_num_vec[0]);
     double num_flows = (FLAGS_num_processes - 1) * FLAGS_incast_threads_other;
     double fair_share = c->rpc->get_bandwidth() / num_flows;
-    timely_0->rate = fair_share * FLAGS_incast_throttle;
+    int ret = c->rpc->set_session_rate_limit(
+        c->session_num_vec[0], fair_share * FLAGS_incast_throttle);
+    erpc::rt_assert(ret == 0, "set_session_rate_limit() failed");
   }
 }
 
@@ -102,6 +103,10 @@ void thread_func_incast_other(size_t thread_id, app_stats_t *app_stats,
                                   basic_sm_handler, phy_port);
   rpc.retry_connect_on_invalid_rpc_id = true;
   c.rpc = &rpc;
+  set_cc_mode(&rpc);
+  if (FLAGS_prioritize_regular) {
+    rpc.set_req_type_priority(kAppReqTypeIncast, erpc::kPriorityLow);
+  }
 
   connect_sessions_func_incast(&c);
   printf("congestion: Incast thread %zu: Sessions connected.\n", thread_id);
@@ -131,18 +136,18 @@ void thread_func_incast_other(size_t thread_id, app_stats_t *app_stats,
     c.incast_tx_bytes = 0;
     c.rpc->pkt_loss_stats.num_re_tx = 0;
 
-    erpc::Timely *timely_0 = c.rpc->get_timely(0);
+    erpc::CCongestionControl *cc_0 = c.rpc->get_cc(0);
 
     printf(
         "congestion: Incast thread %zu: Tput %.2f Gbps. "
         "Retransmissions %zu. "
-        "Session 0 Timely: {{%.1f, %.1f, %.1f} us, %.2f Gbps}. "
+        "Session 0 CC: {{%.1f, %.1f, %.1f} us, %.2f Gbps}. "
         "Credits %zu (best = 32).\n",
-        c.thread_id, stats.incast_gbps, stats.re_tx, timely_0->get_rtt_perc(.5),
-        timely_0->get_rtt_perc(.9), timely_0->get_rtt_perc(.99),
-        timely_0->get_rate_gbps(), erpc::kSessionCredits);
+        c.thread_id, stats.incast_gbps, stats.re_tx, cc_0->get_rtt_perc(.5),
+        cc_0->get_rtt_perc(.9), cc_0->get_rtt_perc(.99),
+        cc_0->get_rate_gbps(), erpc::kSessionCredits);
 
-    timely_0->reset_rtt_stats();
+    cc_0->reset_rtt_stats();
 
     if (c.thread_id == 0) {
       app_stats_t accum_stats;
@@ -192,6 +197,7 @@ void thread_func_incast_zero(size_t thread_id, erpc::Nexus *nexus) {
                                   basic_sm_handler, phy_port);
   rpc.retry_connect_on_invalid_rpc_id = true;
   c.rpc = &rpc;
+  set_cc_mode(&rpc);  // The incast receiver schedules grants
 
   for (size_t i = 0; i < FLAGS_test_ms; i += kAppEvLoopMs) {
     rpc.run_event_loop(kAppEvLoopMs);
@@ -112,6 +112,10 @@ void thread_func_regular(size_t thread_id, app_stats_t *app_stats,
                                   basic_sm_handler, phy_port);
   rpc.retry_connect_on_invalid_rpc_id = true;
   c.rpc = &rpc;
+  set_cc_mode(&rpc);
+  if (FLAGS_prioritize_regular) {
+    rpc.set_req_type_priority(kAppReqTypeRegular, erpc::kPriorityHigh);
+  }
 
   connect_sessions_func_regular(&c);
   printf("congestion: Regular thread %zu: Sessions connected.\n", thread_id);
@@ -11,6 +11,10 @@
  *     o Process 0 and process (N - 1) do not send requests
  *     o All threads on processes 1 through (N - 2) incast to process 0
  *     o Thread T - 1 on processes (N - 2) sends requests to process (N - 1)
+ *
+ * With small_req_size, a small_req_frac fraction of requests are small, which
+ * gives a bimodal size mix. srpt_aging_us enables SRPT scheduling to compare
+ * mean and tail RPC completion times with the default FIFO credit sharing.
  */
 
 #include "large_rpc_tput.h"
@@ -36,7 +40,11 @@ void app_cont_func(void *, void *);  // Forward declaration
 // Send a request using this MsgBuffer
 void send_req(AppContext *c, size_t msgbuf_idx) {
   erpc::MsgBuffer &req_msgbuf = c->req_msgbuf[msgbuf_idx];
-  assert(req_msgbuf.get_data_size() == FLAGS_req_size);
+  const bool is_small =
+      FLAGS_small_req_size > 0 &&
+      c->fastrand_.next_u32() % 1000 < FLAGS_small_req_frac * 1000;
+  const size_t req_size = is_small ? FLAGS_small_req_size : FLAGS_req_size;
+  c->rpc_->resize_msg_buffer(&req_msgbuf, req_size);
 
   if (kAppVerbose) {
     printf("large_rpc_tput: Thread %zu sending request using msgbuf_idx %zu.\n",
@@ -48,7 +56,7 @@ void send_req(AppContext *c, size_t msgbuf_idx) {
                            &c->resp_msgbuf[msgbuf_idx], app_cont_func,
                            reinterpret_cast<void *>(msgbuf_idx));
 
-  c->stat_tx_bytes_tot += FLAGS_req_size;
+  c->stat_tx_bytes_tot += req_size;
 }
 
 void req_handler(erpc::ReqHandle *req_handle, void *_context) {
@@ -67,7 +75,7 @@ void req_handler(erpc::ReqHandle *req_handle, void *_context) {
     resp_msgbuf.buf_[0] = resp_byte;
   }
 
-  c->stat_rx_bytes_tot += FLAGS_req_size;
+  c->stat_rx_bytes_tot += req_msgbuf->get_data_size();
   c->stat_tx_bytes_tot += FLAGS_resp_size;
 
   c->rpc_->enqueue_response(req_handle, &resp_msgbuf);
@@ -133,6 +141,7 @@ void thread_func(size_t thread_id, app_stats_t *app_stats, erpc::Nexus *nexus) {
   if (erpc::kTesting) rpc.fault_inject_set_pkt_drop_prob_st(FLAGS_drop_prob);
 
   c.rpc_ = &rpc;
+  if (FLAGS_srpt_aging_us > 0) rpc.enable_srpt_scheduling(FLAGS_srpt_aging_us);
 
   // Create the session. Some threads may not create any sessions, and therefore
   // not run the event loop required for other threads to connect them. This
@@ -164,17 +173,20 @@ void thread_func(size_t thread_id, app_stats_t *app_stats, erpc::Nexus *nexus) {
     if (c.session_num_vec_.size() == 0) continue;  // No stats to print
 
     const double ns = c.tput_t0.get_ns();
-    erpc::Timely *timely_0 = c.rpc_->get_timely(0);
+    erpc::CCongestionControl *cc_0 = c.rpc_->get_cc(0);
 
     // Publish stats
     auto &stats = c.app_stats[c.thread_id_];
     stats.rx_gbps = c.stat_rx_bytes_tot * 8 / ns;
     stats.tx_gbps = c.stat_tx_bytes_tot * 8 / ns;
     stats.re_tx = c.rpc_->get_num_re_tx(c.session_num_vec_[0]);
-    stats.rtt_50_us = timely_0->get_rtt_perc(0.50);
-    stats.rtt_99_us = timely_0->get_rtt_perc(0.99);
+    stats.rtt_50_us = cc_0->get_rtt_perc(0.50);
+    stats.rtt_99_us = cc_0->get_rtt_perc(0.99);
 
+    double rpc_mean_us = 0;
     if (c.lat_vec.size() > 0) {
+      for (double lat : c.lat_vec) rpc_mean_us += lat;
+      rpc_mean_us /= c.lat_vec.size();
       std::sort(c.lat_vec.begin(), c.lat_vec.end());
       stats.rpc_50_us = c.lat_vec[c.lat_vec.size() * 0.50];
       stats.rpc_99_us = c.lat_vec[c.lat_vec.size() * 0.99];
@@ -189,19 +201,20 @@ void thread_func(size_t thread_id, app_stats_t *app_stats, erpc::Nexus *nexus) {
     printf(
         "large_rpc_tput: Thread %zu: Tput {RX %.2f (%zu), TX %.2f (%zu)} "
         "Gbps (IOPS). Retransmissions %zu. Packet RTTs: {%.1f, %.1f} us. "
-        "RPC latency {%.1f 50th, %.1f 99th, %.1f 99.9th}. Timely rate %.1f "
-        "Gbps. Credits %zu (best = 32).\n",
+        "RPC latency {%.1f mean, %.1f 50th, %.1f 99th, %.1f 99.9th}. CC "
+        "rate %.1f Gbps. Credits %zu (best = 32).\n",
         c.thread_id_, stats.rx_gbps, c.stat_rx_bytes_tot / FLAGS_resp_size,
         stats.tx_gbps, c.stat_tx_bytes_tot / FLAGS_req_size, stats.re_tx,
-        stats.rtt_50_us, stats.rtt_99_us, stats.rpc_50_us, stats.rpc_99_us,
-        stats.rpc_999_us, timely_0->get_rate_gbps(), erpc::kSessionCredits);
+        stats.rtt_50_us, stats.rtt_99_us, rpc_mean_us, stats.rpc_50_us,
+        stats.rpc_99_us, stats.rpc_999_us, cc_0->get_rate_gbps(),
+        erpc::kSessionCredits);
 
     // Reset stats for next iteration
     c.stat_rx_bytes_tot = 0;
     c.stat_tx_bytes_tot = 0;
     c.rpc_->reset_num_re_tx(c.session_num_vec_[0]);
     c.lat_vec.clear();
-    timely_0->reset_rtt_stats();
+    cc_0->reset_rtt_stats();
 
     if (c.thread_id_ == 0) {
       app_stats_t accum_stats;
@@ -261,6 +274,7 @@ int main(int argc, char **argv) {
   signal(SIGINT, ctrl_c_handler);
   gflags::ParseCommandLineFlags(&argc, &argv, true);
   erpc::rt_assert(FLAGS_concurrency <= kAppMaxConcurrency, "Invalid conc");
+  erpc::rt_assert(FLAGS_small_req_size <= FLAGS_req_size, "Invalid size");
   erpc::rt_assert(FLAGS_profile == "incast" || FLAGS_profile == "victim",
                   "Invalid profile");
   erpc::rt_assert(FLAGS_process_id < FLAGS_num_processes, "Invalid process ID");
@@ -273,6 +287,7 @@ int main(int argc, char **argv) {
 
   setup_profile();
   erpc::rt_assert(connect_sessions_func != nullptr, "No connect_sessions_func");
+  flags_set_netem();
 
   erpc::Nexus nexus(erpc::get_uri_for_process(FLAGS_process_id),
                     FLAGS_numa_node, 0);
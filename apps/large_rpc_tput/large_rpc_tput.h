@@ -26,6 +26,9 @@ DEFINE_double(drop_prob, 0, "Packet drop probability");
 DEFINE_string(profile, "", "Experiment profile to use");
 DEFINE_double(throttle, 0, "Throttle flows to incast receiver?");
 DEFINE_double(throttle_fraction, 1, "Fraction of fair share to throttle to.");
+DEFINE_uint64(small_req_size, 0, "If non-zero, small request size (bimodal)");
+DEFINE_double(small_req_frac, 0, "Fraction of small requests (bimodal)");
+DEFINE_uint64(srpt_aging_us, 0, "If non-zero, use SRPT with this aging");
 
 struct app_stats_t {
   double rx_gbps;
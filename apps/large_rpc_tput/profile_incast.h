@@ -32,11 +32,12 @@ void connect_sessions_func_incast(AppContext *c) {
   }
 
   if (FLAGS_throttle == 1) {
-    erpc::Timely *timely_0 = c->rpc_->get_timely(c->session_num_vec_[0]);
     double num_flows = (FLAGS_num_processes - 1) * FLAGS_num_proc_other_threads;
     double fair_share = c->rpc_->get_bandwidth() / num_flows;
 
-    timely_0->rate_ = fair_share * FLAGS_throttle_fraction;
+    int ret = c->rpc_->set_session_rate_limit(
+        c->session_num_vec_[0], fair_share * FLAGS_throttle_fraction);
+    erpc::rt_assert(ret == 0, "set_session_rate_limit() failed");
   }
 }
 
@@ -41,11 +41,12 @@ void connect_sessions_func_victim(AppContext *c) {
 
   // If throttling is enabled, flows to the incast victim are throttled
   if (server_process_id == 0 && FLAGS_throttle == 1) {
-    erpc::Timely *timely_0 = c->rpc_->get_timely(c->session_num_vec_[0]);
     double num_incast_flows =
         ((FLAGS_num_processes - 2) * FLAGS_num_proc_other_threads) - 1;
     double fair_share = c->rpc_->get_bandwidth() / num_incast_flows;
-    timely_0->rate_ = fair_share * FLAGS_throttle_fraction;
+    int ret = c->rpc_->set_session_rate_limit(
+        c->session_num_vec_[0], fair_share * FLAGS_throttle_fraction);
+    erpc::rt_assert(ret == 0, "set_session_rate_limit() failed");
   }
 }
 
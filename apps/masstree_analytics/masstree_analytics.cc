@@ -171,7 +171,7 @@ void app_cont_func(void *_context, void *_msgbuf_idx) {
       }
     }
   } else {
-    c->client.range_latency.update(static_cast<size_t>(usec));
+    c->client.range_latency.update(static_cast<size_t>(usec * 10.0));
   }
 
   c->client.num_resps_tot++;
@@ -186,13 +186,16 @@ void client_print_stats(AppContext &c) {
   stats.lat_us_50 = c.client.point_latency.perc(0.50) / 10.0;
   stats.lat_us_90 = c.client.point_latency.perc(0.90) / 10.0;
   stats.lat_us_99 = c.client.point_latency.perc(0.99) / 10.0;
+  stats.lat_us_999 = c.client.point_latency.perc(0.999) / 10.0;
+  stats.range_lat_us_99 = c.client.range_latency.perc(0.99) / 10.0;
 
   printf(
       "Client %zu. Tput = %.3f Mrps. "
-      "Point-query latency (us) = {%.1f 50th, %.1f 90th, %.1f 99th}. "
-      "Range-query latency (us) = {%zu 99th}.\n",
+      "Point-query latency (us) = {%.1f 50th, %.1f 90th, %.1f 99th, "
+      "%.1f 99.9th}. Range-query latency (us) = {%.1f 50th, %.1f 99th}.\n",
       c.thread_id_, tput_mrps, stats.lat_us_50, stats.lat_us_90,
-      stats.lat_us_99, c.client.range_latency.perc(.99));
+      stats.lat_us_99, stats.lat_us_999,
+      c.client.range_latency.perc(.50) / 10.0, stats.range_lat_us_99);
 
   if (c.thread_id_ == 0) {
     app_stats_t accum;
@@ -201,6 +204,8 @@ void client_print_stats(AppContext &c) {
     }
     accum.lat_us_50 /= FLAGS_num_client_threads;
     accum.lat_us_99 /= FLAGS_num_client_threads;
+    accum.lat_us_999 /= FLAGS_num_client_threads;
+    accum.range_lat_us_99 /= FLAGS_num_client_threads;
     c.tmp_stat_->write(accum.to_string());
   }
 
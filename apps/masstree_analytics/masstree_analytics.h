@@ -91,21 +91,24 @@ struct wire_resp_t {
 };
 
 struct app_stats_t {
-  double mrps;       // Point request rate
-  double lat_us_50;  // Point request median latency
-  double lat_us_90;  // Point request 90th percentile latency
-  double lat_us_99;  // Point request 99th percentile latency
-  size_t pad[4];
+  double mrps;             // Point request rate
+  double lat_us_50;        // Point request median latency
+  double lat_us_90;        // Point request 90th percentile latency
+  double lat_us_99;        // Point request 99th percentile latency
+  double lat_us_999;       // Point request 99.9th percentile latency
+  double range_lat_us_99;  // Range request 99th percentile latency
+  size_t pad[2];
 
   app_stats_t() { memset(this, 0, sizeof(app_stats_t)); }
 
   static std::string get_template_str() {
-    return "mrps lat_us_50 lat_us_90 lat_us_99";
+    return "mrps lat_us_50 lat_us_90 lat_us_99 lat_us_999 range_lat_us_99";
   }
 
   std::string to_string() {
     return std::to_string(mrps) + " " + std::to_string(lat_us_50) + " " +
-           std::to_string(lat_us_90) + " " + std::to_string(lat_us_99);
+           std::to_string(lat_us_90) + " " + std::to_string(lat_us_99) + " " +
+           std::to_string(lat_us_999) + " " + std::to_string(range_lat_us_99);
   }
 
   /// Accumulate stats
@@ -114,6 +117,8 @@ struct app_stats_t {
     this->lat_us_50 += rhs.lat_us_50;
     this->lat_us_90 += rhs.lat_us_90;
     this->lat_us_99 += rhs.lat_us_99;
+    this->lat_us_999 += rhs.lat_us_999;
+    this->range_lat_us_99 += rhs.range_lat_us_99;
     return *this;
   }
 };
@@ -132,7 +137,7 @@ class AppContext : public BasicAppContext {
     app_stats_t *app_stats;        // Common stats array for all threads
 
     erpc::Latency point_latency;  // Latency of point requests (factor = 10)
-    erpc::Latency range_latency;  // Latency of point requests (factor = 1)
+    erpc::Latency range_latency;  // Latency of range requests (factor = 10)
 
     struct {
       uint32_t req_seed_;
@@ -0,0 +1,285 @@
+/**
+ * @file sim_congestion.cc
+ *
+ * @brief The congestion app's scenario in one process and in virtual time.
+ * This requires the sim transport (cmake -DTRANSPORT=sim).
+ *
+ * Each thread of each congestion app process becomes an Rpc on this process's
+ * only thread, and the Rpcs exchange packets through a SimFabric. Each Rpc is
+ * a host with its own link to the switch. With N processes:
+ *  o Process 0's incast_threads_zero Rpcs receive incast traffic
+ *  o incast_threads_other Rpcs at each of processes {1, ..., N - 1} send
+ *    incast traffic, with one session to an Rpc of process 0
+ *  o regular_threads_other Rpcs at each of processes {1, ..., N - 1} send
+ *    regular traffic to the same thread index at every other such process
+ *
+ * test_ms is in virtual time. A run's output depends only on the flags.
+ */
+
+#include <gflags/gflags.h>
+#include <signal.h>
+#include <cstring>
+#include <random>
+#include "../apps_common.h"
+#include "rpc.h"
+
+static constexpr uint8_t kAppReqTypeIncast = 1;
+static constexpr uint8_t kAppReqTypeRegular = 2;
+static constexpr uint8_t kAppDataByte = 3;  // Data transferred in req & resp
+static constexpr size_t kAppMaxConcurrency = 32;  // Max outstanding reqs/Rpc
+static constexpr size_t kAppStatUs = 1000;  // Virtual time between stats
+
+volatile sig_atomic_t ctrl_c_pressed = 0;
+void ctrl_c_handler(int) { ctrl_c_pressed = 1; }
+
+// Traffic flags, as in the congestion app
+DEFINE_uint64(incast_threads_zero, 0, "Threads receiving incast at process 0");
+DEFINE_uint64(incast_threads_other, 0, "Threads sending incast traffic");
+DEFINE_uint64(incast_req_size, 0, "Incast request data size");
+DEFINE_uint64(incast_resp_size, 0, "Incast response data size");
+DEFINE_uint64(regular_threads_other, 0, "Threads sending regular traffic");
+DEFINE_uint64(regular_concurrency, 0, "Concurrent requests per regular thread");
+DEFINE_uint64(regular_req_size, 0, "Reqular request data size");
+DEFINE_uint64(regular_resp_size, 0, "Regular response data size");
+DEFINE_bool(ecn, false, "Also use ECN marks as a congestion signal");
+
+// Fabric flags
+DEFINE_double(link_gbps, 25.0, "Rate of each host's link");
+DEFINE_double(link_delay_us, 1.0, "One-way propagation delay of a link");
+DEFINE_uint64(port_buffer_kb, 1024, "Buffer of each switch output port");
+DEFINE_uint64(ecn_threshold_kb, 100, "Queue length for ECN marks");
+DEFINE_double(loss_rate, 0.0, "Probability of dropping a packet at random");
+DEFINE_uint64(seed, 1, "Seed for random drops and session choices");
+DEFINE_uint64(tick_ns, 100, "Max virtual time between event loop runs");
+
+class AppContext : public BasicAppContext {
+ public:
+  bool is_regular_ = false;
+  size_t incast_bytes_ = 0;  // Incast request bytes completed
+
+  size_t req_tsc_[kAppMaxConcurrency];  // Per-request timestamps
+  erpc::MsgBuffer req_msgbuf_[kAppMaxConcurrency];
+  erpc::MsgBuffer resp_msgbuf_[kAppMaxConcurrency];
+  erpc::Latency regular_latency_;
+};
+
+/// Respond to a request with \p resp_size bytes
+void respond(erpc::ReqHandle *req_handle, void *_context, size_t resp_size) {
+  auto *c = static_cast<AppContext *>(_context);
+  const erpc::MsgBuffer *req_msgbuf = req_handle->get_req_msgbuf();
+
+  erpc::MsgBuffer *resp_msgbuf = &req_handle->pre_resp_msgbuf_;
+  if (resp_size <= erpc::CTransport::kMaxDataPerPkt) {
+    c->rpc_->resize_msg_buffer(resp_msgbuf, resp_size);
+  } else {
+    resp_msgbuf = &req_handle->dyn_resp_msgbuf_;
+    *resp_msgbuf = c->rpc_->alloc_msg_buffer_or_die(resp_size);
+  }
+
+  resp_msgbuf->buf_[0] = req_msgbuf->buf_[0];  // Touch the response
+  c->rpc_->enqueue_response(req_handle, resp_msgbuf);
+}
+
+void req_handler_incast(erpc::ReqHandle *req_handle, void *_context) {
+  respond(req_handle, _context, FLAGS_incast_resp_size);
+}
+
+void req_handler_regular(erpc::ReqHandle *req_handle, void *_context) {
+  respond(req_handle, _context, FLAGS_regular_resp_size);
+}
+
+void cont_incast(void *, void *);  // Forward declaration
+void cont_regular(void *, void *);  // Forward declaration
+
+void send_req_incast(AppContext *c) {
+  c->rpc_->enqueue_request(c->session_num_vec_[0], kAppReqTypeIncast,
+                           &c->req_msgbuf_[0], &c->resp_msgbuf_[0],
+                           cont_incast, nullptr);
+}
+
+void send_req_regular(AppContext *c, size_t msgbuf_idx) {
+  c->req_tsc_[msgbuf_idx] = erpc::rdtsc();
+  c->rpc_->enqueue_request(c->fast_get_rand_session_num(), kAppReqTypeRegular,
+                           &c->req_msgbuf_[msgbuf_idx],
+                           &c->resp_msgbuf_[msgbuf_idx], cont_regular,
+                           reinterpret_cast<void *>(msgbuf_idx));
+}
+
+void cont_incast(void *_context, void *) {
+  auto *c = static_cast<AppContext *>(_context);
+  erpc::rt_assert(c->resp_msgbuf_[0].buf_[0] == kAppDataByte);  // Touch
+  c->incast_bytes_ += FLAGS_incast_req_size;
+  send_req_incast(c);
+}
+
+void cont_regular(void *_context, void *_msgbuf_idx) {
+  auto *c = static_cast<AppContext *>(_context);
+  auto msgbuf_idx = reinterpret_cast<size_t>(_msgbuf_idx);
+  erpc::rt_assert(c->resp_msgbuf_[msgbuf_idx].buf_[0] == kAppDataByte);
+
+  const double usec = erpc::to_usec(erpc::rdtsc() - c->req_tsc_[msgbuf_idx],
+                                    c->rpc_->get_freq_ghz());
+  c->regular_latency_.update(static_cast<size_t>(usec));
+  send_req_regular(c, msgbuf_idx);
+}
+
+/// Allocate request and response MsgBuffers, and send the first requests
+void start_traffic(AppContext *c) {
+  if (c->session_num_vec_.empty()) return;  // Incast receiver
+
+  const size_t concurrency = c->is_regular_ ? FLAGS_regular_concurrency : 1;
+  const size_t req_size =
+      c->is_regular_ ? FLAGS_regular_req_size : FLAGS_incast_req_size;
+  const size_t resp_size =
+      c->is_regular_ ? FLAGS_regular_resp_size : FLAGS_incast_resp_size;
+
+  for (size_t i = 0; i < concurrency; i++) {
+    c->req_msgbuf_[i] = c->rpc_->alloc_msg_buffer_or_die(req_size);
+    c->resp_msgbuf_[i] = c->rpc_->alloc_msg_buffer_or_die(resp_size);
+    memset(c->req_msgbuf_[i].buf_, kAppDataByte, req_size);
+  }
+
+  if (!c->is_regular_) {
+    send_req_incast(c);
+    return;
+  }
+  for (size_t i = 0; i < concurrency; i++) send_req_regular(c, i);
+}
+
+/// Print stats for the last kAppStatUs, and reset them
+void print_stats(std::vector<AppContext> &ctx_vec,
+                 const erpc::SimFabric &fabric, size_t start_tsc) {
+  size_t incast_bytes = 0, num_re_tx = 0;
+  erpc::Latency regular_latency;
+  for (AppContext &c : ctx_vec) {
+    incast_bytes += c.incast_bytes_;
+    c.incast_bytes_ = 0;
+
+    regular_latency += c.regular_latency_;
+    c.regular_latency_.reset();
+
+    for (int session_num : c.session_num_vec_) {
+      num_re_tx += c.rpc_->get_num_re_tx(session_num);
+      c.rpc_->reset_num_re_tx(session_num);
+    }
+  }
+
+  const erpc::SimFabric::stats_t &stats = fabric.get_stats();
+  printf(
+      "sim_congestion: %.1f ms: Incast %.2f Gbps. "
+      "Regular %zu reqs, latency {%zu, %zu, %zu} us. Retransmissions %zu. "
+      "Fabric drops %zu, ECN marks %zu, max queue %zu KB.\n",
+      erpc::to_msec(erpc::rdtsc() - start_tsc, erpc::kSimFreqGhz),
+      incast_bytes * 8 / (kAppStatUs * 1000.0),
+      regular_latency.count(), regular_latency.perc(.50),
+      regular_latency.perc(.99),
+      regular_latency.perc(.999), num_re_tx,
+      stats.num_drops_ + stats.num_random_drops_, stats.num_ecn_marks_,
+      stats.max_queue_bytes_ / 1024);
+}
+
+int main(int argc, char **argv) {
+  signal(SIGINT, ctrl_c_handler);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  erpc::rt_assert(FLAGS_num_processes >= 3, "Too few processes");
+  erpc::rt_assert(FLAGS_regular_concurrency <= kAppMaxConcurrency,
+                  "Invalid concurrency");
+  erpc::rt_assert(FLAGS_incast_threads_zero >= 1, "Need > 0 incast threads");
+
+  // The Rpc ID of thread t at process p
+  const size_t threads_other =
+      FLAGS_incast_threads_other + FLAGS_regular_threads_other;
+  auto get_rpc_id = [&](size_t p, size_t t) {
+    return p == 0 ? t : FLAGS_incast_threads_zero + (p - 1) * threads_other + t;
+  };
+  const size_t num_rpcs = get_rpc_id(FLAGS_num_processes, 0);
+  erpc::rt_assert(num_rpcs <= erpc::kMaxRpcId + 1, "Too many threads");
+
+  const std::string uri = "127.0.0.1:" + std::to_string(erpc::kBaseSmUdpPort);
+  erpc::Nexus nexus(uri, FLAGS_numa_node, 0);
+  nexus.register_req_func(kAppReqTypeIncast, req_handler_incast);
+  nexus.register_req_func(kAppReqTypeRegular, req_handler_regular);
+
+  erpc::sim_fabric_config_t config;
+  config.link_gbps_ = FLAGS_link_gbps;
+  config.link_delay_us_ = FLAGS_link_delay_us;
+  config.port_buffer_bytes_ = KB(FLAGS_port_buffer_kb);
+  config.ecn_threshold_bytes_ = KB(FLAGS_ecn_threshold_kb);
+  config.loss_rate_ = FLAGS_loss_rate;
+  config.seed_ = FLAGS_seed;
+  erpc::SimFabric fabric(config);
+
+  std::mt19937_64 seed_gen(FLAGS_seed);  // Seeds for the Rpcs' FastRands
+  std::vector<AppContext> ctx_vec(num_rpcs);
+  for (size_t i = 0; i < num_rpcs; i++) {
+    AppContext &c = ctx_vec[i];
+    c.thread_id_ = i;
+    c.fastrand_.seed_ = seed_gen();
+    c.rpc_ = new erpc::Rpc<erpc::CTransport>(
+        &nexus, &c, static_cast<uint8_t>(i), basic_sm_handler);
+    if (FLAGS_ecn) {
+      erpc::rt_assert(c.rpc_->enable_ecn() == 0, "ECN unsupported");
+    }
+  }
+
+  // Create sessions like the congestion app
+  for (size_t p = 1; p < FLAGS_num_processes; p++) {
+    for (size_t t = 0; t < threads_other; t++) {
+      AppContext &c = ctx_vec[get_rpc_id(p, t)];
+      if (t < FLAGS_incast_threads_other) {
+        const size_t rem_t =
+            (p * FLAGS_incast_threads_other + t) % FLAGS_incast_threads_zero;
+        c.session_num_vec_.push_back(c.rpc_->create_session(
+            uri, static_cast<uint8_t>(get_rpc_id(0, rem_t))));
+      } else {
+        c.is_regular_ = true;
+        for (size_t rem_p = 1; rem_p < FLAGS_num_processes; rem_p++) {
+          if (rem_p == p) continue;
+          c.session_num_vec_.push_back(c.rpc_->create_session(
+              uri, static_cast<uint8_t>(get_rpc_id(rem_p, t))));
+        }
+      }
+
+      for (int session_num : c.session_num_vec_) {
+        erpc::rt_assert(session_num >= 0, "create_session() failed");
+      }
+
+      // Sessions connect in real time while the virtual clock stays still, so
+      // lost SM packets are never retransmitted. Connecting one Rpc at a time
+      // keeps the SM socket from overflowing.
+      while (c.num_sm_resps_ != c.session_num_vec_.size() &&
+             ctrl_c_pressed == 0) {
+        for (AppContext &c_i : ctx_vec) c_i.rpc_->run_event_loop_once();
+      }
+    }
+  }
+  printf("sim_congestion: %zu Rpcs connected.\n", num_rpcs);
+
+  for (AppContext &c : ctx_vec) start_traffic(&c);
+
+  const size_t tick_tsc = erpc::ns_to_cycles(FLAGS_tick_ns, erpc::kSimFreqGhz);
+  const size_t stat_tsc = erpc::us_to_cycles(kAppStatUs, erpc::kSimFreqGhz);
+  const size_t start_tsc = erpc::rdtsc();
+  const size_t end_tsc =
+      start_tsc + erpc::ms_to_cycles(FLAGS_test_ms, erpc::kSimFreqGhz);
+  size_t next_stat_tsc = start_tsc + stat_tsc;
+  erpc::ChronoTimer real_timer;
+
+  while (erpc::rdtsc() < end_tsc && ctrl_c_pressed == 0) {
+    for (AppContext &c : ctx_vec) c.rpc_->run_event_loop_once();
+    fabric.advance(tick_tsc);
+
+    if (erpc::rdtsc() >= next_stat_tsc) {
+      print_stats(ctx_vec, fabric, start_tsc);
+      next_stat_tsc += stat_tsc;
+    }
+  }
+
+  printf("sim_congestion: Simulated %.1f ms in %.1f s.\n",
+         erpc::to_msec(erpc::rdtsc() - start_tsc, erpc::kSimFreqGhz),
+         real_timer.get_sec());
+
+  // Rpcs must be destroyed before the fabric. We don't disconnect sessions.
+  for (AppContext &c : ctx_vec) delete c.rpc_;
+}
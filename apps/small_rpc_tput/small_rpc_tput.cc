@@ -26,6 +26,8 @@ DEFINE_uint64(batch_size, 0, "Request batch size");
 DEFINE_uint64(msg_size, 0, "Request and response size");
 DEFINE_uint64(num_threads, 0, "Number of foreground threads per machine");
 DEFINE_uint64(concurrency, 0, "Concurrent batches per thread");
+DEFINE_uint64(session_group, 0, "Pick sessions by load (1) or randomly (0)");
+DEFINE_uint64(slow_server_us, 0, "Extra request handler time at process 0");
 
 volatile sig_atomic_t ctrl_c_pressed = 0;
 void ctrl_c_handler(int) { ctrl_c_pressed = 1; }
@@ -115,6 +117,7 @@ class AppContext : public BasicAppContext {
 
   std::array<BatchContext, kAppMaxConcurrency> batch_arr;  // Per-batch context
   erpc::Latency latency;  // Cold if latency measurement disabled
+  int session_group_;     // Session group of session_num_vec_, if enabled
 
   ~AppContext() {}
 };
@@ -125,6 +128,7 @@ void app_cont_func(void *, void *);  // Forward declaration
 void send_reqs(AppContext *c, size_t batch_i) {
   assert(batch_i < FLAGS_concurrency);
   BatchContext &bc = c->batch_arr[batch_i];
+  erpc::enq_req_args_t req_args[kAppMaxBatchSize];
 
   for (size_t i = 0; i < FLAGS_batch_size; i++) {
     if (kAppVerbose) {
@@ -143,17 +147,30 @@ void send_reqs(AppContext *c, size_t batch_i) {
 
     if (kAppMeasureLatency) bc.req_tsc[i] = erpc::rdtsc();
 
+    int session_num = FLAGS_session_group == 1
+                          ? c->rpc_->get_group_session_num(c->session_group_)
+                          : c->fast_get_rand_session_num();
+    // No group member is connected, so fall back to random selection
+    if (unlikely(session_num < 0)) session_num = c->fast_get_rand_session_num();
+
     tag_t tag(batch_i, i);
-    c->rpc_->enqueue_request(c->fast_get_rand_session_num(), kAppReqType,
-                             &bc.req_msgbuf[i], &bc.resp_msgbuf[i],
-                             app_cont_func, reinterpret_cast<void *>(tag._tag));
+    req_args[i] = erpc::enq_req_args_t(
+        session_num, kAppReqType, &bc.req_msgbuf[i], &bc.resp_msgbuf[i],
+        app_cont_func, reinterpret_cast<void *>(tag._tag));
   }
+
+  c->rpc_->enqueue_request_batch(req_args, FLAGS_batch_size);
 }
 
 void req_handler(erpc::ReqHandle *req_handle, void *_context) {
   auto *c = static_cast<AppContext *>(_context);
   c->stat_req_rx_tot++;
 
+  // Emulate a slow server to compare session selection policies
+  if (FLAGS_slow_server_us > 0 && FLAGS_process_id == 0) {
+    erpc::nano_sleep(FLAGS_slow_server_us * 1000, c->rpc_->get_freq_ghz());
+  }
+
   const erpc::MsgBuffer *req_msgbuf = req_handle->get_req_msgbuf();
   assert(req_msgbuf->get_data_size() == FLAGS_msg_size);
 
@@ -287,8 +304,8 @@ void print_stats(AppContext &c) {
   std::vector<double> session_tput;
   if (erpc::kCcRateComp) {
     for (int session_num : c.session_num_vec) {
-      erpc::Timely *timely = c.rpc->get_timely(session_num);
-      session_tput.push_back(timely->get_rate_gbps());
+      erpc::CCongestionControl *cc = c.rpc->get_cc(session_num);
+      session_tput.push_back(cc->get_rate_gbps());
     }
     std::sort(session_tput.begin(), session_tput.end());
   }
@@ -375,6 +392,10 @@ void thread_func(size_t thread_id, app_stats_t *app_stats, erpc::Nexus *nexus) {
   }
 
   connect_sessions(c);
+  if (FLAGS_session_group == 1) {
+    c.session_group_ = rpc.create_session_group(c.session_num_vec_);
+    erpc::rt_assert(c.session_group_ >= 0, "Failed to create session group");
+  }
 
   printf("Process %zu, thread %zu: All sessions connected. Starting work.\n",
          FLAGS_process_id, thread_id);
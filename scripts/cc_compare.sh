@@ -0,0 +1,32 @@
+#!/usr/bin/env bash
+# Compare the congestion control policies on the congestion app. This must be
+# run from eRPC homedir, with the congestion app's config file and an autorun
+# process file set up. Extra arguments are passed to cmake, e.g., the
+# transport.
+source $(dirname $0)/utils.sh
+
+function echo_and_log() {
+  echo $1
+  echo $1 >> cc_compare_out
+}
+
+rm -f cc_compare_out
+echo "congestion" > scripts/autorun_app_file
+
+for cc in timely swift; do
+  echo_and_log "Building for CC = $cc"
+  cmake . -DCC=$cc "$@" 1>/dev/null
+  make -j congestion 1>/dev/null 2>/dev/null
+
+  echo_and_log "Running"
+  ./scripts/run-all.sh 1>/dev/null 2>/dev/null
+
+  # Columns: incast_gbps incast_gbps_stddev re_tx regular_50/99/999_us
+  echo_and_log "Fetching output"
+  ./scripts/proc-out.sh | grep "Final column" | tee -a cc_compare_out
+
+  echo_and_log "Cleaning up"
+  ./scripts/kill-all.sh 1>/dev/null 2>/dev/null
+
+  echo_and_log ""
+done
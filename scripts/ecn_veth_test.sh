@@ -0,0 +1,58 @@
+#!/usr/bin/env bash
+# Test ECN with the socket transport on one machine. This runs a server command
+# ($1) and a client command ($2) in two network namespaces connected by a veth
+# pair. The client-to-server link is rate-limited, and marks packets with CE
+# when its queue delay exceeds a threshold. Both commands must enable ECN, e.g.,
+# the congestion app with --ecn 1. Requires root.
+source $(dirname $0)/utils.sh
+
+if [ "$#" -ne 2 ]; then
+  blue "Usage: ecn_veth_test.sh <server command> <client command>"
+  exit
+fi
+
+rate="1gbit"            # Bottleneck rate of the client-to-server link
+ce_threshold="100us"    # Queue delay above which packets are CE-marked
+
+function cleanup() {
+  ip netns del erpc_ecn_srv 2>/dev/null
+  ip netns del erpc_ecn_clt 2>/dev/null
+}
+
+cleanup
+trap cleanup EXIT
+
+blue "Creating namespaces and veth pair"
+ip netns add erpc_ecn_srv
+ip netns add erpc_ecn_clt
+ip link add veth_ecn_clt netns erpc_ecn_clt type veth \
+  peer name veth_ecn_srv netns erpc_ecn_srv
+
+# The socket transport picks its local address from the default route
+ip -n erpc_ecn_srv addr add 10.77.0.1/24 dev veth_ecn_srv
+ip -n erpc_ecn_clt addr add 10.77.0.2/24 dev veth_ecn_clt
+for ns in erpc_ecn_srv erpc_ecn_clt; do
+  ip -n $ns link set lo up
+done
+ip -n erpc_ecn_srv link set veth_ecn_srv up
+ip -n erpc_ecn_clt link set veth_ecn_clt up
+ip -n erpc_ecn_srv route add default dev veth_ecn_srv
+ip -n erpc_ecn_clt route add default dev veth_ecn_clt
+
+blue "Adding a $rate CE-marking bottleneck at the client"
+ip netns exec erpc_ecn_clt tc qdisc add dev veth_ecn_clt root handle 1: \
+  tbf rate $rate burst 32kb latency 100ms
+ip netns exec erpc_ecn_clt tc qdisc add dev veth_ecn_clt parent 1:1 \
+  handle 10: fq_codel ecn ce_threshold $ce_threshold
+
+blue "Running server and client"
+ip netns exec erpc_ecn_srv $1 &
+server_pid=$!
+sleep 1
+ip netns exec erpc_ecn_clt $2
+kill $server_pid 2>/dev/null
+wait $server_pid 2>/dev/null
+
+# Expect a non-zero ce_mark count if the client saturated the bottleneck
+blue "Bottleneck qdisc stats"
+ip netns exec erpc_ecn_clt tc -s qdisc show dev veth_ecn_clt
@@ -0,0 +1,73 @@
+/**
+ * @file cc_policy.h
+ * @brief The congestion control policy interface
+ *
+ * Each client session owns one instance of the congestion control policy
+ * CCongestionControl, which is picked at compile time with CMake's CC option,
+ * like the transport. Calls to the policy are therefore not virtual, and are
+ * inlined into the datapath. A policy class provides:
+ *
+ *  o Policy(freq_ghz, link_bandwidth, mtu): Start at the link bandwidth
+ *  o on_ack(rdtsc, sample_rtt_tsc): Handle an RTT sample from a credit return
+ *    or response packet
+ *  o on_loss(rdtsc): Handle a retransmission timeout
+ *  o on_ecn(rdtsc, ce): Handle the ECN mark of an acknowledged packet, after
+ *    on_ack(). Called only if Rpc::enable_ecn() succeeded.
+ *  o get_rate(): The pacing rate in bytes/sec. A session is paced by the
+ *    timing wheel unless is_uncongested().
+ *  o get_cwnd(): The congestion window in packets, for stats. Session credits
+ *    cap the packets in flight, so a policy enforces smaller windows through
+ *    its pacing rate.
+ *  o get_srtt_tsc(): The smoothed RTT, for load balancing
+ *  o rate_: The public rate member. Apps should cap rates with
+ *    Rpc::set_session_rate_limit() instead of overwriting it.
+ *  o kMinRate: The minimum pacing rate
+ *  o get_rate_gbps(), get_rtt_perc(), reset_rtt_stats(): Stats for apps
+ */
+
+#pragma once
+
+#include <type_traits>
+#include "cc/swift.h"
+#include "cc/timely.h"
+#include "sm_types.h"
+
+namespace erpc {
+
+/// Compile-time check that a class implements the congestion control policy
+/// interface
+template <class TCc>
+class CcPolicyCheck {
+  static_assert(std::is_same<decltype(std::declval<TCc &>().on_ack(
+                                 size_t(0), size_t(0))),
+                             void>::value,
+                "on_ack()");
+  static_assert(std::is_same<decltype(std::declval<TCc &>().on_loss(size_t(0))),
+                             void>::value,
+                "on_loss()");
+  static_assert(
+      std::is_same<decltype(std::declval<TCc &>().on_ecn(size_t(0), false)),
+                   void>::value,
+      "on_ecn()");
+  static_assert(
+      std::is_same<decltype(std::declval<const TCc &>().get_rate()),
+                   double>::value,
+      "get_rate()");
+  static_assert(
+      std::is_same<decltype(std::declval<const TCc &>().get_cwnd()),
+                   double>::value,
+      "get_cwnd()");
+  static_assert(
+      std::is_same<decltype(std::declval<const TCc &>().is_uncongested()),
+                   bool>::value,
+      "is_uncongested()");
+  static_assert(std::is_constructible<TCc, double, double, size_t>::value,
+                "Policy(freq_ghz, link_bandwidth, mtu)");
+};
+
+template class CcPolicyCheck<Timely>;
+template class CcPolicyCheck<Swift>;
+
+static_assert(Swift::kMaxCwnd == kSessionCredits, "");
+
+}  // namespace erpc
@@ -0,0 +1,54 @@
+/**
+ * @file ecn.h
+ * @brief DCTCP-style estimation of the fraction of ECN-marked packets
+ * [SIGCOMM 10]
+ */
+
+#pragma once
+
+#include "common.h"
+
+namespace erpc {
+
+/**
+ * @brief Tracks the fraction of acknowledged packets that carried a CE mark.
+ * Once per smoothed RTT, the fraction of marked acks in the last window is
+ * folded into an EWMA alpha. If any packet in the window was marked, the
+ * congestion control policy scales its rate or window by (1 - alpha / 2).
+ */
+class EcnAlpha {
+ public:
+  static constexpr double kG = 1.0 / 16;  ///< EWMA weight for alpha
+
+  double alpha_ = 1.0;  ///< Start conservatively, like DCTCP
+  size_t num_acks_ = 0;    ///< Acks in the current window
+  size_t num_marked_ = 0;  ///< CE-marked acks in the current window
+  size_t window_start_tsc_ = 0;
+
+  /**
+   * @brief Record one acknowledgment
+   *
+   * @param _rdtsc A recently sampled RDTSC
+   * @param ce True iff the acknowledged packet was CE-marked
+   * @param srtt_tsc The policy's smoothed RTT in RDTSC cycles
+   *
+   * @return The factor to scale the rate or window by, which is 1.0 except
+   * at the end of a window with marks
+   */
+  double on_ack(size_t _rdtsc, bool ce, double srtt_tsc) {
+    num_acks_++;
+    if (ce) num_marked_++;
+    if (_rdtsc - window_start_tsc_ < srtt_tsc) return 1.0;
+
+    const double frac = num_marked_ / static_cast<double>(num_acks_);
+    alpha_ = (1 - kG) * alpha_ + kG * frac;
+    const bool any_marked = num_marked_ > 0;
+
+    num_acks_ = 0;
+    num_marked_ = 0;
+    window_start_tsc_ = _rdtsc;
+    return any_marked ? 1.0 - alpha_ / 2 : 1.0;
+  }
+};
+
+}  // namespace erpc
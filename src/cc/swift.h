@@ -0,0 +1,150 @@
+/**
+ * @file swift.h
+ * @brief Swift-style delay-target congestion control [SIGCOMM 20]
+ * Units: Microseconds or TSC for time, bytes/sec for throughput, packets for
+ * the congestion window
+ */
+
+#pragma once
+
+#include "cc/ecn.h"
+#include "common.h"
+#include "util/latency.h"
+#include "util/timer.h"
+
+namespace erpc {
+
+/**
+ * @brief A Swift-like congestion control policy. The congestion window grows
+ * additively while the RTT is below a target delay, and shrinks in proportion
+ * to the excess delay otherwise, at most once per RTT.
+ *
+ * eRPC's session credits already cap the packets in flight, so the window is
+ * enforced by pacing at (cwnd * MTU / smoothed RTT). A window below one packet
+ * therefore paces at less than one packet per RTT, like Swift.
+ */
+class Swift {
+ public:
+  // Debugging
+  static constexpr bool kLatencyStats = false;  ///< Track per-packet RTT stats
+
+  // Config
+  static constexpr double kMinRate = 15.0 * 1000 * 1000;
+  static constexpr double kTargetDelay = 50;  ///< Target delay in microseconds
+  static constexpr double kAddIncrease = 1.0;  ///< Window increase per RTT
+  static constexpr double kBeta = 0.8;     ///< Multiplicative decrease scaling
+  static constexpr double kMaxMdf = 0.5;   ///< Max multiplicative decrease
+  static constexpr double kMinCwnd = 0.01;  ///< In packets
+  static constexpr double kMaxCwnd = 32;    ///< In packets, session credits
+  static constexpr double kSrttAlpha = 0.125;  ///< EWMA weight for srtt_tsc_
+
+  double rate_ = 0.0;  ///< The pacing rate derived from the window
+  double cwnd_ = kMaxCwnd;  ///< The congestion window in packets
+  size_t last_decrease_tsc_ = 0;
+
+  /// Smoothed RTT in RDTSC cycles. Used for pacing, for limiting decreases to
+  /// once per RTT, and to balance load across sessions.
+  double srtt_tsc_ = 0.0;
+
+  // Const
+  double target_delay_tsc_ = 0.0;
+  double freq_ghz_ = 0.0;
+  double link_bandwidth_ = 0.0;
+  double mtu_ = 0.0;
+
+  EcnAlpha ecn_;  ///< Used only if ECN is enabled for the Rpc
+
+  // For latency stats
+  Latency latency_;
+
+  Swift() {}
+  Swift(double freq_ghz, double link_bandwidth, size_t mtu)
+      : target_delay_tsc_(kTargetDelay * freq_ghz * 1000),
+        freq_ghz_(freq_ghz),
+        link_bandwidth_(link_bandwidth),
+        mtu_(mtu) {
+    rate_ = link_bandwidth;  // Start sending at the max rate
+  }
+
+  /**
+   * @brief Update the window on receiving the acknowledgment for a packet
+   *
+   * @param _rdtsc A recently sampled RDTSC
+   * @param sample_rtt_tsc The RTT sample in RDTSC cycles
+   */
+  void on_ack(size_t _rdtsc, size_t sample_rtt_tsc) {
+    srtt_tsc_ = srtt_tsc_ == 0.0
+                    ? sample_rtt_tsc
+                    : srtt_tsc_ + kSrttAlpha * (sample_rtt_tsc - srtt_tsc_);
+    if (kLatencyStats) {
+      latency_.update(static_cast<size_t>(to_usec(sample_rtt_tsc, freq_ghz_)));
+    }
+
+    if (sample_rtt_tsc < target_delay_tsc_) {
+      if (cwnd_ == kMaxCwnd) return;  // Uncongested, so the rate is unchanged
+
+      // Additive increase by kAddIncrease per window of acknowledgments
+      cwnd_ += cwnd_ >= 1.0 ? kAddIncrease / cwnd_ : kAddIncrease;
+    } else if (can_decrease(_rdtsc)) {
+      const double excess = (sample_rtt_tsc - target_delay_tsc_) /
+                            static_cast<double>(sample_rtt_tsc);
+      cwnd_ *= (std::max)(1.0 - kBeta * excess, 1.0 - kMaxMdf);
+      last_decrease_tsc_ = _rdtsc;
+    } else {
+      return;
+    }
+
+    cwnd_ = (std::max)((std::min)(cwnd_, double(kMaxCwnd)), double(kMinCwnd));
+    update_pacing_rate();
+  }
+
+  /// Shrink the window on a retransmission timeout
+  void on_loss(size_t _rdtsc) {
+    if (!can_decrease(_rdtsc)) return;
+    cwnd_ = (std::max)(cwnd_ * (1.0 - kMaxMdf), double(kMinCwnd));
+    last_decrease_tsc_ = _rdtsc;
+    update_pacing_rate();
+  }
+
+  /// Shrink the window DCTCP-style once per RTT in which acks carried CE
+  /// marks. This counts as the RTT's delay-based decrease.
+  void on_ecn(size_t _rdtsc, bool ce) {
+    const double factor = ecn_.on_ack(_rdtsc, ce, srtt_tsc_);
+    if (factor == 1.0 || !can_decrease(_rdtsc)) return;
+    cwnd_ = (std::max)(cwnd_ * factor, double(kMinCwnd));
+    last_decrease_tsc_ = _rdtsc;
+    update_pacing_rate();
+  }
+
+  double get_rate() const { return rate_; }
+  double get_cwnd() const { return cwnd_; }
+  double get_srtt_tsc() const { return srtt_tsc_; }
+  bool is_uncongested() const { return rate_ == link_bandwidth_; }
+
+  /// Get RTT percentile if latency stats are enabled
+  double get_rtt_perc(double perc) {
+    if (!kLatencyStats || latency_.count() == 0) return -1.0;
+    return latency_.perc(perc);
+  }
+
+  void reset_rtt_stats() { latency_.reset(); }
+  double get_rate_gbps() const { return (rate_ / (1000 * 1000 * 1000)) * 8; }
+
+ private:
+  /// The window is decreased at most once per smoothed RTT
+  bool can_decrease(size_t _rdtsc) const {
+    return _rdtsc - last_decrease_tsc_ >= srtt_tsc_;
+  }
+
+  void update_pacing_rate() {
+    if (cwnd_ == kMaxCwnd) {
+      rate_ = link_bandwidth_;
+      return;
+    }
+
+    const double srtt_sec = to_sec(static_cast<size_t>(srtt_tsc_), freq_ghz_);
+    rate_ = srtt_sec == 0.0 ? link_bandwidth_ : cwnd_ * mtu_ / srtt_sec;
+    rate_ = (std::max)((std::min)(rate_, link_bandwidth_), double(kMinRate));
+  }
+};
+}  // namespace erpc
@@ -8,6 +8,8 @@
 #pragma once
 
 #include <iomanip>
+#include <limits>
+#include "cc/ecn.h"
 #include "cc/timely_sweep_params.h"
 #include "common.h"
 #include "util/latency.h"
@@ -46,6 +48,7 @@ class Timely {
   static constexpr double kTLow = 50;
   static constexpr double kTHigh = 1000;
   static constexpr size_t kHaiThresh = 5;
+  static constexpr double kSrttAlpha = 0.125;  ///< EWMA weight for srtt_tsc_
 
   double rate_ = 0.0;  ///< The current sending rate
   size_t neg_gradient_count_ = 0;
@@ -53,12 +56,18 @@ class Timely {
   double avg_rtt_diff_ = 0.0;
   size_t last_update_tsc_ = 0;
 
+  /// Smoothed RTT in RDTSC cycles, including samples that bypass the rate
+  /// update. Used to balance load across sessions. Zero until the first sample.
+  double srtt_tsc_ = 0.0;
+
   // Const
   double min_rtt_tsc_ = 0.0;
   double t_low_tsc_ = 0.0;
   double freq_ghz_ = 0.0;
   double link_bandwidth_ = 0.0;
 
+  EcnAlpha ecn_;  ///< Used only if ECN is enabled for the Rpc
+
   // For latency stats
   Latency latency_;
 
@@ -78,6 +87,11 @@ class Timely {
     if (kRecord) record_vec_.reserve(1000000);
   }
 
+  /// The congestion control policy constructor. Timely's rate doesn't depend
+  /// on the packet size.
+  Timely(double freq_ghz, double link_bandwidth, size_t)
+      : Timely(freq_ghz, link_bandwidth) {}
+
   /// The w() function from the ECN-vs-delay paper by Zhu et al. (CoNEXT 16)
   static double w_func(double g) {
     assert(kPatched);
@@ -94,7 +108,14 @@ class Timely {
    * @param sample_rtt_tsc The RTT sample in RDTSC cycles
    */
   void update_rate(size_t _rdtsc, size_t sample_rtt_tsc) {
-    assert(_rdtsc >= 1000000000 && _rdtsc >= last_update_tsc_);  // Sanity check
+    assert(_rdtsc >= 1000000000);  // Sanity check
+
+    // Packet timestamps converted from the kernel's clock can be slightly out
+    // of order
+    if (unlikely(_rdtsc < last_update_tsc_)) _rdtsc = last_update_tsc_;
+    srtt_tsc_ = srtt_tsc_ == 0.0
+                    ? sample_rtt_tsc
+                    : srtt_tsc_ + kSrttAlpha * (sample_rtt_tsc - srtt_tsc_);
 
     if (kCcOptTimelyBypass &&
         (rate_ == link_bandwidth_ && sample_rtt_tsc <= t_low_tsc_)) {
@@ -180,6 +201,31 @@ class Timely {
     }
   }
 
+  // Congestion control policy interface, see cc/cc_policy.h
+
+  /// Update the rate on receiving the acknowledgment for a packet
+  inline void on_ack(size_t _rdtsc, size_t sample_rtt_tsc) {
+    update_rate(_rdtsc, sample_rtt_tsc);
+  }
+
+  /// Timely reacts only to RTT, so a retransmission timeout has no effect
+  inline void on_loss(size_t) {}
+
+  /// Cut the rate DCTCP-style once per RTT in which acks carried CE marks
+  inline void on_ecn(size_t _rdtsc, bool ce) {
+    const double factor = ecn_.on_ack(_rdtsc, ce, srtt_tsc_);
+    if (factor == 1.0) return;
+    rate_ = (std::max)(rate_ * factor, double(kMinRate));
+  }
+
+  double get_rate() const { return rate_; }
+  double get_srtt_tsc() const { return srtt_tsc_; }
+  bool is_uncongested() const { return rate_ == link_bandwidth_; }
+
+  /// Timely doesn't use a congestion window. Only session credits limit the
+  /// packets in flight.
+  double get_cwnd() const { return std::numeric_limits<double>::max(); }
+
   /// Get RTT percentile if latency stats are enabled, and reset latency stats
   double get_rtt_perc(double perc) {
     if (!kLatencyStats || latency_.count() == 0) return -1.0;
@@ -1,74 +1,152 @@
 /**
  * @file timing_wheel.h
- * @brief Timing wheel implementation from Carousel [SIGCOMM 17]
+ * @brief Hierarchical timing wheel, based on Carousel [SIGCOMM 17] and
+ * Varghese & Lauck [SOSP 87]
  * Units: Microseconds or TSC for time, bytes/sec for throughput
  *
- * SSlots scheduled for transmission in a wheel slot are stored in a chain
- * of associative buckets. Deletes do not compact the chain, so some buckets in
- * a chain may be empty or partially full.
+ * Time is divided into wheel slots of kWheelSlotWidthUs. Level 0 has one
+ * wheel slot per slot of the current level-0 window, i.e., the aligned run of
+ * kWheelLevelSlots slots that contains the current slot. Each wheel slot of
+ * level l > 0 covers one aligned window of level l - 1. An entry is placed in
+ * the lowest level whose window contains its slot, and moves down a level when
+ * time enters the window of its wheel slot. Entries therefore reach level 0 in
+ * insertion order, and are reaped at the resolution of level 0 for any delay
+ * up to the horizon.
+ *
+ * Entries in a wheel slot are stored in a chain of associative buckets.
+ * Reaped entries wait in fixed-capacity rings, so neither inserting nor
+ * reaping allocates memory once the bucket pools are warm.
  */
 
 #pragma once
 
+#include <array>
 #include <iomanip>
-#include <queue>
-#include "cc/timely.h"
+#include "cc/cc_policy.h"
 #include "common.h"
 #include "sm_types.h"
 #include "sslot.h"
 #include "transport_impl/dpdk/dpdk_transport.h"
 #include "transport_impl/fake/fake_transport.h"
 #include "transport_impl/infiniband/ib_transport.h"
+#include "transport_impl/netem/netem_transport.h"
 #include "transport_impl/raw/raw_transport.h"
+#include "transport_impl/sim/sim_transport.h"
+#include "util/math_utils.h"
 #include "util/mempool.h"
 #include "wheel_record.h"
 
 namespace erpc {
 
 static constexpr double kWheelSlotWidthUs = .5;  ///< Duration per wheel slot
+static constexpr size_t kWheelLevelBits = 10;  ///< log2(slots per level)
+static constexpr size_t kWheelLevelSlots = 1ull << kWheelLevelBits;
+static constexpr size_t kWheelLevelMask = kWheelLevelSlots - 1;
+static constexpr size_t kWheelNumLevels = 4;
+static constexpr size_t kWheelTopShift =
+    kWheelLevelBits * (kWheelNumLevels - 1);  ///< Wheel slot bits below top
+
+/// The max delay of an entry in wheel slots. The top level is used as a
+/// circular wheel, so one of its slots is left as slack.
+static constexpr size_t kWheelHorizonSlots =
+    (kWheelLevelSlots - 2) << kWheelTopShift;
 static constexpr double kWheelHorizonUs =
-    1000000 * (kSessionCredits * CTransport::kMTU) / Timely::kMinRate;
-
-// This ensures that packets for an sslot undergoing retransmission are rarely
-// in the wheel. This is recommended but not required.
-// static_assert(kWheelHorizonUs <= kRpcRTOUs, "");
-
-static constexpr size_t kWheelNumWslots =
-    1 + erpc::ceil(kWheelHorizonUs / kWheelSlotWidthUs);
+    kWheelHorizonSlots * kWheelSlotWidthUs;
 
 static constexpr bool kWheelRecord = false;  ///< Fast-record wheel actions
 
 /// One entry in a timing wheel bucket
 struct wheel_ent_t {
   uint64_t sslot_ : 48;  ///< The things I do for perf
-  uint64_t pkt_num_ : 16;
-  wheel_ent_t(SSlot *sslot, size_t pkt_num)
-      : sslot_(reinterpret_cast<uint64_t>(sslot)), pkt_num_(pkt_num) {}
+  uint64_t pkt_num_ : 14;
+  uint64_t priority_ : 2;  ///< The priority class of the sslot's request
+  wheel_ent_t() = default;
+  wheel_ent_t(SSlot *sslot, size_t pkt_num, size_t priority = kPriorityNormal)
+      : sslot_(reinterpret_cast<uint64_t>(sslot)),
+        pkt_num_(pkt_num),
+        priority_(priority) {}
 };
 static_assert(sizeof(wheel_ent_t) == 8, "");
+static_assert(kNumPriorities <= 4, "");
 
-// Handle the fact that we're not using all 64 TSC bits
-static constexpr size_t kWheelBucketCap = 5;  ///< Wheel entries per bucket
-static constexpr size_t kNumBktEntriesBits = 3;
-static_assert((1ull << kNumBktEntriesBits) > kWheelBucketCap, "");
+/// Capacity of each ready ring. Every wheel entry holds a session credit, and
+/// an Rpc's sessions have at most one RX ring's worth of credits.
+static constexpr size_t kWheelReadyQueueCap = Transport::kNumRxRingEntries;
+static_assert(is_power_of_two(kWheelReadyQueueCap), "");
 
-// TSC ticks per day = ~3 billion per second * 86400 seconds per day
-// Require that rollback happens only after server lifetime
-static constexpr size_t kKTscTicks = 1ull << (64 - kNumBktEntriesBits);
-static_assert(kKTscTicks / (3000000000ull * 86400) > 2000, "");
+/// The queue of reaped wheel entries. Entries leave in priority order, and in
+/// FIFO order within a priority class, so the packets of one request are not
+/// reordered.
+class WheelReadyQueue {
+ public:
+  void push(const wheel_ent_t &ent) {
+    ring_t &ring = rings_[ent.priority_];
+    assert(ring.tail_ - ring.head_ < kWheelReadyQueueCap);
+    ring.ents_[ring.tail_ & (kWheelReadyQueueCap - 1)] = ent;
+    ring.tail_++;
+    size_++;
+  }
 
-struct wheel_bkt_t {
-  size_t num_entries_ : kNumBktEntriesBits;  ///< Valid entries in this bucket
+  /// Return the oldest entry of the highest non-empty priority class
+  wheel_ent_t &front() {
+    ring_t &ring = rings_[top_priority()];
+    return ring.ents_[ring.head_ & (kWheelReadyQueueCap - 1)];
+  }
+
+  void pop() {
+    rings_[top_priority()].head_++;
+    size_--;
+  }
 
-  /// Timestamp at which it is safe to transmit packets in this bucket's chain
-  size_t tx_tsc_ : 64 - kNumBktEntriesBits;
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
 
-  wheel_bkt_t *last_;  ///< Last bucket in chain. Used only at the first bucket.
-  wheel_bkt_t *next_;  ///< Next bucket in chain
+ private:
+  struct ring_t {
+    std::array<wheel_ent_t, kWheelReadyQueueCap> ents_;
+    size_t head_ = 0;  ///< Free-running index of the oldest entry
+    size_t tail_ = 0;  ///< Free-running index of the next free entry
+  };
+
+  size_t top_priority() const {
+    assert(size_ > 0);
+    size_t priority = kNumPriorities - 1;
+    while (rings_[priority].head_ == rings_[priority].tail_) priority--;
+    return priority;
+  }
+
+  std::array<ring_t, kNumPriorities> rings_;
+  size_t size_ = 0;
+};
+
+static constexpr size_t kWheelBucketCap = 5;  ///< Wheel entries per bucket
+
+/// A bucket of level-0 entries
+struct wheel_bkt_t {
+  size_t num_entries_;  ///< Valid entries in this bucket
+  wheel_bkt_t *last_;   ///< Last bucket in chain. Used only at first bucket.
+  wheel_bkt_t *next_;   ///< Next bucket in chain
   wheel_ent_t entry_[kWheelBucketCap];  ///< Space for wheel entries
 };
 static_assert(sizeof(wheel_bkt_t) == 64, "");
 
+/// An entry in levels above 0, which needs its wheel slot to move down
+struct wheel_far_ent_t {
+  wheel_ent_t ent_;
+  size_t wslot_;  ///< The absolute level-0 wheel slot of the entry
+};
+
+static constexpr size_t kWheelFarBucketCap = 6;  ///< Entries per far bucket
+
+/// A bucket of entries in levels above 0
+struct wheel_far_bkt_t {
+  size_t num_entries_;
+  wheel_far_bkt_t *last_;
+  wheel_far_bkt_t *next_;
+  wheel_far_ent_t entry_[kWheelFarBucketCap];
+};
+static_assert(sizeof(wheel_far_bkt_t) <= 128, "");
+
 struct timing_wheel_args_t {
   double freq_ghz_;
   HugeAlloc *huge_alloc_;
@@ -81,21 +159,40 @@ class TimingWheel {
         wslot_width_tsc_(us_to_cycles(kWheelSlotWidthUs, freq_ghz_)),
         horizon_tsc_(us_to_cycles(kWheelHorizonUs, freq_ghz_)),
         huge_alloc_(args.huge_alloc_),
-        bkt_pool_(huge_alloc_) {
-    // wheel_buffer is leaked by the wheel, and deleted later with the allocator
+        bkt_pool_(huge_alloc_),
+        far_bkt_pool_(huge_alloc_) {
+    // The wheel buffers are leaked by the wheel, and deleted later with the
+    // allocator
     Buffer wheel_buffer = huge_alloc_->alloc_raw(
-        kWheelNumWslots * sizeof(wheel_bkt_t), DoRegister::kFalse);
-    rt_assert(wheel_buffer.buf_ != nullptr,
+        kWheelLevelSlots * sizeof(wheel_bkt_t), DoRegister::kFalse);
+    Buffer far_wheel_buffer = huge_alloc_->alloc_raw(
+        (kWheelNumLevels - 1) * kWheelLevelSlots * sizeof(wheel_far_bkt_t),
+        DoRegister::kFalse);
+    rt_assert(wheel_buffer.buf_ != nullptr && far_wheel_buffer.buf_ != nullptr,
               std::string("Failed to allocate wheel. ") +
                   HugeAlloc::kAllocFailHelpStr);
 
-    size_t base_tsc = rdtsc();
+    // Fill the bucket pools now, since growing them takes hundreds of
+    // microseconds
+    bkt_pool_.free(bkt_pool_.alloc());
+    far_bkt_pool_.free(far_bkt_pool_.alloc());
+
+    base_tsc_ = rdtsc();
     wheel_ = reinterpret_cast<wheel_bkt_t *>(wheel_buffer.buf_);
-    for (size_t ws_i = 0; ws_i < kWheelNumWslots; ws_i++) {
+    for (size_t ws_i = 0; ws_i < kWheelLevelSlots; ws_i++) {
       reset_bkt(&wheel_[ws_i]);
-      wheel_[ws_i].tx_tsc_ = base_tsc + (ws_i + 1) * wslot_width_tsc_;
       wheel_[ws_i].last_ = &wheel_[ws_i];
     }
+
+    auto *far_wheel =
+        reinterpret_cast<wheel_far_bkt_t *>(far_wheel_buffer.buf_);
+    for (size_t level = 1; level < kWheelNumLevels; level++) {
+      far_wheel_[level] = &far_wheel[(level - 1) * kWheelLevelSlots];
+      for (size_t ws_i = 0; ws_i < kWheelLevelSlots; ws_i++) {
+        reset_bkt(&far_wheel_[level][ws_i]);
+        far_wheel_[level][ws_i].last_ = &far_wheel_[level][ws_i];
+      }
+    }
   }
 
   /// Return a dummy wheel entry
@@ -105,20 +202,34 @@ class TimingWheel {
 
   /// Roll the wheel forward until it catches up with current time. Hopefully
   /// this is needed only during initialization.
-  void catchup() {
-    while (wheel_[cur_wslot_].tx_tsc_ < rdtsc()) reap(rdtsc());
-  }
+  void catchup() { reap(rdtsc()); }
 
-  /// Move entries from all wheel slots older than reap_tsc to the ready queue.
-  /// The max_tsc of all these wheel slots is advanced.
-  /// This function must be called with non-decreasing values of reap_tsc
+  /**
+   * @brief Move entries from all wheel slots that end at or before reap_tsc to
+   * the ready queue. Runs of empty wheel slots are skipped in bulk, so the
+   * cost does not grow with the time since the last reap.
+   *
+   * This function must be called with non-decreasing values of reap_tsc
+   */
   void reap(size_t reap_tsc) {
-    while (wheel_[cur_wslot_].tx_tsc_ <= reap_tsc) {
-      reap_wslot(cur_wslot_);
-      wheel_[cur_wslot_].tx_tsc_ += (wslot_width_tsc_ * kWheelNumWslots);
+    if (unlikely(reap_tsc < base_tsc_)) return;
+    const size_t end_wslot = (reap_tsc - base_tsc_) / wslot_width_tsc_;
+
+    while (cur_wslot_ < end_wslot) {
+      if (num_wslot_entries_ == 0) {
+        cur_wslot_ = end_wslot;  // Nothing to reap or move down
+        return;
+      }
+
+      if (level_entries_[0] == 0) {
+        // Skip the rest of the level-0 window
+        cur_wslot_ = (std::min)(end_wslot, (cur_wslot_ | kWheelLevelMask) + 1);
+      } else {
+        reap_wslot(cur_wslot_ & kWheelLevelMask);
+        cur_wslot_++;
+      }
 
-      cur_wslot_++;
-      if (cur_wslot_ == kWheelNumWslots) cur_wslot_ = 0;
+      if ((cur_wslot_ & kWheelLevelMask) == 0) cascade();
     }
   }
 
@@ -140,26 +251,96 @@ class TimingWheel {
     assert(desired_tx_tsc - ref_tsc <= horizon_tsc_);  // Horizon definition
 
     reap(ref_tsc);  // Advance the wheel to a recent time
-    assert(wheel_[cur_wslot_].tx_tsc_ > ref_tsc);
-
-    size_t dst_wslot;
-    if (desired_tx_tsc <= wheel_[cur_wslot_].tx_tsc_) {
-      dst_wslot = cur_wslot_;
-    } else {
-      size_t wslot_delta =
-          1 + (desired_tx_tsc - wheel_[cur_wslot_].tx_tsc_) / wslot_width_tsc_;
-      assert(wslot_delta < kWheelNumWslots);
-
-      dst_wslot = cur_wslot_ + wslot_delta;
-      if (dst_wslot >= kWheelNumWslots) dst_wslot -= kWheelNumWslots;
-    }
+
+    size_t wslot = desired_tx_tsc > base_tsc_
+                       ? (desired_tx_tsc - base_tsc_) / wslot_width_tsc_
+                       : 0;
+    wslot = (std::max)(wslot, cur_wslot_);
 
     if (kWheelRecord) record_vec_.emplace_back(ent.pkt_num_, desired_tx_tsc);
 
-    insert_into_wslot(dst_wslot, ent);
+    insert_at_wslot(ent, wslot);
+    num_wslot_entries_++;
+  }
+
+  /// Return the number of entries in wheel slots, i.e., not yet reaped
+  size_t get_num_wslot_entries() const { return num_wslot_entries_; }
+
+  /// Return a lower bound on the timestamp at which reap() makes progress, or
+  /// SIZE_MAX if the wheel slots are empty. This scans level 0.
+  size_t get_next_reap_tsc() const {
+    if (num_wslot_entries_ == 0) return SIZE_MAX;
+    if (level_entries_[0] == 0) {
+      // Entries move down at the start of the next level-0 window
+      const size_t next_window = (cur_wslot_ | kWheelLevelMask) + 1;
+      return base_tsc_ + next_window * wslot_width_tsc_;
+    }
+
+    size_t wslot = cur_wslot_;
+    while (wheel_[wslot & kWheelLevelMask].num_entries_ == 0) wslot++;
+    return base_tsc_ + (wslot + 1) * wslot_width_tsc_;
+  }
+
+  /// Move all entries to the ready queue in TX timestamp order, regardless of
+  /// the current time. Used for testing.
+  void reap_all() {
+    for (size_t ws_i = cur_wslot_ & kWheelLevelMask; ws_i < kWheelLevelSlots;
+         ws_i++) {
+      reap_wslot(ws_i);
+    }
+
+    for (size_t level = 1; level < kWheelNumLevels; level++) {
+      const size_t cur_i = cur_wslot_ >> (kWheelLevelBits * level);
+      for (size_t i = 1; i < kWheelLevelSlots; i++) {
+        drain_far_wslot(level, (cur_i + i) & kWheelLevelMask,
+                        [this](const wheel_far_ent_t &far_ent) {
+                          ready_queue_.push(far_ent.ent_);
+                          num_wslot_entries_--;
+                        });
+      }
+    }
+
+    assert(num_wslot_entries_ == 0);
   }
 
  private:
+  /// Return the lowest level whose current window contains a wheel slot
+  inline size_t get_level(size_t wslot) const {
+    const size_t diff = wslot ^ cur_wslot_;
+    if (diff < kWheelLevelSlots) return 0;
+
+    const size_t msb = 63 - static_cast<size_t>(__builtin_clzll(diff));
+    return (std::min)(msb / kWheelLevelBits, kWheelNumLevels - 1);
+  }
+
+  /// Add an entry to the level and wheel slot that cover \p wslot
+  void insert_at_wslot(const wheel_ent_t &ent, size_t wslot) {
+    assert(wslot >= cur_wslot_);
+    assert((wslot >> kWheelTopShift) - (cur_wslot_ >> kWheelTopShift) <
+           kWheelLevelSlots);
+    const size_t level = get_level(wslot);
+    level_entries_[level]++;
+
+    if (level == 0) {
+      insert_into_wslot(wslot & kWheelLevelMask, ent);
+      return;
+    }
+
+    const size_t ws_i = (wslot >> (kWheelLevelBits * level)) & kWheelLevelMask;
+    wheel_far_bkt_t *last_bkt = far_wheel_[level][ws_i].last_;
+    assert(last_bkt->num_entries_ < kWheelFarBucketCap);
+    last_bkt->entry_[last_bkt->num_entries_].ent_ = ent;
+    last_bkt->entry_[last_bkt->num_entries_].wslot_ = wslot;
+    last_bkt->num_entries_++;
+
+    if (last_bkt->num_entries_ == kWheelFarBucketCap) {
+      wheel_far_bkt_t *new_bkt = far_bkt_pool_.alloc();
+      reset_bkt(new_bkt);
+      last_bkt->next_ = new_bkt;
+      far_wheel_[level][ws_i].last_ = new_bkt;
+    }
+  }
+
   void insert_into_wslot(size_t ws_i, const wheel_ent_t &ent) {
     wheel_bkt_t *last_bkt = wheel_[ws_i].last_;
     assert(last_bkt->next_ == nullptr);
@@ -176,11 +357,13 @@ class TimingWheel {
     }
   }
 
-  /// Transfer all entries from a wheel slot to the ready queue. The wheel slot
-  /// is reset and its chained buckets are returned to the pool.
+  /// Transfer all entries from a level-0 wheel slot to the ready queue. The
+  /// wheel slot is reset and its chained buckets are returned to the pool.
   void reap_wslot(size_t ws_i) {
     wheel_bkt_t *bkt = &wheel_[ws_i];
     while (bkt != nullptr) {
+      num_wslot_entries_ -= bkt->num_entries_;
+      level_entries_[0] -= bkt->num_entries_;
       for (size_t i = 0; i < bkt->num_entries_; i++) {
         ready_queue_.push(bkt->entry_[i]);
         if (kWheelRecord) {
@@ -198,7 +381,47 @@ class TimingWheel {
     wheel_[ws_i].last_ = &wheel_[ws_i];  // Reset last pointer
   }
 
-  inline void reset_bkt(wheel_bkt_t *bkt) {
+  /// The current wheel slot has entered new windows of one or more levels.
+  /// Move the entries of these windows down, starting at the highest level so
+  /// that entries keep their insertion order.
+  void cascade() {
+    for (size_t level = kWheelNumLevels - 1; level >= 1; level--) {
+      const size_t shift = kWheelLevelBits * level;
+      if ((cur_wslot_ & ((1ull << shift) - 1)) != 0) continue;
+      if (level_entries_[level] == 0) continue;
+
+      drain_far_wslot(level, (cur_wslot_ >> shift) & kWheelLevelMask,
+                      [this](const wheel_far_ent_t &far_ent) {
+                        insert_at_wslot(far_ent.ent_, far_ent.wslot_);
+                      });
+    }
+  }
+
+  /// Remove all entries from a far wheel slot, and pass them to \p func in
+  /// insertion order. The wheel slot is reset before \p func runs, and its
+  /// chained buckets are returned to the pool.
+  template <class TFunc>
+  void drain_far_wslot(size_t level, size_t ws_i, TFunc func) {
+    wheel_far_bkt_t *head = &far_wheel_[level][ws_i];
+    if (head->num_entries_ == 0) return;
+
+    wheel_far_bkt_t first = *head;  // The wheel slot's own bucket
+    reset_bkt(head);
+    head->last_ = head;
+
+    wheel_far_bkt_t *bkt = &first;
+    while (bkt != nullptr) {
+      level_entries_[level] -= bkt->num_entries_;
+      for (size_t i = 0; i < bkt->num_entries_; i++) func(bkt->entry_[i]);
+
+      wheel_far_bkt_t *tmp_next = bkt->next_;
+      if (bkt != &first) far_bkt_pool_.free(bkt);
+      bkt = tmp_next;
+    }
+  }
+
+  template <class TBkt>
+  inline void reset_bkt(TBkt *bkt) {
     bkt->next_ = nullptr;
     bkt->num_entries_ = 0;
   }
@@ -214,12 +437,17 @@ class TimingWheel {
   const size_t horizon_tsc_;      ///< Horizon in TSC units
   HugeAlloc *huge_alloc_;
 
-  wheel_bkt_t *wheel_;
-  size_t cur_wslot_ = 0;
+  size_t base_tsc_;  ///< Start time of wheel slot zero
+  wheel_bkt_t *wheel_;  ///< The wheel slots of level 0
+  std::array<wheel_far_bkt_t *, kWheelNumLevels> far_wheel_;  ///< Levels 1+
+  size_t cur_wslot_ = 0;  ///< Absolute index of the earliest unreaped slot
+  size_t num_wslot_entries_ = 0;
+  std::array<size_t, kWheelNumLevels> level_entries_ = {};  ///< Per level
   MemPool<wheel_bkt_t> bkt_pool_;
+  MemPool<wheel_far_bkt_t> far_bkt_pool_;
 
  public:
   std::vector<wheel_record_t> record_vec_;  ///< Used only with kWheelRecord
-  std::queue<wheel_ent_t> ready_queue_;
+  WheelReadyQueue ready_queue_;
 };
 }  // namespace erpc
@@ -0,0 +1,28 @@
+#pragma once
+#include <stdlib.h>
+
+namespace erpc {
+
+// Pick a transport. This is hard to control from CMake.
+class IBTransport;
+class RawTransport;
+class DpdkTransport;
+class FakeTransport;
+class SimTransport;
+template <class TTr>
+class NetemTransport;
+
+// CTransport is CBaseTransport, or CBaseTransport wrapped in NetemTransport
+#define CBaseTransport FakeTransport
+#define CTransport FakeTransport
+static constexpr size_t kHeadroom = 40;
+static constexpr size_t kIsRoCE = false;
+static constexpr size_t kIsAzure = false;
+static constexpr size_t kIsNetem = false;
+
+// Pick a congestion control policy, see cc/cc_policy.h
+class Timely;
+class Swift;
+
+#define CCongestionControl Timely
+}  // namespace erpc
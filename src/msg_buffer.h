@@ -1,5 +1,6 @@
 #pragma once
 
+#include <sys/uio.h>
 #include "common.h"
 #include "pkthdr.h"
 #include "util/buffer.h"
@@ -13,6 +14,35 @@ class Session;
 template <typename T>
 class Rpc;
 
+template <class TTr>
+class NetemTransport;
+
+/**
+ * @brief One fragment of a scatter-gather message. A fragment must lie in
+ * memory registered with eRPC's transport, i.e., inside a MsgBuffer allocated
+ * with Rpc::alloc_msg_buffer or inside application memory registered with
+ * Rpc::register_app_mem. Fragments are created with Rpc::make_msg_frag or
+ * Rpc::make_app_msg_frag.
+ */
+struct msg_frag_t {
+  const uint8_t *buf_;  ///< The first data byte of this fragment
+  size_t size_;         ///< Number of data bytes in this fragment
+  uint32_t lkey_;       ///< The memory registration key for this fragment
+};
+
+/**
+ * @brief An application-owned memory region registered with eRPC's transport
+ * using Rpc::register_app_mem, e.g., the value store of a key-value server.
+ * Responses can be sent directly from such a region with
+ * Rpc::enqueue_response_sg.
+ */
+struct app_mem_t {
+  uint8_t *buf_ = nullptr;        ///< The first byte of the region
+  size_t size_ = 0;               ///< The size of the region in bytes
+  void *transport_mr_ = nullptr;  ///< The transport's memory region handle
+  uint32_t lkey_ = 0;             ///< The memory registration key
+};
+
 /**
  * @brief Applications store request and response messages in hugepage-backed
  * buffers called message buffers. These buffers are registered with the NIC,
@@ -24,10 +54,23 @@ class Rpc;
  * Rpc::free_msg_buffer frees a message buffer.
  *
  * A message buffer is invalid if its #buf pointer is null.
+ *
+ * A message buffer's data can also be fragmented, i.e., described by a list of
+ * fragments instead of being stored contiguously at #buf:
+ *  - eRPC internally creates fragmented message buffers for
+ *    Rpc::enqueue_request_sg and Rpc::enqueue_response_sg. These contain only
+ *    packet headers, and the transport gathers the fragments per packet. eRPC
+ *    frees them in the foreground thread.
+ *  - With Rpc::enable_frag_rx, received multi-packet requests and responses
+ *    may be delivered as fragmented message buffers that reference the
+ *    received packets in place. Applications read these with get_frag() or
+ *    get_iovec(), which also work for contiguous message buffers.
  */
 class MsgBuffer {
-  friend class CTransport;
+  friend class CBaseTransport;
   friend class Rpc<CTransport>;
+  template <class TTr>
+  friend class NetemTransport;
   friend class Session;
 
  private:
@@ -40,6 +83,7 @@ class MsgBuffer {
   /// get_pkthdr_0() is more efficient for retrieving the zeroth header.
   inline pkthdr_t *get_pkthdr_n(size_t n) const {
     if (unlikely(n == 0)) return get_pkthdr_0();
+    if (unlikely(is_fragmented())) return get_pkthdr_0() + n;  // TX SG only
     return reinterpret_cast<pkthdr_t *>(
         buf_ + round_up<sizeof(size_t)>(max_data_size_) +
         (n - 1) * sizeof(pkthdr_t));
@@ -58,6 +102,46 @@ class MsgBuffer {
     return (buf_ == nullptr && buffer_.buf_ == nullptr);
   }
 
+  /**
+   * @brief Get the pieces of the scatter-gather fragments that make up the data
+   * of packet \p pkt_idx of this MsgBuffer
+   *
+   * @param out Output array for the pieces. It must have space for the maximum
+   * number of fragments per packet, which eRPC checks when creating the
+   * scatter-gather MsgBuffer.
+   *
+   * @return The number of pieces written to \p out
+   */
+  template <size_t kMaxDataPerPkt>
+  inline size_t get_pkt_frags(size_t pkt_idx, msg_frag_t *out) const {
+    assert(is_fragmented());
+    size_t offset = pkt_idx * kMaxDataPerPkt;
+    size_t to_go = (std::min)(kMaxDataPerPkt, data_size_ - offset);
+
+    // Find the fragment containing the packet's first data byte
+    size_t frag_i = 0;
+    while (to_go > 0 && offset >= frags_[frag_i].size_) {
+      offset -= frags_[frag_i].size_;
+      frag_i++;
+    }
+
+    size_t num_pieces = 0;
+    while (to_go > 0) {
+      const msg_frag_t &frag = frags_[frag_i];
+      const size_t piece_size = (std::min)(frag.size_ - offset, to_go);
+      out[num_pieces].buf_ = frag.buf_ + offset;
+      out[num_pieces].size_ = piece_size;
+      out[num_pieces].lkey_ = frag.lkey_;
+      num_pieces++;
+
+      to_go -= piece_size;
+      offset = 0;
+      frag_i++;
+    }
+
+    return num_pieces;
+  }
+
   /// Get the packet size (i.e., including packet header) of a packet
   template <size_t kMaxDataPerPkt>
   inline size_t get_pkt_size(size_t pkt_idx) const {
@@ -73,7 +157,9 @@ class MsgBuffer {
     ret << "[buf " << static_cast<void *>(buf_) << ", "
         << "buffer " << buffer_.to_string() << ", "
         << "data_size " << data_size_ << "(" << max_data_size_ << "), "
-        << "pkts " << num_pkts_ << "(" << max_num_pkts_ << ")]";
+        << "pkts " << num_pkts_ << "(" << max_num_pkts_ << ")";
+    if (is_fragmented()) ret << ", frags " << num_frags_;
+    ret << "]";
     return ret.str();
   }
 
@@ -92,9 +178,34 @@ class MsgBuffer {
     assert(max_num_pkts >= 1);
     assert(buffer.class_size_ >=
            max_data_size + max_num_pkts * sizeof(pkthdr_t));
+    init_pkthdr_0();
+  }
+
+  /// Construct a scatter-gather MsgBuffer with a dynamic Buffer allocated by
+  /// eRPC. \p buffer contains \p num_pkts contiguous packet headers starting
+  /// at \p hdr_offset. The data is described by \p num_frags fragments in
+  /// \p frags, which must outlive this MsgBuffer.
+  MsgBuffer(Buffer buffer, size_t hdr_offset, msg_frag_t *frags,
+            size_t num_frags, size_t data_size, size_t num_pkts)
+      : buffer_(buffer),
+        max_data_size_(data_size),
+        data_size_(data_size),
+        max_num_pkts_(num_pkts),
+        num_pkts_(num_pkts),
+        frags_(frags),
+        num_frags_(num_frags),
+        buf_(buffer.buf_ + hdr_offset + sizeof(pkthdr_t)) {
+    assert(buffer.buf_ != nullptr && frags != nullptr);
+    assert(num_pkts >= 1);
+    assert(buffer.class_size_ >= hdr_offset + num_pkts * sizeof(pkthdr_t));
+    init_pkthdr_0();
+  }
 
+  /// Initialize the constant fields of the zeroth packet header
+  inline void init_pkthdr_0() {
     pkthdr_t *pkthdr_0 = get_pkthdr_0();
     pkthdr_0->magic_ = kPktHdrMagic;
+    pkthdr_0->clear_word_2();
 
     // UDP checksum for raw Ethernet. Useless for other transports.
     static_assert(sizeof(pkthdr_t::headroom_) == kHeadroom + 2, "");
@@ -116,6 +227,18 @@ class MsgBuffer {
     buffer_.buf_ = nullptr;  // Mark as a non-dynamic ("fake") MsgBuffer
   }
 
+  /// Construct a non-dynamic MsgBuffer for a \p num_pkts packet message whose
+  /// zeroth packet \p pkthdr is held in the RX ring. The caller must attach
+  /// the fragment array for the held packets.
+  MsgBuffer(pkthdr_t *pkthdr, size_t data_size, size_t num_pkts)
+      : max_data_size_(data_size),
+        data_size_(data_size),
+        max_num_pkts_(num_pkts),
+        num_pkts_(num_pkts),
+        buf_(reinterpret_cast<uint8_t *>(pkthdr) + sizeof(pkthdr_t)) {
+    buffer_.buf_ = nullptr;  // Mark as a non-dynamic MsgBuffer
+  }
+
   /// Resize this MsgBuffer to any size smaller than its maximum allocation
   inline void resize(size_t new_data_size, size_t new_num_pkts) {
     assert(new_data_size <= max_data_size_);
@@ -136,6 +259,46 @@ class MsgBuffer {
   inline size_t get_data_size() const { return data_size_; }
   inline size_t get_req_type() const { return get_pkthdr_0()->req_type_; }
 
+  /// Return true iff this MsgBuffer's data is split into fragments, i.e., not
+  /// stored contiguously at #buf
+  inline bool is_fragmented() const { return frags_ != nullptr; }
+
+  /// Return the number of data fragments. This is one for contiguous
+  /// MsgBuffers.
+  inline size_t get_num_frags() const {
+    return is_fragmented() ? num_frags_ : 1;
+  }
+
+  /// Return data fragment \p i. For contiguous MsgBuffers, the only fragment
+  /// is the whole data.
+  inline msg_frag_t get_frag(size_t i) const {
+    assert(i < get_num_frags());
+    if (is_fragmented()) return frags_[i];
+
+    msg_frag_t frag;
+    frag.buf_ = buf_;
+    frag.size_ = data_size_;
+    frag.lkey_ = buffer_.lkey_;
+    return frag;
+  }
+
+  /**
+   * @brief Describe this MsgBuffer's data with up to \p max_iov iovecs, e.g.,
+   * for writev()
+   *
+   * @return The number of iovecs filled, which is smaller than
+   * get_num_frags() if \p max_iov is too small
+   */
+  inline size_t get_iovec(struct iovec *iov, size_t max_iov) const {
+    const size_t num_iov = (std::min)(get_num_frags(), max_iov);
+    for (size_t i = 0; i < num_iov; i++) {
+      const msg_frag_t frag = get_frag(i);
+      iov[i].iov_base = const_cast<uint8_t *>(frag.buf_);
+      iov[i].iov_len = frag.size_;
+    }
+    return num_iov;
+  }
+
  private:
   /// The optional backing hugepage buffer. buffer.buf points to the zeroth
   /// packet header, i.e., not application data.
@@ -147,9 +310,14 @@ class MsgBuffer {
   size_t max_num_pkts_;   ///< Max number of packets in this MsgBuffer
   size_t num_pkts_;       ///< Current number of packets in this MsgBuffer
 
+  // Scatter-gather info
+  msg_frag_t *frags_ = nullptr;  ///< Data fragments, null if contiguous
+  size_t num_frags_ = 0;         ///< Number of data fragments
+
  public:
   /// Pointer to the first application data byte. The message buffer is invalid
-  /// invalid if this is null.
+  /// if this is null. For fragmented MsgBuffers, this points to the first
+  /// fragment, and must not be used to access data beyond it.
   uint8_t *buf_;
 };
 }  // namespace erpc
@@ -5,8 +5,10 @@
 #include "heartbeat_mgr.h"
 #include "session.h"
 #include "sm_types.h"
+#include "util/futex.h"
 #include "util/logger.h"
-#include "util/mt_queue.h"
+#include "util/mpsc_ring.h"
+#include "util/spsc_ring.h"
 #include "util/tls_registry.h"
 
 namespace erpc {
@@ -59,9 +61,39 @@ class Nexus {
   int register_req_func(uint8_t req_type, erpc_req_func_t req_func,
                         ReqFuncType req_func_type = ReqFuncType::kForeground);
 
+  /**
+   * @brief Register an application-defined batch request handler function,
+   * which runs in the foreground. This must be done before any Rpc registers a
+   * hook with the Nexus.
+   *
+   * @return 0 on success, negative errno on failure.
+   */
+  int register_req_func(uint8_t req_type, erpc_batch_req_func_t batch_req_func);
+
+  /// Default time for which an idle background thread polls its request
+  /// queue before parking
+  static constexpr size_t kDefaultBgIdleSpinUs = 1000;
+
+  /**
+   * @brief Set the time for which an idle background thread polls its request
+   * queue before it parks. A parked background thread uses no CPU, and is
+   * woken up by the next submitted work item at the cost of a system call on
+   * the submitting thread. The default is #kDefaultBgIdleSpinUs.
+   *
+   * @param spin_us The polling budget in microseconds. SIZE_MAX disables
+   * parking.
+   */
+  void set_bg_idle_spin_us(size_t spin_us) { bg_idle_spin_us_ = spin_us; }
+
+  /// Print the CPU time used by the session management and background threads
   void print_stats();
 
  private:
+  /// Return 0 if a handler of type \p req_func_type can be registered for
+  /// \p req_type, negative errno otherwise
+  int check_req_func_registration(uint8_t req_type, bool null_func,
+                                  ReqFuncType req_func_type);
+
   enum class BgWorkItemType : bool { kReq, kResp };
 
   /// A work item submitted to a background thread
@@ -69,10 +101,12 @@ class Nexus {
    public:
     BgWorkItem() {}
 
-    static inline BgWorkItem make_req_item(void *context, SSlot *sslot) {
+    static inline BgWorkItem make_req_item(void *context,
+                                           Rpc<CTransport> *rpc, SSlot *sslot) {
       BgWorkItem ret;
       ret.wi_type_ = BgWorkItemType::kReq;
       ret.context_ = context;
+      ret.rpc_ = rpc;
       ret.sslot_ = sslot;
       return ret;
     }
@@ -93,6 +127,7 @@ class Nexus {
 
     // Fields for request handlers. For request handlers, we still have
     // ownership of the request slot, so we can hold it until enqueue_response.
+    Rpc<CTransport> *rpc_;  ///< The Rpc, for dropping expired requests
     SSlot *sslot_;
 
     // Fields for continuations. For continuations, we have lost ownership of
@@ -103,17 +138,88 @@ class Nexus {
     bool is_req() const { return wi_type_ == BgWorkItemType::kReq; }
   };
 
+  /// Capacity of each background thread's request queue. Rpc threads that
+  /// find a queue full process their own background queues while they wait.
+  static constexpr size_t kBgReqQueueSize = 4096;
+
+  /// Capacity of each Rpc's session management RX queue. Packets that don't
+  /// fit are dropped, and recovered by session management retransmissions.
+  static constexpr size_t kSmRxQueueSize = 64;
+
+  /// A background thread's request queue. Producers are Rpc threads.
+  class BgReqQueue {
+   public:
+    /// Return the number of work items queued or running at this background
+    /// thread. Safe to call from any thread, but possibly stale.
+    size_t get_load() const {
+      return ring_.num_pushed() - num_done_.load(std::memory_order_relaxed);
+    }
+
+    /// Wake up the background thread if it's parked. Producers must call this
+    /// after pushing to the ring.
+    void wake_if_parked() {
+      // Order the push before reading parked_. The background thread orders
+      // its store to parked_ before its final emptiness check.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (unlikely(parked_.load(std::memory_order_relaxed) != 0)) {
+        parked_.store(0, std::memory_order_relaxed);
+        futex_wake_all(&parked_);
+      }
+    }
+
+    /// Block the background thread until a work item is pushed, for at most
+    /// \p timeout_us. Only the background thread may call this.
+    void park(size_t timeout_us) {
+      parked_.store(1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);  // See above
+
+      if (ring_.empty()) futex_wait(&parked_, 1, timeout_us);
+      parked_.store(0, std::memory_order_relaxed);
+    }
+
+    MpscRing<BgWorkItem, kBgReqQueueSize> ring_;
+
+    /// Number of work items completed. Written only by the background thread.
+    std::atomic<size_t> num_done_{0};
+
+    /// Futex word that is non-zero while the background thread is parked
+    std::atomic<uint32_t> parked_{0};
+    const uint8_t pad_[64 - sizeof(size_t) - sizeof(uint32_t)] = {0};
+  };
+
   /// A hook created by an Rpc thread, and shared with the Nexus
   class Hook {
    public:
     uint8_t rpc_id_;  ///< ID of the Rpc that created this hook
 
     /// Background thread request queues, installed by the Nexus
-    MtQueue<BgWorkItem> *bg_req_queue_arr_[kMaxBgThreads] = {nullptr};
+    BgReqQueue *bg_req_queue_arr_[kMaxBgThreads] = {nullptr};
 
     /// The Rpc thread's session management RX queue, installed by the Rpc.
-    /// Work items from the SM thread for this Rpc are queued here.
-    MtQueue<SmWorkItem> sm_rx_queue_;
+    /// Packets from the SM thread for this Rpc are queued here.
+    SpscRing<SmPkt, kSmRxQueueSize> sm_rx_queue_;
+
+    /// The Rpc's eventfd for work queued by other threads, or -1. See
+    /// Rpc::get_event_fd().
+    int event_notify_fd_ = -1;
+
+    /// True while the Rpc thread may block on its event file descriptor
+    std::atomic<bool> event_waiting_{false};
+
+    /// Wake up the Rpc thread if it's waiting on its event file descriptor.
+    /// Threads must call this after queueing work for the Rpc.
+    void notify_event() {
+      // Order the queued work before reading event_waiting_. The Rpc thread
+      // orders its store to event_waiting_ before checking its queues.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (unlikely(event_waiting_.load(std::memory_order_relaxed)) &&
+          event_waiting_.exchange(false)) {
+        const uint64_t one = 1;
+        if (write(event_notify_fd_, &one, sizeof(one)) < 0) {
+          // The eventfd counter can't overflow here, so ignore errors
+        }
+      }
+    }
   };
 
   /// Check if a hook with for rpc_id exists in this Nexus. The caller must not
@@ -130,6 +236,10 @@ class Nexus {
   class BgThreadCtx {
    public:
     volatile bool *kill_switch_;  ///< The Nexus's kill switch
+    double freq_ghz_;             ///< RDTSC frequency
+
+    /// The Nexus's polling budget before parking (Nexus::set_bg_idle_spin_us)
+    volatile size_t *idle_spin_us_;
 
     /// The Nexus's request functions array. Unlike Rpc threads that create a
     /// copy of the Nexus's request functions, background threads have a
@@ -139,7 +249,7 @@ class Nexus {
 
     TlsRegistry *tls_registry_;          ///< The Nexus's thread-local registry
     size_t bg_thread_index_;             ///< Index of this background thread
-    MtQueue<BgWorkItem> *bg_req_queue_;  ///< Background thread request queue
+    BgReqQueue *bg_req_queue_;           ///< Background thread request queue
   };
 
   /// Session management thread context
@@ -188,8 +298,11 @@ class Nexus {
   HeartbeatMgr heartbeat_mgr_;  ///< The heartbeat manager
   volatile bool kill_switch_;   ///< Used to turn off SM and background threads
 
+  /// Background thread polling budget before parking
+  volatile size_t bg_idle_spin_us_ = kDefaultBgIdleSpinUs;
+
   std::thread sm_thread_;  ///< The session management thread
-  MtQueue<BgWorkItem> bg_req_queue_[kMaxBgThreads];  ///< Background req queues
+  BgReqQueue *bg_req_queue_[kMaxBgThreads] = {nullptr};  ///< Bg req queues
   std::thread bg_thread_arr_[kMaxBgThreads];  ///< Background thread context
 };
 }  // namespace erpc
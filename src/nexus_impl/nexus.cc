@@ -36,10 +36,13 @@ Nexus::Nexus(std::string local_uri, size_t numa_node, size_t num_bg_threads)
 
     BgThreadCtx bg_thread_ctx;
     bg_thread_ctx.kill_switch_ = &kill_switch_;
+    bg_thread_ctx.freq_ghz_ = freq_ghz_;
+    bg_thread_ctx.idle_spin_us_ = &bg_idle_spin_us_;
     bg_thread_ctx.req_func_arr_ = &req_func_arr_;
     bg_thread_ctx.tls_registry_ = &tls_registry_;
     bg_thread_ctx.bg_thread_index_ = i;
-    bg_thread_ctx.bg_req_queue_ = &bg_req_queue_[i];
+    bg_req_queue_[i] = new BgReqQueue();
+    bg_thread_ctx.bg_req_queue_ = bg_req_queue_[i];
 
     bg_thread_arr_[i] = std::thread(bg_thread_func, bg_thread_ctx);
 
@@ -81,6 +84,16 @@ void Nexus::print_stats() {
   } else {
     ERPC_INFO("[CPU_TIME] for sm_thread_ of nexus: %4jd.%03ld\n", (intmax_t) ts.tv_sec, ts.tv_nsec / 1000000);
   }
+
+  for (size_t i = 0; i < num_bg_threads_; i++) {
+    pthread_getcpuclockid(bg_thread_arr_[i].native_handle(), &cid);
+    if (clock_gettime(cid, &ts) == -1) {
+      ERPC_INFO("[ERROR] clock_gettime for background thread %zu", i);
+    } else {
+      ERPC_INFO("[CPU_TIME] for background thread %zu: %4jd.%03ld\n", i,
+                static_cast<intmax_t>(ts.tv_sec), ts.tv_nsec / 1000000);
+    }
+  }
 }
 
 Nexus::~Nexus() {
@@ -90,7 +103,10 @@ Nexus::~Nexus() {
   kill_switch_ = true;
 
   for (size_t i = 0; i < num_bg_threads_; i++) {
+    bg_req_queue_[i]->parked_.store(0);  // Don't wait for the park timeout
+    futex_wake_all(&bg_req_queue_[i]->parked_);
     bg_thread_arr_[i].join();
+    delete bg_req_queue_[i];
   }
 
   {
@@ -135,7 +151,7 @@ void Nexus::register_hook(Hook *hook) {
 
   // Install background request submission lists
   for (size_t i = 0; i < num_bg_threads_; i++) {
-    hook->bg_req_queue_arr_[i] = &bg_req_queue_[i];
+    hook->bg_req_queue_arr_[i] = bg_req_queue_[i];
   }
 
   reg_hooks_lock_.unlock();
@@ -154,6 +170,29 @@ void Nexus::unregister_hook(Hook *hook) {
 
 int Nexus::register_req_func(uint8_t req_type, erpc_req_func_t req_func,
                              ReqFuncType req_func_type) {
+  // Batch handlers are registered with the erpc_batch_req_func_t overload
+  if (req_func_type == ReqFuncType::kBatch) return -EINVAL;
+
+  int ret = check_req_func_registration(req_type, req_func == nullptr,
+                                        req_func_type);
+  if (ret != 0) return ret;
+
+  req_func_arr_[req_type] = ReqFunc(req_func, req_func_type);
+  return 0;
+}
+
+int Nexus::register_req_func(uint8_t req_type,
+                             erpc_batch_req_func_t batch_req_func) {
+  int ret = check_req_func_registration(req_type, batch_req_func == nullptr,
+                                        ReqFuncType::kBatch);
+  if (ret != 0) return ret;
+
+  req_func_arr_[req_type] = ReqFunc(batch_req_func);
+  return 0;
+}
+
+int Nexus::check_req_func_registration(uint8_t req_type, bool null_func,
+                                       ReqFuncType req_func_type) {
   char issue_msg[kMaxIssueMsgLen];  // The basic issue message
   sprintf(issue_msg,
           "eRPC Nexus: Failed to register handlers for request type %u. Issue",
@@ -165,14 +204,12 @@ int Nexus::register_req_func(uint8_t req_type, erpc_req_func_t req_func,
     return -EPERM;
   }
 
-  ReqFunc &arr_req_func = req_func_arr_[req_type];
-
   if (req_func_arr_[req_type].is_registered()) {
     ERPC_WARN("%s: Handler for this request type already exists.\n", issue_msg);
     return -EEXIST;
   }
 
-  if (req_func == nullptr) {
+  if (null_func) {
     ERPC_WARN("%s: Invalid handler.\n", issue_msg);
     return -EINVAL;
   }
@@ -182,7 +219,6 @@ int Nexus::register_req_func(uint8_t req_type, erpc_req_func_t req_func,
     return -EPERM;
   }
 
-  arr_req_func = ReqFunc(req_func, req_func_type);
   return 0;
 }
 }  // namespace erpc
@@ -1,12 +1,19 @@
 #include "common.h"
 #include "nexus.h"
+#include "rpc.h"
 #include "rpc_types.h"
 #include "session.h"
-#include "util/mt_queue.h"
 #include "req_handle.h"
 
 namespace erpc {
 
+/// Maximum number of work items a background thread dequeues at once
+static constexpr size_t kBgThreadBurstSize = 16;
+
+/// Maximum time a background thread stays parked without a wakeup. This
+/// bounds the time to notice the kill switch.
+static constexpr size_t kBgThreadParkTimeoutUs = 10000;
+
 void Nexus::bg_thread_func(BgThreadCtx ctx) {
   ERPC_INFO("invoke here........");
   ctx.tls_registry_->init();  // Initialize thread-local variables
@@ -17,25 +24,50 @@ void Nexus::bg_thread_func(BgThreadCtx ctx) {
   ERPC_INFO("eRPC Nexus: Background thread %zu running. Tiny TID = %zu.\n",
             ctx.bg_thread_index_, ctx.tls_registry_->get_etid());
 
+  BgWorkItem wi_arr[kBgThreadBurstSize];
+  size_t num_done = 0;
+  size_t idle_start_tsc = rdtsc();
   while (*ctx.kill_switch_ == false) {
-    if (ctx.bg_req_queue_->size_ == 0) {
-      // TODO: Put bg thread to sleep if it's idle for a long time
+    const size_t num_wi =
+        ctx.bg_req_queue_->ring_.pop_burst(wi_arr, kBgThreadBurstSize);
+    if (num_wi == 0) {
+      // Poll for the idle budget, then park until work arrives
+      const size_t spin_us = *ctx.idle_spin_us_;
+      if (spin_us != SIZE_MAX &&
+          rdtsc() - idle_start_tsc > us_to_cycles(spin_us, ctx.freq_ghz_)) {
+        ctx.bg_req_queue_->park(kBgThreadParkTimeoutUs);
+        idle_start_tsc = rdtsc();
+      }
       continue;
     }
 
-    while (ctx.bg_req_queue_->size_ > 0) {
-      BgWorkItem wi = ctx.bg_req_queue_->unlocked_pop();
+    for (size_t i = 0; i < num_wi; i++) {
+      const BgWorkItem &wi = wi_arr[i];
 
       if (wi.is_req()) {
         SSlot *s = wi.sslot_;  // For requests, we have a valid sslot
-        uint8_t req_type = s->server_info_.req_type_;
-        const ReqFunc &req_func = ctx.req_func_arr_->at(req_type);
-        req_func.req_func_(static_cast<ReqHandle *>(s), wi.context_);
+
+        // Don't run the handler for requests that expired in the queue
+        if (unlikely(Rpc<CTransport>::server_req_expired(s, rdtsc()))) {
+          wi.rpc_->enqueue_expired_response(s);
+        } else {
+          uint8_t req_type = s->server_info_.req_type_;
+          const ReqFunc &req_func = ctx.req_func_arr_->at(req_type);
+          s->server_info_.handler_tsc_ = rdtsc();  // For admission control
+          req_func.req_func_(static_cast<ReqHandle *>(s), wi.context_);
+        }
       } else {
         // For responses, we don't have a valid sslot
         wi.cont_func_(wi.context_, wi.tag_);
       }
+
+      // Dequeued items still count towards this thread's load until they are
+      // done, so that Rpc threads avoid a thread stuck on a long request
+      num_done++;
+      ctx.bg_req_queue_->num_done_.store(num_done, std::memory_order_relaxed);
     }
+
+    idle_start_tsc = rdtsc();
   }
 
   ERPC_INFO("eRPC Nexus: Background thread %zu exiting.\n",
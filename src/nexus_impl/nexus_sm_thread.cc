@@ -36,8 +36,12 @@ void Nexus::sm_thread_func(SmThreadCtx ctx) {
     Hook *target_hook = const_cast<Hook *>(ctx.reg_hooks_arr_[target_rpc_id]);
 
     if (target_hook != nullptr) {
-      target_hook->sm_rx_queue_.unlocked_push(
-          SmWorkItem(target_rpc_id, sm_pkt));
+      if (target_hook->sm_rx_queue_.try_push(sm_pkt)) {
+        target_hook->notify_event();
+      } else {
+        ERPC_WARN("eRPC SM thread: SM RX queue of Rpc %u full. Dropping %s.\n",
+                  target_rpc_id, sm_pkt.to_string().c_str());
+      }
     } else {
       // We don't have an Rpc object for the target Rpc. Send an error
       // response iff it's a request packet.
@@ -20,9 +20,12 @@ static constexpr size_t kHeadroomHackBits = 16;
 static constexpr size_t kMsgSizeBits = 24;  ///< Bits for message size
 static constexpr size_t kReqNumBits = 44;   ///< Bits for request number
 static constexpr size_t kPktNumBits = 14;   ///< Bits for packet number
+static constexpr size_t kDeadlineBits = 32;  ///< Bits for request deadline
+static constexpr size_t kPriorityBits = 2;   ///< Bits for request priority
+static_assert(kNumPriorities <= (1ull << kPriorityBits), "");
 
-/// Debug bits for packet header. Also useful for making the total size of all
-/// pkthdr_t bitfields equal to 128 bits, which makes copying faster.
+/// Debug bits for packet header. Also useful for making the total size of the
+/// first two sets of pkthdr_t bitfields equal to 128 bits.
 static const size_t k_pkt_hdr_magic_bits =
     128 -
     (kHeadroomHackBits + 8 + kMsgSizeBits + 16 + 2 + kPktNumBits + kReqNumBits);
@@ -72,6 +75,34 @@ struct pkthdr_t {
   uint64_t req_num_ : kReqNumBits;
   uint64_t magic_ : k_pkt_hdr_magic_bits;  ///< Magic from alloc_msg_buffer()
 
+  // The next set of fields goes in eight bytes total
+
+  /// The request's remaining time budget in microseconds when the client
+  /// transmitted it, or zero if the request has no deadline. Servers convert
+  /// it to a local deadline, since client and server clocks are unrelated.
+  uint64_t deadline_us_ : kDeadlineBits;
+
+  /// Set in a response iff the server dropped the request because its
+  /// deadline expired before the request handler could run
+  uint64_t expired_ : 1;
+
+  /// Set in a response iff the server shed the request because it was
+  /// overloaded
+  uint64_t overloaded_ : 1;
+
+  /// The request's priority class. Responses and control packets carry the
+  /// priority of their request.
+  uint64_t priority_ : kPriorityBits;
+
+  /// Set by the receiving transport iff the network marked this packet with
+  /// ECN Congestion Experienced. Never set by the sender.
+  uint64_t ecn_ce_ : 1;
+
+  /// Set in a credit return or response iff a request packet that it
+  /// acknowledges arrived with a CE mark
+  uint64_t ecn_echo_ : 1;
+  uint64_t reserved_ : 64 - kDeadlineBits - 4 - kPriorityBits;  ///< Zero
+
   /// Fill in packet header fields
   void format(uint64_t _req_type, uint64_t _msg_size,
               uint64_t _dest_session_num, uint64_t _pkt_type, uint64_t _pkt_num,
@@ -83,8 +114,14 @@ struct pkthdr_t {
     pkt_num_ = _pkt_num;
     req_num_ = _req_num;
     magic_ = kPktHdrMagic;
+    clear_word_2();
+    priority_ = kPriorityNormal;
   }
 
+  /// Zero the eight bytes of fields from deadline_us_ to reserved_, e.g., in
+  /// a reused MsgBuffer that holds the header of a received packet
+  inline void clear_word_2() { memset(ehdrptr() + 16, 0, sizeof(uint64_t)); }
+
   bool matches(PktType _pkt_type, uint64_t _pkt_num) const {
     return pkt_type_ == _pkt_type && pkt_num_ == _pkt_num;
   }
@@ -97,7 +134,13 @@ struct pkthdr_t {
         << "reqn " << std::to_string(req_num_) << ", "
         << "pktn " << std::to_string(pkt_num_) << ", "
         << "msz " << std::to_string(msg_size_) << ", "
-        << "magic " << std::to_string(magic_) << "]";
+        << "magic " << std::to_string(magic_) << ", "
+        << "dl_us " << std::to_string(deadline_us_) << ", "
+        << "exp " << std::to_string(expired_) << ", "
+        << "ovl " << std::to_string(overloaded_) << ", "
+        << "prio " << std::to_string(priority_) << ", "
+        << "ce " << std::to_string(ecn_ce_) << ", "
+        << "ece " << std::to_string(ecn_echo_) << "]";
 
     return ret.str();
   }
@@ -148,7 +191,7 @@ struct pkthdr_t {
 
 } __attribute__((packed));
 
-static_assert(sizeof(pkthdr_t) == kHeadroom + 16, "");
+static_assert(sizeof(pkthdr_t) == kHeadroom + 24, "");
 static_assert(sizeof(pkthdr_t) % sizeof(size_t) == 0, "");
 
 }  // namespace erpc
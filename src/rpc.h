@@ -12,11 +12,14 @@
 #include "session.h"
 #include "transport.h"
 #include "util/buffer.h"
+#include "util/dpath_memcpy.h"
 #include "util/fixed_queue.h"
 #include "util/huge_alloc.h"
+#include "util/latency.h"
 #include "util/logger.h"
-#include "util/mt_queue.h"
+#include "util/mpsc_ring.h"
 #include "util/rand.h"
+#include "util/spsc_ring.h"
 #include "util/timer.h"
 #include "util/udp_client.h"
 
@@ -73,6 +76,7 @@ namespace erpc {
 template <class TTr>
 class Rpc {
   friend class RpcTest;
+  friend class Nexus;  // For expiring requests in background threads
 
  private:
   /// Initial capacity of the hugepage allocator
@@ -172,6 +176,7 @@ class Rpc {
   static inline void resize_msg_buffer(MsgBuffer *msg_buffer,
                                        size_t new_data_size) {
     assert(new_data_size <= msg_buffer->max_data_size_);
+    assert(!msg_buffer->is_fragmented());
 
     // Avoid division for single-packet data sizes
     size_t new_num_pkts = data_size_to_num_pkts(new_data_size);
@@ -186,6 +191,67 @@ class Rpc {
     unlock_cond(&huge_alloc_lock_);
   }
 
+  /**
+   * @brief Create a scatter-gather fragment for enqueue_request_sg() or
+   * enqueue_response_sg() from a range of a MsgBuffer's data
+   *
+   * @param msg_buffer A MsgBuffer created by alloc_msg_buffer()
+   * @param offset The offset of the fragment's first byte in \p msg_buffer
+   * @param size The number of bytes in the fragment
+   */
+  static inline msg_frag_t make_msg_frag(const MsgBuffer *msg_buffer,
+                                         size_t offset, size_t size) {
+    assert(!msg_buffer->is_fragmented());
+    assert(offset + size <= msg_buffer->max_data_size_);
+    msg_frag_t frag;
+    frag.buf_ = msg_buffer->buf_ + offset;
+    frag.size_ = size;
+    frag.lkey_ = msg_buffer->buffer_.lkey_;
+    return frag;
+  }
+
+  /**
+   * @brief Register an application-owned memory region with this Rpc's
+   * transport, allowing responses to be sent from it without copying. Memory
+   * registration is slow, so this should be done at initialization, e.g., for
+   * a server's whole value store.
+   *
+   * @param buf The first byte of the region
+   * @param size The size of the region in bytes
+   * @param app_mem The registered region, valid only on success
+   *
+   * @return 0 on success, -EINVAL if the region is empty, and -ENOMEM if the
+   * transport failed to register the region
+   */
+  int register_app_mem(void *buf, size_t size, app_mem_t *app_mem);
+
+  /**
+   * @brief Deregister a region registered with register_app_mem(). There must
+   * be no response in flight from this region, i.e., all release callbacks
+   * for it must have been invoked.
+   */
+  void deregister_app_mem(app_mem_t *app_mem);
+
+  /**
+   * @brief Create a scatter-gather fragment for enqueue_response_sg() or
+   * enqueue_request_sg() from a range of an application-owned memory region
+   *
+   * @param app_mem A region registered with register_app_mem()
+   * @param buf The first byte of the fragment, which must lie in \p app_mem
+   * @param size The number of bytes in the fragment
+   */
+  static inline msg_frag_t make_app_msg_frag(const app_mem_t *app_mem,
+                                             const void *buf, size_t size) {
+    const auto *frag_buf = static_cast<const uint8_t *>(buf);
+    assert(frag_buf >= app_mem->buf_ &&
+           frag_buf + size <= app_mem->buf_ + app_mem->size_);
+    msg_frag_t frag;
+    frag.buf_ = frag_buf;
+    frag.size_ = size;
+    frag.lkey_ = app_mem->lkey_;
+    return frag;
+  }
+
   /**
    * @brief A session is a connection between two eRPC endpoints (similar to a
    * TCP connection). This function creates a session to a remote Rpc object and
@@ -226,6 +292,52 @@ class Rpc {
     return destroy_session_st(session_num);
   }
 
+  /**
+   * @brief Create a group of client sessions, e.g., to replicas of a service,
+   * for load balancing with get_group_session_num(). This must be called from
+   * the foreground thread.
+   *
+   * @return The group's ID, or -EINVAL if \p session_nums is empty or has a
+   * session number that is not a client session of this Rpc
+   */
+  int create_session_group(const std::vector<int> &session_nums);
+
+  /**
+   * @brief Pick a session from session group \p group_id for a new request,
+   * using power-of-two-choices: of two random members, pick the one with the
+   * lower load, i.e., outstanding requests times smoothed RTT. Sessions that
+   * are not connected (e.g., resetting) are skipped, and congested sessions
+   * are picked only if all connected members are congested. This must be
+   * called from the foreground thread.
+   *
+   * @return A connected session number, or -ENOTCONN if no member is connected
+   */
+  inline int get_group_session_num(int group_id) {
+    assert(in_dispatch());
+    assert(static_cast<size_t>(group_id) < session_group_vec_.size());
+    const std::vector<int> &group =
+        session_group_vec_[static_cast<size_t>(group_id)];
+
+    // Lemire's trick picks two distinct random members
+    const size_t n = group.size();
+    const size_t i = (static_cast<size_t>(fast_rand_.next_u32()) * n) >> 32;
+    size_t j = i;
+    if (likely(n > 1)) {
+      j = (static_cast<size_t>(fast_rand_.next_u32()) * (n - 1)) >> 32;
+      if (j >= i) j++;
+    }
+
+    const double load_i = group_session_load(group[i]);
+    const double load_j = group_session_load(group[j]);
+    const double min_load = (std::min)(load_i, load_j);
+    if (likely(min_load < kCongestedSessionLoad)) {
+      return load_i <= load_j ? group[i] : group[j];
+    }
+
+    // Both choices are congested or not connected
+    return pick_group_session_slow_st(group);
+  }
+
   /**
    * @brief Enqueue a request for transmission. This always succeeds. eRPC owns
    * the request and response msgbufs until it invokes the continuation
@@ -249,14 +361,138 @@ class Rpc {
    * @param tag A tag for this request that will be passed to the application
    * in the continuation callback
    *
-   * @param cont_etid The eRPC thread ID of the background thread to run the
-   * continuation on. The default value of \p kInvalidBgETid means that the
-   * continuation runs in the foreground. This argument is meant only for
-   * internal use by eRPC (i.e., user calls must ignore it).
+   * @param deadline_us If non-zero, the time budget for this request in
+   * microseconds, counted from this call. If the response hasn't been received
+   * by then, the continuation is invoked with a zero-size response (and the
+   * -ETIMEDOUT status in completion-queue mode). The budget is carried in the
+   * request's packets, so the server drops the request without running its
+   * handler if the request waits past its deadline at the server.
+   *
+   * @param priority The priority class of this request, e.g., kPriorityHigh.
+   * By default, this is the priority of \p req_type (see
+   * set_req_type_priority()). Packets of higher-priority requests get session
+   * credits and leave the timing wheel first, and are transmitted without
+   * waiting for the TX batch to fill. The server sends the response with the
+   * same priority.
    */
   void enqueue_request(int session_num, uint8_t req_type, MsgBuffer *req_msgbuf,
                        MsgBuffer *resp_msgbuf, erpc_cont_func_t cont_func,
-                       void *tag, size_t cont_etid = kInvalidBgETid);
+                       void *tag, size_t deadline_us = 0,
+                       uint8_t priority = kPriorityOfReqType);
+
+  /**
+   * @brief Set the priority class of requests of type \p req_type that don't
+   * specify a priority in enqueue_request(). The default is kPriorityNormal.
+   * This must be called from the foreground thread.
+   */
+  void set_req_type_priority(uint8_t req_type, uint8_t priority) {
+    assert(in_dispatch());
+    rt_assert(priority < kNumPriorities, "Invalid request priority");
+    req_type_priority_[req_type] = priority;
+  }
+
+  /**
+   * @brief Cancel the oldest incomplete request with tag \p tag. Its
+   * continuation is invoked before this function returns, with a zero-size
+   * response (and the -ECANCELED status in completion-queue mode), which
+   * returns the request's MsgBuffers to the application. If this is called
+   * from the batch continuation, the completion is delivered in the next
+   * batch.
+   *
+   * A request whose packets are still in flight completes the protocol with
+   * the server using eRPC-owned copies of its MsgBuffers, so its session slot
+   * and credits are reclaimed only when the server responds. This must be
+   * called from the foreground thread.
+   *
+   * @return 0 on success, -ENOENT if there is no such request, or -ENOMEM if
+   * the eRPC-owned MsgBuffers for an in-flight request can't be allocated. The
+   * request is then not cancelled, and completes as usual.
+   */
+  int cancel_request(void *tag);
+
+  /**
+   * @brief Enqueue a hedged request to cut tail latency with replicas. The
+   * request is sent on the primary session now, and a duplicate is sent on the
+   * backup session if no response arrives within the hedge delay (see
+   * set_hedge_policy()). The first response is placed in \p resp_msgbuf and
+   * the continuation is invoked once; the other copy is cancelled. If a copy
+   * fails, e.g., because its session is reset, the duplicate is sent at once,
+   * and the request fails only if both copies fail.
+   *
+   * The duplicate sends an eRPC-owned copy of \p req_msgbuf, which is not
+   * sent if it cannot be allocated. If the other copy has packets in flight
+   * when the continuation is invoked, it finishes with that copy, so the
+   * application gets \p req_msgbuf back unchanged. Hedged requests cannot be
+   * cancelled with cancel_request(). This must be called from the foreground
+   * thread.
+   *
+   * @param primary_session_num The connected client session to send the
+   * request on first
+   *
+   * @param backup_session_num The connected client session for the duplicate,
+   * which must differ from \p primary_session_num
+   *
+   * The other parameters are identical to enqueue_request().
+   *
+   * @return 0 on success, i.e., if the request was enqueued. -EINVAL if the
+   * sessions are invalid or \p req_msgbuf is fragmented. The continuation is
+   * not invoked on failure.
+   */
+  int enqueue_hedged_request(int primary_session_num, int backup_session_num,
+                             uint8_t req_type, MsgBuffer *req_msgbuf,
+                             MsgBuffer *resp_msgbuf, erpc_cont_func_t cont_func,
+                             void *tag);
+
+  /**
+   * @brief Set the hedge delay of hedged requests to the \p percentile-th
+   * quantile (in (0, 1]) of this Rpc's recent hedged-request latencies. Until
+   * enough latencies are observed, the delay is \p initial_delay_us. Latencies
+   * above 4 ms are counted as 4 ms.
+   */
+  void set_hedge_policy(double percentile, size_t initial_delay_us) {
+    assert(percentile > 0.0 && percentile <= 1.0);
+    hedge_percentile_ = percentile;
+    hedge_delay_cycles_ = us_to_cycles(initial_delay_us, freq_ghz_);
+    hedge_num_samples_ = 0;
+    hedge_latency_.reset();
+  }
+
+  /**
+   * @brief Enqueue a batch of requests for transmission, with the same
+   * semantics as calling enqueue_request() for each request in order. This is
+   * faster than individual calls because it checks the calling thread once,
+   * overlaps the cache misses on the batch's sessions and request headers, and
+   * handles each run of consecutive requests for one session in one pass.
+   * The requests' packets share TX bursts of up to TTr::kPostlist packets.
+   * This function is safe to call from background threads (TS).
+   *
+   * @param reqs The request descriptors. The descriptor array is not used
+   * after this function returns. Each descriptor's \p cont_etid_ must be
+   * \p kInvalidBgETid, which is the descriptor constructor's default. A
+   * descriptor's \p deadline_tsc_ is an absolute rdtsc() deadline, or zero.
+   * Its \p priority_ is a priority class, or kPriorityOfReqType.
+   *
+   * @param num_reqs The number of requests in \p reqs
+   */
+  void enqueue_request_batch(const enq_req_args_t *reqs, size_t num_reqs);
+
+  /// Capacity of a request submission ring created by create_submit_ring()
+  static constexpr size_t kSubmitRingSize = 256;
+
+  /// A request submission ring for one non-eRPC application thread
+  typedef SpscRing<enq_req_args_t, kSubmitRingSize> submit_ring_t;
+
+  /**
+   * @brief Create a request submission ring for an application thread that is
+   * not an eRPC thread, and therefore cannot call enqueue_request(). The
+   * thread submits request descriptors with the ring's try_push(), which
+   * fails if the ring is full. The event loop transmits submitted requests in
+   * order, and runs their continuations in the foreground.
+   *
+   * Each ring must have exactly one producer thread. The ring is owned by this
+   * Rpc and is destroyed with it. This function is not thread-safe.
+   */
+  submit_ring_t *create_submit_ring();
 
   /**
    * @brief Enqueue a response for transmission at the server. This must
@@ -276,14 +512,310 @@ class Rpc {
    * used for only responses that fit in one packet, in which case it is the
    * better choice.
    *
-   * @note The restriction on resp_msgbuf is inconvenient to the user because
-   * they cannot provide an arbitrary application-owned buffer. Unfortunately,
-   * supporting this feature will require passing the response MsgBuffer by
-   * value instead of reference since eRPC provides no application callback for
-   * when the response can be re-used or freed.
+   * @note To send a response from application-owned memory, register the
+   * memory with register_app_mem() and use enqueue_response_sg(), which
+   * provides a callback for when the memory can be re-used.
    */
   void enqueue_response(ReqHandle *req_handle, MsgBuffer *resp_msgbuf);
 
+  /**
+   * @brief Enqueue a request whose data is gathered from a list of fragments,
+   * avoiding a copy into one contiguous request MsgBuffer. The transport
+   * gathers the fragments per packet. This function is safe to call from
+   * background threads (TS).
+   *
+   * The fragment array is copied, so it may be on the caller's stack. The
+   * fragments' data is owned by eRPC until the continuation is invoked, like
+   * a request MsgBuffer for enqueue_request().
+   *
+   * @param frags The fragments, created with make_msg_frag(). Their total size
+   * must not exceed get_max_msg_size(), and no packet's data may span more
+   * than TTr::kMaxFragsPerPkt fragments.
+   *
+   * @param num_frags The number of fragments in \p frags
+   *
+   * The other parameters are identical to enqueue_request().
+   *
+   * @return 0 on success, i.e., if the request was enqueued. Negative errno if
+   * the fragments are invalid or eRPC ran out of hugepage memory for packet
+   * headers. The continuation is not invoked on failure.
+   */
+  int enqueue_request_sg(int session_num, uint8_t req_type,
+                         const msg_frag_t *frags, size_t num_frags,
+                         MsgBuffer *resp_msgbuf, erpc_cont_func_t cont_func,
+                         void *tag);
+
+  /**
+   * @brief Enqueue a response whose data is gathered from a list of fragments.
+   * This function is safe to call from background threads (TS).
+   *
+   * eRPC creates the response in the request handle's dynamic response
+   * MsgBuffer, which must be unused. Only packet headers are allocated, so the
+   * response data is transmitted directly from the fragments. The fragments'
+   * data must remain valid and unmodified until eRPC receives the next request
+   * on this request's session slot, since the response may be retransmitted
+   * until then.
+   *
+   * @param release_func An optional callback invoked in the foreground thread
+   * when eRPC no longer needs the fragments' data, e.g., to unpin a value in
+   * an application-owned store. It is not invoked on failure.
+   *
+   * @param release_tag The tag passed to \p release_func
+   *
+   * @return 0 on success. Negative errno if the fragments are invalid or eRPC
+   * ran out of hugepage memory, in which case the application still owns the
+   * request handle and must send a response.
+   */
+  int enqueue_response_sg(ReqHandle *req_handle, const msg_frag_t *frags,
+                          size_t num_frags,
+                          erpc_release_func_t release_func = nullptr,
+                          void *release_tag = nullptr);
+
+  /**
+   * @brief Allow this Rpc to deliver multi-packet messages as fragmented
+   * MsgBuffers that reference the received packets in place, instead of
+   * copying the packets into a contiguous MsgBuffer. This avoids a copy of
+   * every large request and response byte.
+   *
+   * This applies to requests for foreground request handlers, and responses
+   * for continuations that run in the foreground. Handlers and continuations
+   * must then read data with MsgBuffer::get_frag() or MsgBuffer::get_iovec().
+   * MsgBuffer::buf_ of a fragmented MsgBuffer points to the first fragment
+   * only, so the rest of the message cannot be read through it.
+   * A message is copied as before if the transport cannot hold its packets.
+   *
+   * A fragmented request is released on enqueue_response(). A fragmented
+   * response must be released with release_msg_frags() before its MsgBuffer
+   * is reused or freed.
+   *
+   * @return 0 on success, -ENOTSUP if the transport cannot hold packets
+   */
+  int enable_frag_rx() {
+    assert(in_dispatch());
+    rx_hold_capacity_ = transport_->enable_rx_hold();
+    if (rx_hold_capacity_ == 0) return -ENOTSUP;
+
+    // Preallocate one fragment array of each size that can be held
+    for (size_t i = 0; i <= get_frag_arr_class(rx_hold_capacity_); i++) {
+      if (frag_arr_pool_[i].empty()) extend_frag_arr_pool_st(i);
+    }
+
+    frag_rx_ = true;
+    return 0;
+  }
+
+  /**
+   * @brief Release the packets referenced by a fragmented response MsgBuffer.
+   * The MsgBuffer becomes contiguous again, with undefined contents. This
+   * does nothing for contiguous MsgBuffers. This must be called from the
+   * foreground thread.
+   */
+  void release_msg_frags(MsgBuffer *resp_msgbuf) {
+    assert(in_dispatch());
+    if (resp_msgbuf->is_fragmented()) release_rx_frags_st(resp_msgbuf);
+  }
+
+  /**
+   * @brief Enable completion-queue mode, in which requests with foreground
+   * continuations don't invoke their continuation. Instead, eRPC appends a
+   * completion with the request's tag, status, and response size to a
+   * completion queue in this Rpc, keeping the application's processing out
+   * of eRPC's packet RX loop. The continuation passed to enqueue_request()
+   * may then be null. Requests with background continuations are unaffected.
+   *
+   * A failed request (e.g., due to a session reset) has a negative status.
+   * Ownership of the request and response MsgBuffers returns to the
+   * application when its completion is queued.
+   *
+   * @param batch_cont_func If non-null, eRPC invokes it with all queued
+   * completions after processing each burst of received packets. Completions
+   * caused by the callback itself are delivered on the next call. Otherwise,
+   * the application must drain the queue with poll_completions(), e.g., after
+   * each call to run_event_loop_once().
+   */
+  void enable_completion_queue(erpc_batch_cont_func_t batch_cont_func) {
+    assert(in_dispatch());
+    comp_queue_mode_ = true;
+    batch_cont_func_ = batch_cont_func;
+    comp_queue_.reserve(kSessionReqWindow * TTr::kPostlist);
+    comp_deliver_queue_.reserve(kSessionReqWindow * TTr::kPostlist);
+  }
+
+  /**
+   * @brief Dequeue up to \p max_comps completions, oldest first. This must be
+   * called from the foreground thread.
+   *
+   * @return The number of completions written to \p comps
+   */
+  size_t poll_completions(completion_t *comps, size_t max_comps) {
+    assert(in_dispatch());
+    const size_t n =
+        (std::min)(max_comps, comp_queue_.size() - comp_queue_head_);
+    memcpy(comps, &comp_queue_[comp_queue_head_], n * sizeof(completion_t));
+    comp_queue_head_ += n;
+
+    if (comp_queue_head_ == comp_queue_.size()) {
+      comp_queue_.clear();
+      comp_queue_head_ = 0;
+    }
+    return n;
+  }
+
+  /**
+   * @brief Return the status of the request whose foreground continuation is
+   * running, i.e., the status that completion-queue mode would report. For
+   * example, -EBUSY means that the server shed the request because it was
+   * overloaded, so the client should back off.
+   */
+  int get_cont_status() const {
+    assert(in_dispatch());
+    return cont_status_;
+  }
+
+  /**
+   * @brief Enable CoDel admission control for requests received by this Rpc.
+   * The server measures each request's queueing delay, from receiving it
+   * (including time in the RX ring with packet timestamps) to the start of
+   * its request handler, which includes waiting for a background thread. If
+   * the delay stays above \p target_us for \p interval_us, there is a
+   * standing queue, so the server sheds one new request, and then the next
+   * one after interval / sqrt(count) for the count-th shed request, until the
+   * delay falls below the target. A shed request gets an empty "overloaded"
+   * response without running its handler. Clients see an -EBUSY status for
+   * shed requests. This must be called from the foreground thread.
+   *
+   * @param target_us The target delay. Zero disables admission control.
+   * @param interval_us The interval, which should be a few times the typical
+   * delay
+   */
+  void set_admission_control(size_t target_us, size_t interval_us) {
+    assert(in_dispatch());
+    admission_.target_cycles_ = us_to_cycles(target_us, freq_ghz_);
+    admission_.interval_cycles_ = us_to_cycles(interval_us, freq_ghz_);
+    admission_.first_above_tsc_ = 0;
+    admission_.dropping_ = false;
+    admission_.count_ = 0;
+  }
+
+  /// Return the number of requests shed by admission control
+  size_t get_num_shed_reqs() const { return admission_.num_shed_; }
+
+  /**
+   * @brief Enable shortest-remaining-processing-time (SRPT) scheduling of
+   * client packets. By default, a request that has credits keeps sending,
+   * and requests that wait for credits are served in arrival order. With
+   * SRPT, each session's credits go to its requests with the fewest packets
+   * left to transmit, which cuts the mean completion time for mixed message
+   * sizes. Request priority classes still take precedence. This must be
+   * called from the foreground thread before requests are enqueued.
+   *
+   * @param aging_us To avoid starving large messages, a request's count of
+   * packets left is reduced by one for every \p aging_us that passed since it
+   * was enqueued. Zero disables aging.
+   */
+  void enable_srpt_scheduling(size_t aging_us) {
+    assert(in_dispatch());
+    srpt_.enabled_ = true;
+    srpt_.aging_per_cycle_ =
+        aging_us == 0 ? 0.0 : 1.0 / us_to_cycles(aging_us, freq_ghz_);
+  }
+
+  /**
+   * @brief Enable receiver-driven, grant-based congestion control for this
+   * Rpc, in the spirit of Homa. This replaces sender-side rate updates for the
+   * requests that this Rpc sends, and it schedules the requests that this Rpc
+   * receives.
+   *
+   * As a client, the Rpc sends the first \p unsched_pkts packets of each
+   * request without waiting, and every later packet only after a grant. The
+   * server's credit returns are the grants.
+   *
+   * As a server, the Rpc defers the credit returns for multi-packet requests.
+   * It grants packets to the requests with the fewest packets left to
+   * receive, with at most \p max_granted_pkts granted packets in flight
+   * across all requests. Senders that don't use grants interoperate.
+   *
+   * This must be called from the foreground thread before sessions are
+   * created.
+   *
+   * @param unsched_pkts The unscheduled prefix of each request in packets,
+   * typically about one bandwidth-delay product
+   * @param max_granted_pkts The maximum number of granted packets in flight
+   */
+  void enable_grant_cc(size_t unsched_pkts, size_t max_granted_pkts) {
+    assert(in_dispatch());
+    rt_assert(unsched_pkts >= 1 && unsched_pkts <= kSessionCredits,
+              "Invalid unscheduled packets for grant CC");
+    rt_assert(max_granted_pkts >= 1, "Invalid granted packets for grant CC");
+    grant_.enabled_ = true;
+    grant_.unsched_pkts_ = unsched_pkts;
+    grant_.max_granted_pkts_ = max_granted_pkts;
+  }
+
+  /**
+   * @brief Let run_event_loop() park this thread after the Rpc has been idle
+   * for \p spin_us. An Rpc is idle when it receives no packets and has no
+   * queued packets or background-thread work. A parked thread uses no CPU,
+   * and wakes up when a packet is received, or after at most #kMaxParkUs to
+   * run timers and process session management and background thread work.
+   * By default, the event loop polls without parking.
+   *
+   * @param spin_us The polling budget in microseconds. SIZE_MAX disables
+   * parking.
+   *
+   * @return 0 on success, or -ENOTSUP if the transport does not support
+   * waiting for packets
+   */
+  int set_idle_spin_us(size_t spin_us) {
+    if (spin_us == SIZE_MAX) {
+      idle_spin_cycles_ = SIZE_MAX;
+      return 0;
+    }
+
+    if (transport_->get_rx_event_fd() == -1) return -ENOTSUP;
+    idle_spin_cycles_ = us_to_cycles(spin_us, freq_ghz_);
+    return 0;
+  }
+
+  /// Maximum time for which run_event_loop() parks the thread at once
+  static constexpr size_t kMaxParkUs = 1000;
+
+  /**
+   * @brief Return a file descriptor for running this Rpc from an external
+   * event loop (e.g., epoll). After arm_event_fd() returns true, the
+   * descriptor becomes readable when a packet is received, or when another
+   * thread queues work for this Rpc. The application then calls
+   * run_event_loop_once() until it's done, and re-arms the descriptor.
+   *
+   * The external event loop must also wait for at most next_deadline_ns() so
+   * that eRPC does not miss retransmission and pacing deadlines.
+   *
+   * @return The file descriptor, or negative errno on failure. -ENOTSUP means
+   * that the transport does not support waiting for packets.
+   */
+  int get_event_fd();
+
+  /**
+   * @brief Prepare to wait on the descriptor from get_event_fd(), clearing
+   * previous notifications
+   *
+   * @return True if the caller may wait on the descriptor, false if this Rpc
+   * already has work, in which case the caller must run the event loop
+   */
+  bool arm_event_fd();
+
+  /**
+   * @brief Return the time in nanoseconds before which the event loop must run
+   * even without notifications on the event descriptor, e.g., for packet loss
+   * detection or paced packets. Zero means that the event loop has work now,
+   * and SIZE_MAX means that there is no deadline.
+   */
+  size_t next_deadline_ns() const;
+
+  /// Make the event descriptor readable. This is safe to call from any thread,
+  /// e.g., after pushing to a submit ring (see create_submit_ring()).
+  void notify_event_fd() { nexus_hook_.notify_event(); }
+
   /// Run the event loop for some milliseconds. See Rpc::run_event_loop_once()
   /// for more on eRPC's event loop.
   inline void run_event_loop(size_t timeout_ms) {
@@ -346,10 +878,101 @@ class Rpc {
     return ret;
   }
 
-  /// Return the Timely instance for a connected session. Expert use only.
-  Timely *get_timely(int session_num) {
+  /**
+   * @brief Cap the sending rate of a client session at \p bytes_per_sec,
+   * whatever its congestion control policy says. Packets of a capped session
+   * are always paced by the timing wheel. This must be called from the
+   * foreground thread.
+   *
+   * @param bytes_per_sec The rate cap, which must be at least kMinRateLimit.
+   * It may be below the congestion control policy's minimum rate. Zero
+   * removes the cap.
+   *
+   * @return 0 on success, -EINVAL if the session is not a client session or
+   * the rate is too low, or -ENOTSUP if packet pacing is disabled
+   */
+  int set_session_rate_limit(int session_num, double bytes_per_sec) {
+    assert(in_dispatch());
+    if (!kCcPacing) return -ENOTSUP;
+    if (!is_usr_session_num_in_range_st(session_num)) return -EINVAL;
+
+    Session *session = session_vec_[static_cast<size_t>(session_num)];
+    if (session == nullptr || !session->is_client()) return -EINVAL;
+    if (bytes_per_sec != 0.0 && bytes_per_sec < kMinRateLimit) {
+      return -EINVAL;
+    }
+
+    session->client_info_.cc_.rate_limit_ = bytes_per_sec;
+    return 0;
+  }
+
+  /**
+   * @brief Cap the total sending rate of this Rpc's client sessions at
+   * \p bytes_per_sec, on top of any per-session caps. With a total cap, all
+   * client packets are paced by the timing wheel. This must be called from the
+   * foreground thread.
+   *
+   * @param bytes_per_sec The rate cap, which must be at least kMinRateLimit.
+   * It may be below the congestion control policy's minimum rate. Zero
+   * removes the cap.
+   *
+   * @return 0 on success, -EINVAL if the rate is too low, or -ENOTSUP if
+   * packet pacing is disabled
+   */
+  int set_total_rate_limit(double bytes_per_sec) {
+    assert(in_dispatch());
+    if (!kCcPacing) return -ENOTSUP;
+    if (bytes_per_sec != 0.0 && bytes_per_sec < kMinRateLimit) {
+      return -EINVAL;
+    }
+
+    total_rate_limit_.rate_ = bytes_per_sec;
+    total_rate_limit_.prev_desired_tx_tsc_ = rdtsc();
+    return 0;
+  }
+
+  /**
+   * @brief Use ECN marks as a congestion signal, in addition to RTT. The
+   * transport marks this Rpc's packets as ECN-capable, and reports packets
+   * that the network marked with Congestion Experienced (CE). As a server, the
+   * Rpc echoes CE marks on request and RFR packets in its credit returns and
+   * responses. As a client, the Rpc feeds echoed marks, and CE marks on
+   * responses, to the congestion control policy, which cuts the rate
+   * DCTCP-style. Both endpoints must enable ECN. This must be called from the
+   * foreground thread before sessions are created.
+   *
+   * @return 0 on success, or -ENOTSUP if the transport can't read ECN marks or
+   * rate-based congestion control is disabled
+   */
+  int enable_ecn() {
+    assert(in_dispatch());
+    if (!kCcRateComp || !transport_->enable_ecn()) return -ENOTSUP;
+    ecn_enabled_ = true;
+    return 0;
+  }
+
+  /**
+   * @brief Take RTT samples from kernel or NIC packet timestamps instead of
+   * the event loop's TSC. With kernel-based transports, the event loop may
+   * see a packet long after it arrived, which inflates RTT samples. Packets
+   * without a timestamp fall back to the event loop's TSC. This must be called
+   * from the foreground thread.
+   *
+   * @return 0 on success, or -ENOTSUP if the transport doesn't support
+   * timestamps or RTT measurement is disabled
+   */
+  int enable_pkt_timestamps() {
+    assert(in_dispatch());
+    if (!kCcRTT || !transport_->enable_timestamps(freq_ghz_)) return -ENOTSUP;
+    pkt_timestamps_ = true;
+    return 0;
+  }
+
+  /// Return the congestion control policy instance for a connected session.
+  /// Expert use only.
+  CCongestionControl *get_cc(int session_num) {
     Session *session = session_vec_[static_cast<size_t>(session_num)];
-    return &session->client_info_.cc_.timely_;
+    return &session->client_info_.cc_.policy_;
   }
 
   /// Return the Timing Wheel for this Rpc. Expert use only.
@@ -503,7 +1126,11 @@ class Rpc {
     // This high-specificity checks prevents freeing a null tx_msgbuf.
     if (sslot->tx_msgbuf_ == &sslot->dyn_resp_msgbuf_) {
       MsgBuffer *tx_msgbuf = sslot->tx_msgbuf_;
-      free_msg_buffer(*tx_msgbuf);
+      if (unlikely(tx_msgbuf->is_fragmented())) {
+        free_sg_msg_buffer(tx_msgbuf);  // Invokes the release callback
+      } else {
+        free_msg_buffer(*tx_msgbuf);
+      }
       // Need not nullify tx_msgbuf->buffer.buf: we'll just nullify tx_msgbuf
     }
 
@@ -522,11 +1149,96 @@ class Rpc {
     if (unlikely(req_msgbuf.is_dynamic())) {
       free_msg_buffer(req_msgbuf);
       req_msgbuf.buffer_.buf_ = nullptr;  // Mark invalid for future
+    } else if (unlikely(req_msgbuf.is_fragmented())) {
+      release_rx_frags_st(&req_msgbuf);
     }
 
     req_msgbuf.buf_ = nullptr;
   }
 
+  //
+  // Fragmented reception of multi-packet messages
+  //
+
+  /// Return true iff a message with \p num_pkts packets can be received as a
+  /// fragmented MsgBuffer
+  inline bool can_frag_rx_st(size_t num_pkts) const {
+    return frag_rx_ && rx_pkts_held_ + num_pkts <= rx_hold_capacity_;
+  }
+
+  /// Return the class of fragment arrays in frag_arr_pool_ that fit
+  /// \p num_frags fragments
+  static inline size_t get_frag_arr_class(size_t num_frags) {
+    assert(num_frags >= 1);
+    return msb_index(static_cast<int>(num_frags - 1));
+  }
+
+  /// Add one fragment array of class \p frag_arr_class to frag_arr_pool_.
+  /// The arrays are freed with the hugepage allocator.
+  void extend_frag_arr_pool_st(size_t frag_arr_class) {
+    rt_assert(frag_arr_class < kNumFragArrClasses, "Too many fragments");
+    Buffer buffer =
+        huge_alloc_->alloc(sizeof(msg_frag_t) * (1ull << frag_arr_class));
+    rt_assert(buffer.buf_ != nullptr, "Hugepage allocation failed");
+    frag_arr_pool_[frag_arr_class].push_back(
+        reinterpret_cast<msg_frag_t *>(buffer.buf_));
+  }
+
+  /// Start fragmented reception into \p msgbuf, reserving packet holds for
+  /// all its packets
+  inline void start_frag_rx_st(MsgBuffer *msgbuf) {
+    assert(can_frag_rx_st(msgbuf->num_pkts_));
+    rx_pkts_held_ += msgbuf->num_pkts_;
+
+    std::vector<msg_frag_t *> &pool =
+        frag_arr_pool_[get_frag_arr_class(msgbuf->num_pkts_)];
+    if (unlikely(pool.empty())) {
+      extend_frag_arr_pool_st(get_frag_arr_class(msgbuf->num_pkts_));
+    }
+    msgbuf->frags_ = pool.back();
+    pool.pop_back();
+    msgbuf->num_frags_ = 0;
+  }
+
+  /// Hold the packet that is being processed, and append its data to
+  /// fragmented MsgBuffer \p msgbuf as the next fragment
+  inline void hold_rx_pkt_st(MsgBuffer *msgbuf, const pkthdr_t *pkthdr) {
+    const size_t ring_idx = (rx_ring_head_ + TTr::kNumRxRingEntries - 1) %
+                            TTr::kNumRxRingEntries;  // Advanced before process
+    assert(rx_ring_[ring_idx] == reinterpret_cast<const uint8_t *>(pkthdr));
+    uint8_t *pkt = transport_->hold_rx_pkt(ring_idx);
+
+    const size_t offset = msgbuf->num_frags_ * TTr::kMaxDataPerPkt;
+    msg_frag_t &frag = msgbuf->frags_[msgbuf->num_frags_++];
+    frag.buf_ = pkt + sizeof(pkthdr_t);
+    frag.size_ = (std::min)(TTr::kMaxDataPerPkt, pkthdr->msg_size_ - offset);
+    frag.lkey_ = 0;  // Received data is not used for TX
+
+    // buf points to the first fragment, whose packet header is header 0
+    if (msgbuf->num_frags_ == 1) msgbuf->buf_ = pkt + sizeof(pkthdr_t);
+  }
+
+  /// Return the held packets of fragmented MsgBuffer \p msgbuf to the
+  /// transport, including the holds reserved for packets not yet received
+  inline void release_rx_frags_st(MsgBuffer *msgbuf) {
+    assert(msgbuf->is_fragmented());
+    for (size_t i = 0; i < msgbuf->num_frags_; i++) {
+      transport_->release_rx_pkt(
+          const_cast<uint8_t *>(msgbuf->frags_[i].buf_) - sizeof(pkthdr_t));
+    }
+
+    rx_pkts_held_ -= msgbuf->num_pkts_;
+    frag_arr_pool_[get_frag_arr_class(msgbuf->num_pkts_)].push_back(
+        msgbuf->frags_);
+    msgbuf->frags_ = nullptr;
+    msgbuf->num_frags_ = 0;
+
+    // Point a response MsgBuffer back at its own data
+    if (msgbuf->is_dynamic()) {
+      msgbuf->buf_ = msgbuf->buffer_.buf_ + sizeof(pkthdr_t);
+    }
+  }
+
   //
   // Handle available ring entries
   //
@@ -552,12 +1264,359 @@ class Rpc {
   // Datapath helpers
   //
 
+  /// Enqueue a request on \p session in the dispatch thread. This is the
+  /// dispatch-thread part of enqueue_request().
+  inline void enqueue_request_st(Session *session,
+                                 const enq_req_args_t &req_args);
+
+  /// Fill in a free sslot and the packet headers for a new request on
+  /// \p session, without transmitting. If no sslot is free, save the request
+  /// to the session's backlog.
+  ///
+  /// @return The request's sslot, or nullptr if the request was saved
+  inline SSlot *init_req_sslot_st(Session *session,
+                                  const enq_req_args_t &req_args);
+
+  /// Transmit the first packets of a request that init_req_sslot_st()
+  /// prepared, or stall it if the session cannot send now
+  inline void start_req_st(Session *session, SSlot *sslot) {
+    if (likely(session->client_info_.credits_ > 0 && !srpt_.enabled_)) {
+      kick_req_st(sslot);
+    } else {
+      stall_sslot_st(sslot);
+    }
+  }
+
+  /// Complete a request whose continuation runs in the foreground, either by
+  /// invoking the continuation or by queueing a completion
+  inline void complete_fg_req_st(erpc_cont_func_t cont_func, void *tag,
+                                 int status, size_t resp_size) {
+    if (unlikely(cont_func == hedge_cont_func)) {
+      complete_hedge_st(static_cast<hedge_copy_t *>(tag), status, resp_size);
+      return;
+    }
+
+    if (unlikely(comp_queue_mode_)) {
+      comp_queue_.emplace_back(tag, status, resp_size);
+    } else {
+      cont_status_ = status;
+      cont_func(context_, tag);
+    }
+  }
+
+  /// Enqueue a request saved by eRPC, e.g., in a session's backlog or a
+  /// background queue, keeping its continuation thread and deadline
+  void enqueue_saved_request_st(const enq_req_args_t &req_args);
+
+  /// Move the oldest backlogged request of \p session, if any, to the session
+  /// slot that was just freed
+  inline void dequeue_backlog_st(Session *session) {
+    auto &backlog = session->client_info_.enq_req_backlog_;
+    if (backlog.empty()) return;
+
+    // We just got a new sslot, and we should have no more if there's backlog
+    assert(session->client_info_.sslot_free_vec_.size() == 1);
+    const enq_req_args_t req_args = backlog.front();
+    backlog.pop();
+    enqueue_saved_request_st(req_args);
+  }
+
+  //
+  // Request deadlines and cancellation
+  //
+
+  /// Return the time budget carried in the packets of a request with deadline
+  /// \p deadline_tsc, which is at least one microsecond
+  inline size_t deadline_tsc_to_us(size_t deadline_tsc, size_t cur_tsc) const {
+    if (deadline_tsc <= cur_tsc) return 1;
+    const double us = to_usec(deadline_tsc - cur_tsc, freq_ghz_);
+    if (us >= static_cast<double>(kMaxDeadlineUs)) return kMaxDeadlineUs;
+    return us < 1.0 ? 1 : static_cast<size_t>(us);
+  }
+
+  /// Largest time budget that fits in the packet header
+  static constexpr size_t kMaxDeadlineUs = (1ull << kDeadlineBits) - 1;
+
+  /// Record the local deadline of a new request at the server
+  inline void set_server_deadline_st(SSlot *sslot, const pkthdr_t *pkthdr) {
+    sslot->server_info_.deadline_tsc_ =
+        pkthdr->deadline_us_ == 0
+            ? 0
+            : ev_loop_tsc_ + us_to_cycles(pkthdr->deadline_us_, freq_ghz_);
+  }
+
+  /// Return true iff the request at server sslot \p sslot is expired at \p tsc
+  static inline bool server_req_expired(const SSlot *sslot, size_t tsc) {
+    return sslot->server_info_.deadline_tsc_ != 0 &&
+           tsc > sslot->server_info_.deadline_tsc_;
+  }
+
+  /// Respond to an expired request with an empty response marked as expired,
+  /// instead of running its request handler. This function is safe to call
+  /// from background threads (TS).
+  void enqueue_expired_response(SSlot *sslot);
+
+  /// Return a request's MsgBuffers to the application with a zero-size
+  /// response and failure \p status
+  void fail_req_st(const enq_req_args_t &req_args, int status);
+
+  /// Return the client sslot of the active, uncancelled request with tag
+  /// \p tag, or nullptr if there's none
+  SSlot *find_active_req_st(void *tag);
+
+  /// Remove the first backlogged request with tag \p tag and save its
+  /// arguments in \p req_args. Return false if there's no such request.
+  bool remove_backlogged_req_st(void *tag, enq_req_args_t *req_args);
+
+  /// Release client sslot \p sslot of a request that has no packets sent. The
+  /// server hasn't seen the request, so its request number is rolled back.
+  void release_unsent_req_st(SSlot *sslot);
+
+  /// Fail the request in client sslot \p sslot with \p status. A request with
+  /// no packets sent releases its sslot now. Otherwise, the request is
+  /// cancelled: it keeps its sslot until the server responds.
+  ///
+  /// @return 0 on success, or -ENOMEM if the eRPC-owned MsgBuffers for a
+  /// cancelled request can't be allocated. The request is then left untouched.
+  int abort_req_st(SSlot *sslot, int status);
+
+  /// Free the eRPC-owned MsgBuffers of cancelled request sslot \p sslot
+  void free_cancelled_msgbufs_st(SSlot *sslot);
+
+  /// Fail the backlogged and active requests whose deadline has passed
+  void expire_reqs_st();
+
+  //
+  // Request hedging
+  //
+
+  struct hedge_t;
+
+  /// One of the two copies of a hedged request. A copy's tag is a pointer to
+  /// its hedge_copy_t, and its continuation is hedge_cont_func.
+  struct hedge_copy_t {
+    hedge_t *hedge_;
+    bool live_;  ///< True iff this copy is enqueued and hasn't completed
+  };
+
+  /// A hedged request
+  struct hedge_t {
+    // The application's request
+    MsgBuffer *req_msgbuf_;
+    MsgBuffer *resp_msgbuf_;
+    erpc_cont_func_t cont_func_;
+    void *tag_;
+    uint8_t req_type_;
+    int backup_session_num_;
+
+    size_t start_tsc_;  ///< Time when the primary copy was enqueued
+    size_t hedge_tsc_;  ///< Time when the backup copy is due
+    bool in_pending_;   ///< True iff this is in hedge_pending_vec_
+    bool backup_sent_;  ///< True iff the backup copy was enqueued
+    bool done_;         ///< True iff the application got the completion
+
+    /// Number of cancelled copies still in flight. They reference the
+    /// request's buffer and the eRPC-owned response buffer until their
+    /// response arrives or their session is reset.
+    size_t refcnt_;
+
+    /// eRPC-owned copy of the request, sent by the backup copy, and by a
+    /// primary copy cancelled in flight. buf_ is null if not allocated.
+    MsgBuffer own_req_msgbuf_;
+
+    /// eRPC-owned response of the backup copy, or of a cancelled copy. buf_ is
+    /// null if not allocated.
+    MsgBuffer own_resp_msgbuf_;
+
+    hedge_copy_t copies_[2];  ///< The primary and backup copies
+  };
+
+  /// Number of hedge records allocated at a time
+  static constexpr size_t kHedgePoolChunk = 64;
+
+  /// The hedge delay until set_hedge_policy() or the first delay update
+  static constexpr size_t kDefaultHedgeDelayUs = 100;
+
+  /// Number of latency samples between hedge delay updates
+  static constexpr size_t kHedgeUpdateSamples = 256;
+
+  /// Number of latency samples after which older samples are discarded
+  static constexpr size_t kHedgeHistorySamples = 16 * kHedgeUpdateSamples;
+
+  /// The continuation of hedged request copies. It's never invoked, since
+  /// complete_fg_req_st() diverts hedged copies to complete_hedge_st().
+  static void hedge_cont_func(void *, void *) {}
+
+  /// Enqueue the backup copy of hedged request \p hedge if its backup session
+  /// is still connected
+  void send_hedge_backup_st(hedge_t *hedge);
+
+  /// Handle the completion of one copy of a hedged request
+  void complete_hedge_st(hedge_copy_t *copy, int status, size_t resp_size);
+
+  /// Cancel the losing copy \p copy of a decided hedged request without
+  /// invoking a continuation. A copy with packets in flight keeps its sslot
+  /// and shares the hedge's buffers until its response arrives.
+  void cancel_hedge_copy_st(hedge_copy_t *copy);
+
+  /// Drop the reference of a cancelled copy of \p hedge that finished
+  void release_hedge_st(hedge_t *hedge) {
+    assert(hedge->refcnt_ > 0);
+    hedge->refcnt_--;
+    free_hedge_if_unused_st(hedge);
+  }
+
+  /// Free the buffers of \p hedge if no copy uses them, and return it to the
+  /// pool if it's also out of hedge_pending_vec_
+  void free_hedge_if_unused_st(hedge_t *hedge);
+
+  /// Free the eRPC-owned MsgBuffers of \p hedge that are allocated
+  void free_hedge_msgbufs_st(hedge_t *hedge);
+
+  /// Add kHedgePoolChunk hedge records to hedge_free_vec_
+  void extend_hedge_pool_st() {
+    auto *hedges = new hedge_t[kHedgePoolChunk];
+    hedge_alloc_vec_.push_back(hedges);
+    for (size_t i = 0; i < kHedgePoolChunk; i++) {
+      hedge_free_vec_.push_back(&hedges[i]);
+    }
+  }
+
+  /// Send the backup copies of hedged requests whose hedge delay has passed
+  void process_hedges_st();
+
+  /// Add a hedged-request latency sample, and update the hedge delay
+  void update_hedge_delay_st(size_t latency_cycles);
+
+  //
+  // Session groups
+  //
+
+  /// Load of congested sessions in session groups, added to their actual load
+  static constexpr double kCongestedSessionLoad = 1e30;
+
+  /// Return the load of session \p session_num for session-group selection,
+  /// which is infinite if the session is not connected
+  inline double group_session_load(int session_num) const {
+    const Session *session = session_vec_[static_cast<size_t>(session_num)];
+    if (unlikely(session == nullptr || !session->is_connected())) {
+      return std::numeric_limits<double>::infinity();
+    }
+
+    const auto &ci = session->client_info_;
+    const size_t outstanding = kSessionReqWindow - ci.sslot_free_vec_.size() +
+                               ci.enq_req_backlog_.size();
+
+    // Sessions without RTT samples yet get picked by outstanding requests
+    const double load =
+        (outstanding + 1) * (ci.cc_.policy_.get_srtt_tsc() + 1.0);
+    return session->is_uncongested() ? load : load + kCongestedSessionLoad;
+  }
+
+  /// Return the least-loaded session of \p group, or -ENOTCONN if no member
+  /// is connected
+  int pick_group_session_slow_st(const std::vector<int> &group);
+
+  //
+  // Admission control
+  //
+
+  /// Return true iff admission control sheds the request that was just fully
+  /// received in server sslot \p sslot
+  inline bool shed_req_st(SSlot *sslot) {
+    if (likely(admission_.target_cycles_ == 0)) return false;
+
+    const size_t rx_tsc = get_cur_pkt_rx_tsc_st();
+    sslot->server_info_.rx_tsc_ = rx_tsc;
+    sslot->server_info_.handler_tsc_ = dpath_rdtsc();  // Foreground handlers
+
+    // Shed only if the delay has been above the target for an interval
+    auto &ac = admission_;
+    if (likely(ac.first_above_tsc_ == 0 || rx_tsc < ac.first_above_tsc_)) {
+      ac.dropping_ = false;
+      return false;
+    }
+    return codel_shed_st(rx_tsc);
+  }
+
+  /// Apply CoDel's control law at \p now to a request that arrived while the
+  /// delay was above the target for an interval. Return true iff it's shed.
+  bool codel_shed_st(size_t now);
+
+  /// Add the queueing delay of a request whose handler ran in server sslot
+  /// \p sslot to admission control
+  inline void sample_server_delay_st(const SSlot *sslot) {
+    const auto &si = sslot->server_info_;
+    auto &ac = admission_;
+    const size_t delay =
+        si.handler_tsc_ > si.rx_tsc_ ? si.handler_tsc_ - si.rx_tsc_ : 0;
+    if (delay < ac.target_cycles_) {
+      ac.first_above_tsc_ = 0;
+    } else if (ac.first_above_tsc_ == 0) {
+      ac.first_above_tsc_ = si.handler_tsc_ + ac.interval_cycles_;
+    }
+  }
+
+  /**
+   * @brief Return the time at which the packet that process_comps_st() is
+   * processing was received. Without packet timestamps, this is the start of
+   * the RX burst.
+   */
+  inline size_t get_cur_pkt_rx_tsc_st() const {
+    if (unlikely(pkt_timestamps_)) {
+      const size_t ring_idx = (rx_ring_head_ + TTr::kNumRxRingEntries - 1) %
+                              TTr::kNumRxRingEntries;  // Advanced before RX
+      const size_t rx_tsc = transport_->get_rx_tsc(ring_idx);
+      if (rx_tsc != 0) return rx_tsc;
+    }
+    return ev_loop_tsc_;
+  }
+
+  /// Respond to a shed request with an empty response marked as overloaded,
+  /// instead of running its request handler
+  void enqueue_overloaded_response_st(SSlot *sslot);
+
+  /// Invoke the batch continuation with all queued completions. Completions
+  /// that the callback causes (e.g., by cancelling a request) are queued in
+  /// comp_queue_ and delivered on the next call, so the callback's array is
+  /// a separate vector.
+  inline void deliver_completions_st() {
+    assert(batch_cont_func_ != nullptr && !comp_queue_.empty());
+    comp_deliver_queue_.swap(comp_queue_);
+    batch_cont_func_(context_, comp_deliver_queue_.data(),
+                     comp_deliver_queue_.size());
+    comp_deliver_queue_.clear();
+  }
+
   /// Convert a response packet's wire protocol packet number (pkt_num) to its
   /// index in the response MsgBuffer
   static inline size_t resp_ntoi(size_t pkt_num, size_t num_req_pkts) {
     return pkt_num - (num_req_pkts - 1);
   }
 
+  /**
+   * @brief Create a scatter-gather MsgBuffer for fragments \p frags. The
+   * MsgBuffer struct, the release callback, a copy of the fragment array, and
+   * the packet headers are stored in one hugepage allocation that is freed by
+   * free_sg_msg_buffer(). Safe to call from background threads (TS), unlike
+   * free_sg_msg_buffer().
+   *
+   * @param release_func If non-null, invoked with \p release_tag when the
+   * MsgBuffer is freed
+   *
+   * @return The MsgBuffer on success, nullptr with \p err set to a negative
+   * errno on failure
+   */
+  MsgBuffer *alloc_sg_msg_buffer(const msg_frag_t *frags, size_t num_frags,
+                                 int *err,
+                                 erpc_release_func_t release_func = nullptr,
+                                 void *release_tag = nullptr);
+
+  /// Free a MsgBuffer created by alloc_sg_msg_buffer(), and invoke its release
+  /// callback. This is not thread-safe: it must be called from the foreground
+  /// thread, where release callbacks run.
+  void free_sg_msg_buffer(MsgBuffer *sg_msgbuf);
+
   /// Return true iff a packet received by a client is in order. This must be
   /// only a few instructions.
   inline size_t in_order_client(const SSlot *sslot, const pkthdr_t *pkthdr) {
@@ -604,6 +1663,44 @@ class Rpc {
     return sslot->client_info_.num_tx_ < sslot->tx_msgbuf_->num_pkts_;
   }
 
+  /// Return the number of packets that a client sslot has left to transmit.
+  /// RFRs are counted only after the first response packet is received.
+  static inline size_t pkts_left_to_tx(SSlot *sslot) {
+    const auto &ci = sslot->client_info_;
+    MsgBuffer *req_msgbuf = sslot->tx_msgbuf_;
+    if (ci.num_rx_ < req_msgbuf->num_pkts_) {
+      return req_msgbuf->num_pkts_ - ci.num_tx_;
+    }
+    return wire_pkts(req_msgbuf, ci.resp_msgbuf_) - ci.num_tx_;
+  }
+
+  /// Return the number of request packets that a client sslot may send now,
+  /// given \p credits. With grant CC, a request may have at most the
+  /// unscheduled prefix of packets in flight beyond its grants.
+  inline size_t req_pkts_sendable(SSlot *sslot, size_t credits) const {
+    const auto &ci = sslot->client_info_;
+    size_t sendable =
+        (std::min)(credits, sslot->tx_msgbuf_->num_pkts_ - ci.num_tx_);
+    if (unlikely(grant_.enabled_)) {
+      const size_t window_end = ci.num_rx_ + grant_.unsched_pkts_;
+      sendable = (std::min)(
+          sendable, window_end > ci.num_tx_ ? window_end - ci.num_tx_ : 0);
+    }
+    return sendable;
+  }
+
+  /// With grant CC, return the number of granted packets for a server sslot's
+  /// partially-received request that are still in flight. The credit return
+  /// for packet i grants packet (i + unscheduled packets).
+  inline size_t granted_pkts_in_flight(const SSlot *sslot) const {
+    const auto &si = sslot->server_info_;
+    const size_t granted_end =
+        (std::min)(si.num_grants_ + grant_.unsched_pkts_,
+                   si.req_msgbuf_.num_pkts_);
+    const size_t rx_end = (std::max)(si.num_rx_, grant_.unsched_pkts_);
+    return granted_end > rx_end ? granted_end - rx_end : 0;
+  }
+
   /// Return true iff it's currently OK to bypass the wheel for this request
   inline bool can_bypass_wheel(SSlot *sslot) const {
     if (!kCcPacing) return true;
@@ -612,7 +1709,9 @@ class Rpc {
       // To prevent reordering, do not bypass the wheel if it contains packets
       // for this session.
       return sslot->client_info_.wheel_count_ == 0 &&
-             sslot->session_->is_uncongested();
+             sslot->session_->is_uncongested() &&
+             !sslot->session_->is_rate_limited() &&
+             total_rate_limit_.rate_ == 0.0;
     }
     return false;
   }
@@ -624,6 +1723,26 @@ class Rpc {
     transport_->tx_flush();
   }
 
+  /// Add a client sslot to the credit stall queue, behind sslots of the same
+  /// or higher priority. Higher-priority requests then get credits first.
+  inline void stall_sslot_st(SSlot *sslot) {
+    assert(!sslot->client_info_.stalled_);
+    sslot->client_info_.stalled_ = true;
+    auto it = stallq_.end();
+    while (it != stallq_.begin() && (*(it - 1))->priority_ < sslot->priority_) {
+      it--;
+    }
+    stallq_.insert(it, sslot);
+  }
+
+  /// With SRPT scheduling, client sslots with packets to send wait in the
+  /// stall queue instead of using credits directly, so that the stall queue
+  /// can hand out each session's credits by remaining packets
+  inline void srpt_stall_st(SSlot *sslot) {
+    assert(srpt_.enabled_);
+    if (!sslot->client_info_.stalled_) stall_sslot_st(sslot);
+  }
+
   /// Add an RPC slot to the list of active RPCs
   inline void add_to_active_rpc_list(SSlot &sslot) {
     SSlot *prev_tail = active_rpcs_tail_sentinel_.client_info_.prev_;
@@ -651,6 +1770,12 @@ class Rpc {
   /// Actually run one iteration of the event loop
   int run_event_loop_do_one_st();
 
+  /// Return true iff the event loop has no work to do until packets arrive
+  bool is_idle_st() const;
+
+  /// Block until a packet is received, or for at most \p park_us
+  void park_st(size_t park_us);
+
   /// Enqueue client packets for a sslot that has at least one credit and
   /// request packets to send. Packets may be added to the timing wheel or the
   /// TX burst; credits are used in both cases.
@@ -668,6 +1793,10 @@ class Rpc {
   /// Process a packet for a multi-packet request
   void process_large_req_one_st(SSlot *, const pkthdr_t *);
 
+  /// Invoke batch request handlers for the requests collected from this RX
+  /// burst, one invocation per request type
+  void process_batch_reqs_st();
+
   /**
    * @brief Process a single-packet response
    * @param rx_tsc The timestamp at which this packet was received
@@ -675,13 +1804,13 @@ class Rpc {
   void process_resp_one_st(SSlot *, const pkthdr_t *, size_t rx_tsc);
 
   /**
-   * @brief Enqueue an explicit credit return
+   * @brief Enqueue an explicit credit return for the sslot's current request
    *
    * @param sslot The session slot to send the explicit CR for
-   * @param req_pkthdr The packet header of the request packet that triggered
-   * this explicit CR. The packet number of req_pkthdr is copied to the CR.
+   * @param req_type The request's type
+   * @param pkt_num The number of the request packet that triggered this CR
    */
-  void enqueue_cr_st(SSlot *sslot, const pkthdr_t *req_pkthdr);
+  void enqueue_cr_st(SSlot *sslot, size_t req_type, size_t pkt_num);
 
   /**
    * @brief Process an explicit credit return packet
@@ -730,7 +1859,9 @@ class Rpc {
                sslot->progress_str().c_str(), item.drop_ ? " Drop." : "");
 
     tx_batch_i_++;
-    if (tx_batch_i_ == TTr::kPostlist) do_tx_burst_st();
+    if (tx_batch_i_ == TTr::kPostlist || sslot->priority_ == kPriorityHigh) {
+      do_tx_burst_st();  // Don't hold high-priority packets for the batch
+    }
   }
 
   /// Enqueue a control packet for tx_burst. ctrl_msgbuf can be reused after
@@ -757,7 +1888,31 @@ class Rpc {
                sslot->progress_str().c_str(), item.drop_ ? " Drop." : "");
 
     tx_batch_i_++;
-    if (tx_batch_i_ == TTr::kPostlist) do_tx_burst_st();
+    if (tx_batch_i_ == TTr::kPostlist || sslot->priority_ == kPriorityHigh) {
+      do_tx_burst_st();  // Don't hold high-priority packets for the batch
+    }
+  }
+
+  /// Get the desired TX timestamp for a packet of \p pkt_size bytes from a
+  /// client sslot, respecting the session's pacing and the total rate cap
+  inline size_t get_desired_tx_tsc(SSlot *sslot, size_t ref_tsc,
+                                   size_t pkt_size) {
+    Session *session = sslot->session_;
+    size_t desired_tx_tsc = session->cc_getupdate_tx_tsc(ref_tsc, pkt_size);
+    if (likely(total_rate_limit_.rate_ == 0.0)) return desired_tx_tsc;
+
+    auto &trl = total_rate_limit_;
+    const double ns_delta = 1000000000 * (pkt_size / trl.rate_);
+    desired_tx_tsc = (std::max)(
+        desired_tx_tsc,
+        trl.prev_desired_tx_tsc_ +
+            static_cast<size_t>(ns_to_cycles(ns_delta, freq_ghz_)));
+    desired_tx_tsc = (std::min)(
+        desired_tx_tsc, ref_tsc + us_to_cycles(kWheelHorizonUs, freq_ghz_));
+
+    trl.prev_desired_tx_tsc_ = desired_tx_tsc;
+    session->client_info_.cc_.prev_desired_tx_tsc_ = desired_tx_tsc;
+    return desired_tx_tsc;
   }
 
   /// Enqueue a request packet to the timing wheel
@@ -766,14 +1921,14 @@ class Rpc {
     size_t pktsz =
         sslot->tx_msgbuf_->get_pkt_size<TTr::kMaxDataPerPkt>(pkt_idx);
     size_t ref_tsc = dpath_rdtsc();
-    size_t desired_tx_tsc =
-        sslot->session_->cc_getupdate_tx_tsc(ref_tsc, pktsz);
+    size_t desired_tx_tsc = get_desired_tx_tsc(sslot, ref_tsc, pktsz);
 
     ERPC_CC("Rpc %u: lsn/req/pkt %u/%zu/%zu, REQ wheeled for %.3f us.\n",
             rpc_id_, sslot->session_->local_session_num_, sslot->cur_req_num_,
             pkt_num, to_usec(desired_tx_tsc - creation_tsc_, freq_ghz_));
 
-    wheel_->insert(wheel_ent_t(sslot, pkt_num), ref_tsc, desired_tx_tsc);
+    wheel_->insert(wheel_ent_t(sslot, pkt_num, sslot->priority_), ref_tsc,
+                   desired_tx_tsc);
     sslot->client_info_.in_wheel_[pkt_num % kSessionCredits] = true;
     sslot->client_info_.wheel_count_++;
   }
@@ -784,14 +1939,14 @@ class Rpc {
     const MsgBuffer *resp_msgbuf = sslot->client_info_.resp_msgbuf_;
     size_t pktsz = resp_msgbuf->get_pkt_size<TTr::kMaxDataPerPkt>(pkt_idx);
     size_t ref_tsc = dpath_rdtsc();
-    size_t desired_tx_tsc =
-        sslot->session_->cc_getupdate_tx_tsc(ref_tsc, pktsz);
+    size_t desired_tx_tsc = get_desired_tx_tsc(sslot, ref_tsc, pktsz);
 
     ERPC_CC("Rpc %u: lsn/req/pkt %u/%zu/%zu, RFR wheeled for %.3f us.\n",
             rpc_id_, sslot->session_->local_session_num_, sslot->cur_req_num_,
             pkt_num, to_usec(desired_tx_tsc - creation_tsc_, freq_ghz_));
 
-    wheel_->insert(wheel_ent_t(sslot, pkt_num), ref_tsc, desired_tx_tsc);
+    wheel_->insert(wheel_ent_t(sslot, pkt_num, sslot->priority_), ref_tsc,
+                   desired_tx_tsc);
     sslot->client_info_.in_wheel_[pkt_num % kSessionCredits] = true;
     sslot->client_info_.wheel_count_++;
   }
@@ -827,13 +1982,16 @@ class Rpc {
     session->client_info_.credits_++;
   }
 
-  /// Copy the data from a packet to a MsgBuffer at a packet index
+  /// Copy the data from a packet to a MsgBuffer at a packet index. Large
+  /// messages are copied with non-temporal stores, so the caller must call
+  /// dpath_memcpy_fence() after copying the last packet of such messages.
   static inline void copy_data_to_msgbuf(MsgBuffer *msgbuf, size_t pkt_idx,
                                          const pkthdr_t *pkthdr) {
     size_t offset = pkt_idx * TTr::kMaxDataPerPkt;
     size_t to_copy =
         (std::min)(TTr::kMaxDataPerPkt, pkthdr->msg_size_ - offset);
-    memcpy(&msgbuf->buf_[offset], pkthdr + 1, to_copy);  // From end of pkthdr
+    dpath_memcpy_msg(&msgbuf->buf_[offset], pkthdr + 1, to_copy,
+                     pkthdr->msg_size_);  // From end of pkthdr
   }
 
   /**
@@ -850,7 +2008,7 @@ class Rpc {
   int process_comps_st();
 
   /**
-   * @brief Submit a request work item to a random background thread
+   * @brief Submit a request work item to a lightly-loaded background thread
    *
    * @param sslot Session sslot with a complete request. Used only for request
    * work item types.
@@ -869,6 +2027,10 @@ class Rpc {
    */
   void submit_bg_resp_st(erpc_cont_func_t cont_func, void *tag, size_t bg_etid);
 
+  /// Process our background queues while a background thread's request queue
+  /// is full
+  void drain_bg_queues_st();
+
   //
   // Queue handlers
   //
@@ -876,6 +2038,16 @@ class Rpc {
   /// Try to transmit request packets from sslots that are stalled for credits.
   void process_credit_stall_queue_st();
 
+  /// The SRPT-scheduling version of process_credit_stall_queue_st()
+  void process_srpt_stall_queue_st();
+
+  /// With grant CC, send the deferred credit returns that grant packets to
+  /// partially-received requests, fewest packets left first
+  void process_grants_st();
+
+  /// With grant CC, stop scheduling grants for a server sslot
+  void remove_from_grant_list_st(SSlot *sslot);
+
   /// Process the wheel. We have already paid credits for sslots in the wheel.
   void process_wheel_st();
 
@@ -885,6 +2057,9 @@ class Rpc {
   /// Process the responses enqueued by background threads
   void process_bg_queues_enqueue_response_st();
 
+  /// Process the requests submitted to rings by non-eRPC threads
+  void process_submit_rings_st();
+
   /**
    * @brief Check if the caller can inject faults
    * @throw runtime_error if the caller cannot inject faults
@@ -926,18 +2101,36 @@ class Rpc {
   }
 
   /**
-   * @brief Perform a Timely rate update on receiving the explict CR or response
-   * packet for this triggering packet number
+   * @brief Perform a congestion control update on receiving the explict CR or
+   * response packet for this triggering packet number
    *
    * @param sslot The request sslot for which a packet is received
    * @param pkt_num The received packet's packet number
    * @param Time at which the explicit CR or response packet was received
+   * @param ecn_ce True iff the received packet reports a CE mark on the path
    */
-  inline void update_timely_rate(SSlot *sslot, size_t pkt_num, size_t rx_tsc) {
+  inline void update_cc_rate(SSlot *sslot, size_t pkt_num, size_t rx_tsc,
+                             bool ecn_ce) {
     size_t rtt_tsc =
         rx_tsc - sslot->client_info_.tx_ts_[pkt_num % kSessionCredits];
-    // This might use Timely bypass
-    sslot->session_->client_info_.cc_.timely_.update_rate(rx_tsc, rtt_tsc);
+    // The policy may skip the update if the session is uncongested
+    auto &policy = sslot->session_->client_info_.cc_.policy_;
+    policy.on_ack(rx_tsc, rtt_tsc);
+    if (unlikely(ecn_enabled_)) policy.on_ecn(rx_tsc, ecn_ce);
+  }
+
+  /**
+   * @brief Return the time at which the packet at RX ring index \p ring_idx
+   * was received, for RTT samples
+   *
+   * @param batch_rx_tsc The TSC sampled before the RX burst
+   */
+  inline size_t get_rx_tsc_st(size_t ring_idx, size_t batch_rx_tsc) const {
+    if (unlikely(pkt_timestamps_)) {
+      const size_t rx_tsc = transport_->get_rx_tsc(ring_idx);
+      if (rx_tsc != 0) return rx_tsc;
+    }
+    return kCcOptBatchTsc ? batch_rx_tsc : dpath_rdtsc();
   }
 
   /// Return true iff a packet should be dropped
@@ -974,6 +2167,9 @@ class Rpc {
   /// a pointer instead, but an array is faster.
   const std::array<ReqFunc, kReqTypeArraySize> req_func_arr_;
 
+  /// Priority class of each request type, see set_req_type_priority()
+  std::array<uint8_t, kReqTypeArraySize> req_type_priority_;
+
   // Rpc metadata
   size_t creator_etid_;        ///< eRPC thread ID of the creator thread
   TlsRegistry *tls_registry_;  ///< Pointer to the Nexus's thread-local registry
@@ -1002,13 +2198,108 @@ class Rpc {
   uint8_t *rx_ring_[TTr::kNumRxRingEntries];
   size_t rx_ring_head_ = 0;  ///< Current unused RX ring buffer
 
-  std::vector<SSlot *> stallq_;  ///< Request sslots stalled for credits
+  // Fragmented reception
+  bool frag_rx_ = false;         ///< True iff enable_frag_rx() succeeded
+  size_t rx_hold_capacity_ = 0;  ///< Max packets the transport lets us hold
+  size_t rx_pkts_held_ = 0;      ///< Packets held or reserved for holding
+
+  /// Classes of fragment arrays. Class i arrays have 2^i fragments.
+  static constexpr size_t kNumFragArrClasses = 20;
+
+  /// Free fragment arrays for fragmented MsgBuffers, indexed by class
+  std::array<std::vector<msg_frag_t *>, kNumFragArrClasses> frag_arr_pool_;
+
+  /// Request sslots stalled for credits, in non-increasing priority order
+  std::vector<SSlot *> stallq_;
+
+  /// Shortest-remaining-processing-time scheduling of client packets
+  struct {
+    bool enabled_ = false;
+    double aging_per_cycle_ = 0.0;  ///< Packets of credit per waiting cycle
+
+    /// Scratch space for sorting the stall queue by (priority, key)
+    std::vector<std::pair<double, SSlot *>> sort_vec_;
+  } srpt_;
+
+  /// Receiver-driven, grant-based congestion control
+  struct {
+    bool enabled_ = false;
+    size_t unsched_pkts_ = 0;      ///< Request packets sent without grants
+    size_t max_granted_pkts_ = 0;  ///< Max granted packets in flight
+    bool pending_ = false;  ///< True iff a request packet awaits grant work
+
+    /// Server sslots with a partially-received multi-packet request
+    std::vector<SSlot *> sslot_vec_;
+  } grant_;
+
+  // Batch request handlers
+  std::vector<SSlot *> batch_req_vec_;  ///< This RX burst's batched requests
+  std::vector<ReqHandle *> batch_req_handles_;  ///< Handles for one req type
+
+  // Completion-queue mode
+  bool comp_queue_mode_ = false;  ///< True iff enable_completion_queue()
+  erpc_batch_cont_func_t batch_cont_func_ = nullptr;  ///< Optional callback
+  std::vector<completion_t> comp_queue_;  ///< Queued, undrained completions
+  std::vector<completion_t> comp_deliver_queue_;  ///< Being delivered
+  size_t comp_queue_head_ = 0;  ///< Index of the oldest undrained completion
 
   size_t ev_loop_tsc_;  ///< TSC taken at each iteration of the ev loop
+  int cont_status_ = 0;  ///< Status of the running foreground continuation
+
+  /// CoDel admission control for requests at this server
+  struct {
+    size_t target_cycles_ = 0;  ///< Target request delay, zero if disabled
+    size_t interval_cycles_ = 0;  ///< Time above the target before shedding
+
+    /// One interval after the delay went above the target, zero if the delay
+    /// is below the target
+    size_t first_above_tsc_ = 0;
+
+    bool dropping_ = false;   ///< True iff in CoDel's dropping state
+    size_t drop_next_tsc_ = 0;  ///< Time to shed the next request
+    size_t count_ = 0;     ///< Requests shed in the current dropping state
+    size_t num_shed_ = 0;  ///< Number of shed requests
+  } admission_;
+
+  /// The app-set cap on the total sending rate of client sessions
+  struct {
+    double rate_ = 0.0;  ///< Rate cap in bytes/sec, zero if disabled
+    size_t prev_desired_tx_tsc_ = 0;  ///< Desired TX timestamp of last packet
+  } total_rate_limit_;
+
+  bool ecn_enabled_ = false;  ///< True iff enable_ecn() succeeded
+  bool pkt_timestamps_ = false;  ///< True iff enable_pkt_timestamps() succeeded
+
+  /// A lower bound on the earliest deadline of this Rpc's requests, SIZE_MAX
+  /// if no request has a deadline
+  size_t next_deadline_tsc_ = SIZE_MAX;
+
+  /// Session groups created by create_session_group(), indexed by group ID
+  std::vector<std::vector<int>> session_group_vec_;
+
+  // Request hedging
+  std::vector<hedge_t *> hedge_pending_vec_;  ///< Hedges with no backup yet
+  std::vector<hedge_t *> hedge_free_vec_;     ///< Unused hedge records
+  std::vector<hedge_t *> hedge_alloc_vec_;    ///< Arrays of hedge records
+
+  /// A lower bound on the earliest hedge time in hedge_pending_vec_, SIZE_MAX
+  /// if it's empty
+  size_t next_hedge_tsc_ = SIZE_MAX;
+
+  Latency hedge_latency_;  ///< Recent hedged-request latencies
+  size_t hedge_num_samples_ = 0;  ///< Samples since set_hedge_policy()
+  double hedge_percentile_ = 0.95;
+  size_t hedge_delay_cycles_;  ///< The current hedge delay
 
   // Packet loss
   size_t pkt_loss_scan_tsc_;  ///< Timestamp of the previous scan for lost pkts
 
+  /// Idle time before run_event_loop() parks, SIZE_MAX if it never parks
+  size_t idle_spin_cycles_ = SIZE_MAX;
+
+  /// epoll descriptor returned by get_event_fd(), or -1 if not created
+  int event_epoll_fd_ = -1;
+
   /// The doubly-linked list of active RPCs. An RPC slot is added to this list
   /// when the request is enqueued. The slot is deleted from this list when its
   /// continuation is invoked or queued to a background thread.
@@ -1032,12 +2323,19 @@ class Rpc {
   /// but not bumped the num_tx counter.
   TimingWheel *wheel_;
 
+  /// Capacity of the queues for datapath API requests from background threads.
+  /// Background threads spin while a queue is full.
+  static constexpr size_t kBgQueueSize = 1024;
+  static constexpr size_t kBgQueueBurstSize = 16;  ///< Dequeue batch size
+
   /// Queues for datapath API requests from background threads
   struct {
-    MtQueue<enq_req_args_t> enqueue_request_;
-    MtQueue<enq_resp_args_t> enqueue_response_;
+    MpscRing<enq_req_args_t, kBgQueueSize> enqueue_request_;
+    MpscRing<enq_resp_args_t, kBgQueueSize> enqueue_response_;
   } bg_queues_;
 
+  std::vector<submit_ring_t *> submit_ring_vec_;  ///< Non-eRPC thread rings
+
   // Misc
   SlowRand slow_rand_;  ///< A slow random generator for "real" randomness
   UDPClient<SmPkt> udp_client_;  ///< UDP endpoint used to send SM packets
@@ -1090,6 +2388,13 @@ class Rpc {
     size_t still_in_wheel_during_retx_ = 0;
   } pkt_loss_stats_;
 
+  /// Event loop parking stats. These change only when parking is enabled.
+  struct {
+    size_t num_idle_iters_ = 0;  ///< Event loop iterations past the idle spin
+    size_t num_parks_ = 0;       ///< Times the dispatch thread blocked
+    size_t num_rx_wakeups_ = 0;  ///< Parks ended by a received packet
+  } park_stats_;
+
   /// Size of the preallocated response buffer. This is one packet by default,
   /// but some applications might benefit from a larger preallocated buffer,
   /// at the expense of increased memory utilization.
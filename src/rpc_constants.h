@@ -43,7 +43,7 @@ static constexpr size_t kMaxNumaNodes = 8;
  * @relates Rpc
  * @brief Maximum number of background threads per process
  */
-static constexpr size_t kMaxBgThreads = 8;
+static constexpr size_t kMaxBgThreads = 64;
 
 /**
  * @relates Rpc
@@ -60,6 +60,50 @@ static constexpr size_t kMaxPhyPorts = 16;
  */
 static constexpr size_t kMachineFailureTimeoutMs = 500;
 
+/**
+ * @relates Rpc
+ * @brief The number of request priority classes. The packets of a
+ * higher-priority request get credits, leave the timing wheel, and are
+ * transmitted before those of lower-priority requests on the same Rpc.
+ */
+static constexpr size_t kNumPriorities = 3;
+
+/// @relates Rpc
+/// @brief The priority class for bulk transfers
+static constexpr uint8_t kPriorityLow = 0;
+
+/// @relates Rpc
+/// @brief The default priority class
+static constexpr uint8_t kPriorityNormal = 1;
+
+/// @relates Rpc
+/// @brief The priority class for latency-critical requests, e.g., heartbeats
+static constexpr uint8_t kPriorityHigh = 2;
+
+/**
+ * @relates Rpc
+ * @brief A priority that tells enqueue_request() to use the priority of the
+ * request type, set with Rpc::set_req_type_priority()
+ */
+static constexpr uint8_t kPriorityOfReqType = UINT8_MAX;
+
+/**
+ * @relates Rpc
+ * @brief The IP DSCP of each priority class, for transports that send IP
+ * packets: CS1 (scavenger) for low priority, and EF for high priority
+ */
+static constexpr uint8_t kPriorityDscp[kNumPriorities] = {8, 0, 46};
+
+/**
+ * @relates Rpc
+ * @brief The lowest rate cap in bytes/sec accepted by
+ * Rpc::set_session_rate_limit() and Rpc::set_total_rate_limit(). A window of
+ * packets at this rate fits well within the timing wheel's horizon. Packets
+ * may wait in the wheel for much longer than the RTO, so the RTO restarts when
+ * a packet leaves the wheel.
+ */
+static constexpr double kMinRateLimit = 1000.0;
+
 /**
  * @brief Return the datapath UDP port used for an Rpc object in a process
  *
@@ -21,13 +21,17 @@ Rpc<TTr>::Rpc(Nexus *nexus, void *context, uint8_t rpc_id,
       numa_node_(nexus->numa_node_),
       creation_tsc_(rdtsc()),
       multi_threaded_(nexus->num_bg_threads_ > 0),
+#ifdef ERPC_SIM
+      freq_ghz_(kSimFreqGhz),  // Simulated Rpcs run in virtual time
+#else
       freq_ghz_(nexus->freq_ghz_),
+#endif
       rpc_rto_cycles_(us_to_cycles(kRpcRTOUs, freq_ghz_)),
       rpc_pkt_loss_scan_cycles_(rpc_rto_cycles_ / 10),
       req_func_arr_(nexus->req_func_arr_) {
 #ifndef _WIN32
 // for socket, we don't really need to use root permission
-#ifndef ERPC_FAKE
+#if !defined(ERPC_FAKE) && !defined(ERPC_SIM)
   rt_assert(!getuid(), "You need to be root to use eRPC");
 #endif
 #endif
@@ -37,8 +41,14 @@ Rpc<TTr>::Rpc(Nexus *nexus, void *context, uint8_t rpc_id,
   rt_assert(numa_node_ < kMaxNumaNodes, "Invalid NUMA node");
 
   tls_registry_ = &nexus->tls_registry_;
+#ifdef ERPC_SIM
+  // All simulated Rpcs share the thread that runs the fabric
+  if (!tls_registry_->is_init()) tls_registry_->init();
+#else
   tls_registry_->init();  // Initialize thread-local variables for this thread
+#endif
   creator_etid_ = get_etid();
+  req_type_priority_.fill(kPriorityNormal);
 
   if (ERPC_LOG_LEVEL >= ERPC_LOG_LEVEL_REORDER) {
     const auto trace_filename = "/tmp/erpc_trace_" +
@@ -90,6 +100,9 @@ Rpc<TTr>::Rpc(Nexus *nexus, void *context, uint8_t rpc_id,
 
   //ERPC_INFO("Rpc %u created. eRPC TID = %zu.\n", rpc_id, creator_etid_);
 
+  hedge_delay_cycles_ = us_to_cycles(kDefaultHedgeDelayUs, freq_ghz_);
+  extend_hedge_pool_st();
+
   active_rpcs_root_sentinel_.client_info_.next_ = &active_rpcs_tail_sentinel_;
   active_rpcs_root_sentinel_.client_info_.prev_ = nullptr;
   active_rpcs_tail_sentinel_.client_info_.next_ = nullptr;
@@ -109,6 +122,9 @@ Rpc<TTr>::~Rpc() {
     if (session != nullptr) delete session;
   }
 
+  for (submit_ring_t *submit_ring : submit_ring_vec_) delete submit_ring;
+  for (hedge_t *hedges : hedge_alloc_vec_) delete[] hedges;
+
   ERPC_INFO("Destroying Rpc %u.\n", rpc_id_);
 
   // First delete the hugepage allocator. This deregisters and deletes the
@@ -120,6 +136,10 @@ Rpc<TTr>::~Rpc() {
   delete transport_;
 
   nexus_->unregister_hook(&nexus_hook_);
+  if (event_epoll_fd_ != -1) {
+    close(event_epoll_fd_);
+    close(nexus_hook_.event_notify_fd_);
+  }
 
   if (ERPC_LOG_LEVEL >= ERPC_LOG_LEVEL_REORDER) fclose(trace_file_);
 }
@@ -0,0 +1,50 @@
+/**
+ * @file rpc_admission.cc
+ * @brief Server-side admission control
+ */
+#include "rpc.h"
+
+namespace erpc {
+
+template <class TTr>
+bool Rpc<TTr>::codel_shed_st(size_t now) {
+  assert(in_dispatch());
+  auto &ac = admission_;
+
+  if (ac.dropping_) {
+    if (now < ac.drop_next_tsc_) return false;
+    ac.count_++;
+  } else {
+    // Like CoDel, resume near the previous shedding rate if the previous
+    // dropping state ended recently
+    ac.dropping_ = true;
+    ac.count_ = (ac.count_ > 2 &&
+                 now < ac.drop_next_tsc_ + 16 * ac.interval_cycles_)
+                    ? ac.count_ - 2
+                    : 1;
+    ac.drop_next_tsc_ = now;
+    ERPC_REORDER("Rpc %u: Started shedding requests. Count = %zu.\n", rpc_id_,
+                 ac.count_);
+  }
+
+  // The control law
+  ac.drop_next_tsc_ += static_cast<size_t>(
+      ac.interval_cycles_ / std::sqrt(static_cast<double>(ac.count_)));
+  ac.num_shed_++;
+  return true;
+}
+
+template <class TTr>
+void Rpc<TTr>::enqueue_overloaded_response_st(SSlot *sslot) {
+  ERPC_REORDER("Rpc %u, lsn %u: Shedding request %zu.\n", rpc_id_,
+               sslot->session_->local_session_num_, sslot->cur_req_num_);
+
+  sslot->server_info_.overloaded_ = true;
+  MsgBuffer &resp_msgbuf = sslot->pre_resp_msgbuf_;
+  resize_msg_buffer(&resp_msgbuf, 0);
+  enqueue_response(static_cast<ReqHandle *>(sslot), &resp_msgbuf);
+}
+
+FORCE_COMPILE_TRANSPORTS
+
+}  // namespace erpc
@@ -1,24 +1,29 @@
+#include <algorithm>
+
 #include "rpc.h"
 
 namespace erpc {
 
 template <class TTr>
-void Rpc<TTr>::enqueue_cr_st(SSlot *sslot, const pkthdr_t *req_pkthdr) {
+void Rpc<TTr>::enqueue_cr_st(SSlot *sslot, size_t req_type, size_t pkt_num) {
   assert(in_dispatch());
 
   MsgBuffer *ctrl_msgbuf = &ctrl_msgbufs_[ctrl_msgbuf_head_];
   ctrl_msgbuf_head_++;
   if (ctrl_msgbuf_head_ == 2 * TTr::kUnsigBatch) ctrl_msgbuf_head_ = 0;
 
-  // Fill in the CR packet header. Avoid copying req_pkthdr's headroom.
+  // Fill in the CR packet header
   pkthdr_t *cr_pkthdr = ctrl_msgbuf->get_pkthdr_0();
-  cr_pkthdr->req_type_ = req_pkthdr->req_type_;
+  cr_pkthdr->req_type_ = req_type;
   cr_pkthdr->msg_size_ = 0;
   cr_pkthdr->dest_session_num_ = sslot->session_->remote_session_num_;
   cr_pkthdr->pkt_type_ = PktType::kExplCR;
-  cr_pkthdr->pkt_num_ = req_pkthdr->pkt_num_;
-  cr_pkthdr->req_num_ = req_pkthdr->req_num_;
+  cr_pkthdr->pkt_num_ = pkt_num;
+  cr_pkthdr->req_num_ = sslot->cur_req_num_;
+  cr_pkthdr->priority_ = sslot->priority_;
+  cr_pkthdr->ecn_echo_ = sslot->server_info_.ecn_ce_;
   cr_pkthdr->magic_ = kPktHdrMagic;
+  sslot->server_info_.ecn_ce_ = false;
 
   enqueue_hdr_tx_burst_st(sslot, ctrl_msgbuf, nullptr);
 }
@@ -40,14 +45,70 @@ void Rpc<TTr>::process_expl_cr_st(SSlot *sslot, const pkthdr_t *pkthdr,
     return;
   }
 
-  // Update client tracking metadata
-  if (kCcRateComp) update_timely_rate(sslot, pkthdr->pkt_num_, rx_tsc);
+  // Update client tracking metadata. With grant CC, the server delays credit
+  // returns on purpose, so they are not RTT samples.
+  if (kCcRateComp && likely(!grant_.enabled_)) {
+    update_cc_rate(sslot, pkthdr->pkt_num_, rx_tsc, pkthdr->ecn_echo_);
+  }
   bump_credits(sslot->session_);
   sslot->client_info_.num_rx_++;
   sslot->client_info_.progress_tsc_ = ev_loop_tsc_;
 
   // If we've transmitted all request pkts, there's nothing more to TX yet
-  if (req_pkts_pending(sslot)) kick_req_st(sslot);  // credits >= 1
+  if (req_pkts_pending(sslot)) {
+    if (unlikely(srpt_.enabled_)) {
+      srpt_stall_st(sslot);
+    } else {
+      kick_req_st(sslot);  // credits >= 1
+    }
+  }
+}
+
+template <class TTr>
+void Rpc<TTr>::process_grants_st() {
+  assert(in_dispatch());
+  grant_.pending_ = false;
+
+  size_t granted = 0;  // Granted packets in flight, across all requests
+  for (SSlot *sslot : grant_.sslot_vec_) {
+    granted += granted_pkts_in_flight(sslot);
+  }
+
+  std::stable_sort(grant_.sslot_vec_.begin(), grant_.sslot_vec_.end(),
+                   [](const SSlot *a, const SSlot *b) {
+                     if (a->priority_ != b->priority_) {
+                       return a->priority_ > b->priority_;
+                     }
+                     return a->server_info_.req_msgbuf_.num_pkts_ -
+                                a->server_info_.num_rx_ <
+                            b->server_info_.req_msgbuf_.num_pkts_ -
+                                b->server_info_.num_rx_;
+                   });
+
+  // Send the credit returns owed for received packets, in order. A credit
+  // return that grants a packet that isn't received yet must fit in the
+  // budget. Others are plain acknowledgments.
+  for (SSlot *sslot : grant_.sslot_vec_) {
+    auto &si = sslot->server_info_;
+    const size_t num_pkts = si.req_msgbuf_.num_pkts_;
+    while (si.num_grants_ < si.num_rx_) {
+      const size_t granted_pkt = si.num_grants_ + grant_.unsched_pkts_;
+      const bool new_grant =
+          granted_pkt < num_pkts && granted_pkt >= si.num_rx_;
+      if (new_grant && granted >= grant_.max_granted_pkts_) break;
+
+      enqueue_cr_st(sslot, si.grant_req_type_, si.num_grants_);
+      si.num_grants_++;
+      if (new_grant) granted++;
+    }
+  }
+}
+
+template <class TTr>
+void Rpc<TTr>::remove_from_grant_list_st(SSlot *sslot) {
+  auto &vec = grant_.sslot_vec_;
+  auto it = std::find(vec.begin(), vec.end(), sslot);
+  if (it != vec.end()) vec.erase(it);
 }
 
 FORCE_COMPILE_TRANSPORTS
@@ -0,0 +1,272 @@
+/**
+ * @file rpc_deadline.cc
+ * @brief Request deadlines and client-side cancellation
+ */
+#include "rpc.h"
+
+namespace erpc {
+
+template <class TTr>
+int Rpc<TTr>::cancel_request(void *tag) {
+  assert(in_dispatch());
+
+  // Requests in session slots are older than backlogged requests
+  SSlot *sslot = find_active_req_st(tag);
+  if (sslot != nullptr) return abort_req_st(sslot, -ECANCELED);
+
+  enq_req_args_t req_args;
+  if (remove_backlogged_req_st(tag, &req_args)) {
+    fail_req_st(req_args, -ECANCELED);
+    return 0;
+  }
+
+  return -ENOENT;
+}
+
+template <class TTr>
+SSlot *Rpc<TTr>::find_active_req_st(void *tag) {
+  SSlot *cur = active_rpcs_root_sentinel_.client_info_.next_;
+  while (cur != &active_rpcs_tail_sentinel_) {
+    if (cur->client_info_.tag_ == tag && !cur->client_info_.cancelled_) {
+      return cur;
+    }
+    cur = cur->client_info_.next_;
+  }
+  return nullptr;
+}
+
+template <class TTr>
+bool Rpc<TTr>::remove_backlogged_req_st(void *tag, enq_req_args_t *req_args) {
+  for (Session *session : session_vec_) {
+    if (session == nullptr || !session->is_client()) continue;
+
+    // Rotate the backlog once, removing the first request with this tag
+    auto &backlog = session->client_info_.enq_req_backlog_;
+    bool found = false;
+    const size_t backlog_size = backlog.size();
+    for (size_t i = 0; i < backlog_size; i++) {
+      const enq_req_args_t cur_args = backlog.front();
+      backlog.pop();
+      if (!found && cur_args.tag_ == tag) {
+        found = true;
+        *req_args = cur_args;
+      } else {
+        backlog.push(cur_args);
+      }
+    }
+
+    if (found) return true;
+  }
+
+  return false;
+}
+
+template <class TTr>
+void Rpc<TTr>::enqueue_expired_response(SSlot *sslot) {
+  ERPC_REORDER("Rpc %u, lsn %u: Dropping expired request %zu.\n", rpc_id_,
+               sslot->session_->local_session_num_, sslot->cur_req_num_);
+
+  sslot->server_info_.expired_ = true;
+  MsgBuffer &resp_msgbuf = sslot->pre_resp_msgbuf_;
+  resize_msg_buffer(&resp_msgbuf, 0);
+  enqueue_response(static_cast<ReqHandle *>(sslot), &resp_msgbuf);
+}
+
+template <class TTr>
+void Rpc<TTr>::fail_req_st(const enq_req_args_t &req_args, int status) {
+  assert(in_dispatch());
+
+  // eRPC owns scatter-gather request MsgBuffers
+  if (req_args.req_msgbuf_->is_fragmented()) {
+    free_sg_msg_buffer(req_args.req_msgbuf_);
+  }
+
+  resize_msg_buffer(req_args.resp_msgbuf_, 0);  // 0 response size marks error
+  if (req_args.cont_etid_ == kInvalidBgETid) {
+    complete_fg_req_st(req_args.cont_func_, req_args.tag_, status, 0);
+  } else {
+    submit_bg_resp_st(req_args.cont_func_, req_args.tag_, req_args.cont_etid_);
+  }
+}
+
+template <class TTr>
+void Rpc<TTr>::release_unsent_req_st(SSlot *sslot) {
+  assert(sslot->client_info_.num_tx_ == 0);
+  Session *session = sslot->session_;
+  stallq_.erase(std::remove(stallq_.begin(), stallq_.end(), sslot),
+                stallq_.end());
+  sslot->tx_msgbuf_ = nullptr;
+  sslot->cur_req_num_ -= kSessionReqWindow;
+  delete_from_active_rpc_list(*sslot);
+  session->client_info_.sslot_free_vec_.push_back(sslot->index_);
+  dequeue_backlog_st(session);
+}
+
+template <class TTr>
+int Rpc<TTr>::abort_req_st(SSlot *sslot, int status) {
+  assert(in_dispatch());
+  auto &ci = sslot->client_info_;
+  assert(sslot->tx_msgbuf_ != nullptr && !ci.cancelled_);
+
+  Session *session = sslot->session_;
+  MsgBuffer *req_msgbuf = sslot->tx_msgbuf_;
+  MsgBuffer *resp_msgbuf = ci.resp_msgbuf_;
+  const enq_req_args_t req_args(
+      session->local_session_num_, req_msgbuf->get_pkthdr_0()->req_type_,
+      req_msgbuf, resp_msgbuf, ci.cont_func_, ci.tag_, ci.cont_etid_);
+
+  if (ci.num_tx_ == 0) {
+    // The request is stalled for credits, and the server hasn't seen it
+    release_unsent_req_st(sslot);
+  } else {
+    // The server may be processing the request, so the request must finish
+    // the protocol to keep the session slot in sync. Do that with eRPC-owned
+    // copies of the MsgBuffers, so that the app gets its MsgBuffers back now.
+    // The sslot and credits are reclaimed when the response arrives. Hedged
+    // copies are cancelled with cancel_hedge_copy_st() instead.
+    assert(ci.cont_func_ != hedge_cont_func);
+
+    // Allocate before modifying any state, so that failure leaves the request
+    // running as if it were never aborted
+    MsgBuffer own_req = alloc_msg_buffer(req_msgbuf->data_size_);
+    MsgBuffer own_resp = alloc_msg_buffer(resp_msgbuf->max_data_size_);
+    if (unlikely(own_req.buf_ == nullptr || own_resp.buf_ == nullptr)) {
+      ERPC_WARN("Rpc %u: Failed to allocate buffers to abort request %zu.\n",
+                rpc_id_, sslot->cur_req_num_);
+      if (own_req.buf_ != nullptr) free_msg_buffer(own_req);
+      if (own_resp.buf_ != nullptr) free_msg_buffer(own_resp);
+      return -ENOMEM;
+    }
+
+    drain_tx_batch_and_dma_queue();  // Packets may reference req_msgbuf
+    ci.cancel_req_msgbuf_ = own_req;
+    ci.cancel_resp_msgbuf_ = own_resp;
+
+    size_t offset = 0;
+    for (size_t i = 0; i < req_msgbuf->get_num_frags(); i++) {
+      const msg_frag_t frag = req_msgbuf->get_frag(i);
+      memcpy(ci.cancel_req_msgbuf_.buf_ + offset, frag.buf_, frag.size_);
+      offset += frag.size_;
+    }
+
+    // Tell the server that the request has expired in case it gets request
+    // packets later, e.g., retransmissions
+    for (size_t i = 0; i < req_msgbuf->num_pkts_; i++) {
+      *ci.cancel_req_msgbuf_.get_pkthdr_n(i) = *req_msgbuf->get_pkthdr_n(i);
+      ci.cancel_req_msgbuf_.get_pkthdr_n(i)->deadline_us_ = 1;
+    }
+    ci.deadline_tsc_ = ev_loop_tsc_;
+
+    // The response data is not needed, but its size and header are needed to
+    // track response packets and send RFRs
+    release_msg_frags(resp_msgbuf);  // Partially-received response
+    resize_msg_buffer(&ci.cancel_resp_msgbuf_, resp_msgbuf->data_size_);
+    *ci.cancel_resp_msgbuf_.get_pkthdr_0() = *resp_msgbuf->get_pkthdr_0();
+
+    sslot->tx_msgbuf_ = &ci.cancel_req_msgbuf_;
+    ci.resp_msgbuf_ = &ci.cancel_resp_msgbuf_;
+    ci.cancelled_ = true;
+  }
+
+  fail_req_st(req_args, status);
+  return 0;
+}
+
+template <class TTr>
+void Rpc<TTr>::free_cancelled_msgbufs_st(SSlot *sslot) {
+  assert(in_dispatch());
+  auto &ci = sslot->client_info_;
+  assert(ci.cancelled_);
+
+  // Cancelled hedged copies share their hedge's buffers
+  if (unlikely(ci.cont_func_ == hedge_cont_func)) {
+    release_msg_frags(ci.resp_msgbuf_);
+    ci.resp_msgbuf_ = nullptr;
+    release_hedge_st(static_cast<hedge_copy_t *>(ci.tag_)->hedge_);
+    return;
+  }
+
+  assert(sslot->tx_msgbuf_ == &ci.cancel_req_msgbuf_);
+  assert(ci.resp_msgbuf_ == &ci.cancel_resp_msgbuf_);
+  release_msg_frags(ci.resp_msgbuf_);
+  free_msg_buffer(ci.cancel_resp_msgbuf_);
+  free_msg_buffer(ci.cancel_req_msgbuf_);
+  ci.resp_msgbuf_ = nullptr;
+}
+
+// This runs only when a deadline has passed, so it doesn't need to be fast
+template <class TTr>
+void Rpc<TTr>::expire_reqs_st() {
+  assert(in_dispatch());
+
+  // Continuations invoked below may enqueue requests, which lower this
+  next_deadline_tsc_ = SIZE_MAX;
+  size_t next_deadline_tsc = SIZE_MAX;
+
+  // Collect the expired requests in session slots first, since failing a
+  // request modifies the active RPC list
+  std::vector<SSlot *> expired_sslots;
+  SSlot *cur = active_rpcs_root_sentinel_.client_info_.next_;
+  while (cur != &active_rpcs_tail_sentinel_) {
+    const auto &ci = cur->client_info_;
+    if (ci.deadline_tsc_ != 0 && !ci.cancelled_) {
+      if (ci.deadline_tsc_ <= ev_loop_tsc_) {
+        expired_sslots.push_back(cur);
+      } else {
+        next_deadline_tsc = (std::min)(next_deadline_tsc, ci.deadline_tsc_);
+      }
+    }
+    cur = ci.next_;
+  }
+
+  // Index-based loop because continuations may create sessions
+  std::vector<enq_req_args_t> expired_backlog;
+  for (size_t i = 0; i < session_vec_.size(); i++) {
+    Session *session = session_vec_[i];
+    if (session == nullptr || !session->is_client()) continue;
+
+    auto &backlog = session->client_info_.enq_req_backlog_;
+    const size_t backlog_size = backlog.size();
+    for (size_t j = 0; j < backlog_size; j++) {
+      const enq_req_args_t req_args = backlog.front();
+      backlog.pop();
+      if (req_args.deadline_tsc_ == 0) {
+        backlog.push(req_args);
+      } else if (req_args.deadline_tsc_ <= ev_loop_tsc_) {
+        expired_backlog.push_back(req_args);
+      } else {
+        next_deadline_tsc =
+            (std::min)(next_deadline_tsc, req_args.deadline_tsc_);
+        backlog.push(req_args);
+      }
+    }
+  }
+
+  // Fail backlogged requests first, so that sslots released below don't pick
+  // them up from the backlog
+  for (const enq_req_args_t &req_args : expired_backlog) {
+    fail_req_st(req_args, -ETIMEDOUT);
+  }
+
+  for (SSlot *sslot : expired_sslots) {
+    // Continuations invoked above may have cancelled this request, or reused
+    // its sslot for a request that hasn't expired
+    const auto &ci = sslot->client_info_;
+    if (sslot->tx_msgbuf_ == nullptr || ci.cancelled_ ||
+        ci.deadline_tsc_ == 0 || ci.deadline_tsc_ > ev_loop_tsc_) {
+      continue;
+    }
+
+    // Out of memory: retry at the next packet loss scan
+    if (unlikely(abort_req_st(sslot, -ETIMEDOUT) != 0)) {
+      const size_t retry_tsc = ev_loop_tsc_ + rpc_pkt_loss_scan_cycles_;
+      next_deadline_tsc = (std::min)(next_deadline_tsc, retry_tsc);
+    }
+  }
+
+  next_deadline_tsc_ = (std::min)(next_deadline_tsc_, next_deadline_tsc);
+}
+
+FORCE_COMPILE_TRANSPORTS
+
+}  // namespace erpc
@@ -1,3 +1,7 @@
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
 #include "rpc.h"
 
 namespace erpc {
@@ -8,15 +12,21 @@ int Rpc<TTr>::run_event_loop_do_one_st() {
   dpath_stat_inc(dpath_stats_.ev_loop_calls_, 1);
 
   // Handle any new session management packets
-  if (unlikely(nexus_hook_.sm_rx_queue_.size_ > 0)) handle_sm_rx_st();
+  if (unlikely(!nexus_hook_.sm_rx_queue_.empty())) handle_sm_rx_st();
 
   // The packet RX code uses ev_loop_tsc as the RX timestamp, so it must be
   // next to ev_loop_tsc stamping.
   ev_loop_tsc_ = dpath_rdtsc();
   int num_pkts = process_comps_st();  // RX, process a message
 
+  // In completion-queue mode, hand this burst's completions to the app at once
+  if (batch_cont_func_ != nullptr && !comp_queue_.empty()) {
+    deliver_completions_st();
+  }
+
   process_credit_stall_queue_st();    // TX
   if (kCcPacing) process_wheel_st();  // TX
+  if (unlikely(grant_.pending_)) process_grants_st();  // TX
 
   // Drain all packets
   if (tx_batch_i_ > 0) do_tx_burst_st();
@@ -27,12 +37,18 @@ int Rpc<TTr>::run_event_loop_do_one_st() {
     process_bg_queues_enqueue_response_st();
   }
 
+  // Process requests submitted by non-eRPC threads
+  if (unlikely(!submit_ring_vec_.empty())) process_submit_rings_st();
+
   // Check for packet loss if we're in a new epoch. ev_loop_tsc is stale by
   // less than one event loop iteration, which is negligible compared to epoch.
   if (unlikely(ev_loop_tsc_ - pkt_loss_scan_tsc_ > rpc_pkt_loss_scan_cycles_)) {
     pkt_loss_scan_tsc_ = ev_loop_tsc_;
     pkt_loss_scan_st();
   }
+
+  if (unlikely(ev_loop_tsc_ >= next_deadline_tsc_)) expire_reqs_st();
+  if (unlikely(ev_loop_tsc_ >= next_hedge_tsc_)) process_hedges_st();
   return num_pkts;
 }
 
@@ -42,11 +58,164 @@ void Rpc<TTr>::run_event_loop_timeout_st(size_t timeout_ms) {
 
   size_t timeout_tsc = ms_to_cycles(timeout_ms, freq_ghz_);
   size_t start_tsc = rdtsc();  // For counting timeout_ms
+  size_t idle_start_tsc = start_tsc;
 
   while (true) {
-    run_event_loop_do_one_st();  // Run at least once even if timeout_ms is 0
+    // Run at least once even if timeout_ms is 0
+    const int num_pkts = run_event_loop_do_one_st();
     if (unlikely(ev_loop_tsc_ - start_tsc > timeout_tsc)) break;
+    if (likely(idle_spin_cycles_ == SIZE_MAX)) continue;
+
+    if (num_pkts > 0 || !is_idle_st()) {
+      idle_start_tsc = ev_loop_tsc_;
+      continue;
+    }
+
+    if (ev_loop_tsc_ - idle_start_tsc > idle_spin_cycles_) {
+      park_stats_.num_idle_iters_++;
+
+      // Don't park past the timeout, the next packet loss scan, the next
+      // request deadline, or the next hedge. The idle start time is not reset,
+      // so that timer wakeups don't restart the spin.
+      size_t park_cycles = timeout_tsc - (ev_loop_tsc_ - start_tsc);
+      const size_t since_scan = ev_loop_tsc_ - pkt_loss_scan_tsc_;
+      if (since_scan < rpc_pkt_loss_scan_cycles_) {
+        park_cycles =
+            (std::min)(park_cycles, rpc_pkt_loss_scan_cycles_ - since_scan);
+      }
+      const size_t next_timer_tsc =
+          (std::min)(next_deadline_tsc_, next_hedge_tsc_);
+      if (next_timer_tsc != SIZE_MAX) {
+        park_cycles = next_timer_tsc <= ev_loop_tsc_
+                          ? 0
+                          : (std::min)(park_cycles,
+                                       next_timer_tsc - ev_loop_tsc_);
+      }
+
+      // Round up so that the last microsecond before a timer isn't spent
+      // spinning
+      const auto park_us =
+          static_cast<size_t>(std::ceil(to_usec(park_cycles, freq_ghz_)));
+      park_st(park_us < kMaxParkUs ? park_us : kMaxParkUs);
+    }
+  }
+}
+
+template <class TTr>
+bool Rpc<TTr>::is_idle_st() const {
+  if (!stallq_.empty() || tx_batch_i_ > 0) return false;
+  if (kCcPacing && wheel_->get_num_wslot_entries() > 0) return false;
+  if (!nexus_hook_.sm_rx_queue_.empty()) return false;
+
+  if (multi_threaded_ && (!bg_queues_.enqueue_request_.empty() ||
+                          !bg_queues_.enqueue_response_.empty())) {
+    return false;
+  }
+
+  for (const submit_ring_t *submit_ring : submit_ring_vec_) {
+    if (!submit_ring->empty()) return false;
+  }
+  return true;
+}
+
+template <class TTr>
+void Rpc<TTr>::park_st(size_t park_us) {
+  assert(in_dispatch());
+  if (park_us == 0 || !transport_->arm_rx_event()) return;
+
+  struct pollfd pfd;
+  pfd.fd = transport_->get_rx_event_fd();
+  pfd.events = POLLIN;
+
+  struct timespec timeout;
+  timeout.tv_sec = static_cast<time_t>(park_us / 1000000);
+  timeout.tv_nsec = static_cast<long>((park_us % 1000000) * 1000);
+  park_stats_.num_parks_++;
+  if (ppoll(&pfd, 1, &timeout, nullptr) > 0) park_stats_.num_rx_wakeups_++;
+}
+
+template <class TTr>
+int Rpc<TTr>::get_event_fd() {
+  assert(in_dispatch());
+  if (event_epoll_fd_ != -1) return event_epoll_fd_;
+
+  const int rx_fd = transport_->get_rx_event_fd();
+  if (rx_fd == -1) return -ENOTSUP;
+
+  const int notify_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (notify_fd < 0) return -errno;
+
+  const int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd < 0) {
+    const int err = errno;
+    close(notify_fd);
+    return -err;
+  }
+
+  for (const int fd : {rx_fd, notify_fd}) {
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+      const int err = errno;
+      close(epoll_fd);
+      close(notify_fd);
+      return -err;
+    }
+  }
+
+  nexus_hook_.event_notify_fd_ = notify_fd;
+  event_epoll_fd_ = epoll_fd;
+  return event_epoll_fd_;
+}
+
+template <class TTr>
+bool Rpc<TTr>::arm_event_fd() {
+  assert(in_dispatch());
+  assert(event_epoll_fd_ != -1);
+
+  uint64_t counter;
+  while (read(nexus_hook_.event_notify_fd_, &counter, sizeof(counter)) > 0) {
+    // Clear stale notifications
   }
+
+  // See Nexus::Hook::notify_event()
+  nexus_hook_.event_waiting_.store(true);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  if (!is_idle_st() || !transport_->arm_rx_event()) {
+    nexus_hook_.event_waiting_.store(false);
+    return false;
+  }
+  return true;
+}
+
+template <class TTr>
+size_t Rpc<TTr>::next_deadline_ns() const {
+  assert(in_dispatch());
+  if (!is_idle_st()) return 0;
+
+  size_t deadline_tsc = SIZE_MAX;
+
+  // The packet loss scan matters only with outstanding requests
+  if (active_rpcs_root_sentinel_.client_info_.next_ !=
+          &active_rpcs_tail_sentinel_ ||
+      !sm_pending_reqs_.empty()) {
+    deadline_tsc = pkt_loss_scan_tsc_ + rpc_pkt_loss_scan_cycles_;
+  }
+
+  if (kCcPacing) {
+    deadline_tsc = (std::min)(deadline_tsc, wheel_->get_next_reap_tsc());
+  }
+
+  deadline_tsc = (std::min)(deadline_tsc, next_deadline_tsc_);  // Requests
+  deadline_tsc = (std::min)(deadline_tsc, next_hedge_tsc_);  // Hedges
+
+  if (deadline_tsc == SIZE_MAX) return SIZE_MAX;
+
+  const size_t cur_tsc = rdtsc();
+  if (deadline_tsc <= cur_tsc) return 0;
+  return static_cast<size_t>(to_nsec(deadline_tsc - cur_tsc, freq_ghz_));
 }
 
 FORCE_COMPILE_TRANSPORTS
@@ -0,0 +1,269 @@
+/**
+ * @file rpc_hedge.cc
+ * @brief Hedged requests across replica sessions
+ */
+#include "rpc.h"
+
+namespace erpc {
+
+template <class TTr>
+int Rpc<TTr>::enqueue_hedged_request(int primary_session_num,
+                                     int backup_session_num, uint8_t req_type,
+                                     MsgBuffer *req_msgbuf,
+                                     MsgBuffer *resp_msgbuf,
+                                     erpc_cont_func_t cont_func, void *tag) {
+  assert(in_dispatch());
+
+  for (int session_num : {primary_session_num, backup_session_num}) {
+    if (unlikely(!is_usr_session_num_in_range_st(session_num))) return -EINVAL;
+    Session *session = session_vec_[static_cast<size_t>(session_num)];
+    if (unlikely(session == nullptr || !session->is_client() ||
+                 !session->is_connected())) {
+      return -EINVAL;
+    }
+  }
+
+  if (unlikely(primary_session_num == backup_session_num ||
+               req_msgbuf->is_fragmented())) {
+    return -EINVAL;
+  }
+
+  if (unlikely(hedge_free_vec_.empty())) extend_hedge_pool_st();
+  hedge_t *hedge = hedge_free_vec_.back();
+  hedge_free_vec_.pop_back();
+
+  hedge->req_msgbuf_ = req_msgbuf;
+  hedge->resp_msgbuf_ = resp_msgbuf;
+  hedge->cont_func_ = cont_func;
+  hedge->tag_ = tag;
+  hedge->req_type_ = req_type;
+  hedge->backup_session_num_ = backup_session_num;
+
+  hedge->start_tsc_ = rdtsc();
+  hedge->hedge_tsc_ = hedge->start_tsc_ + hedge_delay_cycles_;
+  hedge->in_pending_ = true;
+  hedge->backup_sent_ = false;
+  hedge->done_ = false;
+  hedge->refcnt_ = 0;
+  hedge->own_req_msgbuf_.buf_ = nullptr;
+  hedge->own_resp_msgbuf_.buf_ = nullptr;
+  for (hedge_copy_t &copy : hedge->copies_) {
+    copy.hedge_ = hedge;
+    copy.live_ = false;
+  }
+
+  hedge_pending_vec_.push_back(hedge);
+  next_hedge_tsc_ = (std::min)(next_hedge_tsc_, hedge->hedge_tsc_);
+
+  // The primary copy uses the application's MsgBuffers
+  hedge->copies_[0].live_ = true;
+  enqueue_saved_request_st(
+      enq_req_args_t(primary_session_num, req_type, req_msgbuf, resp_msgbuf,
+                     hedge_cont_func, &hedge->copies_[0], kInvalidBgETid));
+  return 0;
+}
+
+template <class TTr>
+void Rpc<TTr>::send_hedge_backup_st(hedge_t *hedge) {
+  assert(!hedge->done_ && !hedge->backup_sent_);
+
+  // The backup session may have been disconnected after the request was
+  // enqueued. Then the request relies on the primary copy.
+  const int session_num = hedge->backup_session_num_;
+  Session *session = session_vec_[static_cast<size_t>(session_num)];
+  if (session == nullptr || !session->is_connected()) return;
+
+  // The backup copy sends an eRPC-owned copy of the request, which outlives
+  // the application's request MsgBuffer if the backup copy is cancelled in
+  // flight. Without memory for it, the request relies on the primary copy.
+  const MsgBuffer *req_msgbuf = hedge->req_msgbuf_;
+  hedge->own_req_msgbuf_ = alloc_msg_buffer(req_msgbuf->data_size_);
+  hedge->own_resp_msgbuf_ =
+      alloc_msg_buffer(hedge->resp_msgbuf_->max_data_size_);
+  if (unlikely(hedge->own_req_msgbuf_.buf_ == nullptr ||
+               hedge->own_resp_msgbuf_.buf_ == nullptr)) {
+    ERPC_WARN("Rpc %u: Failed to send hedge, out of hugepage memory.\n",
+              rpc_id_);
+    free_hedge_msgbufs_st(hedge);
+    return;
+  }
+  memcpy(hedge->own_req_msgbuf_.buf_, req_msgbuf->buf_, req_msgbuf->data_size_);
+
+  hedge->backup_sent_ = true;
+  hedge->copies_[1].live_ = true;
+  enqueue_saved_request_st(
+      enq_req_args_t(session_num, hedge->req_type_, &hedge->own_req_msgbuf_,
+                     &hedge->own_resp_msgbuf_, hedge_cont_func,
+                     &hedge->copies_[1], kInvalidBgETid));
+}
+
+template <class TTr>
+void Rpc<TTr>::complete_hedge_st(hedge_copy_t *copy, int status,
+                                 size_t resp_size) {
+  assert(in_dispatch());
+  hedge_t *hedge = copy->hedge_;
+  assert(copy->live_ && !hedge->done_);
+  const bool is_backup = (copy == &hedge->copies_[1]);
+  hedge_copy_t *other = &hedge->copies_[is_backup ? 0 : 1];
+  copy->live_ = false;
+
+  // A failed primary copy makes the backup copy due now
+  if (status != 0 && !hedge->backup_sent_) send_hedge_backup_st(hedge);
+
+  if (status == 0 || !other->live_) {
+    // This copy decides the request
+    hedge->done_ = true;
+    MsgBuffer *resp_msgbuf = hedge->resp_msgbuf_;
+    if (status == 0) {
+      update_hedge_delay_st(rdtsc() - hedge->start_tsc_);
+      if (is_backup) {
+        // A live primary copy tracks its response in the app's response
+        // MsgBuffer. It continues in the backup's response MsgBuffer after
+        // the backup's response, which may be fragmented, is gathered.
+        MsgBuffer *own_resp = &hedge->own_resp_msgbuf_;
+        const pkthdr_t primary_pkthdr_0 = *resp_msgbuf->get_pkthdr_0();
+        const size_t primary_resp_size = resp_msgbuf->data_size_;
+        release_msg_frags(resp_msgbuf);
+
+        resize_msg_buffer(resp_msgbuf, resp_size);
+        *resp_msgbuf->get_pkthdr_0() = *own_resp->get_pkthdr_0();
+        size_t offset = 0;
+        for (size_t i = 0; i < own_resp->get_num_frags(); i++) {
+          const msg_frag_t frag = own_resp->get_frag(i);
+          memcpy(resp_msgbuf->buf_ + offset, frag.buf_, frag.size_);
+          offset += frag.size_;
+        }
+
+        release_msg_frags(own_resp);
+        resize_msg_buffer(own_resp, primary_resp_size);
+        *own_resp->get_pkthdr_0() = primary_pkthdr_0;
+      }
+    } else {
+      resize_msg_buffer(resp_msgbuf, 0);  // 0 size marks the error
+    }
+
+    if (other->live_) cancel_hedge_copy_st(other);
+    complete_fg_req_st(hedge->cont_func_, hedge->tag_, status,
+                       status == 0 ? resp_size : 0);
+  }
+
+  free_hedge_if_unused_st(hedge);
+}
+
+template <class TTr>
+void Rpc<TTr>::cancel_hedge_copy_st(hedge_copy_t *copy) {
+  hedge_t *hedge = copy->hedge_;
+  assert(copy->live_ && hedge->done_);
+  copy->live_ = false;
+
+  SSlot *sslot = find_active_req_st(copy);
+  if (sslot == nullptr) {
+    enq_req_args_t req_args;
+    const bool found = remove_backlogged_req_st(copy, &req_args);
+    _unused(found);
+    assert(found);
+    return;
+  }
+
+  auto &ci = sslot->client_info_;
+  if (ci.num_tx_ == 0) {
+    release_unsent_req_st(sslot);
+    return;
+  }
+
+  // The server may be processing this copy, so it must finish the protocol
+  // (see abort_req_st()) without the application's request MsgBuffer. A
+  // backup copy already sends the hedge's copy of the request. A primary copy
+  // is cancelled only when the backup copy has completed, so the primary
+  // copy's headers move to the request copy that the backup no longer uses.
+  MsgBuffer *own_req = &hedge->own_req_msgbuf_;
+  assert(own_req->buf_ != nullptr);
+  drain_tx_batch_and_dma_queue();  // Packets may reference the request
+  if (sslot->tx_msgbuf_ != own_req) {
+    assert(sslot->tx_msgbuf_ == hedge->req_msgbuf_);
+    for (size_t i = 0; i < own_req->num_pkts_; i++) {
+      *own_req->get_pkthdr_n(i) = *sslot->tx_msgbuf_->get_pkthdr_n(i);
+    }
+    sslot->tx_msgbuf_ = own_req;
+  }
+
+  // Tell the server that the request has expired in case it gets request
+  // packets later, e.g., retransmissions
+  for (size_t i = 0; i < sslot->tx_msgbuf_->num_pkts_; i++) {
+    sslot->tx_msgbuf_->get_pkthdr_n(i)->deadline_us_ = 1;
+  }
+  ci.deadline_tsc_ = ev_loop_tsc_;
+
+  ci.resp_msgbuf_ = &hedge->own_resp_msgbuf_;
+  ci.cancelled_ = true;
+  hedge->refcnt_++;
+}
+
+template <class TTr>
+void Rpc<TTr>::free_hedge_if_unused_st(hedge_t *hedge) {
+  if (!hedge->done_ || hedge->copies_[0].live_ || hedge->copies_[1].live_ ||
+      hedge->refcnt_ > 0) {
+    return;
+  }
+
+  free_hedge_msgbufs_st(hedge);
+  if (!hedge->in_pending_) hedge_free_vec_.push_back(hedge);
+}
+
+template <class TTr>
+void Rpc<TTr>::free_hedge_msgbufs_st(hedge_t *hedge) {
+  if (hedge->own_req_msgbuf_.buf_ != nullptr) {
+    free_msg_buffer(hedge->own_req_msgbuf_);
+    hedge->own_req_msgbuf_.buf_ = nullptr;
+  }
+
+  if (hedge->own_resp_msgbuf_.buf_ != nullptr) {
+    release_msg_frags(&hedge->own_resp_msgbuf_);
+    free_msg_buffer(hedge->own_resp_msgbuf_);
+    hedge->own_resp_msgbuf_.buf_ = nullptr;
+  }
+}
+
+// This runs only when a hedge delay has passed, so it doesn't need to be fast
+template <class TTr>
+void Rpc<TTr>::process_hedges_st() {
+  assert(in_dispatch());
+
+  // Completed and already-hedged requests are removed lazily, here
+  std::vector<hedge_t *> due_hedges;
+  size_t next_hedge_tsc = SIZE_MAX;
+  size_t num_pending = 0;
+  for (hedge_t *hedge : hedge_pending_vec_) {
+    if (hedge->done_ || hedge->backup_sent_) {
+      hedge->in_pending_ = false;
+      free_hedge_if_unused_st(hedge);
+    } else if (hedge->hedge_tsc_ <= ev_loop_tsc_) {
+      hedge->in_pending_ = false;
+      due_hedges.push_back(hedge);
+    } else {
+      next_hedge_tsc = (std::min)(next_hedge_tsc, hedge->hedge_tsc_);
+      hedge_pending_vec_[num_pending++] = hedge;
+    }
+  }
+  hedge_pending_vec_.resize(num_pending);
+  next_hedge_tsc_ = next_hedge_tsc;
+
+  for (hedge_t *hedge : due_hedges) send_hedge_backup_st(hedge);
+}
+
+template <class TTr>
+void Rpc<TTr>::update_hedge_delay_st(size_t latency_cycles) {
+  hedge_latency_.update(
+      static_cast<size_t>(to_usec(latency_cycles, freq_ghz_)));
+  hedge_num_samples_++;
+  if (hedge_num_samples_ % kHedgeUpdateSamples != 0) return;
+
+  // Computing a percentile is slow, so do it rarely
+  const size_t delay_us = hedge_latency_.perc(hedge_percentile_);
+  hedge_delay_cycles_ = us_to_cycles(delay_us > 0 ? delay_us : 1, freq_ghz_);
+  if (hedge_num_samples_ % kHedgeHistorySamples == 0) hedge_latency_.reset();
+}
+
+FORCE_COMPILE_TRANSPORTS
+
+}  // namespace erpc
@@ -9,8 +9,7 @@ void Rpc<TTr>::kick_req_st(SSlot *sslot) {
   assert(credits > 0);  // Precondition
 
   auto &ci = sslot->client_info_;
-  size_t sending =
-      (std::min)(credits, sslot->tx_msgbuf_->num_pkts_ - ci.num_tx_);
+  size_t sending = req_pkts_sendable(sslot, credits);
   bool bypass = can_bypass_wheel(sslot);
 
   for (size_t x = 0; x < sending; x++) {
@@ -103,8 +103,10 @@ void Rpc<TTr>::pkt_loss_retransmit_st(SSlot *sslot) {
     return;
   }
 
-  // We have num_tx > num_rx, so stallq cannot contain sslot
-  assert(std::find(stallq_.begin(), stallq_.end(), sslot) == stallq_.end());
+  // We have num_tx > num_rx, so stallq cannot contain sslot, unless SRPT
+  // scheduling left this sslot's remaining packets in the stall queue
+  assert(srpt_.enabled_ ||
+         std::find(stallq_.begin(), stallq_.end(), sslot) == stallq_.end());
 
   // Do not roll back if this request still has packets in the wheel. Deleting
   // from the wheel is too complex.
@@ -117,6 +119,9 @@ void Rpc<TTr>::pkt_loss_retransmit_st(SSlot *sslot) {
   // If we're here, we will roll back and retransmit
   pkt_loss_stats_.num_re_tx_++;
   sslot->session_->client_info_.num_re_tx_++;
+  if (kCcRateComp && likely(!grant_.enabled_)) {
+    sslot->session_->client_info_.cc_.policy_.on_loss(ev_loop_tsc_);
+  }
 
   ERPC_REORDER("%s: Retransmitting %s.\n", issue_msg,
                ci.num_rx_ < req_msgbuf->num_pkts_ ? "requests" : "RFRs");
@@ -124,6 +129,19 @@ void Rpc<TTr>::pkt_loss_retransmit_st(SSlot *sslot) {
   ci.num_tx_ = ci.num_rx_;
   ci.progress_tsc_ = ev_loop_tsc_;
 
+  // Retransmitted request packets carry the remaining time budget
+  if (unlikely(ci.deadline_tsc_ != 0)) {
+    const size_t deadline_us =
+        deadline_tsc_to_us(ci.deadline_tsc_, ev_loop_tsc_);
+    for (size_t i = ci.num_tx_; i < req_msgbuf->num_pkts_; i++) {
+      req_msgbuf->get_pkthdr_n(i)->deadline_us_ = deadline_us;
+    }
+  }
+
+  if (unlikely(srpt_.enabled_)) {
+    srpt_stall_st(sslot);
+    return;
+  }
   req_pkts_pending(sslot) ? kick_req_st(sslot) : kick_rfr_st(sslot);
 }
 
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "rpc.h"
 
 namespace erpc {
@@ -5,11 +7,19 @@ namespace erpc {
 template <class TTr>
 void Rpc<TTr>::process_credit_stall_queue_st() {
   assert(in_dispatch());
+  if (unlikely(srpt_.enabled_)) {
+    if (!stallq_.empty()) process_srpt_stall_queue_st();
+    return;
+  }
+
   size_t write_index = 0;  // Re-add incomplete sslots at this index
 
+  // The stall queue is in priority order, so higher-priority sslots get their
+  // session's credits first. Compaction preserves this order.
   for (SSlot *sslot : stallq_) {
     if (sslot->session_->client_info_.credits_ > 0) {
       // sslots in stall queue have packets to send
+      sslot->client_info_.stalled_ = false;
       req_pkts_pending(sslot) ? kick_req_st(sslot) : kick_rfr_st(sslot);
     } else {
       stallq_[write_index++] = sslot;
@@ -19,6 +29,59 @@ void Rpc<TTr>::process_credit_stall_queue_st() {
   stallq_.resize(write_index);  // Number of sslots left = write_index
 }
 
+template <class TTr>
+void Rpc<TTr>::process_srpt_stall_queue_st() {
+  assert(in_dispatch());
+
+  // Sorting is wasted work if no stalled sslot has credits
+  bool have_credits = false;
+  for (SSlot *sslot : stallq_) {
+    have_credits |= (sslot->session_->client_info_.credits_ > 0);
+  }
+  if (!have_credits) return;
+
+  // Order sslots by priority, and then by packets left to transmit, minus the
+  // aging credit for their waiting time
+  auto &sort_vec = srpt_.sort_vec_;
+  sort_vec.clear();
+  for (SSlot *sslot : stallq_) {
+    assert(pkts_left_to_tx(sslot) > 0);
+    const size_t enqueue_tsc = sslot->client_info_.enqueue_tsc_;
+    const size_t wait_cycles =
+        ev_loop_tsc_ > enqueue_tsc ? ev_loop_tsc_ - enqueue_tsc : 0;
+    sort_vec.emplace_back(pkts_left_to_tx(sslot) -
+                              wait_cycles * srpt_.aging_per_cycle_,
+                          sslot);
+  }
+
+  std::stable_sort(sort_vec.begin(), sort_vec.end(),
+                   [](const std::pair<double, SSlot *> &a,
+                      const std::pair<double, SSlot *> &b) {
+                     if (a.second->priority_ != b.second->priority_) {
+                       return a.second->priority_ > b.second->priority_;
+                     }
+                     return a.first < b.first;
+                   });
+
+  // A kicked sslot uses all of its session's credits that it can, so the
+  // next sslot of the session gets only the leftover credits. sslots that
+  // still have packets left wait for more credits.
+  size_t write_index = 0;
+  for (auto &ent : sort_vec) {
+    SSlot *sslot = ent.second;
+    if (sslot->session_->client_info_.credits_ > 0) {
+      req_pkts_pending(sslot) ? kick_req_st(sslot) : kick_rfr_st(sslot);
+      if (pkts_left_to_tx(sslot) == 0) {
+        sslot->client_info_.stalled_ = false;
+        continue;
+      }
+    }
+    stallq_[write_index++] = sslot;
+  }
+
+  stallq_.resize(write_index);
+}
+
 template <class TTr>
 void Rpc<TTr>::process_wheel_st() {
   assert(in_dispatch());
@@ -46,8 +109,10 @@ void Rpc<TTr>::process_wheel_st() {
       enqueue_rfr_st(sslot, resp_msgbuf->get_pkthdr_0());
     }
 
-    sslot->client_info_.wheel_count_--;
-    sslot->client_info_.in_wheel_[crd_i] = false;
+    // Time spent paced in the wheel doesn't count toward the RTO
+    ci.progress_tsc_ = ev_loop_tsc_;
+    ci.wheel_count_--;
+    ci.in_wheel_[crd_i] = false;
     wheel_->ready_queue_.pop();
   }
 }
@@ -56,13 +121,16 @@ template <class TTr>
 void Rpc<TTr>::process_bg_queues_enqueue_request_st() {
   assert(in_dispatch());
   auto &queue = bg_queues_.enqueue_request_;
-  const size_t cmds_to_process = queue.size_;  // Reduce cache line traffic
+  enq_req_args_t args_arr[kBgQueueBurstSize];
+
+  // Bound the work per call so that busy producers can't starve the event loop
+  for (size_t i = 0; i < kBgQueueSize / kBgQueueBurstSize; i++) {
+    const size_t num_args = queue.pop_burst(args_arr, kBgQueueBurstSize);
+    if (num_args == 0) break;
 
-  for (size_t i = 0; i < cmds_to_process; i++) {
-    enq_req_args_t args = queue.unlocked_pop();
-    enqueue_request(args.session_num_, args.req_type_, args.req_msgbuf_,
-                    args.resp_msgbuf_, args.cont_func_, args.tag_,
-                    args.cont_etid_);
+    for (size_t j = 0; j < num_args; j++) {
+      enqueue_saved_request_st(args_arr[j]);
+    }
   }
 }
 
@@ -70,11 +138,38 @@ template <class TTr>
 void Rpc<TTr>::process_bg_queues_enqueue_response_st() {
   assert(in_dispatch());
   auto &queue = bg_queues_.enqueue_response_;
-  const size_t cmds_to_process = queue.size_;  // Reduce cache line traffic
+  enq_resp_args_t args_arr[kBgQueueBurstSize];
+
+  for (size_t i = 0; i < kBgQueueSize / kBgQueueBurstSize; i++) {
+    const size_t num_args = queue.pop_burst(args_arr, kBgQueueBurstSize);
+    if (num_args == 0) break;
+
+    for (size_t j = 0; j < num_args; j++) {
+      enqueue_response(args_arr[j].req_handle_, args_arr[j].resp_msgbuf_);
+    }
+  }
+}
 
-  for (size_t i = 0; i < cmds_to_process; i++) {
-    enq_resp_args_t enq_resp_args = queue.unlocked_pop();
-    enqueue_response(enq_resp_args.req_handle_, enq_resp_args.resp_msgbuf_);
+template <class TTr>
+typename Rpc<TTr>::submit_ring_t *Rpc<TTr>::create_submit_ring() {
+  assert(in_dispatch());
+  auto *submit_ring = new submit_ring_t();
+  submit_ring_vec_.push_back(submit_ring);
+  return submit_ring;
+}
+
+template <class TTr>
+void Rpc<TTr>::process_submit_rings_st() {
+  assert(in_dispatch());
+  enq_req_args_t args_arr[kBgQueueBurstSize];
+
+  for (submit_ring_t *submit_ring : submit_ring_vec_) {
+    const size_t num_args = submit_ring->pop_burst(args_arr, kBgQueueBurstSize);
+    for (size_t i = 0; i < num_args; i++) {
+      // Non-eRPC threads can't run continuations, so run them here
+      args_arr[i].cont_etid_ = kInvalidBgETid;
+      enqueue_saved_request_st(args_arr[i]);
+    }
   }
 }
 
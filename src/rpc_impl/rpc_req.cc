@@ -4,59 +4,65 @@
 
 namespace erpc {
 
-// The cont_etid parameter is passed only when the event loop processes the
-// background threads' queue of enqueue_request calls.
 template <class TTr>
-void Rpc<TTr>::enqueue_request(int session_num, uint8_t req_type,
-                               MsgBuffer *req_msgbuf, MsgBuffer *resp_msgbuf,
-                               erpc_cont_func_t cont_func, void *tag,
-                               size_t cont_etid) {
-  // When called from a background thread, enqueue to the foreground thread
-  if (unlikely(!in_dispatch())) {
-    auto req_args = enq_req_args_t(session_num, req_type, req_msgbuf,
-                                   resp_msgbuf, cont_func, tag, get_etid());
-    bg_queues_.enqueue_request_.unlocked_push(req_args);
-    return;
-  }
-
-  // If we're here, we're in the dispatch thread
-  Session *session = session_vec_[static_cast<size_t>(session_num)];
+inline SSlot *Rpc<TTr>::init_req_sslot_st(Session *session,
+                                          const enq_req_args_t &req_args) {
+  assert(in_dispatch());
   assert(session->is_connected());  // User is notified before we disconnect
+  assert(!req_args.resp_msgbuf_->is_fragmented());  // See release_msg_frags()
+
+  // Requests that expire here are failed by the event loop, not by this call,
+  // so that a continuation re-enqueuing its request cannot recurse
+  size_t deadline_us = 0;  // The time budget carried in the request packets
+  if (unlikely(req_args.deadline_tsc_ != 0)) {
+    deadline_us = deadline_tsc_to_us(req_args.deadline_tsc_, rdtsc());
+    next_deadline_tsc_ = (std::min)(next_deadline_tsc_, req_args.deadline_tsc_);
+  }
 
   // If a free sslot is unavailable, save to session backlog
   if (unlikely(session->client_info_.sslot_free_vec_.size() == 0)) {
-    session->client_info_.enq_req_backlog_.emplace(session_num, req_type,
-                                                   req_msgbuf, resp_msgbuf,
-                                                   cont_func, tag, cont_etid);
-    return;
+    session->client_info_.enq_req_backlog_.push(req_args);
+    return nullptr;
   }
 
+  MsgBuffer *req_msgbuf = req_args.req_msgbuf_;
+
   // Fill in the sslot info
   size_t sslot_i = session->client_info_.sslot_free_vec_.pop_back();
   SSlot &sslot = session->sslot_arr_[sslot_i];
   assert(sslot.tx_msgbuf_ == nullptr);  // Previous response was received
   sslot.tx_msgbuf_ = req_msgbuf;        // Mark the request as active/incomplete
   sslot.cur_req_num_ += kSessionReqWindow;  // Move to next request
+  sslot.priority_ = req_args.priority_ == kPriorityOfReqType
+                        ? req_type_priority_[req_args.req_type_]
+                        : req_args.priority_;
 
   auto &ci = sslot.client_info_;
-  ci.resp_msgbuf_ = resp_msgbuf;
-  ci.cont_func_ = cont_func;
-  ci.tag_ = tag;
+  ci.resp_msgbuf_ = req_args.resp_msgbuf_;
+  ci.cont_func_ = req_args.cont_func_;
+  ci.tag_ = req_args.tag_;
   ci.progress_tsc_ = ev_loop_tsc_;
   add_to_active_rpc_list(sslot);
 
   ci.num_rx_ = 0;
   ci.num_tx_ = 0;
-  ci.cont_etid_ = cont_etid;
+  ci.cont_etid_ = req_args.cont_etid_;
+  ci.deadline_tsc_ = req_args.deadline_tsc_;
+  ci.cancelled_ = false;
+  ci.enqueue_tsc_ = ev_loop_tsc_;
+  ci.stalled_ = false;
 
   // Fill in packet 0's header
   pkthdr_t *pkthdr_0 = req_msgbuf->get_pkthdr_0();
-  pkthdr_0->req_type_ = req_type;
+  pkthdr_0->req_type_ = req_args.req_type_;
   pkthdr_0->msg_size_ = req_msgbuf->data_size_;
   pkthdr_0->dest_session_num_ = session->remote_session_num_;
   pkthdr_0->pkt_type_ = PktType::kReq;
   pkthdr_0->pkt_num_ = 0;
   pkthdr_0->req_num_ = sslot.cur_req_num_;
+  pkthdr_0->clear_word_2();  // The buffer may hold a received response header
+  pkthdr_0->deadline_us_ = deadline_us;
+  pkthdr_0->priority_ = sslot.priority_;
 
   // Fill in any non-zeroth packet headers, using pkthdr_0 as the base.
   if (unlikely(req_msgbuf->num_pkts_ > 1)) {
@@ -67,10 +73,89 @@ void Rpc<TTr>::enqueue_request(int session_num, uint8_t req_type,
     }
   }
 
-  if (likely(session->client_info_.credits_ > 0)) {
-    kick_req_st(&sslot);
-  } else {
-    stallq_.push_back(&sslot);
+  return &sslot;
+}
+
+template <class TTr>
+inline void Rpc<TTr>::enqueue_request_st(Session *session,
+                                         const enq_req_args_t &req_args) {
+  SSlot *sslot = init_req_sslot_st(session, req_args);
+  if (sslot != nullptr) start_req_st(session, sslot);
+}
+
+template <class TTr>
+void Rpc<TTr>::enqueue_request(int session_num, uint8_t req_type,
+                               MsgBuffer *req_msgbuf, MsgBuffer *resp_msgbuf,
+                               erpc_cont_func_t cont_func, void *tag,
+                               size_t deadline_us, uint8_t priority) {
+  assert(priority < kNumPriorities || priority == kPriorityOfReqType);
+  auto req_args = enq_req_args_t(session_num, req_type, req_msgbuf,
+                                 resp_msgbuf, cont_func, tag);
+  req_args.priority_ = priority;
+  if (deadline_us != 0) {
+    req_args.deadline_tsc_ = rdtsc() + us_to_cycles(deadline_us, freq_ghz_);
+  }
+
+  // When called from a background thread, enqueue to the foreground thread
+  if (unlikely(!in_dispatch())) {
+    req_args.cont_etid_ = get_etid();
+    bg_queues_.enqueue_request_.push(req_args);
+    nexus_hook_.notify_event();
+    return;
+  }
+
+  // If we're here, we're in the dispatch thread
+  Session *session = session_vec_[static_cast<size_t>(session_num)];
+  enqueue_request_st(session, req_args);
+}
+
+template <class TTr>
+void Rpc<TTr>::enqueue_saved_request_st(const enq_req_args_t &req_args) {
+  assert(in_dispatch());
+  Session *session = session_vec_[static_cast<size_t>(req_args.session_num_)];
+  enqueue_request_st(session, req_args);
+}
+
+template <class TTr>
+void Rpc<TTr>::enqueue_request_batch(const enq_req_args_t *reqs,
+                                     size_t num_reqs) {
+  if (unlikely(!in_dispatch())) {
+    for (size_t i = 0; i < num_reqs; i++) {
+      enq_req_args_t req_args = reqs[i];
+      req_args.cont_etid_ = get_etid();
+      bg_queues_.enqueue_request_.push(req_args);
+    }
+    nexus_hook_.notify_event();
+    return;
+  }
+
+  // First pass: Prefetch the session state and request headers that the
+  // second pass writes, so that their cache misses overlap
+  for (size_t i = 0; i < num_reqs; i++) {
+    Session *session = session_vec_[static_cast<size_t>(reqs[i].session_num_)];
+    __builtin_prefetch(&session->client_info_, 1, 3);
+    __builtin_prefetch(reqs[i].req_msgbuf_->get_pkthdr_0(), 1, 3);
+  }
+
+  // Second pass: Handle each run of requests for one session together. The
+  // session is looked up once, all the run's sslots and headers are filled
+  // in, and then the requests are transmitted in order, which gives the same
+  // result as enqueueing them one by one. Packets go to the TX burst array,
+  // which is flushed only when it holds TTr::kPostlist packets, or at the end
+  // of this event loop iteration.
+  size_t i = 0;
+  while (i < num_reqs) {
+    const int session_num = reqs[i].session_num_;
+    Session *session = session_vec_[static_cast<size_t>(session_num)];
+
+    SSlot *sslots[kSessionReqWindow];  // A session has this many sslots
+    size_t num_sslots = 0;
+    for (; i < num_reqs && reqs[i].session_num_ == session_num; i++) {
+      SSlot *sslot = init_req_sslot_st(session, reqs[i]);
+      if (sslot != nullptr) sslots[num_sslots++] = sslot;
+    }
+
+    for (size_t j = 0; j < num_sslots; j++) start_req_st(session, sslots[j]);
   }
 }
 
@@ -119,7 +204,10 @@ void Rpc<TTr>::process_small_req_st(SSlot *sslot, pkthdr_t *pkthdr) {
 
   // Update sslot tracking
   sslot->cur_req_num_ = pkthdr->req_num_;
+  sslot->priority_ = pkthdr->priority_;
   sslot->server_info_.num_rx_ = 1;
+  sslot->server_info_.ecn_ce_ = pkthdr->ecn_ce_;
+  set_server_deadline_st(sslot, pkthdr);
 
   const ReqFunc &req_func = req_func_arr_[pkthdr->req_type_];
 
@@ -130,6 +218,12 @@ void Rpc<TTr>::process_small_req_st(SSlot *sslot, pkthdr_t *pkthdr) {
   sslot->server_info_.req_type_ = pkthdr->req_type_;
   sslot->server_info_.req_func_type_ = req_func.req_func_type_;
 
+  if (unlikely(shed_req_st(sslot))) {
+    req_msgbuf = MsgBuffer(pkthdr, pkthdr->msg_size_);  // Needed for the resp
+    enqueue_overloaded_response_st(sslot);
+    return;
+  }
+
   if (likely(!req_func.is_background())) {
     if (kZeroCopyRX) {
       // For foreground request handlers, a "fake" static request msgbuf
@@ -138,14 +232,22 @@ void Rpc<TTr>::process_small_req_st(SSlot *sslot, pkthdr_t *pkthdr) {
       req_msgbuf = MsgBuffer(pkthdr, pkthdr->msg_size_);
     } else {
       req_msgbuf = alloc_msg_buffer(pkthdr->msg_size_);
-      memcpy(req_msgbuf.buf_, pkthdr + 1, pkthdr->msg_size_);  // Omit header
+      dpath_memcpy(req_msgbuf.buf_, pkthdr + 1, pkthdr->msg_size_);  // No hdr
     }
+
+    if (unlikely(req_func.is_batch())) {
+      // The RX ring packet stays valid until the batch handler is invoked at
+      // the end of this RX burst
+      batch_req_vec_.push_back(sslot);
+      return;
+    }
+
     req_func.req_func_(static_cast<ReqHandle *>(sslot), context_);
     return;
   } else {
     // Background request handlers need an RX ring--independent request copy
     req_msgbuf = alloc_msg_buffer(pkthdr->msg_size_);
-    memcpy(req_msgbuf.buf_, pkthdr + 1, pkthdr->msg_size_);  // Omit header
+    dpath_memcpy(req_msgbuf.buf_, pkthdr + 1, pkthdr->msg_size_);  // No hdr
     submit_bg_req_st(sslot);
     return;
   }
@@ -186,8 +288,15 @@ void Rpc<TTr>::process_large_req_one_st(SSlot *sslot, const pkthdr_t *pkthdr) {
     // req_msgbuf could be buried if we have received the entire request and
     // queued the response, so directly compute number of packets in request.
     if (pkthdr->pkt_num_ != data_size_to_num_pkts(pkthdr->msg_size_) - 1) {
+      // With grant CC, a credit return that wasn't sent yet is still deferred
+      if (unlikely(grant_.enabled_) &&
+          pkthdr->pkt_num_ >= sslot->server_info_.num_grants_) {
+        ERPC_REORDER("%s: Dropping because grant is pending.\n", issue_msg);
+        return;
+      }
+
       ERPC_REORDER("%s: Re-sending credit return.\n", issue_msg);
-      enqueue_cr_st(sslot, pkthdr);  // Header only, so tx_flush uneeded
+      enqueue_cr_st(sslot, pkthdr->req_type_, pkthdr->pkt_num_);  // Header only
       return;
     }
 
@@ -216,26 +325,61 @@ void Rpc<TTr>::process_large_req_one_st(SSlot *sslot, const pkthdr_t *pkthdr) {
     // cur_req_num as unavailable.
     bury_resp_msgbuf_server_st(sslot);
 
-    req_msgbuf = alloc_msg_buffer(pkthdr->msg_size_);
-    assert(req_msgbuf.buf_ != nullptr);
+    const size_t num_pkts = data_size_to_num_pkts(pkthdr->msg_size_);
+    if (!req_func_arr_[pkthdr->req_type_].is_background() &&
+        can_frag_rx_st(num_pkts)) {
+      // Reference the request's packets in the RX ring instead of copying
+      req_msgbuf = MsgBuffer(const_cast<pkthdr_t *>(pkthdr), pkthdr->msg_size_,
+                             num_pkts);
+      start_frag_rx_st(&req_msgbuf);
+    } else {
+      req_msgbuf = alloc_msg_buffer(pkthdr->msg_size_);
+      assert(req_msgbuf.buf_ != nullptr);
+    }
 
     // Update sslot tracking
     sslot->cur_req_num_ = pkthdr->req_num_;
+    sslot->priority_ = pkthdr->priority_;
     sslot->server_info_.num_rx_ = 1;
+    sslot->server_info_.ecn_ce_ = pkthdr->ecn_ce_;
+    set_server_deadline_st(sslot, pkthdr);
+
+    if (unlikely(grant_.enabled_)) {
+      sslot->server_info_.num_grants_ = 0;
+      sslot->server_info_.grant_req_type_ = pkthdr->req_type_;
+      grant_.sslot_vec_.push_back(sslot);
+    }
   } else {
     // This is not the first packet for this request
     sslot->server_info_.num_rx_++;
+    sslot->server_info_.ecn_ce_ |= pkthdr->ecn_ce_;
   }
 
-  // Send a credit return for every request packet except the last in sequence
-  if (pkthdr->pkt_num_ != req_msgbuf.num_pkts_ - 1) {
-    enqueue_cr_st(sslot, pkthdr);
+  if (unlikely(grant_.enabled_)) {
+    // Credit returns are deferred to process_grants_st(), except that all
+    // owed credit returns are sent once the request is complete
+    auto &si = sslot->server_info_;
+    grant_.pending_ = true;
+    if (si.num_rx_ == req_msgbuf.num_pkts_) {
+      for (; si.num_grants_ < req_msgbuf.num_pkts_ - 1; si.num_grants_++) {
+        enqueue_cr_st(sslot, pkthdr->req_type_, si.num_grants_);
+      }
+      remove_from_grant_list_st(sslot);
+    }
+  } else if (pkthdr->pkt_num_ != req_msgbuf.num_pkts_ - 1) {
+    // Send a credit return for every request packet except the last
+    enqueue_cr_st(sslot, pkthdr->req_type_, pkthdr->pkt_num_);
   }
 
-  copy_data_to_msgbuf(&req_msgbuf, pkthdr->pkt_num_, pkthdr);  // Omits header
+  if (req_msgbuf.is_fragmented()) {
+    hold_rx_pkt_st(&req_msgbuf, pkthdr);
+  } else {
+    copy_data_to_msgbuf(&req_msgbuf, pkthdr->pkt_num_, pkthdr);  // Omits hdr
+  }
 
   // Invoke the request handler iff we have all the request packets
   if (sslot->server_info_.num_rx_ != req_msgbuf.num_pkts_) return;
+  if (req_msgbuf.data_size_ >= kDpathMemcpyNtThresh) dpath_memcpy_fence();
 
   const ReqFunc &req_func = req_func_arr_[pkthdr->req_type_];
 
@@ -246,14 +390,69 @@ void Rpc<TTr>::process_large_req_one_st(SSlot *sslot, const pkthdr_t *pkthdr) {
   sslot->server_info_.req_type_ = pkthdr->req_type_;
   sslot->server_info_.req_func_type_ = req_func.req_func_type_;
 
-  // req_msgbuf here is independent of the RX ring, so don't make another copy
+  // Don't run the handler if the request expired while its packets arrived
+  if (unlikely(server_req_expired(sslot, ev_loop_tsc_))) {
+    enqueue_expired_response(sslot);
+    return;
+  }
+
+  if (unlikely(shed_req_st(sslot))) {
+    enqueue_overloaded_response_st(sslot);
+    return;
+  }
+
+  // req_msgbuf here is independent of the RX ring (or holds its ring buffers
+  // until enqueue_response()), so don't make another copy
   if (likely(!req_func.is_background())) {
-    req_func.req_func_(static_cast<ReqHandle *>(sslot), context_);
+    if (unlikely(req_func.is_batch())) {
+      batch_req_vec_.push_back(sslot);
+    } else {
+      req_func.req_func_(static_cast<ReqHandle *>(sslot), context_);
+    }
   } else {
     submit_bg_req_st(sslot);
   }
 }
 
+template <class TTr>
+void Rpc<TTr>::process_batch_reqs_st() {
+  assert(in_dispatch());
+
+  // Invoke each request type's batch handler once, in the order of the types'
+  // first requests. Requests of other types are compacted to the front of
+  // batch_req_vec_, preserving their order.
+  size_t num_left = batch_req_vec_.size();
+  while (num_left > 0) {
+    const uint8_t req_type = batch_req_vec_[0]->server_info_.req_type_;
+
+    size_t num_other = 0;
+    batch_req_handles_.clear();
+    for (size_t i = 0; i < num_left; i++) {
+      SSlot *sslot = batch_req_vec_[i];
+      if (sslot->server_info_.req_type_ == req_type) {
+        batch_req_handles_.push_back(static_cast<ReqHandle *>(sslot));
+      } else {
+        batch_req_vec_[num_other++] = sslot;
+      }
+    }
+
+    if (unlikely(admission_.target_cycles_ != 0)) {
+      const size_t handler_tsc = dpath_rdtsc();
+      for (ReqHandle *req_handle : batch_req_handles_) {
+        static_cast<SSlot *>(req_handle)->server_info_.handler_tsc_ =
+            handler_tsc;
+      }
+    }
+
+    // The handler's enqueue_response() calls invalidate the sslots' req_type
+    req_func_arr_[req_type].batch_req_func_(
+        batch_req_handles_.data(), batch_req_handles_.size(), context_);
+    num_left = num_other;
+  }
+
+  batch_req_vec_.clear();
+}
+
 FORCE_COMPILE_TRANSPORTS
 
 }  // namespace erpc
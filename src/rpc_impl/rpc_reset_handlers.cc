@@ -24,14 +24,31 @@ bool Rpc<TTr>::handle_reset_client_st(Session *session) {
 
   // Invoke continuation-with-failure for all active requests
   for (SSlot &sslot : session->sslot_arr_) {
-    if (sslot.tx_msgbuf_ == nullptr) {
-      sslot.tx_msgbuf_ = nullptr;
+    if (sslot.tx_msgbuf_ != nullptr) {
+      if (sslot.tx_msgbuf_->is_fragmented()) {
+        free_sg_msg_buffer(sslot.tx_msgbuf_);
+      }
       delete_from_active_rpc_list(sslot);
       session->client_info_.sslot_free_vec_.push_back(sslot.index_);
 
+      // The app already got the failure of a cancelled request
+      if (sslot.client_info_.cancelled_) {
+        free_cancelled_msgbufs_st(&sslot);
+        sslot.tx_msgbuf_ = nullptr;
+        continue;
+      }
+      sslot.tx_msgbuf_ = nullptr;
+
       MsgBuffer *resp_msgbuf = sslot.client_info_.resp_msgbuf_;
+      release_msg_frags(resp_msgbuf);  // Partially-received response
       resize_msg_buffer(resp_msgbuf, 0);  // 0 response size marks the error
-      sslot.client_info_.cont_func_(context_, sslot.client_info_.tag_);
+
+      const auto &ci = sslot.client_info_;
+      if (ci.cont_etid_ == kInvalidBgETid) {
+        complete_fg_req_st(ci.cont_func_, ci.tag_, -ECONNRESET, 0);
+      } else {
+        ci.cont_func_(context_, ci.tag_);
+      }
     }
   }
 
@@ -11,8 +11,9 @@ template <class TTr>
 void Rpc<TTr>::enqueue_response(ReqHandle *req_handle, MsgBuffer *resp_msgbuf) {
   // When called from a background thread, enqueue to the foreground thread
   if (unlikely(!in_dispatch())) {
-    bg_queues_.enqueue_response_.unlocked_push(
+    bg_queues_.enqueue_response_.push(
         enq_resp_args_t(req_handle, resp_msgbuf));
+    nexus_hook_.notify_event();
     return;
   }
 
@@ -37,6 +38,12 @@ void Rpc<TTr>::enqueue_response(ReqHandle *req_handle, MsgBuffer *resp_msgbuf) {
     return;  // During session reset, don't add packets to TX burst
   }
 
+  auto &si = sslot->server_info_;
+  if (unlikely(admission_.target_cycles_ != 0) && !si.expired_ &&
+      !si.overloaded_) {
+    sample_server_delay_st(sslot);
+  }
+
   // Fill in packet 0's header
   pkthdr_t *resp_pkthdr_0 = resp_msgbuf->get_pkthdr_0();
   resp_pkthdr_0->req_type_ = sslot->server_info_.req_type_;
@@ -45,6 +52,14 @@ void Rpc<TTr>::enqueue_response(ReqHandle *req_handle, MsgBuffer *resp_msgbuf) {
   resp_pkthdr_0->pkt_type_ = PktType::kResp;
   resp_pkthdr_0->pkt_num_ = sslot->server_info_.sav_num_req_pkts_ - 1;
   resp_pkthdr_0->req_num_ = sslot->cur_req_num_;
+  resp_pkthdr_0->clear_word_2();
+  resp_pkthdr_0->expired_ = si.expired_;
+  resp_pkthdr_0->overloaded_ = si.overloaded_;
+  resp_pkthdr_0->priority_ = sslot->priority_;
+  resp_pkthdr_0->ecn_echo_ = si.ecn_ce_;
+  si.expired_ = false;
+  si.overloaded_ = false;
+  si.ecn_ce_ = false;
 
   // Fill in non-zeroth packet headers, if any
   if (resp_msgbuf->num_pkts_ > 1) {
@@ -54,6 +69,7 @@ void Rpc<TTr>::enqueue_response(ReqHandle *req_handle, MsgBuffer *resp_msgbuf) {
       pkthdr_t *resp_pkthdr_i = resp_msgbuf->get_pkthdr_n(i);
       *resp_pkthdr_i = *resp_pkthdr_0;
       resp_pkthdr_i->pkt_num_ = resp_pkthdr_0->pkt_num_ + i;
+      resp_pkthdr_i->ecn_echo_ = 0;  // Set by process_rfr_st()
     }
   }
 
@@ -90,7 +106,10 @@ void Rpc<TTr>::process_resp_one_st(SSlot *sslot, const pkthdr_t *pkthdr,
   MsgBuffer *resp_msgbuf = ci.resp_msgbuf_;
 
   // Update client tracking metadata
-  if (kCcRateComp) update_timely_rate(sslot, pkthdr->pkt_num_, rx_tsc);
+  if (kCcRateComp) {
+    update_cc_rate(sslot, pkthdr->pkt_num_, rx_tsc,
+                   pkthdr->ecn_echo_ || pkthdr->ecn_ce_);
+  }
   bump_credits(sslot->session_);
   ci.num_rx_++;
   ci.progress_tsc_ = ev_loop_tsc_;
@@ -102,8 +121,8 @@ void Rpc<TTr>::process_resp_one_st(SSlot *sslot, const pkthdr_t *pkthdr,
     // Copy eRPC header and data (but not Transport headroom). The eRPC header
     // will be needed (e.g., to determine the request type) if the continuation
     // runs in a background thread.
-    memcpy(resp_msgbuf->get_pkthdr_0()->ehdrptr(), pkthdr->ehdrptr(),
-           pkthdr->msg_size_ + sizeof(pkthdr_t) - kHeadroom);
+    dpath_memcpy(resp_msgbuf->get_pkthdr_0()->ehdrptr(), pkthdr->ehdrptr(),
+                 pkthdr->msg_size_ + sizeof(pkthdr_t) - kHeadroom);
 
     // Fall through to invoke continuation
   } else {
@@ -115,16 +134,34 @@ void Rpc<TTr>::process_resp_one_st(SSlot *sslot, const pkthdr_t *pkthdr,
       resize_msg_buffer(resp_msgbuf, pkthdr->msg_size_);
       memcpy(resp_msgbuf->get_pkthdr_0()->ehdrptr(), pkthdr->ehdrptr(),
              sizeof(pkthdr_t) - kHeadroom);
+
+      // Only foreground continuations can release a fragmented response
+      if (ci.cont_etid_ == kInvalidBgETid &&
+          can_frag_rx_st(resp_msgbuf->num_pkts_)) {
+        start_frag_rx_st(resp_msgbuf);
+      }
     }
 
     // Transmit remaining RFRs before response memcpy. We have credits.
-    if (ci.num_tx_ != wire_pkts(req_msgbuf, resp_msgbuf)) kick_rfr_st(sslot);
+    if (ci.num_tx_ != wire_pkts(req_msgbuf, resp_msgbuf)) {
+      if (unlikely(srpt_.enabled_)) {
+        srpt_stall_st(sslot);
+      } else {
+        kick_rfr_st(sslot);
+      }
+    }
 
     // Hdr 0 was copied earlier, other headers are unneeded, so copy just data.
     const size_t pkt_idx = resp_ntoi(pkthdr->pkt_num_, req_msgbuf->num_pkts_);
-    copy_data_to_msgbuf(resp_msgbuf, pkt_idx, pkthdr);
+    if (resp_msgbuf->is_fragmented()) {
+      assert(pkt_idx == resp_msgbuf->num_frags_);
+      hold_rx_pkt_st(resp_msgbuf, pkthdr);
+    } else {
+      copy_data_to_msgbuf(resp_msgbuf, pkt_idx, pkthdr);
+    }
 
     if (ci.num_rx_ != wire_pkts(req_msgbuf, resp_msgbuf)) return;
+    if (resp_msgbuf->data_size_ >= kDpathMemcpyNtThresh) dpath_memcpy_fence();
     // Else fall through to invoke continuation
   }
 
@@ -137,6 +174,16 @@ void Rpc<TTr>::process_resp_one_st(SSlot *sslot, const pkthdr_t *pkthdr,
   //    corresponding packets received for packets in the wheel.
   assert(ci.wheel_count_ == 0);
 
+  // eRPC owns scatter-gather request MsgBuffers, and they're not needed anymore
+  if (unlikely(sslot->tx_msgbuf_->is_fragmented())) {
+    free_sg_msg_buffer(sslot->tx_msgbuf_);
+  }
+
+  // The app already got the failure of a cancelled request, and eRPC owns both
+  // of its MsgBuffers
+  const bool cancelled = ci.cancelled_;
+  if (unlikely(cancelled)) free_cancelled_msgbufs_st(sslot);
+
   sslot->tx_msgbuf_ = nullptr;  // Mark response as received
   delete_from_active_rpc_list(*sslot);
 
@@ -146,23 +193,22 @@ void Rpc<TTr>::process_resp_one_st(SSlot *sslot, const pkthdr_t *pkthdr,
   const erpc_cont_func_t cont_func = ci.cont_func_;
   void *tag = ci.tag_;
   const size_t cont_etid = ci.cont_etid_;
+  const size_t resp_size = cancelled ? 0 : ci.resp_msgbuf_->data_size_;
 
   Session *session = sslot->session_;
   session->client_info_.sslot_free_vec_.push_back(sslot->index_);
+  dequeue_backlog_st(session);  // Clear up one request from the backlog
 
-  // Clear up one request from the backlog if needed
-  if (!session->client_info_.enq_req_backlog_.empty()) {
-    // We just got a new sslot, and we should have no more if there's backlog
-    assert(session->client_info_.sslot_free_vec_.size() == 1);
-    enq_req_args_t &args = session->client_info_.enq_req_backlog_.front();
-    enqueue_request(args.session_num_, args.req_type_, args.req_msgbuf_,
-                    args.resp_msgbuf_, args.cont_func_, args.tag_,
-                    args.cont_etid_);
-    session->client_info_.enq_req_backlog_.pop();
-  }
+  if (unlikely(cancelled)) return;
 
+  // A server drops a request that expired before its handler ran, or that it
+  // shed while overloaded, and sends an empty response
+  int status = 0;
+  if (unlikely(pkthdr->expired_ || pkthdr->overloaded_)) {
+    status = pkthdr->expired_ ? -ETIMEDOUT : -EBUSY;
+  }
   if (likely(cont_etid == kInvalidBgETid)) {
-    cont_func(context_, tag);
+    complete_fg_req_st(cont_func, tag, status, resp_size);
   } else {
     submit_bg_resp_st(cont_func, tag, cont_etid);
   }
@@ -18,6 +18,8 @@ void Rpc<TTr>::enqueue_rfr_st(SSlot *sslot, const pkthdr_t *resp_pkthdr) {
   rfr_pkthdr->pkt_type_ = PktType::kRFR;
   rfr_pkthdr->pkt_num_ = sslot->client_info_.num_tx_;
   rfr_pkthdr->req_num_ = resp_pkthdr->req_num_;
+  rfr_pkthdr->priority_ = sslot->priority_;
+  rfr_pkthdr->ecn_echo_ = 0;  // Control buffers are shared with CRs
   rfr_pkthdr->magic_ = kPktHdrMagic;
 
   enqueue_hdr_tx_burst_st(
@@ -63,8 +65,11 @@ void Rpc<TTr>::process_rfr_st(SSlot *sslot, const pkthdr_t *pkthdr) {
   }
 
   sslot->server_info_.num_rx_++;
-  enqueue_pkt_tx_burst_st(
-      sslot, resp_ntoi(pkthdr->pkt_num_, si.sav_num_req_pkts_), nullptr);
+
+  // The response packet for this RFR echoes a CE mark on the RFR
+  const size_t pkt_idx = resp_ntoi(pkthdr->pkt_num_, si.sav_num_req_pkts_);
+  sslot->tx_msgbuf_->get_pkthdr_n(pkt_idx)->ecn_echo_ = pkthdr->ecn_ce_;
+  enqueue_pkt_tx_burst_st(sslot, pkt_idx, nullptr);
 }
 
 FORCE_COMPILE_TRANSPORTS
@@ -16,7 +16,8 @@ int Rpc<TTr>::process_comps_st() {
   const size_t &batch_rx_tsc = ev_loop_tsc_;
 
   for (size_t i = 0; i < num_pkts; i++) {
-    auto *pkthdr = reinterpret_cast<pkthdr_t *>(rx_ring_[rx_ring_head_]);
+    const size_t ring_idx = rx_ring_head_;
+    auto *pkthdr = reinterpret_cast<pkthdr_t *>(rx_ring_[ring_idx]);
     rx_ring_head_ = (rx_ring_head_ + 1) % Transport::kNumRxRingEntries;
 
     // XXX: This acts as a stopgap function to filter non-eRPC packets, like
@@ -69,7 +70,7 @@ int Rpc<TTr>::process_comps_st() {
             : process_large_req_one_st(sslot, pkthdr);
         break;
       case PktType::kResp: {
-        size_t rx_tsc = kCcOptBatchTsc ? batch_rx_tsc : dpath_rdtsc();
+        size_t rx_tsc = get_rx_tsc_st(ring_idx, batch_rx_tsc);
         process_resp_one_st(sslot, pkthdr, rx_tsc);
         break;
       }
@@ -78,13 +79,17 @@ int Rpc<TTr>::process_comps_st() {
         break;
       }
       case PktType::kExplCR: {
-        size_t rx_tsc = kCcOptBatchTsc ? batch_rx_tsc : dpath_rdtsc();
+        size_t rx_tsc = get_rx_tsc_st(ring_idx, batch_rx_tsc);
         process_expl_cr_st(sslot, pkthdr, rx_tsc);
         break;
       }
     }
   }
 
+  // Batch request handlers may use requests in RX ring packets, so they must
+  // run before the packets are reposted
+  if (unlikely(!batch_req_vec_.empty())) process_batch_reqs_st();
+
   // Technically, these RECVs can be posted immediately after rx_burst(), or
   // even in the rx_burst() code.
   transport_->post_recvs(num_pkts);
@@ -96,10 +101,25 @@ void Rpc<TTr>::submit_bg_req_st(SSlot *sslot) {
   assert(in_dispatch());
   assert(nexus_->num_bg_threads_ > 0);
 
-  const size_t bg_etid = fast_rand_.next_u32() % nexus_->num_bg_threads_;
+  // Join the less-loaded of two distinct random background threads. This
+  // approximates join-shortest-queue without reading every thread's load.
+  const size_t num_bg_threads = nexus_->num_bg_threads_;
+  size_t bg_etid = fast_rand_.next_u32() % num_bg_threads;
   auto *req_queue = nexus_hook_.bg_req_queue_arr_[bg_etid];
 
-  req_queue->unlocked_push(Nexus::BgWorkItem::make_req_item(context_, sslot));
+  if (num_bg_threads > 1) {
+    const size_t alt_etid =
+        (bg_etid + 1 + fast_rand_.next_u32() % (num_bg_threads - 1)) %
+        num_bg_threads;
+    auto *alt_req_queue = nexus_hook_.bg_req_queue_arr_[alt_etid];
+    if (alt_req_queue->get_load() < req_queue->get_load()) {
+      req_queue = alt_req_queue;
+    }
+  }
+
+  const auto wi = Nexus::BgWorkItem::make_req_item(context_, this, sslot);
+  while (unlikely(!req_queue->ring_.try_push(wi))) drain_bg_queues_st();
+  req_queue->wake_if_parked();
 }
 
 template <class TTr>
@@ -110,8 +130,18 @@ void Rpc<TTr>::submit_bg_resp_st(erpc_cont_func_t cont_func, void *tag,
   assert(bg_etid < nexus_->num_bg_threads_);
 
   auto *req_queue = nexus_hook_.bg_req_queue_arr_[bg_etid];
-  req_queue->unlocked_push(
-      Nexus::BgWorkItem::make_resp_item(context_, cont_func, tag));
+  const auto wi = Nexus::BgWorkItem::make_resp_item(context_, cont_func, tag);
+  while (unlikely(!req_queue->ring_.try_push(wi))) drain_bg_queues_st();
+  req_queue->wake_if_parked();
+}
+
+template <class TTr>
+void Rpc<TTr>::drain_bg_queues_st() {
+  // The background thread may itself be blocked on a full queue of ours, so
+  // drain our queues to let it make progress
+  process_bg_queues_enqueue_request_st();
+  process_bg_queues_enqueue_response_st();
+  pause();
 }
 
 FORCE_COMPILE_TRANSPORTS
@@ -0,0 +1,180 @@
+/**
+ * @file rpc_sg.cc
+ * @brief Scatter-gather requests and responses
+ */
+#include <new>
+
+#include "rpc.h"
+
+namespace erpc {
+
+/// The release callback of a scatter-gather MsgBuffer, stored in the
+/// MsgBuffer's allocation after the MsgBuffer struct
+struct sg_release_t {
+  erpc_release_func_t release_func_;
+  void *release_tag_;
+};
+
+static constexpr size_t kSgReleaseOffset = round_up<8>(sizeof(MsgBuffer));
+
+template <class TTr>
+int Rpc<TTr>::register_app_mem(void *buf, size_t size, app_mem_t *app_mem) {
+  if (unlikely(buf == nullptr || size == 0)) return -EINVAL;
+
+  Transport::mem_reg_info reg_info;
+  try {
+    reg_info = transport_->reg_mr_func_(buf, size);
+  } catch (const std::runtime_error &e) {
+    ERPC_WARN("Rpc %u: Failed to register %zu B of application memory: %s\n",
+              rpc_id_, size, e.what());
+    return -ENOMEM;
+  }
+
+  app_mem->buf_ = static_cast<uint8_t *>(buf);
+  app_mem->size_ = size;
+  app_mem->transport_mr_ = reg_info.transport_mr_;
+  app_mem->lkey_ = reg_info.lkey_;
+  return 0;
+}
+
+template <class TTr>
+void Rpc<TTr>::deregister_app_mem(app_mem_t *app_mem) {
+  assert(app_mem->buf_ != nullptr);
+  transport_->dereg_mr_func_(
+      Transport::mem_reg_info(app_mem->transport_mr_, app_mem->lkey_));
+  *app_mem = app_mem_t();
+}
+
+template <class TTr>
+MsgBuffer *Rpc<TTr>::alloc_sg_msg_buffer(const msg_frag_t *frags,
+                                         size_t num_frags, int *err,
+                                         erpc_release_func_t release_func,
+                                         void *release_tag) {
+  if (unlikely(frags == nullptr && num_frags > 0)) {
+    *err = -EINVAL;
+    return nullptr;
+  }
+
+  size_t data_size = 0;
+  for (size_t i = 0; i < num_frags; i++) {
+    if (unlikely(frags[i].size_ == 0 || frags[i].buf_ == nullptr)) {
+      *err = -EINVAL;
+      return nullptr;
+    }
+    data_size += frags[i].size_;
+  }
+
+  if (unlikely(data_size > kMaxMsgSize)) {
+    *err = -EMSGSIZE;
+    return nullptr;
+  }
+
+  // Check that the transport can gather each packet's data. The first and last
+  // packets spanned by a fragment may contain other fragments, but packets in
+  // the middle contain only this fragment.
+  size_t cur_pkt = 0, cur_pkt_frags = 0, offset = 0;
+  for (size_t i = 0; i < num_frags; i++) {
+    const size_t first_pkt = offset / TTr::kMaxDataPerPkt;
+    const size_t last_pkt = (offset + frags[i].size_ - 1) / TTr::kMaxDataPerPkt;
+    offset += frags[i].size_;
+
+    cur_pkt_frags = (first_pkt == cur_pkt) ? cur_pkt_frags + 1 : 1;
+    if (unlikely(cur_pkt_frags > TTr::kMaxFragsPerPkt)) {
+      *err = -EINVAL;
+      return nullptr;
+    }
+
+    if (last_pkt != first_pkt) cur_pkt_frags = 1;
+    cur_pkt = last_pkt;
+  }
+
+  // Layout: MsgBuffer struct, release callback, fragment array copy, and
+  // contiguous packet headers
+  const size_t num_pkts = data_size_to_num_pkts(data_size);
+  const size_t frags_offset =
+      round_up<64>(kSgReleaseOffset + sizeof(sg_release_t));
+  const size_t hdr_offset =
+      frags_offset + round_up<sizeof(size_t)>(num_frags * sizeof(msg_frag_t));
+
+  lock_cond(&huge_alloc_lock_);
+  Buffer buffer = huge_alloc_->alloc(hdr_offset + num_pkts * sizeof(pkthdr_t));
+  unlock_cond(&huge_alloc_lock_);
+
+  if (unlikely(buffer.buf_ == nullptr)) {
+    *err = -ENOMEM;
+    return nullptr;
+  }
+
+  auto *release =
+      reinterpret_cast<sg_release_t *>(buffer.buf_ + kSgReleaseOffset);
+  release->release_func_ = release_func;
+  release->release_tag_ = release_tag;
+
+  auto *frags_copy = reinterpret_cast<msg_frag_t *>(buffer.buf_ + frags_offset);
+  if (num_frags > 0) memcpy(frags_copy, frags, num_frags * sizeof(msg_frag_t));
+
+  return new (buffer.buf_)
+      MsgBuffer(buffer, hdr_offset, frags_copy, num_frags, data_size, num_pkts);
+}
+
+template <class TTr>
+void Rpc<TTr>::free_sg_msg_buffer(MsgBuffer *sg_msgbuf) {
+  assert(in_dispatch());
+  assert(sg_msgbuf->is_fragmented());
+
+  // Copy out everything needed before the struct itself is freed
+  const MsgBuffer msgbuf_copy = *sg_msgbuf;
+  const sg_release_t release = *reinterpret_cast<sg_release_t *>(
+      msgbuf_copy.buffer_.buf_ + kSgReleaseOffset);
+
+  free_msg_buffer(msgbuf_copy);
+  if (release.release_func_ != nullptr) {
+    release.release_func_(context_, release.release_tag_);
+  }
+}
+
+template <class TTr>
+int Rpc<TTr>::enqueue_request_sg(int session_num, uint8_t req_type,
+                                 const msg_frag_t *frags, size_t num_frags,
+                                 MsgBuffer *resp_msgbuf,
+                                 erpc_cont_func_t cont_func, void *tag) {
+  int err = 0;
+  MsgBuffer *req_msgbuf = alloc_sg_msg_buffer(frags, num_frags, &err);
+  if (unlikely(req_msgbuf == nullptr)) {
+    ERPC_WARN("Rpc %u: enqueue_request_sg() failed, error %s.\n", rpc_id_,
+              strerror(-err));
+    return err;
+  }
+
+  // The request MsgBuffer is freed when the response is received, or if the
+  // session is reset
+  enqueue_request(session_num, req_type, req_msgbuf, resp_msgbuf, cont_func,
+                  tag);
+  return 0;
+}
+
+template <class TTr>
+int Rpc<TTr>::enqueue_response_sg(ReqHandle *req_handle,
+                                  const msg_frag_t *frags, size_t num_frags,
+                                  erpc_release_func_t release_func,
+                                  void *release_tag) {
+  int err = 0;
+  MsgBuffer *resp_msgbuf = alloc_sg_msg_buffer(frags, num_frags, &err,
+                                               release_func, release_tag);
+  if (unlikely(resp_msgbuf == nullptr)) {
+    ERPC_WARN("Rpc %u: enqueue_response_sg() failed, error %s.\n", rpc_id_,
+              strerror(-err));
+    return err;
+  }
+
+  // The dynamic response MsgBuffer now owns the allocation, so it's freed by
+  // bury_resp_msgbuf_server_st() like any other dynamic response. That's when
+  // the release callback is invoked.
+  req_handle->dyn_resp_msgbuf_ = *resp_msgbuf;
+  enqueue_response(req_handle, &req_handle->dyn_resp_msgbuf_);
+  return 0;
+}
+
+FORCE_COMPILE_TRANSPORTS
+
+}  // namespace erpc
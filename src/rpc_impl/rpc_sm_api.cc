@@ -160,6 +160,36 @@ size_t Rpc<TTr>::num_active_sessions_st() {
   return ret;
 }
 
+template <class TTr>
+int Rpc<TTr>::create_session_group(const std::vector<int> &session_nums) {
+  assert(in_dispatch());
+  if (session_nums.empty()) return -EINVAL;
+
+  for (int session_num : session_nums) {
+    if (!is_usr_session_num_in_range_st(session_num)) return -EINVAL;
+    Session *session = session_vec_[static_cast<size_t>(session_num)];
+    if (session == nullptr || !session->is_client()) return -EINVAL;
+  }
+
+  session_group_vec_.push_back(session_nums);
+  return static_cast<int>(session_group_vec_.size() - 1);
+}
+
+template <class TTr>
+int Rpc<TTr>::pick_group_session_slow_st(const std::vector<int> &group) {
+  int best_session_num = -ENOTCONN;
+  double best_load = std::numeric_limits<double>::infinity();
+  for (int session_num : group) {
+    const double load = group_session_load(session_num);
+    if (load < best_load) {
+      best_load = load;
+      best_session_num = session_num;
+    }
+  }
+
+  return best_session_num;
+}
+
 FORCE_COMPILE_TRANSPORTS
 
 }  // namespace erpc
@@ -9,31 +9,31 @@ namespace erpc {
 template <class TTr>
 void Rpc<TTr>::handle_sm_rx_st() {
   assert(in_dispatch());
-  MtQueue<SmWorkItem> &queue = nexus_hook_.sm_rx_queue_;
-
-  while (queue.size_ > 0) {
-    const SmWorkItem wi = queue.unlocked_pop();
-    assert(!wi.is_reset());
-
-    // Here, it's not a reset item, so we have a valid SM packet
-    const SmPkt sm_pkt = wi.sm_pkt_;
-
-    // If it's an SM response, remove pending requests for this session
-    if (sm_pkt.is_resp() &&
-        sm_pending_reqs_.count(sm_pkt.client_.session_num_) > 0) {
-      sm_pending_reqs_.erase(
-          sm_pending_reqs_.find(sm_pkt.client_.session_num_));
-    }
+  static constexpr size_t kSmRxBurstSize = 8;
+  SmPkt sm_pkt_arr[kSmRxBurstSize];
+
+  size_t num_sm_pkts;
+  while ((num_sm_pkts = nexus_hook_.sm_rx_queue_.pop_burst(
+              sm_pkt_arr, kSmRxBurstSize)) > 0) {
+    for (size_t i = 0; i < num_sm_pkts; i++) {
+      const SmPkt &sm_pkt = sm_pkt_arr[i];
+
+      // If it's an SM response, remove pending requests for this session
+      if (sm_pkt.is_resp() &&
+          sm_pending_reqs_.count(sm_pkt.client_.session_num_) > 0) {
+        sm_pending_reqs_.erase(
+            sm_pending_reqs_.find(sm_pkt.client_.session_num_));
+      }
 
-    switch (wi.sm_pkt_.pkt_type_) {
-      case SmPktType::kConnectReq: handle_connect_req_st(sm_pkt); break;
-      case SmPktType::kDisconnectReq: handle_disconnect_req_st(sm_pkt); break;
-      case SmPktType::kConnectResp: {
-        handle_connect_resp_st(sm_pkt);
-        break;
+      switch (sm_pkt.pkt_type_) {
+        case SmPktType::kConnectReq: handle_connect_req_st(sm_pkt); break;
+        case SmPktType::kDisconnectReq: handle_disconnect_req_st(sm_pkt); break;
+        case SmPktType::kConnectResp: handle_connect_resp_st(sm_pkt); break;
+        case SmPktType::kDisconnectResp:
+          handle_disconnect_resp_st(sm_pkt);
+          break;
+        default: throw std::runtime_error("Invalid packet type");
       }
-      case SmPktType::kDisconnectResp: handle_disconnect_resp_st(sm_pkt); break;
-      default: throw std::runtime_error("Invalid packet type");
     }
   }
 }
@@ -48,8 +48,20 @@ void Rpc<TTr>::bury_session_st(Session *session) {
   // guaranteed to have been freed at this point?
 
   if (session->is_server()) {
-    for (const SSlot &sslot : session->sslot_arr_) {
+    for (SSlot &sslot : session->sslot_arr_) {
       free_msg_buffer(sslot.pre_resp_msgbuf_);  // Prealloc buf is always valid
+
+      // The last response is not needed for retransmission anymore. This also
+      // invokes the release callback of a scatter-gather response.
+      bury_resp_msgbuf_server_st(&sslot);
+
+      // A partially-received fragmented request holds RX ring buffers
+      MsgBuffer &req_msgbuf = sslot.server_info_.req_msgbuf_;
+      if (req_msgbuf.is_fragmented()) {
+        release_rx_frags_st(&req_msgbuf);
+      }
+
+      if (grant_.enabled_) remove_from_grant_list_st(&sslot);
     }
   }
 
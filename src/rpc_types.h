@@ -36,6 +36,26 @@ class ReqHandle;
  */
 typedef void (*erpc_req_func_t)(ReqHandle *req_handle, void *context);
 
+/**
+ * @relates Rpc
+ *
+ * @brief The type of the batch request handler function invoked at the server
+ * with all requests of its request type that were received in one burst of
+ * packets. This allows the application to overlap the work of several
+ * requests, e.g., by prefetching their keys in a hash table first.
+ *
+ * The handler runs in the foreground. It must enqueue one response per request
+ * handle, and request buffer ownership for each request is identical to that
+ * for erpc_req_func_t.
+ *
+ * @param req_handles The handles to the received requests, valid only during
+ * the handler
+ * @param num_reqs The number of handles in \p req_handles, at least one
+ * @param context The context that was used while creating the Rpc object
+ */
+typedef void (*erpc_batch_req_func_t)(ReqHandle *const *req_handles,
+                                      size_t num_reqs, void *context);
+
 /**
  * @relates Rpc
  *
@@ -43,18 +63,65 @@ typedef void (*erpc_req_func_t)(ReqHandle *req_handle, void *context);
  * returns ownership of the request and response message buffers that the
  * application supplied in Rpc::enqueue_request back to the application.
  *
+ * With Rpc::enable_frag_rx, the response may be fragmented, and its
+ * MsgBuffer::buf_ points to the first fragment only. Read it with
+ * MsgBuffer::get_frag(), and release it with Rpc::release_msg_frags().
+ *
  * @param context The context that was used while creating the Rpc object
  * @param tag The tag used by the application for this request
  */
 typedef void (*erpc_cont_func_t)(void *context, void *tag);
 
+/**
+ * @relates Rpc
+ * @brief A completed request, reported instead of a continuation invocation
+ * when completion-queue mode is enabled. See Rpc::enable_completion_queue.
+ */
+struct completion_t {
+  void *tag_;         ///< The tag used by the application for this request
+  int status_;        ///< 0 on success, negative errno on failure
+  size_t resp_size_;  ///< The size of the response data, 0 on failure
+
+  completion_t() {}
+  completion_t(void *tag, int status, size_t resp_size)
+      : tag_(tag), status_(status), resp_size_(resp_size) {}
+};
+
+/**
+ * @relates Rpc
+ *
+ * @brief The type of the batch continuation callback invoked at the client in
+ * completion-queue mode. It reports all requests completed by one burst of
+ * received packets.
+ *
+ * @param context The context that was used while creating the Rpc object
+ * @param comps The completions, valid only during the callback
+ * @param num_comps The number of completions in \p comps, at least one
+ */
+typedef void (*erpc_batch_cont_func_t)(void *context, const completion_t *comps,
+                                       size_t num_comps);
+
+/**
+ * @relates Rpc
+ *
+ * @brief The type of the callback invoked at the server when eRPC no longer
+ * needs the application-owned data of a response enqueued with
+ * Rpc::enqueue_response_sg, i.e., when the response can no longer be
+ * retransmitted. The application may then modify or reuse the data.
+ *
+ * @param context The context that was used while creating the Rpc object
+ * @param tag The release tag passed to Rpc::enqueue_response_sg
+ */
+typedef void (*erpc_release_func_t)(void *context, void *tag);
+
 /**
  * @relates Rpc
  * @brief The possible kinds of request handlers. Foreground-mode handlers run
  * in the thread that calls the event loop. Background-mode handlers run in
- * background threads spawned by eRPC.
+ * background threads spawned by eRPC. Batch-mode handlers run in the
+ * foreground, and receive a burst's requests of their type together.
  */
-enum class ReqFuncType : uint8_t { kForeground, kBackground };
+enum class ReqFuncType : uint8_t { kForeground, kBackground, kBatch };
 
 /**
  * @relates Rpc
@@ -64,19 +131,37 @@ class ReqFunc {
  public:
   erpc_req_func_t req_func_;   ///< The handler function
   ReqFuncType req_func_type_;  ///< The handlers's mode (foreground/background)
+  erpc_batch_req_func_t batch_req_func_;  ///< The batch handler function
 
   inline bool is_background() const {
     return req_func_type_ == ReqFuncType::kBackground;
   }
 
-  ReqFunc() { req_func_ = nullptr; }
+  inline bool is_batch() const { return req_func_type_ == ReqFuncType::kBatch; }
+
+  ReqFunc() {
+    req_func_ = nullptr;
+    batch_req_func_ = nullptr;
+  }
 
   ReqFunc(erpc_req_func_t req_func, ReqFuncType req_func_type)
-      : req_func_(req_func), req_func_type_(req_func_type) {
+      : req_func_(req_func),
+        req_func_type_(req_func_type),
+        batch_req_func_(nullptr) {
     rt_assert(req_func != nullptr, "Invalid Ops with null handler function");
+    rt_assert(req_func_type != ReqFuncType::kBatch, "Use a batch handler");
+  }
+
+  ReqFunc(erpc_batch_req_func_t batch_req_func)
+      : req_func_(nullptr),
+        req_func_type_(ReqFuncType::kBatch),
+        batch_req_func_(batch_req_func) {
+    rt_assert(batch_req_func != nullptr, "Invalid null batch handler function");
   }
 
   /// Check if this request handler is registered
-  inline bool is_registered() const { return req_func_ != nullptr; }
+  inline bool is_registered() const {
+    return req_func_ != nullptr || batch_req_func_ != nullptr;
+  }
 };
 }  // namespace erpc
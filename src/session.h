@@ -4,7 +4,7 @@
 #include <mutex>
 #include <queue>
 
-#include "cc/timely.h"
+#include "cc/cc_policy.h"
 #include "cc/timing_wheel.h"
 #include "common.h"
 #include "msg_buffer.h"
@@ -16,7 +16,8 @@
 
 namespace erpc {
 
-/// The arguments to enqueue_request()
+/// The arguments to enqueue_request(), also used as request descriptors for
+/// Rpc::enqueue_request_batch()
 struct enq_req_args_t {
   int session_num_;
   uint8_t req_type_;
@@ -25,18 +26,23 @@ struct enq_req_args_t {
   erpc_cont_func_t cont_func_;
   void *tag_;
   size_t cont_etid_;
+  size_t deadline_tsc_;  ///< Absolute rdtsc() deadline, or zero for none
+  uint8_t priority_;     ///< Priority class, or kPriorityOfReqType
 
   enq_req_args_t() {}
   enq_req_args_t(int session_num, uint8_t req_type, MsgBuffer *req_msgbuf,
                  MsgBuffer *resp_msgbuf, erpc_cont_func_t cont_func, void *tag,
-                 size_t cont_etid)
+                 size_t cont_etid = kInvalidBgETid, size_t deadline_tsc = 0,
+                 uint8_t priority = kPriorityOfReqType)
       : session_num_(session_num),
         req_type_(req_type),
         req_msgbuf_(req_msgbuf),
         resp_msgbuf_(resp_msgbuf),
         cont_func_(cont_func),
         tag_(tag),
-        cont_etid_(cont_etid) {}
+        cont_etid_(cont_etid),
+        deadline_tsc_(deadline_tsc),
+        priority_(priority) {}
 };
 
 /// The arguments to enqueue_response()
@@ -71,8 +77,10 @@ class Session {
     remote_routing_info_ =
         is_client() ? &server_.routing_info_ : &client_.routing_info_;
 
-    if (is_client())
-      client_info_.cc_.timely_ = Timely(freq_ghz, link_bandwidth);
+    if (is_client()) {
+      client_info_.cc_.policy_ =
+          CCongestionControl(freq_ghz, link_bandwidth, CTransport::kMTU);
+    }
 
     // Arrange the free slot vector so that slots are popped in order
     for (size_t i = 0; i < kSessionReqWindow; i++) {
@@ -87,6 +95,7 @@ class Session {
       sslot.is_client_ = is_client();
       sslot.index_ = sslot_i;
       sslot.cur_req_num_ = sslot_i;  // 1st req num = (+kSessionReqWindow)
+      sslot.priority_ = kPriorityNormal;
 
       if (is_client()) {
         for (auto &x : sslot.client_info_.in_wheel_) x = false;
@@ -115,7 +124,11 @@ class Session {
    * @return The desired TX timestamp for this packet
    */
   inline size_t cc_getupdate_tx_tsc(size_t ref_tsc, size_t pkt_size) {
-    double ns_delta = 1000000000 * (pkt_size / client_info_.cc_.timely_.rate_);
+    double rate = client_info_.cc_.policy_.get_rate();
+    if (is_rate_limited()) {
+      rate = (std::min)(rate, client_info_.cc_.rate_limit_);
+    }
+    double ns_delta = 1000000000 * (pkt_size / rate);
     double cycle_delta = ns_to_cycles(ns_delta, freq_ghz_);
 
     size_t desired_tx_tsc = client_info_.cc_.prev_desired_tx_tsc_ + cycle_delta;
@@ -128,7 +141,12 @@ class Session {
 
   /// Return true iff this session is uncongested
   inline bool is_uncongested() const {
-    return client_info_.cc_.timely_.rate_ == link_bandwidth_;
+    return client_info_.cc_.policy_.is_uncongested();
+  }
+
+  /// Return true iff the app has capped this session's rate
+  inline bool is_rate_limited() const {
+    return client_info_.cc_.rate_limit_ != 0.0;
   }
 
   /// Return the hostname of the remote endpoint for a connected session
@@ -167,8 +185,9 @@ class Session {
 
     // Congestion control
     struct {
-      Timely timely_;
+      CCongestionControl policy_;  ///< See cc/cc_policy.h
       size_t prev_desired_tx_tsc_;  ///< Desired TX timestamp of the last packet
+      double rate_limit_ = 0.0;  ///< App-set rate cap in bytes/sec, 0 if none
     } cc_;
 
     size_t sm_req_ts_;  ///< Timestamp of the last session management request
@@ -285,29 +285,4 @@ static SmPkt sm_construct_resp(const SmPkt &req_sm_pkt, SmErrType err_type) {
   resp_sm_pkt.err_type_ = err_type;
   return resp_sm_pkt;
 }
-
-/// A work item exchanged between an Rpc thread and an SM thread. This does
-/// not have any Nexus-related members, so it's outside the Nexus class.
-class SmWorkItem {
-  enum class Reset { kFalse, kTrue };
-
- public:
-  SmWorkItem(uint8_t rpc_id, SmPkt sm_pkt)
-      : reset_(Reset::kFalse), rpc_id_(rpc_id), sm_pkt_(sm_pkt) {}
-
-  SmWorkItem(std::string reset_rem_hostname)
-      : reset_(Reset::kTrue),
-        rpc_id_(kInvalidRpcId),
-        reset_rem_hostname_(reset_rem_hostname) {}
-
-  bool is_reset() const { return reset_ == Reset::kTrue; }
-
-  const Reset reset_;     ///< Is this work item a reset?
-  const uint8_t rpc_id_;  ///< The local Rpc ID, invalid for reset work items
-
-  SmPkt sm_pkt_;  ///< The session management packet, for non-reset work items
-
-  /// The remote hostname to reset, valid for reset work items
-  std::string reset_rem_hostname_;
-};
 }  // namespace erpc
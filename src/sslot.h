@@ -49,6 +49,10 @@ class SSlot {
   /// Info about the current request
   size_t cur_req_num_;
 
+  /// The priority class of the current request. Servers take it from the
+  /// request's packets.
+  uint8_t priority_;
+
   union {
     struct {
       MsgBuffer *resp_msgbuf_;      ///< User-supplied response buffer
@@ -61,12 +65,24 @@ class SSlot {
       /// Number of pkts received. Pkts up to (num_tx - 1) have been received.
       size_t num_rx_;
 
-      /// TSC at which we last sent or retransmitted a packet, or received an
-      /// in-order packet for this request
+      /// TSC at which we last sent or retransmitted a packet, a packet left the
+      /// wheel, or we received an in-order packet for this request
       size_t progress_tsc_;
 
       size_t cont_etid_;  ///< eRPC thread ID to run the continuation on
 
+      size_t deadline_tsc_;  ///< Absolute deadline, or zero for none
+      size_t enqueue_tsc_;   ///< Time of enqueue, for SRPT aging
+      bool stalled_;  ///< True iff this sslot is in the credit stall queue
+
+      /// True iff the request's failure was already reported to the app, e.g.,
+      /// on timeout. The request then finishes the protocol with eRPC-owned
+      /// MsgBuffers, and the continuation is not invoked again.
+      bool cancelled_;
+
+      /// The eRPC-owned request and response MsgBuffers of a cancelled request
+      MsgBuffer cancel_req_msgbuf_, cancel_resp_msgbuf_;
+
       /// Pointers for the intrusive doubly-linked list of active RPCs
       SSlot *prev_, *next_;
 
@@ -99,9 +115,35 @@ class SSlot {
       /// Number of pkts received. Pkts up to (num_rx - 1) have been received.
       size_t num_rx_;
 
+      /// With grant CC, the number of credit returns sent for this request.
+      /// Credit returns for pkts up to (num_grants - 1) have been sent.
+      size_t num_grants_;
+      uint8_t grant_req_type_;  ///< Request type for deferred credit returns
+
       /// The server remembers the number of packets in the request after
       /// burying the request in enqueue_response().
       size_t sav_num_req_pkts_;
+
+      /// Local deadline computed from the request's time budget, or zero if
+      /// the request has no deadline
+      size_t deadline_tsc_;
+
+      /// True iff the pending response marks the request as expired
+      bool expired_;
+
+      /// True iff the pending response tells the client that this server is
+      /// overloaded
+      bool overloaded_;
+
+      /// True iff a request packet arrived CE-marked since the last credit
+      /// return or response, which must echo the mark to the client
+      bool ecn_ce_;
+
+      /// Time when all request packets were received
+      size_t rx_tsc_;
+
+      /// Time when the request handler started
+      size_t handler_tsc_;
     } server_info_;
   };
 
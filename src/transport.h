@@ -18,7 +18,7 @@ class HugeAlloc;  // Forward declaration: HugeAlloc needs MemRegInfo
 /// The avialable transport backend implementations. RoCE transport is
 /// implemented through minor modifications to InfiniBand transport via the
 /// kIsRoCE config parameter.
-enum class TransportType { kInfiniBand, kRaw, kDPDK, kFake, kInvalid };
+enum class TransportType { kInfiniBand, kRaw, kDPDK, kFake, kSim, kInvalid };
 
 /// Generic unreliable transport
 class Transport {
@@ -70,6 +70,7 @@ class Transport {
       case TransportType::kRaw: return "[Raw Ethernet]";
       case TransportType::kDPDK: return "[DPDK]";
       case TransportType::kFake: return "[Fake, for compilation only]";
+      case TransportType::kSim: return "[Simulated]";
       case TransportType::kInvalid: return "[Invalid]";
     }
     throw std::runtime_error("eRPC: Invalid transport");
@@ -133,6 +134,67 @@ class Transport {
    */
   void post_recvs(size_t num_recvs);
 
+  /**
+   * @brief Prepare to let eRPC hold received packets beyond post_recvs(), e.g.,
+   * by allocating replacement RX ring buffers
+   *
+   * @return The maximum number of packets that may be held at once, which is
+   * zero if holding packets is not supported
+   */
+  size_t enable_rx_hold();
+
+  /**
+   * @brief Take ownership of the received packet at RX ring index
+   * \p ring_idx, such that it is not reused after RECVs are reposted with
+   * post_recvs(). This may replace the ring entry. It must be called before
+   * post_recvs() is called for this packet.
+   *
+   * @return The held packet, which is valid until release_rx_pkt()
+   */
+  uint8_t* hold_rx_pkt(size_t ring_idx);
+
+  /// Return a packet held with hold_rx_pkt() to the transport
+  void release_rx_pkt(uint8_t* pkt);
+
+  /**
+   * @brief Return a file descriptor that becomes readable when a packet is
+   * received after arm_rx_event(), or -1 if the transport supports only
+   * polling
+   */
+  int get_rx_event_fd() const;
+
+  /**
+   * @brief Request a notification on the RX event file descriptor for the
+   * next received packet, and clear previous notifications
+   *
+   * @return False if packets are already pending or if the transport supports
+   * only polling, in which case the caller must not block on the descriptor
+   */
+  bool arm_rx_event();
+
+  /**
+   * @brief Mark transmitted packets as ECN-capable, and report Congestion
+   * Experienced marks on received packets in pkthdr_t::ecn_ce_
+   *
+   * @return False if the transport can't read ECN marks
+   */
+  bool enable_ecn();
+
+  /**
+   * @brief Timestamp received packets, and packets sent with a non-null
+   * tx_burst_item_t::tx_ts_, in the kernel or NIC. Kernel TX timestamps
+   * overwrite *tx_ts_ after tx_burst() returns, but before the packet's
+   * acknowledgment is received.
+   *
+   * @param freq_ghz The RDTSC frequency, to convert timestamps to RDTSC cycles
+   * @return False if the transport doesn't support timestamps
+   */
+  bool enable_timestamps(double freq_ghz);
+
+  /// Return the RX timestamp in RDTSC cycles of the packet at RX ring index
+  /// \p ring_idx, or 0 if it has none. Valid until post_recvs().
+  size_t get_rx_tsc(size_t ring_idx) const;
+
   /// Fill-in local routing information
   void fill_local_routing_info(routing_info_t* routing_info) const;
 
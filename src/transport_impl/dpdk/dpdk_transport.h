@@ -214,6 +214,14 @@ class DpdkTransport : public Transport {
   /// Maximum data bytes (i.e., non-header) in a packet
   static constexpr size_t kMaxDataPerPkt = (kMTU - sizeof(pkthdr_t));
 
+  /// Maximum scatter-gather fragments per packet. Fragments are gathered into
+  /// the mbuf by the CPU, so this limit is only to bound per-packet work.
+  static constexpr size_t kMaxFragsPerPkt = 8;
+
+  /// Maximum received packets held by eRPC at once. Held mbufs come from the
+  /// same mempool as RX and TX mbufs, so this is a fraction of the headroom.
+  static constexpr size_t kMaxHeldRxPkts = kNumRxRingEntries / 4;
+
   static constexpr size_t kRssKeySize = 40;  /// RSS key size in bytes
 
   /// Key used for RSS hashing
@@ -276,6 +284,16 @@ class DpdkTransport : public Transport {
   void tx_flush();
   size_t rx_burst();
   void post_recvs(size_t num_recvs);
+  size_t enable_rx_hold() { return kMaxHeldRxPkts; }
+  uint8_t *hold_rx_pkt(size_t ring_idx);
+  void release_rx_pkt(uint8_t *pkt);
+
+  /// RX notifications are not supported
+  int get_rx_event_fd() const { return -1; }
+  bool arm_rx_event() { return false; }
+  bool enable_ecn() { return false; }
+  bool enable_timestamps(double) { return false; }
+  size_t get_rx_tsc(size_t) const { return 0; }
 
   /// Do DPDK initialization for \p phy_port as a primary or secondary DPDK
   /// process type. \p phy_port must not have been already initialized.
@@ -22,6 +22,7 @@ static void format_pkthdr(pkthdr_t *pkthdr,
   // On most bare-metal clusters, a zero IP checksum works fine. But on Azure
   // VMs we need a valid checksum.
   ipv4_hdr_t *ipv4_hdr = pkthdr->get_ipv4_hdr();
+  ipv4_hdr->dscp_ = kPriorityDscp[pkthdr->priority_];
   ipv4_hdr->tot_len_ = htons(pkt_size - sizeof(eth_hdr_t));
   ipv4_hdr->check_ = get_ipv4_checksum(ipv4_hdr);
 
@@ -42,7 +43,28 @@ void DpdkTransport::tx_burst(const tx_burst_item_t *tx_burst_arr,
     assert(tx_mbufs[i] != nullptr);
 
     pkthdr_t *pkthdr;
-    if (item.pkt_idx_ == 0) {
+    if (unlikely(msg_buffer->is_fragmented())) {
+      // Gather the header and data fragment pieces into one segment
+      pkthdr = msg_buffer->get_pkthdr_n(item.pkt_idx_);
+      const size_t pkt_size =
+          msg_buffer->get_pkt_size<kMaxDataPerPkt>(item.pkt_idx_);
+      format_pkthdr(pkthdr, item, pkt_size);
+
+      tx_mbufs[i]->nb_segs = 1;
+      tx_mbufs[i]->pkt_len = pkt_size;
+      tx_mbufs[i]->data_len = pkt_size;
+      uint8_t *dst = rte_pktmbuf_mtod(tx_mbufs[i], uint8_t *);
+      memcpy(dst, pkthdr, sizeof(pkthdr_t));
+      dst += sizeof(pkthdr_t);
+
+      msg_frag_t pieces[kMaxFragsPerPkt];
+      size_t num_pieces =
+          msg_buffer->get_pkt_frags<kMaxDataPerPkt>(item.pkt_idx_, pieces);
+      for (size_t j = 0; j < num_pieces; j++) {
+        memcpy(dst, pieces[j].buf_, pieces[j].size_);
+        dst += pieces[j].size_;
+      }
+    } else if (item.pkt_idx_ == 0) {
       // This is the first packet, so we need only one seg. This can be CR/RFR.
       pkthdr = msg_buffer->get_pkthdr_0();
       const size_t pkt_size = msg_buffer->get_pkt_size<kMaxDataPerPkt>(0);
@@ -146,16 +168,29 @@ size_t DpdkTransport::rx_burst() {
 
 void DpdkTransport::post_recvs(size_t num_recvs) {
   for (size_t i = 0; i < num_recvs; i++) {
-    auto *mbuf = dpdk_dtom(rx_ring_[rx_ring_tail_]);
+    // Held packets were replaced by null ring entries
+    if (likely(rx_ring_[rx_ring_tail_] != nullptr)) {
+      auto *mbuf = dpdk_dtom(rx_ring_[rx_ring_tail_]);
 #if DEBUG
-    rte_mbuf_sanity_check(mbuf, true /* is_header */);
+      rte_mbuf_sanity_check(mbuf, true /* is_header */);
 #endif
-    rte_pktmbuf_free(mbuf);
+      rte_pktmbuf_free(mbuf);
+    }
 
     rx_ring_tail_ = (rx_ring_tail_ + 1) % kNumRxRingEntries;
   }
 }
 
+uint8_t *DpdkTransport::hold_rx_pkt(size_t ring_idx) {
+  uint8_t *pkt = rx_ring_[ring_idx];
+  rx_ring_[ring_idx] = nullptr;  // The mbuf is freed in release_rx_pkt()
+  return pkt;
+}
+
+void DpdkTransport::release_rx_pkt(uint8_t *pkt) {
+  rte_pktmbuf_free(dpdk_dtom(pkt));
+}
+
 }  // namespace erpc
 
 #endif
@@ -1,9 +1,14 @@
 #ifdef ERPC_FAKE
 #include "fake_transport.h"
+#include "util/timer.h"
 #include <cstdlib>
 #include <cstring>
 #include <cerrno>
 #include <fcntl.h>
+#include <linux/errqueue.h>
+#include <linux/net_tstamp.h>
+#include <poll.h>
+#include <sys/eventfd.h>
 #include <chrono>
 #include <stdexcept>
 
@@ -11,12 +16,35 @@ namespace erpc {
 
 constexpr size_t FakeTransport::kMaxDataPerPkt;
 
+/// Maximum time the receive thread blocks on the socket before checking if it
+/// should stop
+static constexpr int kRxThreadPollTimeoutMs = 10;
+
+static constexpr int kEcnMask = 0x3;  ///< ECN bits of the IP TOS byte
+static constexpr int kEcnEct0 = 0x2;  ///< ECN-capable transport, ECT(0)
+static constexpr int kEcnCe = 0x3;    ///< Congestion Experienced
+
+/// SO_TIMESTAMPING flags. TX timestamps are software-only, since they must
+/// arrive before the packet's acknowledgment.
+static constexpr int kTimestampFlags =
+    SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_RX_HARDWARE |
+    SOF_TIMESTAMPING_TX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE |
+    SOF_TIMESTAMPING_RAW_HARDWARE | SOF_TIMESTAMPING_OPT_ID |
+    SOF_TIMESTAMPING_OPT_TSONLY;
+
+/// Control message space for received packets: IP_TOS and SCM_TIMESTAMPING
+static constexpr size_t kRxCmsgSpace =
+    CMSG_SPACE(sizeof(int)) + CMSG_SPACE(sizeof(struct scm_timestamping));
+
 FakeTransport::FakeTransport(uint16_t sm_udp_port, uint8_t rpc_id, 
                             uint8_t phy_port, size_t numa_node, 
                             FILE *trace_file)
     : Transport(TransportType::kFake, rpc_id, phy_port, numa_node, trace_file),
       socket_fd_(-1), local_port_(sm_udp_port + 10000 + rpc_id), rx_thread_(nullptr), 
-      stop_rx_thread_(false), rx_ring_(nullptr), rx_tail_(0) {
+      stop_rx_thread_(false), rx_event_fd_(-1), rx_event_armed_(false),
+      rx_ring_(nullptr), rx_tail_(0) {
+  rx_tsc_ring_.fill(0);
+  tx_ts_ring_.fill(tx_ts_ent_t{nullptr, 0, 0});
   
   // Resolve local IP address for socket communication
   resolve_local_ip_address();
@@ -57,6 +85,13 @@ FakeTransport::FakeTransport(uint16_t sm_udp_port, uint8_t rpc_id,
                            std::string(strerror(errno)));
   }
 
+  rx_event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (rx_event_fd_ < 0) {
+    close(socket_fd_);
+    throw std::runtime_error("FakeTransport: Failed to create eventfd: " +
+                             std::string(strerror(errno)));
+  }
+
   // Initialize memory registration functions
   init_mem_reg_funcs();
 }
@@ -67,11 +102,12 @@ FakeTransport::~FakeTransport() {
   if (socket_fd_ >= 0) {
     close(socket_fd_);
   }
+  if (rx_event_fd_ >= 0) close(rx_event_fd_);
 
   // Clean up any remaining packets in queue
   std::lock_guard<std::mutex> lock(rx_queue_mutex_);
   while (!rx_packet_queue_.empty()) {
-    free(rx_packet_queue_.front().first);
+    free(rx_packet_queue_.front().buf_);
     rx_packet_queue_.pop();
   }
 }
@@ -164,10 +200,16 @@ void FakeTransport::tx_burst(const tx_burst_item_t *tx_burst_arr, size_t num_pkt
     uint8_t *pkt_buf = reinterpret_cast<uint8_t*>(pkthdr);
     size_t pkt_size = item.msg_buffer_->get_pkt_size<kMaxDataPerPkt>(item.pkt_idx_);
     
-    // Send packet
-    ssize_t bytes_sent = sendto(socket_fd_, pkt_buf, pkt_size, MSG_DONTWAIT,
-                               reinterpret_cast<struct sockaddr*>(&dest_addr),
-                               sizeof(dest_addr));
+    // Send packet. Scatter-gather packets are gathered by the kernel.
+    ssize_t bytes_sent;
+    if (likely(!item.msg_buffer_->is_fragmented() &&
+               kPriorityDscp[pkthdr->priority_] == 0)) {
+      bytes_sent = sendto(socket_fd_, pkt_buf, pkt_size, MSG_DONTWAIT,
+                          reinterpret_cast<struct sockaddr*>(&dest_addr),
+                          sizeof(dest_addr));
+    } else {
+      bytes_sent = sendmsg_pkt(item, pkthdr, pkt_size, &dest_addr);
+    }
     
     if (bytes_sent < 0) {
       if (errno != EAGAIN && errno != EWOULDBLOCK) {
@@ -175,8 +217,170 @@ void FakeTransport::tx_burst(const tx_burst_item_t *tx_burst_arr, size_t num_pkt
           fprintf(trace_file_, "FakeTransport: Send error: %s\n", strerror(errno));
         }
       }
+      if (unlikely(ts_freq_ghz_.load(std::memory_order_relaxed) != 0.0)) {
+        reset_tx_ts_keys();
+      }
+    } else if (unlikely(ts_freq_ghz_.load(std::memory_order_relaxed) != 0.0)) {
+      record_tx_ts(item);
+    }
+  }
+}
+
+bool FakeTransport::enable_timestamps(double freq_ghz) {
+  // Set the frequency first, since the receive thread may see timestamps as
+  // soon as they are enabled
+  ts_freq_ghz_ = freq_ghz;
+  const int flags = kTimestampFlags;
+  if (setsockopt(socket_fd_, SOL_SOCKET, SO_TIMESTAMPING, &flags,
+                 sizeof(flags)) < 0) {
+    ts_freq_ghz_ = 0.0;
+    return false;
+  }
+
+  tx_ts_key_ = 0;
+  return true;
+}
+
+void FakeTransport::record_tx_ts(const tx_burst_item_t &item) {
+  tx_ts_ent_t &ent = tx_ts_ring_[tx_ts_key_ % kTxTsRingSize];
+  ent.tx_ts_ = item.tx_ts_;
+  ent.tsc_ = item.tx_ts_ == nullptr ? 0 : *item.tx_ts_;
+  ent.key_ = tx_ts_key_;
+  tx_ts_key_++;
+}
+
+void FakeTransport::reset_tx_ts_keys() {
+  // The kernel restarts keys at zero when OPT_ID is re-enabled
+  const int flags_no_id = kTimestampFlags & ~SOF_TIMESTAMPING_OPT_ID;
+  const int flags = kTimestampFlags;
+  setsockopt(socket_fd_, SOL_SOCKET, SO_TIMESTAMPING, &flags_no_id,
+             sizeof(flags_no_id));
+  setsockopt(socket_fd_, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags));
+
+  for (tx_ts_ent_t &ent : tx_ts_ring_) ent.tx_ts_ = nullptr;
+  tx_ts_key_ = 0;
+}
+
+void FakeTransport::apply_tx_timestamps() {
+  for (const auto &key_tsc : tx_ts_queue_) {
+    tx_ts_ent_t &ent = tx_ts_ring_[key_tsc.first % kTxTsRingSize];
+
+    // Skip stale keys from before a key reset, and TX timestamp slots that
+    // the Rpc reused for a later packet
+    if (ent.tx_ts_ == nullptr || ent.key_ != key_tsc.first ||
+        *ent.tx_ts_ != ent.tsc_ || key_tsc.second < ent.tsc_) {
+      continue;
+    }
+
+    *ent.tx_ts_ = key_tsc.second;
+    ent.tx_ts_ = nullptr;
+  }
+  tx_ts_queue_.clear();
+}
+
+void FakeTransport::drain_tx_timestamps() {
+  union {
+    char buf_[CMSG_SPACE(sizeof(struct scm_timestamping)) +
+              CMSG_SPACE(sizeof(struct sock_extended_err) +
+                         sizeof(struct sockaddr_in))];
+    struct cmsghdr align_;
+  } cmsg_buf;
+
+  struct msghdr msg;
+  while (true) {
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_control = cmsg_buf.buf_;
+    msg.msg_controllen = sizeof(cmsg_buf.buf_);
+    if (recvmsg(socket_fd_, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) return;
+
+    const size_t tsc = get_msg_tsc(&msg);
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+         cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+      if (cmsg->cmsg_level != IPPROTO_IP || cmsg->cmsg_type != IP_RECVERR) {
+        continue;
+      }
+
+      const auto *serr =
+          reinterpret_cast<struct sock_extended_err *>(CMSG_DATA(cmsg));
+      if (serr->ee_origin == SO_EE_ORIGIN_TIMESTAMPING && tsc != 0) {
+        std::lock_guard<std::mutex> lock(rx_queue_mutex_);
+        tx_ts_queue_.emplace_back(serr->ee_data, tsc);
+      }
+    }
+  }
+}
+
+size_t FakeTransport::get_msg_tsc(struct msghdr *msg) const {
+  const double freq_ghz = ts_freq_ghz_.load(std::memory_order_relaxed);
+  for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(msg); cmsg != nullptr;
+       cmsg = CMSG_NXTHDR(msg, cmsg)) {
+    if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SO_TIMESTAMPING) {
+      continue;
+    }
+
+    // ts[0] is the software timestamp, and ts[2] is the raw NIC timestamp.
+    // A NIC clock that isn't synchronized to CLOCK_REALTIME fails the age
+    // check.
+    const auto *tss =
+        reinterpret_cast<struct scm_timestamping *>(CMSG_DATA(cmsg));
+    size_t tsc = 0;
+    if (tss->ts[2].tv_sec != 0 || tss->ts[2].tv_nsec != 0) {
+      tsc = realtime_to_tsc(tss->ts[2], freq_ghz, kMaxTimestampAgeNs);
+    }
+    if (tsc == 0 && (tss->ts[0].tv_sec != 0 || tss->ts[0].tv_nsec != 0)) {
+      tsc = realtime_to_tsc(tss->ts[0], freq_ghz, kMaxTimestampAgeNs);
+    }
+    return tsc;
+  }
+  return 0;
+}
+
+ssize_t FakeTransport::sendmsg_pkt(const tx_burst_item_t &item,
+                                   pkthdr_t *pkthdr, size_t pkt_size,
+                                   struct sockaddr_in *dest_addr) {
+  struct iovec iov[1 + kMaxFragsPerPkt];
+  size_t num_iov = 1;
+  if (item.msg_buffer_->is_fragmented()) {
+    msg_frag_t pieces[kMaxFragsPerPkt];
+    size_t num_pieces =
+        item.msg_buffer_->get_pkt_frags<kMaxDataPerPkt>(item.pkt_idx_, pieces);
+
+    iov[0].iov_base = pkthdr;
+    iov[0].iov_len = sizeof(pkthdr_t);
+    for (size_t i = 0; i < num_pieces; i++) {
+      iov[i + 1].iov_base = const_cast<uint8_t*>(pieces[i].buf_);
+      iov[i + 1].iov_len = pieces[i].size_;
     }
+    num_iov += num_pieces;
+  } else {
+    iov[0].iov_base = pkthdr;
+    iov[0].iov_len = pkt_size;
+  }
+
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_name = dest_addr;
+  msg.msg_namelen = sizeof(*dest_addr);
+  msg.msg_iov = iov;
+  msg.msg_iovlen = num_iov;
+
+  // The DSCP is the upper six bits of the IP TOS byte
+  union {
+    char buf_[CMSG_SPACE(sizeof(int))];
+    struct cmsghdr align_;
+  } cmsg_buf;
+  const int tos = (kPriorityDscp[pkthdr->priority_] << 2) | ecn_tos_;
+  if (tos != 0) {
+    msg.msg_control = cmsg_buf.buf_;
+    msg.msg_controllen = sizeof(cmsg_buf.buf_);
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = IPPROTO_IP;
+    cmsg->cmsg_type = IP_TOS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &tos, sizeof(tos));
   }
+
+  return sendmsg(socket_fd_, &msg, MSG_DONTWAIT);
 }
 
 void FakeTransport::tx_flush() {
@@ -185,21 +389,23 @@ void FakeTransport::tx_flush() {
 
 size_t FakeTransport::rx_burst() {
   std::lock_guard<std::mutex> lock(rx_queue_mutex_);
+
+  // The receive thread queues a packet's TX timestamp before its
+  // acknowledgment, so apply TX timestamps before returning packets
+  if (unlikely(!tx_ts_queue_.empty())) apply_tx_timestamps();
   
   size_t packets_processed = 0;
   //printf("DEBUG: rx_burst called, queue_size=%zu\n", rx_packet_queue_.size());
   //fflush(stdout);
   
   while (!rx_packet_queue_.empty() && packets_processed < kPostlist) {
-    auto pkt_info = rx_packet_queue_.front();
+    rx_pkt_t pkt_info = rx_packet_queue_.front();
     rx_packet_queue_.pop();
     
-    uint8_t *pkt_data = pkt_info.first;
-    size_t pkt_size = pkt_info.second;
-    
     // Store packet pointer directly in eRPC's RX ring
     size_t ring_index = rx_tail_ % kNumRxRingEntries;
-    rx_ring_[ring_index] = pkt_data;
+    rx_ring_[ring_index] = pkt_info.buf_;
+    rx_tsc_ring_[ring_index] = pkt_info.rx_tsc_;
     rx_tail_++;
     
     packets_processed++;
@@ -208,30 +414,116 @@ size_t FakeTransport::rx_burst() {
   return packets_processed;
 }
 
-void FakeTransport::post_recvs(size_t /* num_recvs */) {
-  // Nothing to do - receive thread handles this automatically
+void FakeTransport::post_recvs(size_t num_recvs) {
+  // The receive thread handles RECVs, so just free the packets that eRPC is
+  // done with. Held packets were replaced by null ring entries.
+  for (size_t i = 0; i < num_recvs; i++) {
+    size_t ring_index = rx_post_tail_ % kNumRxRingEntries;
+    free(rx_ring_[ring_index]);
+    rx_ring_[ring_index] = nullptr;
+    rx_post_tail_++;
+  }
+}
+
+bool FakeTransport::arm_rx_event() {
+  uint64_t counter;
+  while (read(rx_event_fd_, &counter, sizeof(counter)) > 0) {
+    // Clear stale notifications
+  }
+
+  // The receive thread checks the armed flag after queueing a packet under the
+  // lock, so it either sees the flag or we see the packet
+  rx_event_armed_.store(true);
+  std::lock_guard<std::mutex> lock(rx_queue_mutex_);
+  if (!rx_packet_queue_.empty()) {
+    rx_event_armed_.store(false);
+    return false;
+  }
+  return true;
+}
+
+bool FakeTransport::enable_ecn() {
+  // The socket's TOS applies to sendto() packets. sendmsg_pkt() overrides it
+  // with a cmsg, so it adds ecn_tos_ itself.
+  const int tos = kEcnEct0;
+  const int recv_tos = 1;
+  if (setsockopt(socket_fd_, IPPROTO_IP, IP_TOS, &tos, sizeof(tos)) < 0 ||
+      setsockopt(socket_fd_, IPPROTO_IP, IP_RECVTOS, &recv_tos,
+                 sizeof(recv_tos)) < 0) {
+    return false;
+  }
+
+  ecn_tos_ = kEcnEct0;
+  return true;
+}
+
+/// Return true iff the received message carries an IP_TOS cmsg with CE
+static bool is_ecn_ce(struct msghdr *msg) {
+  for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(msg); cmsg != nullptr;
+       cmsg = CMSG_NXTHDR(msg, cmsg)) {
+    if (cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_TOS) {
+      return (*CMSG_DATA(cmsg) & kEcnMask) == kEcnCe;
+    }
+  }
+  return false;
 }
 
 void FakeTransport::rx_thread_func() {
   uint8_t buffer[kMTU];
   struct sockaddr_in sender_addr;
-  socklen_t sender_len = sizeof(sender_addr);
+  struct iovec iov;
+  union {
+    char buf_[kRxCmsgSpace];
+    struct cmsghdr align_;
+  } cmsg_buf;
+
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_name = &sender_addr;
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
   
   while (!stop_rx_thread_) {
-    ssize_t bytes_received = recvfrom(socket_fd_, buffer, sizeof(buffer),
-                                     MSG_DONTWAIT, 
-                                     reinterpret_cast<struct sockaddr*>(&sender_addr),
-                                     &sender_len);
+    // recvmsg() updates the lengths, so reset them for each packet
+    iov.iov_base = buffer;
+    iov.iov_len = sizeof(buffer);
+    msg.msg_namelen = sizeof(sender_addr);
+    msg.msg_control = cmsg_buf.buf_;
+    msg.msg_controllen = sizeof(cmsg_buf.buf_);
+    ssize_t bytes_received = recvmsg(socket_fd_, &msg, MSG_DONTWAIT);
     
     if (bytes_received > 0) {
       // Allocate memory for packet copy
       uint8_t *pkt_copy = static_cast<uint8_t*>(malloc(bytes_received));
       if (pkt_copy != nullptr) {
         memcpy(pkt_copy, buffer, bytes_received);
+        if (static_cast<size_t>(bytes_received) >= sizeof(pkthdr_t) &&
+            is_ecn_ce(&msg)) {
+          reinterpret_cast<pkthdr_t *>(pkt_copy)->ecn_ce_ = 1;
+        }
+
+        // The TX timestamps of packets that this packet acknowledges must be
+        // queued before it
+        size_t rx_tsc = 0;
+        if (ts_freq_ghz_.load(std::memory_order_relaxed) != 0.0) {
+          rx_tsc = get_msg_tsc(&msg);
+          drain_tx_timestamps();
+        }
         
         // Add to receive queue
-        std::lock_guard<std::mutex> lock(rx_queue_mutex_);
-        rx_packet_queue_.push(std::make_pair(pkt_copy, bytes_received));
+        {
+          std::lock_guard<std::mutex> lock(rx_queue_mutex_);
+          rx_packet_queue_.push(
+              rx_pkt_t{pkt_copy, static_cast<size_t>(bytes_received), rx_tsc});
+        }
+
+        // Wake up the event loop if it's waiting for packets
+        if (rx_event_armed_.load() && rx_event_armed_.exchange(false)) {
+          const uint64_t one = 1;
+          if (write(rx_event_fd_, &one, sizeof(one)) < 0) {
+            // The eventfd counter can't overflow here, so ignore errors
+          }
+        }
       }
     } else if (bytes_received < 0) {
       if (errno != EAGAIN && errno != EWOULDBLOCK) {
@@ -239,10 +531,18 @@ void FakeTransport::rx_thread_func() {
           fprintf(trace_file_, "FakeTransport: Receive error: %s\n", strerror(errno));
         }
       }
+
+      // Pending TX timestamps would make poll() return immediately
+      if (ts_freq_ghz_.load(std::memory_order_relaxed) != 0.0) {
+        drain_tx_timestamps();
+      }
+
+      // Block until the socket is readable instead of busy waiting
+      struct pollfd pfd;
+      pfd.fd = socket_fd_;
+      pfd.events = POLLIN;
+      poll(&pfd, 1, kRxThreadPollTimeoutMs);
     }
-    
-    // Small delay to avoid busy waiting
-    std::this_thread::sleep_for(std::chrono::microseconds(10));
   }
 }
 
@@ -12,6 +12,7 @@
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
+#include <array>
 #include <queue>
 #include <mutex>
 #include <thread>
@@ -26,6 +27,7 @@ class FakeTransport : public Transport {
   static constexpr size_t kPostlist = 16;
   static constexpr size_t kUnsigBatch = 64;
   static constexpr size_t kMaxDataPerPkt = (kMTU - sizeof(pkthdr_t));
+  static constexpr size_t kMaxFragsPerPkt = 8;  ///< sendmsg() iovecs - 1
 
   /// Socket routing info structure embedded in routing_info_t
   struct socket_routing_info_t {
@@ -52,12 +54,82 @@ class FakeTransport : public Transport {
   size_t rx_burst();
   void post_recvs(size_t num_recvs);
 
+  /// Received packets are individually malloc-ed, so they can always be held
+  size_t enable_rx_hold() { return kNumRxRingEntries; }
+
+  uint8_t *hold_rx_pkt(size_t ring_idx) {
+    uint8_t *pkt = rx_ring_[ring_idx];
+    rx_ring_[ring_idx] = nullptr;  // Don't free in post_recvs()
+    return pkt;
+  }
+
+  void release_rx_pkt(uint8_t *pkt) { free(pkt); }
+
+  /// The receive thread signals an eventfd when the event loop is waiting
+  int get_rx_event_fd() const { return rx_event_fd_; }
+  bool arm_rx_event();
+
+  /// Set ECT(0) in the IP TOS byte of sent packets, and ask the kernel for the
+  /// TOS byte of received packets to detect CE marks
+  bool enable_ecn();
+
+  /// Use SO_TIMESTAMPING for RX and TX timestamps. RX timestamps come from the
+  /// NIC if it stamps packets with a clock synchronized to CLOCK_REALTIME, and
+  /// from the kernel otherwise. TX timestamps come from the kernel.
+  bool enable_timestamps(double freq_ghz);
+
+  size_t get_rx_tsc(size_t ring_idx) const { return rx_tsc_ring_[ring_idx]; }
+
  private:
+  /// A received packet queued by the receive thread
+  struct rx_pkt_t {
+    uint8_t *buf_;
+    size_t size_;
+    size_t rx_tsc_;  ///< Kernel RX timestamp in RDTSC cycles, or 0
+  };
+
+  /// A sent packet whose kernel TX timestamp will replace *tx_ts_
+  struct tx_ts_ent_t {
+    size_t *tx_ts_;
+    size_t tsc_;    ///< The TSC that the Rpc wrote to *tx_ts_
+    uint32_t key_;  ///< The kernel's timestamp key for the packet
+  };
+
+  /// Sent packets awaiting TX timestamps, indexed by timestamp key. Timestamps
+  /// for software-stamped packets arrive well before this wraps around.
+  static constexpr size_t kTxTsRingSize = 256;
+
+  /// Kernel timestamps older than this are from an unsynchronized clock, or
+  /// are too stale to use
+  static constexpr size_t kMaxTimestampAgeNs = 100 * 1000 * 1000;
+
+  /// Record a packet that was sent with timestamp key tx_ts_key_
+  void record_tx_ts(const tx_burst_item_t &item);
+
+  /// Restart timestamp keys at zero. Used after a failed send, which may or
+  /// may not have consumed a key.
+  void reset_tx_ts_keys();
+
+  /// Apply TX timestamps received by the receive thread to the sent packets
+  void apply_tx_timestamps();
+
+  /// Move TX timestamps from the socket's error queue to tx_ts_queue_
+  void drain_tx_timestamps();
+
+  /// Return the kernel timestamp in \p msg in RDTSC cycles, or 0
+  size_t get_msg_tsc(struct msghdr *msg) const;
   /**
    * @brief Resolve the local IP address for socket communication
    */
   void resolve_local_ip_address();
 
+  /// Send one packet with sendmsg(). Packets of scatter-gather MsgBuffers use
+  /// an iovec for the packet header and each data fragment piece. Packets of
+  /// priority classes with a non-zero DSCP carry it in an IP_TOS cmsg, which
+  /// includes the ECN codepoint if ECN is enabled.
+  ssize_t sendmsg_pkt(const tx_burst_item_t &item, pkthdr_t *pkthdr,
+                      size_t pkt_size, struct sockaddr_in *dest_addr);
+
   // Socket state
   int socket_fd_;
   uint16_t local_port_;
@@ -67,12 +139,27 @@ class FakeTransport : public Transport {
   // Receive thread and buffers
   std::thread *rx_thread_;
   std::atomic<bool> stop_rx_thread_;
-  std::queue<std::pair<uint8_t*, size_t>> rx_packet_queue_;
+  std::queue<rx_pkt_t> rx_packet_queue_;
   std::mutex rx_queue_mutex_;
+
+  int rx_event_fd_;  ///< eventfd signaled for packets received while armed
+  std::atomic<bool> rx_event_armed_;
+
+  int ecn_tos_ = 0;  ///< ECN codepoint of sent packets, zero if ECN is off
+
+  // Timestamps
+  std::atomic<double> ts_freq_ghz_{0.0};  ///< Zero iff timestamps are off
+  std::array<size_t, kNumRxRingEntries> rx_tsc_ring_;  ///< For rx_ring_
+  std::array<tx_ts_ent_t, kTxTsRingSize> tx_ts_ring_;
+  uint32_t tx_ts_key_ = 0;  ///< Timestamp key of the next sent packet
+
+  /// (key, TSC) pairs from the error queue, protected by rx_queue_mutex_
+  std::vector<std::pair<uint32_t, size_t>> tx_ts_queue_;
   
   // Receive ring buffer management  
   uint8_t **rx_ring_;  // Pointer to eRPC's rx_ring array
   size_t rx_tail_;
+  size_t rx_post_tail_ = 0;  // Next RX ring entry to free in post_recvs()
   
   void rx_thread_func();
   void cleanup_rx_thread();
@@ -146,7 +146,7 @@ void IBTransport::init_verbs_structs() {
 
   create_attr.cap.max_send_wr = kSQDepth;
   create_attr.cap.max_recv_wr = kRQDepth;
-  create_attr.cap.max_send_sge = 2;
+  create_attr.cap.max_send_sge = 1 + kMaxFragsPerPkt;
   create_attr.cap.max_recv_sge = 1;
   create_attr.cap.max_inline_data = kMaxInline;
 
@@ -215,6 +215,7 @@ void IBTransport::init_mem_reg_funcs() {
 
 void IBTransport::init_recvs(uint8_t **rx_ring) {
   std::ostringstream xmsg;  // The exception message
+  this->rx_ring = rx_ring;
 
   // Initialize the memory region for RECVs
   const size_t ring_extent_size = kNumRxRingEntries * kRecvSize;
@@ -260,6 +261,26 @@ void IBTransport::init_recvs(uint8_t **rx_ring) {
   recv_wr[kRQDepth - 1].next = &recv_wr[0];  // Restore circularity
 }
 
+size_t IBTransport::enable_rx_hold() {
+  // The modded driver's fast RECVs repost RECV buffers without our SGEs
+  if (use_fast_recv) return 0;
+  if (spare_extent.buf_ != nullptr) return kMaxHeldRxPkts;
+
+  const size_t spare_extent_size = kMaxHeldRxPkts * kRecvSize;
+  spare_extent = huge_alloc_->alloc_raw(spare_extent_size, DoRegister::kTrue);
+  if (spare_extent.buf_ == nullptr) {
+    ERPC_WARN("Failed to allocate %.2f MB for spare RECV buffers.\n",
+              1.0 * spare_extent_size / MB(1));
+    return 0;
+  }
+
+  // Use the same layout as the ring's slots
+  for (size_t i = 0; i < kMaxHeldRxPkts; i++) {
+    spare_bufs.push_back(&spare_extent.buf_[i * kRecvSize + (64 - kGRHBytes)]);
+  }
+  return kMaxHeldRxPkts;
+}
+
 void IBTransport::init_sends() {
   for (size_t i = 0; i < kPostlist; i++) {
     send_wr[i].next = &send_wr[i + 1];
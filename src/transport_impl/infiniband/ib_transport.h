@@ -42,6 +42,14 @@ class IBTransport : public Transport {
   /// Maximum data bytes (i.e., non-header) in a packet
   static constexpr size_t kMaxDataPerPkt = (kMTU - sizeof(pkthdr_t));
 
+  /// Maximum scatter-gather fragments per packet. Each packet needs one more
+  /// SGE for the eRPC header.
+  static constexpr size_t kMaxFragsPerPkt = 3;
+
+  /// Maximum received packets held by eRPC at once. This many spare RECV
+  /// buffers are allocated on enable_rx_hold().
+  static constexpr size_t kMaxHeldRxPkts = kNumRxRingEntries / 2;
+
   /**
    * @brief Session endpoint routing info for InfiniBand.
    *
@@ -99,6 +107,16 @@ class IBTransport : public Transport {
   void tx_flush();
   size_t rx_burst();
   void post_recvs(size_t num_recvs);
+  size_t enable_rx_hold();
+  uint8_t *hold_rx_pkt(size_t ring_idx);
+  void release_rx_pkt(uint8_t *pkt);
+
+  /// RX notifications are not supported
+  int get_rx_event_fd() const { return -1; }
+  bool arm_rx_event() { return false; }
+  bool enable_ecn() { return false; }
+  bool enable_timestamps(double) { return false; }
+  size_t get_rx_tsc(size_t) const { return 0; }
 
   /// Get the current SEND signaling flag, and poll the send CQ if we need to
   inline bool get_signaled_flag() {
@@ -165,7 +183,8 @@ class IBTransport : public Transport {
   // SEND
   size_t nb_tx = 0;  /// Total number of packets sent, reset to 0 on tx_flush()
   struct ibv_send_wr send_wr[kPostlist + 1];  /// +1 for unconditional ->next
-  struct ibv_sge send_sgl[kPostlist][2];  ///< SGEs for eRPC header & payload
+  /// SGEs for eRPC header & payload
+  struct ibv_sge send_sgl[kPostlist][1 + kMaxFragsPerPkt];
 
   // RECV
   size_t recv_head = 0;      ///< Index of current un-posted RECV buffer
@@ -175,6 +194,12 @@ class IBTransport : public Transport {
   struct ibv_sge recv_sgl[kRQDepth];
   struct ibv_wc recv_wc[kRQDepth];
 
+  // Held RECVs. A held ring buffer is replaced by a spare RECV buffer, and it
+  // becomes a spare itself when released.
+  uint8_t **rx_ring = nullptr;     ///< The Rpc's RX ring
+  Buffer spare_extent;             ///< Backing memory for the initial spares
+  std::vector<uint8_t *> spare_bufs;  ///< Spare RECV buffers (SGE addresses)
+
   // Once post_recvs_fast() is used, regular post_recv() must not be used
   bool fast_recv_used = false;
 
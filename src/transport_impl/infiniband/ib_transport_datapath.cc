@@ -6,7 +6,8 @@ namespace erpc {
 
 // Packets that are the first packet in their MsgBuffer use one DMA, and may
 // be inlined. Packets that are not the first packet use two DMAs, and are never
-// inlined for simplicity.
+// inlined for simplicity. Packets of scatter-gather MsgBuffers use one SGE for
+// the header and one per data fragment piece, and are never inlined.
 void IBTransport::tx_burst(const tx_burst_item_t* tx_burst_arr,
                            size_t num_pkts) {
   for (size_t i = 0; i < num_pkts; i++) {
@@ -25,7 +26,23 @@ void IBTransport::tx_burst(const tx_burst_item_t* tx_burst_arr,
     // Set signaling + poll SEND CQ if needed. The wr is non-inline by default.
     wr.send_flags = get_signaled_flag() ? IBV_SEND_SIGNALED : 0;
 
-    if (item.pkt_idx_ == 0) {
+    if (unlikely(msg_buffer->is_fragmented())) {
+      const pkthdr_t* pkthdr = msg_buffer->get_pkthdr_n(item.pkt_idx_);
+      sgl[0].addr = reinterpret_cast<uint64_t>(pkthdr);
+      sgl[0].length = static_cast<uint32_t>(sizeof(pkthdr_t));
+      sgl[0].lkey = msg_buffer->buffer_.lkey_;
+
+      msg_frag_t pieces[kMaxFragsPerPkt];
+      size_t num_pieces =
+          msg_buffer->get_pkt_frags<kMaxDataPerPkt>(item.pkt_idx_, pieces);
+      for (size_t j = 0; j < num_pieces; j++) {
+        sgl[j + 1].addr = reinterpret_cast<uint64_t>(pieces[j].buf_);
+        sgl[j + 1].length = static_cast<uint32_t>(pieces[j].size_);
+        sgl[j + 1].lkey = pieces[j].lkey_;
+      }
+
+      wr.num_sge = static_cast<int>(1 + num_pieces);
+    } else if (item.pkt_idx_ == 0) {
       // This is the first packet, so we need only 1 SGE. This can be CR/RFR.
       const pkthdr_t* pkthdr = msg_buffer->get_pkthdr_0();
       sgl[0].addr = reinterpret_cast<uint64_t>(pkthdr);
@@ -122,6 +139,30 @@ size_t IBTransport::rx_burst() {
   return static_cast<size_t>(ret);
 }
 
+uint8_t* IBTransport::hold_rx_pkt(size_t ring_idx) {
+  assert(!spare_bufs.empty());  // The Rpc doesn't hold more than allowed
+  uint8_t* pkt = rx_ring[ring_idx];
+
+  // Replace the ring slot's RECV buffer. The slot's RECV has completed and is
+  // not reposted until post_recvs(), so changing its SGE is safe.
+  uint8_t* spare = spare_bufs.back();
+  spare_bufs.pop_back();
+
+  const bool in_spare_extent =
+      spare >= spare_extent.buf_ &&
+      spare < spare_extent.buf_ + kMaxHeldRxPkts * kRecvSize;
+  recv_sgl[ring_idx].addr = reinterpret_cast<uint64_t>(spare);
+  recv_sgl[ring_idx].lkey =
+      in_spare_extent ? spare_extent.lkey_ : ring_extent.lkey_;
+  recv_wr[ring_idx].wr_id = recv_sgl[ring_idx].addr + kGRHBytes;
+  rx_ring[ring_idx] = spare + kGRHBytes;
+  return pkt;
+}
+
+void IBTransport::release_rx_pkt(uint8_t* pkt) {
+  spare_bufs.push_back(pkt - kGRHBytes);  // Back to the SGE address
+}
+
 void IBTransport::post_recvs(size_t num_recvs) {
   assert(!fast_recv_used);        // Not supported yet
   assert(num_recvs <= kRQDepth);  // num_recvs can be 0
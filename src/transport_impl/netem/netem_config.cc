@@ -0,0 +1,94 @@
+#include "netem_config.h"
+#include <stdexcept>
+#include "util/autorun_helpers.h"
+
+namespace erpc {
+
+static std::mutex netem_config_mutex;
+static netem_config_t netem_config;  // No impairments
+
+/// Set the field of \p dir_config named \p key to \p value
+static void set_netem_dir_field(netem_dir_config_t &dir_config,
+                                const std::string &key,
+                                const std::string &value) {
+  if (key == "dist") {
+    if (value == "uniform") {
+      dir_config.dist_ = NetemDist::kUniform;
+    } else if (value == "normal") {
+      dir_config.dist_ = NetemDist::kNormal;
+    } else if (value == "pareto") {
+      dir_config.dist_ = NetemDist::kPareto;
+    } else {
+      throw std::runtime_error("eRPC netem: Invalid distribution " + value);
+    }
+    return;
+  }
+
+  if (key == "limit") {
+    dir_config.limit_ = std::stoull(value);
+    return;
+  }
+
+  double *field = nullptr;
+  if (key == "delay_us") field = &dir_config.delay_us_;
+  if (key == "jitter_us") field = &dir_config.jitter_us_;
+  if (key == "reorder") field = &dir_config.reorder_;
+  if (key == "dup") field = &dir_config.duplicate_;
+  if (key == "rate_gbps") field = &dir_config.rate_gbps_;
+  if (key == "loss") field = &dir_config.loss_;
+  if (key == "loss_p") field = &dir_config.loss_p_;
+  if (key == "loss_r") field = &dir_config.loss_r_;
+  if (key == "loss_bad") field = &dir_config.loss_bad_;
+  if (field == nullptr) {
+    throw std::runtime_error("eRPC netem: Invalid key " + key);
+  }
+
+  *field = std::stod(value);
+  if (*field < 0.0) {
+    throw std::runtime_error("eRPC netem: Negative value for " + key);
+  }
+}
+
+netem_config_t parse_netem_spec(const std::string &spec) {
+  netem_config_t config;
+  if (spec.empty()) return config;
+
+  for (const std::string &item : split(spec, ',')) {
+    const size_t eq_pos = item.find('=');
+    if (eq_pos == std::string::npos) {
+      throw std::runtime_error("eRPC netem: Expected key=value, got " + item);
+    }
+
+    const std::string key = item.substr(0, eq_pos);
+    const std::string value = item.substr(eq_pos + 1);
+
+    try {
+      if (key == "seed") {
+        config.seed_ = std::stoull(value);
+      } else if (key.compare(0, 3, "tx_") == 0) {
+        set_netem_dir_field(config.tx_, key.substr(3), value);
+      } else if (key.compare(0, 3, "rx_") == 0) {
+        set_netem_dir_field(config.rx_, key.substr(3), value);
+      } else {
+        set_netem_dir_field(config.tx_, key, value);
+        set_netem_dir_field(config.rx_, key, value);
+      }
+    } catch (const std::logic_error &) {  // From std::stod or std::stoull
+      throw std::runtime_error("eRPC netem: Invalid value for " + key);
+    }
+  }
+
+  return config;
+}
+
+void set_netem_config(const netem_config_t &config) {
+  std::lock_guard<std::mutex> lock(netem_config_mutex);
+  netem_config = config;
+}
+
+netem_config_t get_netem_config() {
+  std::lock_guard<std::mutex> lock(netem_config_mutex);
+  return netem_config;
+}
+
+}  // namespace erpc
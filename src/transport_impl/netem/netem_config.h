@@ -0,0 +1,76 @@
+/**
+ * @file netem_config.h
+ * @brief Impairments applied by the network emulation shim (NetemTransport)
+ */
+#pragma once
+
+#include <string>
+#include "common.h"
+
+namespace erpc {
+
+/// Distribution of the delay added to each packet around its mean
+enum class NetemDist {
+  kUniform,  ///< Uniform in [delay - jitter, delay + jitter]
+  kNormal,   ///< Normal, with jitter as the standard deviation
+  kPareto    ///< Heavy-tailed Pareto, with jitter as the standard deviation
+};
+
+/// Impairments in one direction (TX or RX) of a NetemTransport
+struct netem_dir_config_t {
+  double delay_us_ = 0.0;   ///< Mean delay added to each packet
+  double jitter_us_ = 0.0;  ///< Spread of the delay, see NetemDist
+  NetemDist dist_ = NetemDist::kUniform;
+
+  /// Probability that a packet skips the delay, and overtakes delayed packets
+  double reorder_ = 0.0;
+  double duplicate_ = 0.0;  ///< Probability that a packet is sent twice
+  double rate_gbps_ = 0.0;  ///< Bandwidth limit, or zero for none
+  size_t limit_ = 1000;     ///< Max packets held by the shim. Excess is lost.
+
+  // Bursty loss, from a Gilbert-Elliott model. A packet moves the model from
+  // the good to the bad state with probability loss_p_, and back with
+  // probability loss_r_. loss_p_ = 0 gives independent losses.
+  double loss_ = 0.0;      ///< Loss probability in the good state
+  double loss_p_ = 0.0;    ///< Probability of entering the bad state
+  double loss_r_ = 1.0;    ///< Probability of leaving the bad state
+  double loss_bad_ = 1.0;  ///< Loss probability in the bad state
+
+  /// Return true iff these impairments can change any packet
+  bool enabled() const {
+    return delay_us_ > 0.0 || jitter_us_ > 0.0 || duplicate_ > 0.0 ||
+           rate_gbps_ > 0.0 || loss_ > 0.0 || loss_p_ > 0.0;
+  }
+};
+
+/// Impairments of a NetemTransport in both directions
+struct netem_config_t {
+  netem_dir_config_t tx_;  ///< For packets sent by the Rpc
+  netem_dir_config_t rx_;  ///< For packets received by the Rpc
+
+  /// Seed for random impairments. A transport's randomness depends only on
+  /// the seed and its Rpc ID.
+  uint64_t seed_ = 1;
+};
+
+/**
+ * @brief Parse a spec of comma-separated key=value impairments, e.g.,
+ * "delay_us=20,jitter_us=5,dist=normal,rx_loss=0.01"
+ *
+ * Keys are the netem_dir_config_t fields without the trailing underscore,
+ * except that duplicate_ is "dup". Keys prefixed with "tx_" or "rx_" apply to
+ * one direction, and other keys apply to both. dist is "uniform", "normal", or
+ * "pareto". "seed" sets the seed.
+ *
+ * @throw runtime_error if the spec is invalid
+ */
+netem_config_t parse_netem_spec(const std::string &spec);
+
+/// Set the impairments of NetemTransports that are created after this call.
+/// This is thread-safe.
+void set_netem_config(const netem_config_t &config);
+
+/// Return the impairments for new NetemTransports. There are none by default.
+netem_config_t get_netem_config();
+
+}  // namespace erpc
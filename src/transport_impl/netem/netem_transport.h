@@ -0,0 +1,528 @@
+/**
+ * @file netem_transport.h
+ * @brief A shim transport that wraps another transport and impairs its
+ * packets to emulate a network
+ */
+#pragma once
+
+#include <cmath>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+#include "netem_config.h"
+#include "transport.h"
+#include "util/huge_alloc.h"
+#include "util/rand.h"
+#include "util/timer.h"
+
+namespace erpc {
+
+/**
+ * @brief Network emulation over transport \p TTr, selected with
+ * cmake -DNETEM=on
+ *
+ * A NetemTransport applies the impairments returned by get_netem_config()
+ * when it was created, separately to packets that its Rpc sends (TX) and
+ * receives (RX). Directions without impairments are forwarded to TTr as-is.
+ *
+ * TX: Each packet is copied to a shim buffer from the Rpc's hugepage
+ * allocator, so the Rpc keeps ownership of its MsgBuffers. TTr sends the copy
+ * when its delay expires, from tx_burst() or rx_burst(). Copies carry no TX
+ * timestamp request, so RTT samples include the TX delay.
+ *
+ * RX: Each packet is held in TTr until its delay expires, and then placed in
+ * the Rpc's RX ring. This needs TTr to support holding packets. TTr's RX
+ * timestamps are shifted by the added delay.
+ *
+ * The event loop doesn't sleep while the shim holds packets.
+ */
+/// TTr's RX ring, which NetemTransport inherits before TTr so that TTr's
+/// destructor can still read it
+struct netem_ttr_rx_ring_t {
+  std::vector<uint8_t *> ttr_rx_ring_;
+};
+
+template <class TTr>
+class NetemTransport : private netem_ttr_rx_ring_t, public TTr {
+ public:
+  /// Counters for one direction of the shim
+  struct netem_stats_t {
+    size_t num_pkts_ = 0;       ///< Packets that entered the shim
+    size_t num_losses_ = 0;     ///< Packets lost by the loss model
+    size_t num_overflows_ = 0;  ///< Packets lost because the shim was full
+    size_t num_dups_ = 0;       ///< Duplicates created
+    size_t num_reorders_ = 0;   ///< Packets that skipped the delay
+  };
+
+  NetemTransport(uint16_t sm_udp_port, uint8_t rpc_id, uint8_t phy_port,
+                 size_t numa_node, FILE *trace_file)
+      : TTr(sm_udp_port, rpc_id, phy_port, numa_node, trace_file),
+        freq_ghz_(get_freq_ghz()) {
+    const netem_config_t config = get_netem_config();
+    std::seed_seq seed_seq{config.seed_, static_cast<uint64_t>(rpc_id)};
+    std::mt19937_64 seed_gen(seed_seq);
+    init_dir(tx_, config.tx_, seed_gen());
+    init_dir(rx_, config.rx_, seed_gen());
+  }
+
+  ~NetemTransport() {
+    // The Rpc frees the hugepage memory of the TX copies
+    for (MsgBuffer *msgbuf : tx_bufs_) delete msgbuf;
+
+    if (rx_.enabled_) {
+      while (!rx_queue_.empty()) {
+        release_rx_ref(rx_queue_.top().pkt_);
+        rx_queue_.pop();
+      }
+      post_recvs(rx_tail_ - rx_post_tail_);
+    }
+  }
+
+  void init_hugepage_structures(HugeAlloc *huge_alloc, uint8_t **rx_ring) {
+    rx_ring_ = rx_ring;
+    if (!rx_.enabled_) {
+      TTr::init_hugepage_structures(huge_alloc, rx_ring);
+      return;
+    }
+
+    // TTr fills its own ring, and held packets move to the Rpc's ring
+    ttr_rx_ring_.resize(Transport::kNumRxRingEntries);
+    rx_tsc_ring_.resize(Transport::kNumRxRingEntries);
+    TTr::init_hugepage_structures(huge_alloc, ttr_rx_ring_.data());
+
+    // Share TTr's holds between the RX queue, the packets in the Rpc's ring,
+    // and the Rpc
+    const size_t postlist = TTr::kPostlist;
+    const size_t ttr_capacity = TTr::enable_rx_hold();
+    if (ttr_capacity <= postlist) {
+      throw std::runtime_error(
+          "eRPC NetemTransport: RX impairments need a transport that can "
+          "hold packets");
+    }
+
+    rx_limit_ = (std::min)(rx_.config_.limit_, (ttr_capacity - postlist) / 2);
+    rx_hold_capacity_ = ttr_capacity - postlist - rx_limit_;
+  }
+
+  void tx_burst(const Transport::tx_burst_item_t *tx_burst_arr,
+                size_t num_pkts) {
+    if (!tx_.enabled_) {
+      TTr::tx_burst(tx_burst_arr, num_pkts);
+      return;
+    }
+
+    const size_t now = rdtsc();
+    for (size_t i = 0; i < num_pkts; i++) {
+      const Transport::tx_burst_item_t &item = tx_burst_arr[i];
+      if (item.drop_) continue;
+
+      tx_.stats_.num_pkts_++;
+      if (roll_loss(tx_)) {
+        tx_.stats_.num_losses_++;
+        continue;
+      }
+
+      const size_t num_copies = roll_dup(tx_) ? 2 : 1;
+      for (size_t j = 0; j < num_copies; j++) {
+        MsgBuffer *copy = tx_queue_.size() < tx_.config_.limit_
+                              ? copy_tx_pkt(item.msg_buffer_, item.pkt_idx_)
+                              : nullptr;
+        if (copy == nullptr) {
+          tx_.stats_.num_overflows_++;
+          break;
+        }
+
+        tx_pkt_t pkt;
+        pkt.tsc_ =
+            get_release_tsc(tx_, now, sizeof(pkthdr_t) + copy->data_size_);
+        pkt.seq_ = tx_.next_seq_++;
+        pkt.msgbuf_ = copy;
+        pkt.routing_info_ = *item.routing_info_;
+        tx_queue_.push(pkt);
+      }
+    }
+
+    release_tx(now);
+  }
+
+  /// Flush TTr, which also returns the shim's sent copies to the shim
+  void tx_flush() {
+    TTr::tx_flush();
+    tx_free_.insert(tx_free_.end(), tx_sent_.begin(), tx_sent_.end());
+    tx_sent_.clear();
+  }
+
+  size_t rx_burst() {
+    const size_t now = rdtsc();
+    if (unlikely(!tx_queue_.empty())) release_tx(now);
+    if (!rx_.enabled_) return TTr::rx_burst();
+
+    // Hold TTr's new packets in the RX queue
+    const size_t num_new = TTr::rx_burst();
+    for (size_t i = 0; i < num_new; i++) {
+      const size_t ring_idx =
+          (ttr_rx_head_ + i) % Transport::kNumRxRingEntries;
+      rx_.stats_.num_pkts_++;
+      if (roll_loss(rx_)) {
+        rx_.stats_.num_losses_++;
+        continue;
+      }
+
+      const size_t num_copies = roll_dup(rx_) ? 2 : 1;
+      if (rx_queue_.size() + num_copies > rx_limit_) {
+        rx_.stats_.num_overflows_++;
+        continue;  // TTr reposts the packet
+      }
+
+      uint8_t *pkt = TTr::hold_rx_pkt(ring_idx);
+      const size_t ttr_rx_tsc = TTr::get_rx_tsc(ring_idx);
+      const size_t pkt_size = get_rx_pkt_size(pkt);
+      for (size_t j = 0; j < num_copies; j++) {
+        rx_pkt_t ent;
+        ent.tsc_ = get_release_tsc(rx_, now, pkt_size);
+        ent.seq_ = rx_.next_seq_++;
+        ent.pkt_ = pkt;
+        ent.rx_tsc_ = ttr_rx_tsc == 0 ? 0 : ttr_rx_tsc + (ent.tsc_ - now);
+        rx_queue_.push(ent);
+      }
+
+      if (num_copies == 2) rx_dup_refs_[pkt]++;
+    }
+
+    TTr::post_recvs(num_new);
+    ttr_rx_head_ = (ttr_rx_head_ + num_new) % Transport::kNumRxRingEntries;
+
+    // Place packets whose delay has expired in the Rpc's RX ring
+    size_t num_pkts = 0;
+    while (num_pkts < TTr::kPostlist && !rx_queue_.empty() &&
+           rx_queue_.top().tsc_ <= now) {
+      const size_t ring_idx = rx_tail_ % Transport::kNumRxRingEntries;
+      rx_ring_[ring_idx] = rx_queue_.top().pkt_;
+      rx_tsc_ring_[ring_idx] = rx_queue_.top().rx_tsc_;
+      rx_queue_.pop();
+      rx_tail_++;
+      num_pkts++;
+    }
+
+    return num_pkts;
+  }
+
+  void post_recvs(size_t num_recvs) {
+    if (!rx_.enabled_) {
+      TTr::post_recvs(num_recvs);
+      return;
+    }
+
+    for (size_t i = 0; i < num_recvs; i++) {
+      const size_t ring_idx = rx_post_tail_ % Transport::kNumRxRingEntries;
+      if (rx_ring_[ring_idx] != nullptr) release_rx_ref(rx_ring_[ring_idx]);
+      rx_ring_[ring_idx] = nullptr;
+      rx_post_tail_++;
+    }
+  }
+
+  size_t enable_rx_hold() {
+    return rx_.enabled_ ? rx_hold_capacity_ : TTr::enable_rx_hold();
+  }
+
+  uint8_t *hold_rx_pkt(size_t ring_idx) {
+    if (!rx_.enabled_) return TTr::hold_rx_pkt(ring_idx);
+    uint8_t *pkt = rx_ring_[ring_idx];
+    rx_ring_[ring_idx] = nullptr;  // Don't release in post_recvs()
+    return pkt;
+  }
+
+  void release_rx_pkt(uint8_t *pkt) {
+    rx_.enabled_ ? release_rx_ref(pkt) : TTr::release_rx_pkt(pkt);
+  }
+
+  /// Don't let the event loop sleep while the shim holds packets
+  bool arm_rx_event() {
+    if (!tx_queue_.empty() || !rx_queue_.empty()) return false;
+    return TTr::arm_rx_event();
+  }
+
+  size_t get_rx_tsc(size_t ring_idx) const {
+    return rx_.enabled_ ? rx_tsc_ring_[ring_idx] : TTr::get_rx_tsc(ring_idx);
+  }
+
+  /// Return the link bandwidth, capped by the TX bandwidth limit
+  size_t get_bandwidth() const {
+    const size_t bandwidth = TTr::get_bandwidth();
+    if (tx_.config_.rate_gbps_ == 0.0) return bandwidth;
+    return (std::min)(bandwidth,
+                      static_cast<size_t>(tx_.config_.rate_gbps_ * 1e9 / 8));
+  }
+
+  const netem_stats_t &get_tx_stats() const { return tx_.stats_; }
+  const netem_stats_t &get_rx_stats() const { return rx_.stats_; }
+
+  /// Return true iff the shim holds no packets
+  bool is_idle() const { return tx_queue_.empty() && rx_queue_.empty(); }
+
+ private:
+  /// Shim copies are recycled in batches, since recycling flushes TTr
+  static constexpr size_t kTxRecycleBatch = 64;
+
+  /// The state of one direction
+  struct dir_t {
+    netem_dir_config_t config_;
+    bool enabled_ = false;
+    FastRand rand_;
+    bool loss_bad_state_ = false;  ///< The loss model's state
+    double tsc_per_byte_ = 0.0;    ///< Zero if there is no bandwidth limit
+    size_t link_free_tsc_ = 0;     ///< When the bandwidth limit allows a send
+    size_t next_seq_ = 0;          ///< Breaks ties between release times
+    netem_stats_t stats_;
+  };
+
+  /// A TX copy waiting for its release time
+  struct tx_pkt_t {
+    size_t tsc_;
+    size_t seq_;
+    MsgBuffer *msgbuf_;
+    Transport::routing_info_t routing_info_;  ///< The session may go away
+
+    bool operator>(const tx_pkt_t &o) const {
+      return tsc_ != o.tsc_ ? tsc_ > o.tsc_ : seq_ > o.seq_;
+    }
+  };
+
+  /// A held RX packet waiting for its release time
+  struct rx_pkt_t {
+    size_t tsc_;
+    size_t seq_;
+    uint8_t *pkt_;
+    size_t rx_tsc_;  ///< Shifted RX timestamp, or 0
+
+    bool operator>(const rx_pkt_t &o) const {
+      return tsc_ != o.tsc_ ? tsc_ > o.tsc_ : seq_ > o.seq_;
+    }
+  };
+
+  static double get_freq_ghz() {
+#ifdef ERPC_SIM
+    return kSimFreqGhz;
+#else
+    static const double freq_ghz = measure_rdtsc_freq();
+    return freq_ghz;
+#endif
+  }
+
+  void init_dir(dir_t &dir, const netem_dir_config_t &config, uint64_t seed) {
+    dir.config_ = config;
+    dir.enabled_ = config.enabled();
+    dir.rand_.seed_ = seed;
+    if (config.rate_gbps_ > 0.0) {
+      dir.tsc_per_byte_ = freq_ghz_ * 8 / config.rate_gbps_;
+    }
+  }
+
+  /// Return a uniform random number in (0, 1)
+  static double uniform(dir_t &dir) {
+    return (dir.rand_.next_u32() + 0.5) / 4294967296.0;
+  }
+
+  /// Return true with probability \p p
+  static bool roll(dir_t &dir, double p) {
+    return p > 0.0 && dir.rand_.next_u32() < p * 4294967296.0;
+  }
+
+  /// Step the loss model, and return true iff the packet is lost
+  static bool roll_loss(dir_t &dir) {
+    const netem_dir_config_t &c = dir.config_;
+    if (c.loss_p_ > 0.0) {
+      if (roll(dir, dir.loss_bad_state_ ? c.loss_r_ : c.loss_p_)) {
+        dir.loss_bad_state_ = !dir.loss_bad_state_;
+      }
+    }
+    return roll(dir, dir.loss_bad_state_ ? c.loss_bad_ : c.loss_);
+  }
+
+  static bool roll_dup(dir_t &dir) {
+    if (!roll(dir, dir.config_.duplicate_)) return false;
+    dir.stats_.num_dups_++;
+    return true;
+  }
+
+  /// Return the delay for the next packet
+  size_t sample_delay_tsc(dir_t &dir) const {
+    const netem_dir_config_t &c = dir.config_;
+    double delay_us = c.delay_us_;
+    if (c.jitter_us_ > 0.0) {
+      const double u = uniform(dir);
+      switch (c.dist_) {
+        case NetemDist::kUniform: delay_us += c.jitter_us_ * (2 * u - 1); break;
+        case NetemDist::kNormal: {
+          const double z =  // Box-Muller
+              std::sqrt(-2 * std::log(u)) * std::cos(2 * M_PI * uniform(dir));
+          delay_us += c.jitter_us_ * z;
+          break;
+        }
+        case NetemDist::kPareto: {
+          // Shape 3 and scale 1 give mean 1.5 and standard deviation
+          // sqrt(3) / 2
+          const double x = std::pow(u, -1.0 / 3);
+          delay_us += c.jitter_us_ * (x - 1.5) / (std::sqrt(3.0) / 2);
+          break;
+        }
+      }
+    }
+
+    return delay_us <= 0.0 ? 0 : us_to_cycles(delay_us, freq_ghz_);
+  }
+
+  /// Return the TSC at which a packet of \p pkt_size bytes that entered the
+  /// shim at \p now leaves it
+  size_t get_release_tsc(dir_t &dir, size_t now, size_t pkt_size) const {
+    size_t tsc = now;
+    if (dir.tsc_per_byte_ > 0.0) {
+      dir.link_free_tsc_ = (std::max)(now, dir.link_free_tsc_) +
+                           static_cast<size_t>(pkt_size * dir.tsc_per_byte_);
+      tsc = dir.link_free_tsc_;
+    }
+
+    if (roll(dir, dir.config_.reorder_)) {
+      dir.stats_.num_reorders_++;
+      return tsc;
+    }
+    return tsc + sample_delay_tsc(dir);
+  }
+
+  /// Return a shim buffer for a TX copy, or nullptr if memory is exhausted
+  MsgBuffer *alloc_tx_buf() {
+    if (tx_free_.empty() && tx_sent_.size() >= kTxRecycleBatch) tx_flush();
+    if (!tx_free_.empty()) {
+      MsgBuffer *msgbuf = tx_free_.back();
+      tx_free_.pop_back();
+      return msgbuf;
+    }
+
+    Buffer buffer =
+        this->huge_alloc_->alloc(sizeof(pkthdr_t) + TTr::kMaxDataPerPkt);
+    if (buffer.buf_ == nullptr) return nullptr;
+    auto *msgbuf = new MsgBuffer(buffer, TTr::kMaxDataPerPkt, 1);
+    tx_bufs_.push_back(msgbuf);
+    return msgbuf;
+  }
+
+  /// Copy packet \p pkt_idx of \p msg_buffer to a single-packet shim buffer,
+  /// or return nullptr if memory is exhausted
+  MsgBuffer *copy_tx_pkt(const MsgBuffer *msg_buffer, size_t pkt_idx) {
+    MsgBuffer *copy = alloc_tx_buf();
+    if (copy == nullptr) return nullptr;
+
+    const size_t data_size =
+        msg_buffer->get_pkt_size<TTr::kMaxDataPerPkt>(pkt_idx) -
+        sizeof(pkthdr_t);
+    copy->resize(data_size, 1);
+    memcpy(copy->get_pkthdr_0(), msg_buffer->get_pkthdr_n(pkt_idx),
+           sizeof(pkthdr_t));
+
+    if (likely(!msg_buffer->is_fragmented())) {
+      memcpy(copy->buf_, msg_buffer->buf_ + pkt_idx * TTr::kMaxDataPerPkt,
+             data_size);
+    } else {
+      msg_frag_t pieces[TTr::kMaxFragsPerPkt];
+      const size_t num_pieces =
+          msg_buffer->get_pkt_frags<TTr::kMaxDataPerPkt>(pkt_idx, pieces);
+      size_t offset = 0;
+      for (size_t i = 0; i < num_pieces; i++) {
+        memcpy(copy->buf_ + offset, pieces[i].buf_, pieces[i].size_);
+        offset += pieces[i].size_;
+      }
+    }
+
+    return copy;
+  }
+
+  /// Send the TX copies whose release time is before \p now
+  void release_tx(size_t now) {
+    Transport::tx_burst_item_t items[TTr::kPostlist];
+    Transport::routing_info_t routing_infos[TTr::kPostlist];
+
+    while (!tx_queue_.empty() && tx_queue_.top().tsc_ <= now) {
+      size_t num_pkts = 0;
+      while (num_pkts < TTr::kPostlist && !tx_queue_.empty() &&
+             tx_queue_.top().tsc_ <= now) {
+        const tx_pkt_t &pkt = tx_queue_.top();
+        routing_infos[num_pkts] = pkt.routing_info_;
+
+        Transport::tx_burst_item_t &item = items[num_pkts];
+        item.routing_info_ = &routing_infos[num_pkts];
+        item.msg_buffer_ = pkt.msgbuf_;
+        item.pkt_idx_ = 0;
+        item.tx_ts_ = nullptr;
+        item.drop_ = false;
+
+        tx_sent_.push_back(pkt.msgbuf_);
+        tx_queue_.pop();
+        num_pkts++;
+      }
+
+      TTr::tx_burst(items, num_pkts);
+    }
+  }
+
+  /// Return the size of received packet \p pkt for the bandwidth limit. A
+  /// response packet's number depends on its request's size, so response
+  /// packets count as full unless the response fits in one packet.
+  static size_t get_rx_pkt_size(const uint8_t *pkt) {
+    const size_t max_data = TTr::kMaxDataPerPkt;
+    const auto *pkthdr = reinterpret_cast<const pkthdr_t *>(pkt);
+    const size_t msg_size = pkthdr->msg_size_;
+
+    size_t data_size = 0;
+    if (pkthdr->pkt_type_ == PktType::kReq) {
+      const size_t offset = pkthdr->pkt_num_ * max_data;
+      if (msg_size > offset) {
+        data_size = (std::min)(max_data, msg_size - offset);
+      }
+    } else if (pkthdr->pkt_type_ == PktType::kResp) {
+      data_size = (std::min)(max_data, msg_size);
+    }
+
+    return sizeof(pkthdr_t) + data_size;
+  }
+
+  /// Drop a reference to held RX packet \p pkt, and return it to TTr after
+  /// the last reference
+  void release_rx_ref(uint8_t *pkt) {
+    if (unlikely(!rx_dup_refs_.empty())) {
+      auto it = rx_dup_refs_.find(pkt);
+      if (it != rx_dup_refs_.end()) {
+        if (--it->second == 0) rx_dup_refs_.erase(it);
+        return;
+      }
+    }
+    TTr::release_rx_pkt(pkt);
+  }
+
+  const double freq_ghz_;
+  dir_t tx_, rx_;
+
+  // TX
+  std::priority_queue<tx_pkt_t, std::vector<tx_pkt_t>, std::greater<tx_pkt_t>>
+      tx_queue_;
+  std::vector<MsgBuffer *> tx_bufs_;  ///< All shim buffers
+  std::vector<MsgBuffer *> tx_free_;  ///< Shim buffers ready for copies
+  std::vector<MsgBuffer *> tx_sent_;  ///< Sent copies that TTr may still use
+
+  // RX
+  std::priority_queue<rx_pkt_t, std::vector<rx_pkt_t>, std::greater<rx_pkt_t>>
+      rx_queue_;
+  size_t rx_limit_ = 0;           ///< Max packets in rx_queue_
+  size_t rx_hold_capacity_ = 0;   ///< TTr's holds left for the Rpc
+  uint8_t **rx_ring_ = nullptr;   ///< The Rpc's RX ring
+  std::vector<size_t> rx_tsc_ring_;     ///< RX timestamps for rx_ring_
+  size_t ttr_rx_head_ = 0;  ///< Next new packet in TTr's RX ring
+  size_t rx_tail_ = 0;      ///< Next Rpc RX ring entry to fill
+  size_t rx_post_tail_ = 0;  ///< Next Rpc RX ring entry to release
+
+  /// Extra references to duplicated RX packets
+  std::unordered_map<uint8_t *, size_t> rx_dup_refs_;
+};
+
+}  // namespace erpc
@@ -61,6 +61,7 @@ class RawTransport : public Transport {
 
   /// Maximum data bytes (i.e., non-header) in a packet
   static constexpr size_t kMaxDataPerPkt = (kMTU - sizeof(pkthdr_t));
+  static constexpr size_t kMaxFragsPerPkt = 0;  ///< No scatter-gather support
 
   /// RECVs batched before posting. Relevant only for non-dumbpipe mode.
   static constexpr size_t kRecvSlack = 32;
@@ -133,6 +134,18 @@ class RawTransport : public Transport {
   size_t rx_burst();
   void post_recvs(size_t num_recvs);
 
+  // Holding received packets is not supported
+  size_t enable_rx_hold() { return 0; }
+  uint8_t *hold_rx_pkt(size_t) { return nullptr; }
+  void release_rx_pkt(uint8_t *) {}
+
+  /// RX notifications are not supported
+  int get_rx_event_fd() const { return -1; }
+  bool arm_rx_event() { return false; }
+  bool enable_ecn() { return false; }
+  bool enable_timestamps(double) { return false; }
+  size_t get_rx_tsc(size_t) const { return 0; }
+
   /// Get the current SEND signaling flag, and poll the send CQ if we need to
   inline bool get_signaled_flag() {
     // If kUnsigBatch is 4, the sequence of signaling and polling looks like so:
@@ -0,0 +1,166 @@
+#ifdef ERPC_SIM
+#include "sim_fabric.h"
+#include <algorithm>
+#include <random>
+#include "sim_transport.h"
+#include "util/timer.h"
+
+namespace erpc {
+
+constexpr size_t SimFabric::kStartTsc;
+thread_local SimFabric *SimFabric::current_ = nullptr;
+
+SimFabric::SimFabric(sim_fabric_config_t config)
+    : config_(config),
+      bytes_per_tsc_(config.link_gbps_ / (8 * kSimFreqGhz)),
+      link_delay_tsc_(us_to_cycles(config.link_delay_us_, kSimFreqGhz)),
+      loss_threshold_(static_cast<uint32_t>(
+          (std::min)(config.loss_rate_, 1.0) * UINT32_MAX)) {
+  rt_assert(current_ == nullptr, "SimFabric: Thread already has a fabric");
+  rt_assert(config.link_gbps_ > 0.0, "SimFabric: Invalid link rate");
+
+  // FastRand's first outputs are tiny for small seeds, so scramble the seed
+  fast_rand_.seed_ = std::mt19937_64(config.seed_)();
+  current_ = this;
+  sim_tsc_ptr() = &now_tsc_;
+}
+
+SimFabric::~SimFabric() {
+  while (!events_.empty()) {
+    free(events_.top().pkt_);
+    events_.pop();
+  }
+
+  current_ = nullptr;
+  sim_tsc_ptr() = nullptr;
+}
+
+size_t SimFabric::add_host(SimTransport *transport, uint16_t sm_udp_port,
+                           uint8_t rpc_id) {
+  const uint32_t key = (static_cast<uint32_t>(sm_udp_port) << 8) | rpc_id;
+  rt_assert(host_map_.count(key) == 0, "SimFabric: Host already exists");
+
+  const size_t node = hosts_.size();
+  hosts_.push_back(host_t{transport, now_tsc_, now_tsc_});
+  host_map_[key] = node;
+  return node;
+}
+
+void SimFabric::remove_host(size_t node) {
+  for (auto it = host_map_.begin(); it != host_map_.end(); it++) {
+    if (it->second == node) {
+      host_map_.erase(it);
+      break;
+    }
+  }
+  hosts_[node].transport_ = nullptr;
+}
+
+size_t SimFabric::lookup_host(uint16_t sm_udp_port, uint8_t rpc_id) const {
+  const uint32_t key = (static_cast<uint32_t>(sm_udp_port) << 8) | rpc_id;
+  auto it = host_map_.find(key);
+  return it == host_map_.end() ? kInvalidNode : it->second;
+}
+
+size_t SimFabric::get_bandwidth() const {
+  return static_cast<size_t>(config_.link_gbps_ * 1000 * 1000 * 1000 / 8);
+}
+
+size_t SimFabric::serialize_tsc(size_t pkt_size) const {
+  return erpc::ceil(pkt_size / bytes_per_tsc_);
+}
+
+void SimFabric::send(size_t src_node, size_t dst_node, uint8_t *pkt,
+                     size_t pkt_size, bool ect) {
+  stats_.num_pkts_++;
+  if (unlikely(loss_threshold_ > 0 &&
+               fast_rand_.next_u32() < loss_threshold_)) {
+    stats_.num_random_drops_++;
+    free(pkt);
+    return;
+  }
+
+  // The host's link queue is unbounded, since eRPC paces its own packets
+  host_t &src = hosts_[src_node];
+  src.uplink_free_tsc_ =
+      (std::max)(now_tsc_, src.uplink_free_tsc_) + serialize_tsc(pkt_size);
+
+  event_t ev;
+  ev.ect_ = ect;
+  ev.dst_node_ = dst_node;
+  ev.pkt_ = pkt;
+  ev.pkt_size_ = pkt_size;
+  schedule(src.uplink_free_tsc_ + link_delay_tsc_, EventType::kSwitchArrival,
+           ev);
+}
+
+size_t SimFabric::advance(size_t max_delta_tsc) {
+  size_t next_tsc = max_delta_tsc > SIZE_MAX - now_tsc_
+                        ? SIZE_MAX
+                        : now_tsc_ + max_delta_tsc;
+  if (!events_.empty()) next_tsc = (std::min)(next_tsc, events_.top().tsc_);
+  now_tsc_ = (std::max)(now_tsc_, next_tsc);
+
+  while (!events_.empty() && events_.top().tsc_ <= now_tsc_) {
+    const event_t ev = events_.top();
+    events_.pop();
+
+    switch (ev.type_) {
+      case EventType::kSwitchArrival: process_switch_arrival(ev); break;
+      case EventType::kHostArrival: process_host_arrival(ev); break;
+    }
+  }
+
+  return now_tsc_;
+}
+
+void SimFabric::schedule(size_t tsc, EventType type, const event_t &ev) {
+  event_t new_ev = ev;
+  new_ev.tsc_ = tsc;
+  new_ev.seq_ = next_seq_++;
+  new_ev.type_ = type;
+  events_.push(new_ev);
+}
+
+void SimFabric::process_switch_arrival(const event_t &ev) {
+  host_t &dst = hosts_[ev.dst_node_];
+
+  // The port's queue is the data it hasn't serialized by now
+  const size_t queue_bytes =
+      dst.port_free_tsc_ <= now_tsc_
+          ? 0
+          : static_cast<size_t>((dst.port_free_tsc_ - now_tsc_) *
+                                bytes_per_tsc_);
+
+  if (queue_bytes + ev.pkt_size_ > config_.port_buffer_bytes_) {
+    stats_.num_drops_++;
+    free(ev.pkt_);
+    return;
+  }
+
+  if (ev.ect_ && queue_bytes > config_.ecn_threshold_bytes_) {
+    reinterpret_cast<pkthdr_t *>(ev.pkt_)->ecn_ce_ = 1;
+    stats_.num_ecn_marks_++;
+  }
+
+  stats_.max_queue_bytes_ =
+      (std::max)(stats_.max_queue_bytes_, queue_bytes + ev.pkt_size_);
+  dst.port_free_tsc_ =
+      (std::max)(now_tsc_, dst.port_free_tsc_) + serialize_tsc(ev.pkt_size_);
+  schedule(dst.port_free_tsc_ + link_delay_tsc_, EventType::kHostArrival, ev);
+}
+
+void SimFabric::process_host_arrival(const event_t &ev) {
+  SimTransport *transport = hosts_[ev.dst_node_].transport_;
+  if (transport == nullptr) {
+    free(ev.pkt_);
+    return;
+  }
+
+  stats_.num_delivered_++;
+  transport->deliver(ev.pkt_, now_tsc_);
+}
+
+}  // namespace erpc
+
+#endif
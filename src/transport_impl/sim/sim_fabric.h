@@ -0,0 +1,169 @@
+/**
+ * @file sim_fabric.h
+ * @brief A discrete-event model of the network between simulated Rpcs
+ */
+#pragma once
+
+#ifdef ERPC_SIM
+
+#include <queue>
+#include <unordered_map>
+#include <vector>
+#include "common.h"
+#include "util/rand.h"
+
+namespace erpc {
+
+class SimTransport;
+
+/// Parameters of a simulated fabric
+struct sim_fabric_config_t {
+  double link_gbps_ = 25.0;     ///< Rate of each host's link to the switch
+  double link_delay_us_ = 1.0;  ///< One-way propagation delay of a link
+
+  size_t port_buffer_bytes_ = MB(1);  ///< Buffer of each switch output port
+
+  /// Switch output queue length above which ECN-capable packets are marked
+  size_t ecn_threshold_bytes_ = KB(100);
+
+  double loss_rate_ = 0.0;  ///< Probability of dropping a packet at random
+  uint64_t seed_ = 1;       ///< Seed for random drops
+};
+
+/**
+ * @brief A discrete-event simulation of hosts connected by one output-queued
+ * switch. Each simulated Rpc is a host with its own link to the switch. The
+ * switch has a FIFO output port per host, which drops packets that overflow
+ * its buffer, and CE-marks ECN-capable packets that find a long queue.
+ *
+ * Creating a SimFabric makes its virtual clock the rdtsc() of the calling
+ * thread. Simulated Rpcs must be created, run, and destroyed on this thread,
+ * after the Nexus is created. The thread drives the simulation by running
+ * each Rpc's event loop once, and then advancing the clock:
+ *
+ *   while (...) {
+ *     for (auto *rpc : rpc_vec) rpc->run_event_loop_once();
+ *     fabric.advance(tick_tsc);
+ *   }
+ *
+ * Rpcs take no virtual time to process packets. Session management uses the
+ * Nexus's real UDP socket, so sessions connect without advancing the clock.
+ */
+class SimFabric {
+ public:
+  static constexpr size_t kStartTsc = 1000000000;  ///< Virtual time at start
+  static constexpr size_t kInvalidNode = SIZE_MAX;
+
+  struct stats_t {
+    size_t num_pkts_ = 0;          ///< Packets sent by hosts
+    size_t num_delivered_ = 0;     ///< Packets delivered to hosts
+    size_t num_drops_ = 0;         ///< Drops at full switch ports
+    size_t num_random_drops_ = 0;  ///< Drops from loss_rate_
+    size_t num_ecn_marks_ = 0;     ///< CE-marked packets
+    size_t max_queue_bytes_ = 0;   ///< Longest switch port queue seen
+  };
+
+  SimFabric(sim_fabric_config_t config);
+  ~SimFabric();
+
+  /// Return the fabric of the calling thread, or nullptr if none exists
+  static SimFabric *get_current() { return current_; }
+
+  /// Add a host for \p transport, and return its node index
+  size_t add_host(SimTransport *transport, uint16_t sm_udp_port,
+                  uint8_t rpc_id);
+
+  /// Remove a host. Packets in flight to it are dropped on arrival.
+  void remove_host(size_t node);
+
+  /// Return the node index of a host, or kInvalidNode
+  size_t lookup_host(uint16_t sm_udp_port, uint8_t rpc_id) const;
+
+  /**
+   * @brief Send a packet between two hosts at the current virtual time
+   *
+   * @param pkt A malloc-ed packet, which is owned by the fabric until delivery
+   * @param ect True iff the packet is ECN-capable
+   */
+  void send(size_t src_node, size_t dst_node, uint8_t *pkt, size_t pkt_size,
+            bool ect);
+
+  /**
+   * @brief Advance the virtual clock to the next event, or by
+   * \p max_delta_tsc if that is sooner, and process the events that are due
+   *
+   * A small \p max_delta_tsc bounds how late Rpc timers (e.g., the timing
+   * wheel) fire relative to virtual time.
+   *
+   * @return The new virtual time
+   */
+  size_t advance(size_t max_delta_tsc);
+
+  /// Return the virtual time in RDTSC cycles
+  size_t now() const { return now_tsc_; }
+
+  /// Return true iff no packets are in flight
+  bool is_idle() const { return events_.empty(); }
+
+  /// Return the rate of host links in bytes per second
+  size_t get_bandwidth() const;
+
+  const stats_t &get_stats() const { return stats_; }
+
+ private:
+  enum class EventType : uint8_t {
+    kSwitchArrival,  ///< A packet reaches the switch
+    kHostArrival     ///< A packet reaches its destination host
+  };
+
+  struct event_t {
+    size_t tsc_;
+    size_t seq_;  ///< Orders events with equal times, for reproducibility
+    EventType type_;
+    bool ect_;
+    size_t dst_node_;
+    uint8_t *pkt_;
+    size_t pkt_size_;
+  };
+
+  /// Order the event queue by earliest time first
+  struct event_later_t {
+    bool operator()(const event_t &a, const event_t &b) const {
+      return a.tsc_ != b.tsc_ ? a.tsc_ > b.tsc_ : a.seq_ > b.seq_;
+    }
+  };
+
+  struct host_t {
+    SimTransport *transport_;  ///< nullptr after the host is removed
+    size_t uplink_free_tsc_;   ///< When the host's link drains its queue
+    size_t port_free_tsc_;     ///< When the switch port to the host drains
+  };
+
+  /// Return the time to serialize \p pkt_size bytes on a link
+  size_t serialize_tsc(size_t pkt_size) const;
+
+  void schedule(size_t tsc, EventType type, const event_t &ev);
+  void process_switch_arrival(const event_t &ev);
+  void process_host_arrival(const event_t &ev);
+
+  static thread_local SimFabric *current_;
+
+  const sim_fabric_config_t config_;
+  const double bytes_per_tsc_;    ///< Link rate
+  const size_t link_delay_tsc_;   ///< Link propagation delay
+  const uint32_t loss_threshold_;  ///< Random drop iff next_u32() is lower
+
+  size_t now_tsc_ = kStartTsc;
+  size_t next_seq_ = 0;
+  std::priority_queue<event_t, std::vector<event_t>, event_later_t> events_;
+
+  std::vector<host_t> hosts_;
+  std::unordered_map<uint32_t, size_t> host_map_;  ///< {Port, Rpc ID} to node
+
+  FastRand fast_rand_;
+  stats_t stats_;
+};
+
+}  // namespace erpc
+
+#endif
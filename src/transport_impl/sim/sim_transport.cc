@@ -0,0 +1,147 @@
+#ifdef ERPC_SIM
+#include "sim_transport.h"
+#include <cstring>
+#include <stdexcept>
+
+namespace erpc {
+
+constexpr size_t SimTransport::kMaxDataPerPkt;
+
+SimTransport::SimTransport(uint16_t sm_udp_port, uint8_t rpc_id,
+                           uint8_t phy_port, size_t numa_node,
+                           FILE *trace_file)
+    : Transport(TransportType::kSim, rpc_id, phy_port, numa_node, trace_file),
+      sm_udp_port_(sm_udp_port),
+      fabric_(SimFabric::get_current()) {
+  if (fabric_ == nullptr) {
+    throw std::runtime_error(
+        "SimTransport: Create a SimFabric on the Rpc's thread first");
+  }
+
+  node_ = fabric_->add_host(this, sm_udp_port, rpc_id);
+  rx_tsc_ring_.fill(0);
+  init_mem_reg_funcs();
+}
+
+SimTransport::~SimTransport() {
+  fabric_->remove_host(node_);
+
+  while (!rx_queue_.empty()) {
+    free(rx_queue_.front().buf_);
+    rx_queue_.pop();
+  }
+
+  if (rx_ring_ != nullptr) {
+    for (size_t i = 0; i < kNumRxRingEntries; i++) free(rx_ring_[i]);
+  }
+}
+
+void SimTransport::init_mem_reg_funcs() {
+  // Simulated packets are copied, so nothing needs registration
+  reg_mr_func_ = [](void *, size_t) { return Transport::mem_reg_info(); };
+  dereg_mr_func_ = [](Transport::mem_reg_info) {};
+}
+
+void SimTransport::init_hugepage_structures(HugeAlloc *huge_alloc,
+                                            uint8_t **rx_ring) {
+  huge_alloc_ = huge_alloc;
+  rx_ring_ = rx_ring;
+  for (size_t i = 0; i < kNumRxRingEntries; i++) rx_ring_[i] = nullptr;
+}
+
+void SimTransport::fill_local_routing_info(
+    routing_info_t *routing_info) const {
+  memset(routing_info, 0, sizeof(routing_info_t));
+  auto *ri = reinterpret_cast<sim_routing_info_t *>(routing_info->buf_);
+  ri->sm_udp_port_ = sm_udp_port_;
+  ri->rpc_id_ = rpc_id_;
+  ri->node_ = static_cast<uint32_t>(node_);
+}
+
+bool SimTransport::resolve_remote_routing_info(routing_info_t *routing_info) {
+  auto *ri = reinterpret_cast<sim_routing_info_t *>(routing_info->buf_);
+  const size_t node = fabric_->lookup_host(ri->sm_udp_port_, ri->rpc_id_);
+  if (node == SimFabric::kInvalidNode) return false;
+
+  ri->node_ = static_cast<uint32_t>(node);
+  return true;
+}
+
+std::string SimTransport::routing_info_str(routing_info_t *routing_info) {
+  auto *ri = reinterpret_cast<sim_routing_info_t *>(routing_info->buf_);
+  return "[SM port " + std::to_string(ri->sm_udp_port_) + ", Rpc " +
+         std::to_string(ri->rpc_id_) + ", node " + std::to_string(ri->node_) +
+         "]";
+}
+
+void SimTransport::tx_burst(const tx_burst_item_t *tx_burst_arr,
+                            size_t num_pkts) {
+  for (size_t i = 0; i < num_pkts; i++) {
+    const tx_burst_item_t &item = tx_burst_arr[i];
+    if (item.drop_) continue;
+
+    const MsgBuffer *msg_buffer = item.msg_buffer_;
+    const pkthdr_t *pkthdr = item.pkt_idx_ == 0
+                                 ? msg_buffer->get_pkthdr_0()
+                                 : msg_buffer->get_pkthdr_n(item.pkt_idx_);
+    const size_t pkt_size =
+        msg_buffer->get_pkt_size<kMaxDataPerPkt>(item.pkt_idx_);
+
+    // The fabric owns a copy of the packet until it's delivered. Only the
+    // zeroth packet header is contiguous with the data, and scatter-gather
+    // MsgBuffers need a gather.
+    auto *pkt = static_cast<uint8_t *>(malloc(pkt_size));
+    rt_assert(pkt != nullptr, "SimTransport: Failed to allocate packet");
+    if (likely(!msg_buffer->is_fragmented())) {
+      memcpy(pkt, pkthdr, sizeof(pkthdr_t));
+      memcpy(pkt + sizeof(pkthdr_t),
+             msg_buffer->buf_ + item.pkt_idx_ * kMaxDataPerPkt,
+             pkt_size - sizeof(pkthdr_t));
+    } else {
+      msg_frag_t pieces[kMaxFragsPerPkt];
+      const size_t num_pieces =
+          msg_buffer->get_pkt_frags<kMaxDataPerPkt>(item.pkt_idx_, pieces);
+
+      memcpy(pkt, pkthdr, sizeof(pkthdr_t));
+      size_t offset = sizeof(pkthdr_t);
+      for (size_t j = 0; j < num_pieces; j++) {
+        memcpy(pkt + offset, pieces[j].buf_, pieces[j].size_);
+        offset += pieces[j].size_;
+      }
+    }
+
+    auto *ri = reinterpret_cast<sim_routing_info_t *>(item.routing_info_->buf_);
+    fabric_->send(node_, ri->node_, pkt, pkt_size, ect_);
+  }
+}
+
+size_t SimTransport::rx_burst() {
+  size_t num_pkts = 0;
+  while (!rx_queue_.empty() && num_pkts < kPostlist) {
+    const rx_pkt_t &rx_pkt = rx_queue_.front();
+    const size_t ring_idx = rx_tail_ % kNumRxRingEntries;
+    rx_ring_[ring_idx] = rx_pkt.buf_;
+    rx_tsc_ring_[ring_idx] = rx_pkt.rx_tsc_;
+    rx_queue_.pop();
+
+    rx_tail_++;
+    num_pkts++;
+  }
+
+  return num_pkts;
+}
+
+void SimTransport::post_recvs(size_t num_recvs) {
+  // Free the packets that eRPC is done with. Held packets were replaced by
+  // null ring entries.
+  for (size_t i = 0; i < num_recvs; i++) {
+    const size_t ring_idx = rx_post_tail_ % kNumRxRingEntries;
+    free(rx_ring_[ring_idx]);
+    rx_ring_[ring_idx] = nullptr;
+    rx_post_tail_++;
+  }
+}
+
+}  // namespace erpc
+
+#endif
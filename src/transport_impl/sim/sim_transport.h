@@ -0,0 +1,112 @@
+/**
+ * @file sim_transport.h
+ * @brief Transport that exchanges packets between Rpcs in one process through
+ * a simulated fabric in virtual time
+ */
+#pragma once
+
+#ifdef ERPC_SIM
+
+#include <array>
+#include <queue>
+#include "sim_fabric.h"
+#include "transport.h"
+
+namespace erpc {
+
+class SimTransport : public Transport {
+ public:
+  static constexpr TransportType kTransportType = TransportType::kSim;
+  static constexpr size_t kMTU = 1024;  // Match other eRPC transports
+  static constexpr size_t kPostlist = 16;
+  static constexpr size_t kUnsigBatch = 64;
+  static constexpr size_t kMaxDataPerPkt = (kMTU - sizeof(pkthdr_t));
+  static constexpr size_t kMaxFragsPerPkt = 8;
+
+  /// Simulated routing info embedded in routing_info_t
+  struct sim_routing_info_t {
+    uint16_t sm_udp_port_;  ///< The Nexus's management port
+    uint8_t rpc_id_;
+    uint8_t padding_;
+    uint32_t node_;  ///< The host's fabric node, filled in by resolution
+  };
+
+  /// Construct a host on the calling thread's SimFabric
+  /// @throw runtime_error if the thread has no fabric
+  SimTransport(uint16_t sm_udp_port, uint8_t rpc_id, uint8_t phy_port,
+               size_t numa_node, FILE *trace_file);
+  ~SimTransport();
+
+  void init_hugepage_structures(HugeAlloc *huge_alloc, uint8_t **rx_ring);
+  void init_mem_reg_funcs();
+  void fill_local_routing_info(routing_info_t *routing_info) const;
+
+  bool resolve_remote_routing_info(routing_info_t *routing_info);
+  size_t get_bandwidth() const { return fabric_->get_bandwidth(); }
+
+  static std::string routing_info_str(routing_info_t *routing_info);
+
+  void tx_burst(const tx_burst_item_t *tx_burst_arr, size_t num_pkts);
+  void tx_flush() {}  // Packets are copied into the fabric in tx_burst()
+  size_t rx_burst();
+  void post_recvs(size_t num_recvs);
+
+  /// Received packets are individually malloc-ed, so they can always be held
+  size_t enable_rx_hold() { return kNumRxRingEntries; }
+
+  uint8_t *hold_rx_pkt(size_t ring_idx) {
+    uint8_t *pkt = rx_ring_[ring_idx];
+    rx_ring_[ring_idx] = nullptr;  // Don't free in post_recvs()
+    return pkt;
+  }
+
+  void release_rx_pkt(uint8_t *pkt) { free(pkt); }
+
+  /// The simulation thread runs all Rpcs, so it never blocks for packets
+  int get_rx_event_fd() const { return -1; }
+  bool arm_rx_event() { return false; }
+
+  /// Mark sent packets ECN-capable, so that congested switch ports mark them
+  bool enable_ecn() {
+    ect_ = true;
+    return true;
+  }
+
+  /// RX timestamps are the exact virtual arrival times. TX timestamps are
+  /// already exact, since Rpcs take no virtual time.
+  bool enable_timestamps(double) {
+    timestamps_ = true;
+    return true;
+  }
+
+  size_t get_rx_tsc(size_t ring_idx) const { return rx_tsc_ring_[ring_idx]; }
+
+  /// Queue a packet that arrived from the fabric at virtual time \p rx_tsc
+  void deliver(uint8_t *pkt, size_t rx_tsc) {
+    rx_queue_.push(rx_pkt_t{pkt, timestamps_ ? rx_tsc : 0});
+  }
+
+ private:
+  struct rx_pkt_t {
+    uint8_t *buf_;
+    size_t rx_tsc_;  ///< Virtual arrival time, or 0 without timestamps
+  };
+
+  const uint16_t sm_udp_port_;  ///< The parent Nexus's management port
+  SimFabric *fabric_;  ///< The fabric of the thread that created this
+  size_t node_;        ///< This host's fabric node
+
+  bool ect_ = false;        ///< Send ECN-capable packets
+  bool timestamps_ = false;  ///< Report RX timestamps
+
+  std::queue<rx_pkt_t> rx_queue_;  ///< Delivered packets not in the RX ring
+
+  uint8_t **rx_ring_ = nullptr;  ///< Pointer to eRPC's RX ring
+  std::array<size_t, kNumRxRingEntries> rx_tsc_ring_;  ///< For rx_ring_
+  size_t rx_tail_ = 0;       ///< Next RX ring entry to fill in rx_burst()
+  size_t rx_post_tail_ = 0;  ///< Next RX ring entry to free in post_recvs()
+};
+
+}  // namespace erpc
+
+#endif
@@ -0,0 +1,154 @@
+/**
+ * @file dpath_memcpy.h
+ * @brief Copy kernels for datapath payload copies
+ *
+ * eRPC copies payload out of RX ring buffers in a few places, e.g., when
+ * reassembling multi-packet messages. These copies are between one and a few
+ * packets large, except that they repeat back-to-back for large messages.
+ *
+ * The copy kernel is picked at compile time from the widest available vector
+ * ISA (AVX-512, AVX2, or DPDK's SSE rte_memcpy). For destination messages that
+ * are too large to stay in cache, non-temporal stores avoid polluting the
+ * cache with payload that the application will read much later, if at all.
+ */
+#pragma once
+
+#include <immintrin.h>
+#include "common.h"
+#include "rte_memcpy/rte_memcpy_mod.h"
+
+namespace erpc {
+
+/// Messages at least this large are reassembled using non-temporal stores
+static constexpr size_t kDpathMemcpyNtThresh = MB(1);
+
+/// Copies smaller than this are left to the libc memcpy, which is hard to beat
+/// for tiny sizes
+static constexpr size_t kDpathMemcpyMinVec = 64;
+
+#if defined(__AVX512F__)
+static constexpr size_t kDpathVecSize = 64;
+#elif defined(__AVX2__)
+static constexpr size_t kDpathVecSize = 32;
+#else
+static constexpr size_t kDpathVecSize = 16;
+#endif
+
+/// Copy one vector from src to dst, without alignment requirements
+static inline void dpath_mov_vec(uint8_t *dst, const uint8_t *src) {
+#if defined(__AVX512F__)
+  _mm512_storeu_si512(dst, _mm512_loadu_si512(src));
+#elif defined(__AVX2__)
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst),
+                      _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src)));
+#else
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(dst),
+                   _mm_loadu_si128(reinterpret_cast<const __m128i *>(src)));
+#endif
+}
+
+/// Copy one vector from src to a vector-aligned dst using a non-temporal store
+static inline void dpath_mov_vec_nt(uint8_t *dst, const uint8_t *src) {
+  assert(reinterpret_cast<uintptr_t>(dst) % kDpathVecSize == 0);
+#if defined(__AVX512F__)
+  _mm512_stream_si512(reinterpret_cast<__m512i *>(dst),
+                      _mm512_loadu_si512(src));
+#elif defined(__AVX2__)
+  _mm256_stream_si256(reinterpret_cast<__m256i *>(dst),
+                      _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src)));
+#else
+  _mm_stream_si128(reinterpret_cast<__m128i *>(dst),
+                   _mm_loadu_si128(reinterpret_cast<const __m128i *>(src)));
+#endif
+}
+
+/**
+ * @brief Copy \p n bytes from \p src to \p dst using temporal stores. The
+ * buffers must not overlap.
+ */
+static inline void dpath_memcpy(void *dst, const void *src, size_t n) {
+  if (n < kDpathMemcpyMinVec) {
+    memcpy(dst, src, n);
+    return;
+  }
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+  auto *d = static_cast<uint8_t *>(dst);
+  auto *s = static_cast<const uint8_t *>(src);
+
+  // Four vectors per iteration, then mop up with (possibly overlapping)
+  // vectors ending exactly at the end of the buffer
+  while (n >= 4 * kDpathVecSize) {
+    dpath_mov_vec(d, s);
+    dpath_mov_vec(d + kDpathVecSize, s + kDpathVecSize);
+    dpath_mov_vec(d + 2 * kDpathVecSize, s + 2 * kDpathVecSize);
+    dpath_mov_vec(d + 3 * kDpathVecSize, s + 3 * kDpathVecSize);
+    d += 4 * kDpathVecSize;
+    s += 4 * kDpathVecSize;
+    n -= 4 * kDpathVecSize;
+  }
+
+  while (n > kDpathVecSize) {
+    dpath_mov_vec(d, s);
+    d += kDpathVecSize;
+    s += kDpathVecSize;
+    n -= kDpathVecSize;
+  }
+
+  // At least kDpathMemcpyMinVec bytes were requested, so the last vector
+  // stays within both buffers
+  if (n > 0) dpath_mov_vec(d + n - kDpathVecSize, s + n - kDpathVecSize);
+#else
+  rte_memcpy_func(dst, src, n);
+#endif
+}
+
+/**
+ * @brief Copy \p n bytes from \p src to \p dst using non-temporal stores where
+ * possible. The buffers must not overlap.
+ *
+ * The stores are weakly ordered, so the caller must issue dpath_memcpy_fence()
+ * before another thread may read \p dst.
+ */
+static inline void dpath_memcpy_nt(void *dst, const void *src, size_t n) {
+  auto *d = static_cast<uint8_t *>(dst);
+  auto *s = static_cast<const uint8_t *>(src);
+
+  // Use regular stores until the destination is vector-aligned
+  const size_t misalign = reinterpret_cast<uintptr_t>(d) % kDpathVecSize;
+  if (misalign != 0) {
+    const size_t head = (std::min)(n, kDpathVecSize - misalign);
+    memcpy(d, s, head);
+    d += head;
+    s += head;
+    n -= head;
+  }
+
+  while (n >= kDpathVecSize) {
+    dpath_mov_vec_nt(d, s);
+    d += kDpathVecSize;
+    s += kDpathVecSize;
+    n -= kDpathVecSize;
+  }
+
+  if (n > 0) memcpy(d, s, n);
+}
+
+/// Order prior non-temporal stores before subsequent stores, e.g., before
+/// handing a reassembled message to another thread
+static inline void dpath_memcpy_fence() { _mm_sfence(); }
+
+/**
+ * @brief Copy one chunk of a message that is \p msg_size bytes in total,
+ * choosing the copy kernel based on the message size
+ */
+static inline void dpath_memcpy_msg(void *dst, const void *src, size_t n,
+                                    size_t msg_size) {
+  if (msg_size >= kDpathMemcpyNtThresh) {
+    dpath_memcpy_nt(dst, src, n);
+  } else {
+    dpath_memcpy(dst, src, n);
+  }
+}
+
+}  // namespace erpc
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <linux/futex.h>
+#include <stdint.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include <atomic>
+
+namespace erpc {
+
+/// Block the calling thread while \p word contains \p val, for at most
+/// \p timeout_us microseconds. Spurious wakeups are possible.
+static inline void futex_wait(std::atomic<uint32_t> *word, uint32_t val,
+                              size_t timeout_us) {
+  static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "");
+  struct timespec timeout;
+  timeout.tv_sec = static_cast<time_t>(timeout_us / 1000000);
+  timeout.tv_nsec = static_cast<long>((timeout_us % 1000000) * 1000);
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAIT_PRIVATE,
+          val, &timeout, nullptr, 0);
+}
+
+/// Wake up all threads blocked in futex_wait() on \p word
+static inline void futex_wake_all(std::atomic<uint32_t> *word) {
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAKE_PRIVATE,
+          INT32_MAX, nullptr, nullptr, 0);
+}
+
+}  // namespace erpc
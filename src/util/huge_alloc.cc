@@ -72,7 +72,7 @@ void HugeAlloc::print_stats() {
 }
 
 Buffer HugeAlloc::alloc_raw(size_t size, DoRegister do_register) {
-#ifdef ERPC_FAKE
+#if defined(ERPC_FAKE) || defined(ERPC_SIM)
   _unused(size);
   _unused(do_register);
   uint8_t *buf = new uint8_t[size];
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <atomic>
+#include <type_traits>
+
+#include "util/barrier.h"
+#include "util/math_utils.h"
+
+namespace erpc {
+
+/**
+ * @brief A bounded, lock-free, multi-producer single-consumer ring
+ *
+ * Each slot carries a sequence number that tells whether it is free for the
+ * producer that claimed its position, or filled for the consumer. Producers
+ * claim positions with a compare-and-swap on the tail, so they never block
+ * each other while copying elements. The consumer does not need atomic
+ * read-modify-write operations. The head and tail are on separate cache lines
+ * to avoid false sharing between the consumer and the producers.
+ *
+ * @tparam T The type of elements, which must be trivially copyable
+ * @tparam N The capacity of the ring, which must be a power of two
+ */
+template <typename T, size_t N>
+class MpscRing {
+  static_assert(is_power_of_two(N), "Ring capacity must be a power of two");
+  static_assert(std::is_trivially_copyable<T>::value,
+                "Ring elements must be trivially copyable");
+  static constexpr size_t kMask = N - 1;
+
+  struct slot_t {
+    std::atomic<size_t> seq_;
+    T elem_;
+  };
+
+ public:
+  MpscRing() {
+    for (size_t i = 0; i < N; i++) {
+      slots_[i].seq_.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  /// Add an element to the ring. Safe to call from any thread. Return false
+  /// iff the ring is full.
+  bool try_push(const T &elem) {
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    slot_t *slot;
+
+    while (true) {
+      slot = &slots_[pos & kMask];
+      const size_t seq = slot->seq_.load(std::memory_order_acquire);
+      const auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+
+      if (diff == 0) {
+        // The slot is free for this position, so try to claim the position
+        if (tail_.compare_exchange_weak(pos, pos + 1,
+                                        std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;  // The consumer hasn't freed this slot yet
+      } else {
+        pos = tail_.load(std::memory_order_relaxed);  // Lost a race
+      }
+    }
+
+    slot->elem_ = elem;
+    slot->seq_.store(pos + 1, std::memory_order_release);  // Publish
+    return true;
+  }
+
+  /// Add an element to the ring, spinning while the ring is full. This must
+  /// not be used by threads that the consumer may wait for.
+  void push(const T &elem) {
+    while (!try_push(elem)) pause();
+  }
+
+  /**
+   * @brief Remove up to \p max_elems elements from the ring, oldest first.
+   * Only the consumer thread may call this.
+   *
+   * @return The number of elements written to \p out
+   */
+  size_t pop_burst(T *out, size_t max_elems) {
+    size_t num_popped = 0;
+    while (num_popped < max_elems) {
+      slot_t &slot = slots_[head_ & kMask];
+      if (slot.seq_.load(std::memory_order_acquire) != head_ + 1) break;
+
+      out[num_popped++] = slot.elem_;
+      slot.seq_.store(head_ + N, std::memory_order_release);  // Free the slot
+      head_++;
+    }
+
+    return num_popped;
+  }
+
+  /// Return true iff the ring has no element ready for the consumer. Only the
+  /// consumer thread may call this.
+  bool empty() const {
+    return slots_[head_ & kMask].seq_.load(std::memory_order_acquire) !=
+           head_ + 1;
+  }
+
+  /// Return the number of elements pushed to the ring since its creation.
+  /// Safe to call from any thread, but possibly stale.
+  size_t num_pushed() const { return tail_.load(std::memory_order_relaxed); }
+
+  static constexpr size_t capacity() { return N; }
+
+ private:
+  // Padding keeps the producers' tail and the consumer's head on separate
+  // cache lines, and away from neighboring objects
+  const uint8_t pad_0_[64] = {0};
+  std::atomic<size_t> tail_{0};  ///< Next position to claim
+  const uint8_t pad_1_[64 - sizeof(size_t)] = {0};
+  size_t head_ = 0;  ///< Next position to consume
+  const uint8_t pad_2_[64 - sizeof(size_t)] = {0};
+  slot_t slots_[N];
+};
+
+}  // namespace erpc
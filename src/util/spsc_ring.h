@@ -0,0 +1,93 @@
+#pragma once
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <type_traits>
+
+#include "util/math_utils.h"
+
+namespace erpc {
+
+/**
+ * @brief A bounded, lock-free, single-producer single-consumer ring
+ *
+ * The producer owns the tail and the consumer owns the head, which are on
+ * separate cache lines. Each side caches the other side's index and re-reads
+ * it only when the ring looks full or short of elements, so that a burst of
+ * operations does not bounce cache lines between the two threads.
+ *
+ * @tparam T The type of elements, which must be trivially copyable
+ * @tparam N The capacity of the ring, which must be a power of two
+ */
+template <typename T, size_t N>
+class SpscRing {
+  static_assert(is_power_of_two(N), "Ring capacity must be a power of two");
+  static_assert(std::is_trivially_copyable<T>::value,
+                "Ring elements must be trivially copyable");
+  static constexpr size_t kMask = N - 1;
+
+ public:
+  /// Add an element to the ring. Only the producer thread may call this.
+  /// Return false iff the ring is full.
+  bool try_push(const T &elem) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_cache_ == N) {
+      head_cache_ = head_.load(std::memory_order_acquire);
+      if (tail - head_cache_ == N) return false;
+    }
+
+    elems_[tail & kMask] = elem;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * @brief Remove up to \p max_elems elements from the ring, oldest first.
+   * Only the consumer thread may call this.
+   *
+   * @return The number of elements written to \p out
+   */
+  size_t pop_burst(T *out, size_t max_elems) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (tail_cache_ - head < max_elems) {
+      tail_cache_ = tail_.load(std::memory_order_acquire);
+      if (tail_cache_ == head) return 0;
+    }
+
+    const size_t num_popped = (std::min)(max_elems, tail_cache_ - head);
+    for (size_t i = 0; i < num_popped; i++) {
+      out[i] = elems_[(head + i) & kMask];
+    }
+
+    head_.store(head + num_popped, std::memory_order_release);
+    return num_popped;
+  }
+
+  /// Return true iff the ring is empty. Only the consumer thread may call this.
+  bool empty() const {
+    return tail_.load(std::memory_order_acquire) ==
+           head_.load(std::memory_order_relaxed);
+  }
+
+  static constexpr size_t capacity() { return N; }
+
+ private:
+  const uint8_t pad_0_[64] = {0};
+
+  // Producer-owned cache line
+  std::atomic<size_t> tail_{0};
+  size_t head_cache_ = 0;  ///< The producer's possibly-stale copy of head_
+  const uint8_t pad_1_[64 - 2 * sizeof(size_t)] = {0};
+
+  // Consumer-owned cache line
+  std::atomic<size_t> head_{0};
+  size_t tail_cache_ = 0;  ///< The consumer's possibly-stale copy of tail_
+  const uint8_t pad_2_[64 - 2 * sizeof(size_t)] = {0};
+
+  T elems_[N];
+};
+
+}  // namespace erpc
@@ -7,13 +7,30 @@
 
 #include <stdint.h>
 #include <stdlib.h>
+#include <time.h>
 #include <chrono>
 #include "common.h"
 
 namespace erpc {
 
-/// Return the TSC
+#ifdef ERPC_SIM
+/// Nominal RDTSC frequency of simulation builds. Virtual time doesn't depend on
+/// the CPU, so a fixed frequency makes simulations reproducible across machines.
+static constexpr double kSimFreqGhz = 1.0;
+
+/// The virtual clock of the calling thread, installed by SimFabric on the
+/// thread that runs simulated Rpcs. Other threads use the real TSC.
+inline const size_t *&sim_tsc_ptr() {
+  static thread_local const size_t *sim_tsc = nullptr;
+  return sim_tsc;
+}
+#endif
+
+/// Return the TSC, or the virtual clock in simulation builds
 static inline size_t rdtsc() {
+#ifdef ERPC_SIM
+  if (sim_tsc_ptr() != nullptr) return *sim_tsc_ptr();
+#endif
   uint64_t rax;
   uint64_t rdx;
   asm volatile("rdtsc" : "=a"(rax), "=d"(rdx));
@@ -108,6 +125,26 @@ static double to_nsec(size_t cycles, double freq_ghz) {
   return (cycles / freq_ghz);
 }
 
+/**
+ * @brief Convert a CLOCK_REALTIME timestamp, e.g., a kernel packet timestamp,
+ * to RDTSC cycles. Both clocks are sampled now and only the timestamp's age is
+ * converted, so errors in \p freq_ghz and clock adjustments don't accumulate.
+ *
+ * @return The TSC at \p ts, or 0 if \p ts is in the future or older than
+ * \p max_age_ns, e.g., because it comes from an unsynchronized NIC clock
+ */
+static size_t realtime_to_tsc(const timespec &ts, double freq_ghz,
+                              size_t max_age_ns) {
+  timespec now;
+  const size_t now_tsc = rdtsc();
+  clock_gettime(CLOCK_REALTIME, &now);
+
+  const int64_t age_ns = (now.tv_sec - ts.tv_sec) * 1000000000ll +
+                         (now.tv_nsec - ts.tv_nsec);
+  if (age_ns < 0 || static_cast<size_t>(age_ns) > max_age_ns) return 0;
+  return now_tsc - ns_to_cycles(age_ns, freq_ghz);
+}
+
 /// Simple time that uses RDTSC
 class TscTimer {
  public:
@@ -18,6 +18,8 @@ void TlsRegistry::reset() {
   cur_etid_ = 0;
 }
 
+bool TlsRegistry::is_init() const { return tls_initialized; }
+
 size_t TlsRegistry::get_etid() const {
   assert(tls_initialized);
   return etid;
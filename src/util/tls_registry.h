@@ -13,6 +13,9 @@ class TlsRegistry {
   /// Initialize all the thread-local registry members
   void init();
 
+  /// Return true iff init() was called by this thread
+  bool is_init() const;
+
   /// Reset all members
   void reset();
 
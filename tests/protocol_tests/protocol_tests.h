@@ -167,15 +167,20 @@ class RpcTest : public ::testing::Test {
   size_t num_cont_func_calls_ = 0;
 };
 
-/// The common request handler for subtests. Works for any request size.
-/// Copies request to response.
+/// The common request handler for subtests. Works for any request size, and
+/// for fragmented requests. Copies request to response.
 static void req_handler(ReqHandle *req_handle, void *_context) {
   auto *context = static_cast<RpcTest *>(_context);
   const MsgBuffer *req_msgbuf = req_handle->get_req_msgbuf();
   const size_t resp_size = req_msgbuf->get_data_size();
 
   req_handle->dyn_resp_msgbuf_ = context->rpc_->alloc_msg_buffer(resp_size);
-  memcpy(req_handle->dyn_resp_msgbuf_.buf_, req_msgbuf->buf_, resp_size);
+  size_t offset = 0;
+  for (size_t i = 0; i < req_msgbuf->get_num_frags(); i++) {
+    const msg_frag_t frag = req_msgbuf->get_frag(i);
+    memcpy(&req_handle->dyn_resp_msgbuf_.buf_[offset], frag.buf_, frag.size_);
+    offset += frag.size_;
+  }
 
   context->rpc_->enqueue_response(req_handle, &req_handle->dyn_resp_msgbuf_);
   context->num_req_handler_calls_++;
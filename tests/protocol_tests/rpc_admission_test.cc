@@ -0,0 +1,108 @@
+#include "protocol_tests.h"
+
+namespace erpc {
+
+/// The server sheds requests with CoDel's control law while the queueing
+/// delay stays above the target
+TEST_F(RpcTest, shed_reqs_when_overloaded) {
+  const auto server = get_local_endpoint();
+  const auto client = get_remote_endpoint();
+  Session *srv_session = create_server_session_init(client, server);
+  SSlot *sslot_0 = &srv_session->sslot_arr_[0];
+  const double freq_ghz = rpc_->get_freq_ghz();
+  auto &ac = rpc_->admission_;
+
+  uint8_t req[sizeof(pkthdr_t) + kTestSmallMsgSize];
+  auto *pkthdr_0 = reinterpret_cast<pkthdr_t *>(req);
+  pkthdr_0->format(kTestReqType, kTestSmallMsgSize, server.session_num_,
+                   PktType::kReq, 0 /* pkt_num */, 0 /* req_num */);
+  rpc_->set_admission_control(10 /* target_us */, 100 /* interval_us */);
+
+  // Receive the next request at the server
+  auto recv_req = [&](size_t rx_tsc) {
+    rpc_->ev_loop_tsc_ = rx_tsc;
+    pkthdr_0->req_num_ += kSessionReqWindow;
+    rpc_->process_small_req_st(sslot_0, pkthdr_0);
+    return pkthdr_tx_queue_->pop();
+  };
+
+  // Receive a request that waited 50 us for its handler
+  // Expect: It's admitted, and the delay is above the target
+  const size_t delayed_tsc = rdtsc() - us_to_cycles(50, freq_ghz);
+  ASSERT_EQ(recv_req(delayed_tsc).overloaded_, 0);
+  ASSERT_EQ(num_req_handler_calls_, 1);
+  ASSERT_NE(ac.first_above_tsc_, 0);
+
+  // Receive a request after the delay stayed above the target for an interval
+  // Expect: It's shed with an empty overloaded response
+  ac.first_above_tsc_ = 1;
+  const pkthdr_t resp_pkthdr = recv_req(delayed_tsc);
+  ASSERT_TRUE(resp_pkthdr.matches(PktType::kResp, 0));
+  ASSERT_EQ(resp_pkthdr.overloaded_, 1);
+  ASSERT_EQ(resp_pkthdr.msg_size_, 0);
+  ASSERT_EQ(rpc_->get_num_shed_reqs(), 1);
+  ASSERT_FALSE(sslot_0->server_info_.overloaded_);
+  ASSERT_EQ(ac.drop_next_tsc_, delayed_tsc + ac.interval_cycles_);
+
+  // Expect: Requests are admitted until the next drop time
+  ASSERT_EQ(recv_req(delayed_tsc).overloaded_, 0);
+  ASSERT_EQ(num_req_handler_calls_, 2);
+
+  // Expect: The next request is shed, and drops get closer together
+  const size_t drop_tsc = ac.drop_next_tsc_;
+  ASSERT_EQ(recv_req(drop_tsc).overloaded_, 1);
+  ASSERT_EQ(rpc_->get_num_shed_reqs(), 2);
+  ASSERT_EQ(ac.count_, 2);
+  const double next_gap = ac.interval_cycles_ / std::sqrt(2.0);
+  ASSERT_EQ(ac.drop_next_tsc_, drop_tsc + static_cast<size_t>(next_gap));
+
+  // Receive a request that starts its handler at once
+  // Expect: It's admitted, and shedding stops
+  ASSERT_EQ(recv_req(rdtsc()).overloaded_, 0);
+  ASSERT_EQ(ac.first_above_tsc_, 0);
+  ASSERT_EQ(recv_req(ac.drop_next_tsc_).overloaded_, 0);
+  ASSERT_FALSE(ac.dropping_);
+  ASSERT_EQ(num_req_handler_calls_, 4);
+}
+
+/// The client reports shed requests with the -EBUSY status
+TEST_F(RpcTest, overloaded_response_status) {
+  const auto client = get_local_endpoint();
+  const auto server = get_remote_endpoint();
+  Session *clt_session = create_client_session_connected(client, server);
+  SSlot *sslot_0 = &clt_session->sslot_arr_[0];
+
+  MsgBuffer req = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+  MsgBuffer resp = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+  rpc_->faults_.hard_wheel_bypass_ = true;  // Don't place request pkt in wheel
+
+  uint8_t remote_resp[sizeof(pkthdr_t)];
+  auto *resp_pkthdr_0 = reinterpret_cast<pkthdr_t *>(remote_resp);
+  resp_pkthdr_0->format(kTestReqType, 0, client.session_num_, PktType::kResp,
+                        0 /* pkt_num */, kSessionReqWindow);
+  resp_pkthdr_0->overloaded_ = 1;
+
+  rpc_->enqueue_request(0, kTestReqType, &req, &resp, cont_func, kTestTag);
+  pkthdr_tx_queue_->pop();
+  rpc_->process_resp_one_st(sslot_0, resp_pkthdr_0, rdtsc());
+  ASSERT_EQ(num_cont_func_calls_, 1);
+  ASSERT_EQ(rpc_->cont_status_, -EBUSY);
+  ASSERT_EQ(resp.get_data_size(), 0);
+
+  rpc_->enable_completion_queue(nullptr);
+  rpc_->enqueue_request(0, kTestReqType, &req, &resp, nullptr, kTestTag);
+  pkthdr_tx_queue_->pop();
+  resp_pkthdr_0->req_num_ += kSessionReqWindow;
+  rpc_->process_resp_one_st(sslot_0, resp_pkthdr_0, rdtsc());
+
+  completion_t comp;
+  ASSERT_EQ(rpc_->poll_completions(&comp, 1), 1);
+  ASSERT_EQ(comp.status_, -EBUSY);
+}
+
+}  // namespace erpc
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,258 @@
+#include "protocol_tests.h"
+
+namespace erpc {
+
+/// A request's time budget is carried in its packet headers
+TEST_F(RpcTest, enqueue_request_deadline) {
+  const auto client = get_local_endpoint();
+  const auto server = get_remote_endpoint();
+  create_client_session_connected(client, server);
+
+  MsgBuffer req = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+  MsgBuffer resp = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+
+  rpc_->faults_.hard_wheel_bypass_ = true;  // Don't place request pkt in wheel
+  rpc_->enqueue_request(0, kTestReqType, &req, &resp, cont_func, kTestTag,
+                        1000 /* deadline_us */);
+
+  const pkthdr_t req_pkthdr = pkthdr_tx_queue_->pop();
+  ASSERT_GT(req_pkthdr.deadline_us_, 0);
+  ASSERT_LE(req_pkthdr.deadline_us_, 1000);
+  ASSERT_NE(rpc_->next_deadline_tsc_, SIZE_MAX);
+
+  // A request without a deadline carries a zero budget
+  rpc_->enqueue_request(0, kTestReqType, &req, &resp, cont_func, kTestTag);
+  ASSERT_EQ(pkthdr_tx_queue_->pop().deadline_us_, 0);
+}
+
+/// A request that expires before it's transmitted releases its sslot now
+TEST_F(RpcTest, expire_stalled_request) {
+  const auto client = get_local_endpoint();
+  const auto server = get_remote_endpoint();
+  Session *clt_session = create_client_session_connected(client, server);
+  SSlot *sslot_0 = &clt_session->sslot_arr_[0];
+
+  MsgBuffer req = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+  MsgBuffer resp = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+  rpc_->enable_completion_queue(nullptr);
+
+  clt_session->client_info_.credits_ = 0;  // Stall the request for credits
+  rpc_->enqueue_request(0, kTestReqType, &req, &resp, nullptr, kTestTag, 1);
+  ASSERT_EQ(rpc_->stallq_.size(), 1);
+  const size_t req_num = sslot_0->cur_req_num_;
+
+  // Expect: The request fails with a timeout, and its request number is reused
+  rpc_->ev_loop_tsc_ = rdtsc() + us_to_cycles(10, rpc_->get_freq_ghz());
+  rpc_->expire_reqs_st();
+
+  completion_t comp;
+  ASSERT_EQ(rpc_->poll_completions(&comp, 1), 1);
+  ASSERT_EQ(comp.status_, -ETIMEDOUT);
+  ASSERT_EQ(resp.get_data_size(), 0);
+  ASSERT_TRUE(rpc_->stallq_.empty());
+  ASSERT_EQ(sslot_0->tx_msgbuf_, nullptr);
+  ASSERT_EQ(sslot_0->cur_req_num_, req_num - kSessionReqWindow);
+  ASSERT_EQ(clt_session->client_info_.sslot_free_vec_.size(),
+            kSessionReqWindow);
+  ASSERT_EQ(pkthdr_tx_queue_->size(), 0);
+}
+
+/// A request that expires with packets in flight fails now, and finishes the
+/// protocol with eRPC-owned MsgBuffers
+TEST_F(RpcTest, expire_in_flight_request) {
+  const auto client = get_local_endpoint();
+  const auto server = get_remote_endpoint();
+  Session *clt_session = create_client_session_connected(client, server);
+  SSlot *sslot_0 = &clt_session->sslot_arr_[0];
+
+  MsgBuffer req = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+  MsgBuffer resp = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+
+  rpc_->faults_.hard_wheel_bypass_ = true;  // Don't place request pkt in wheel
+  rpc_->enqueue_request(0, kTestReqType, &req, &resp, cont_func, kTestTag, 1);
+  pkthdr_tx_queue_->pop();
+  ASSERT_EQ(clt_session->client_info_.credits_, kSessionCredits - 1);
+
+  // Expect: The continuation is invoked, but the sslot and credit are in use
+  rpc_->ev_loop_tsc_ = rdtsc() + us_to_cycles(10, rpc_->get_freq_ghz());
+  rpc_->expire_reqs_st();
+  ASSERT_EQ(num_cont_func_calls_, 1);
+  ASSERT_EQ(resp.get_data_size(), 0);
+  ASSERT_TRUE(sslot_0->client_info_.cancelled_);
+  ASSERT_NE(sslot_0->tx_msgbuf_, &req);
+  ASSERT_EQ(clt_session->client_info_.credits_, kSessionCredits - 1);
+
+  // Expect: The deadline isn't checked again
+  rpc_->expire_reqs_st();
+  ASSERT_EQ(num_cont_func_calls_, 1);
+
+  // Receive the response
+  // Expect: The continuation is not invoked again, and the sslot is released
+  uint8_t remote_resp[sizeof(pkthdr_t) + kTestSmallMsgSize];
+  auto *pkthdr_0 = reinterpret_cast<pkthdr_t *>(remote_resp);
+  pkthdr_0->format(kTestReqType, kTestSmallMsgSize, client.session_num_,
+                   PktType::kResp, 0 /* pkt_num */, kSessionReqWindow);
+  rpc_->process_resp_one_st(sslot_0, pkthdr_0, rdtsc());
+  ASSERT_EQ(num_cont_func_calls_, 1);
+  ASSERT_EQ(sslot_0->tx_msgbuf_, nullptr);
+  ASSERT_EQ(clt_session->client_info_.credits_, kSessionCredits);
+  ASSERT_EQ(clt_session->client_info_.sslot_free_vec_.size(),
+            kSessionReqWindow);
+}
+
+TEST_F(RpcTest, cancel_request) {
+  const auto client = get_local_endpoint();
+  const auto server = get_remote_endpoint();
+  Session *clt_session = create_client_session_connected(client, server);
+
+  MsgBuffer req = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+  std::vector<MsgBuffer> resp(kSessionReqWindow + 1);
+  for (auto &r : resp) r = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+  rpc_->enable_completion_queue(nullptr);
+
+  // Fill the session's slots, and backlog one request
+  rpc_->faults_.hard_wheel_bypass_ = true;
+  for (size_t i = 0; i <= kSessionReqWindow; i++) {
+    rpc_->enqueue_request(0, kTestReqType, &req, &resp[i], nullptr,
+                          reinterpret_cast<void *>(i + 1));
+  }
+  while (pkthdr_tx_queue_->size() > 0) pkthdr_tx_queue_->pop();
+  ASSERT_EQ(clt_session->client_info_.enq_req_backlog_.size(), 1);
+
+  ASSERT_EQ(rpc_->cancel_request(reinterpret_cast<void *>(100)), -ENOENT);
+
+  // Expect: The backlogged request is removed and fails
+  void *backlogged_tag = reinterpret_cast<void *>(kSessionReqWindow + 1);
+  completion_t comp;
+  ASSERT_EQ(rpc_->cancel_request(backlogged_tag), 0);
+  ASSERT_EQ(rpc_->poll_completions(&comp, 1), 1);
+  ASSERT_EQ(comp.tag_, backlogged_tag);
+  ASSERT_EQ(comp.status_, -ECANCELED);
+  ASSERT_TRUE(clt_session->client_info_.enq_req_backlog_.empty());
+
+  // Expect: An in-flight request fails, and cannot be cancelled twice
+  ASSERT_EQ(rpc_->cancel_request(reinterpret_cast<void *>(1)), 0);
+  ASSERT_EQ(rpc_->poll_completions(&comp, 1), 1);
+  ASSERT_EQ(comp.status_, -ECANCELED);
+  ASSERT_EQ(rpc_->cancel_request(reinterpret_cast<void *>(1)), -ENOENT);
+}
+
+/// Tags delivered to batch_cancel_cont_func(), which cancels request 2 on its
+/// first call
+static std::vector<void *> batch_cancel_tags;
+
+static void batch_cancel_cont_func(void *_context, const completion_t *comps,
+                                   size_t num_comps) {
+  auto *context = static_cast<RpcTest *>(_context);
+  if (batch_cancel_tags.empty()) {
+    ASSERT_EQ(context->rpc_->cancel_request(reinterpret_cast<void *>(2)), 0);
+  }
+  for (size_t i = 0; i < num_comps; i++) {
+    batch_cancel_tags.push_back(comps[i].tag_);
+  }
+}
+
+/// Cancelling from the batch continuation queues a completion that is
+/// delivered on the next pass, without disturbing the current batch
+TEST_F(RpcTest, cancel_request_in_batch_cont_func) {
+  const auto client = get_local_endpoint();
+  const auto server = get_remote_endpoint();
+  create_client_session_connected(client, server);
+
+  MsgBuffer req = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+  MsgBuffer resp[2];
+  for (auto &r : resp) r = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+  rpc_->enable_completion_queue(batch_cancel_cont_func);
+
+  rpc_->faults_.hard_wheel_bypass_ = true;
+  for (size_t i = 0; i < 2; i++) {
+    rpc_->enqueue_request(0, kTestReqType, &req, &resp[i], nullptr,
+                          reinterpret_cast<void *>(i + 1));
+  }
+  while (pkthdr_tx_queue_->size() > 0) pkthdr_tx_queue_->pop();
+
+  // Queue one completion, in a queue that must grow for the next one
+  ASSERT_EQ(rpc_->cancel_request(reinterpret_cast<void *>(1)), 0);
+  rpc_->comp_queue_.shrink_to_fit();
+  ASSERT_EQ(rpc_->comp_queue_.capacity(), 1);
+
+  batch_cancel_tags.clear();
+  rpc_->deliver_completions_st();
+  ASSERT_EQ(batch_cancel_tags.size(), 1);
+  ASSERT_EQ(batch_cancel_tags[0], reinterpret_cast<void *>(1));
+
+  // Expect: The cancel from the callback is delivered next
+  ASSERT_EQ(rpc_->comp_queue_.size(), 1);
+  rpc_->deliver_completions_st();
+  ASSERT_EQ(batch_cancel_tags.size(), 2);
+  ASSERT_EQ(batch_cancel_tags[1], reinterpret_cast<void *>(2));
+  ASSERT_TRUE(rpc_->comp_queue_.empty());
+}
+
+/// The server drops a request that expires before its handler runs, and the
+/// client reports a timeout on receiving the expired response
+TEST_F(RpcTest, expired_request_at_server) {
+  const size_t num_pkts_in_req =
+      rpc_->data_size_to_num_pkts(kTestLargeMsgSize);
+  const auto server = get_local_endpoint();
+  const auto client = get_remote_endpoint();
+  Session *srv_session = create_server_session_init(client, server);
+  SSlot *srv_sslot_0 = &srv_session->sslot_arr_[0];
+
+  uint8_t req[CTransport::kMTU];
+  auto *pkthdr_0 = reinterpret_cast<pkthdr_t *>(req);
+  pkthdr_0->format(kTestReqType, kTestLargeMsgSize, server.session_num_,
+                   PktType::kReq, 0 /* pkt_num */, kSessionReqWindow);
+  pkthdr_0->deadline_us_ = 10;
+
+  rpc_->ev_loop_tsc_ = rdtsc();
+  rpc_->process_large_req_one_st(srv_sslot_0, pkthdr_0);
+  ASSERT_TRUE(pkthdr_tx_queue_->pop().matches(PktType::kExplCR, 0));
+  ASSERT_NE(srv_sslot_0->server_info_.deadline_tsc_, 0);
+
+  // Receive the last packet after the deadline
+  // Expect: The handler isn't called, and an expired empty response is sent
+  rpc_->ev_loop_tsc_ += us_to_cycles(100, rpc_->get_freq_ghz());
+  srv_sslot_0->server_info_.num_rx_ = num_pkts_in_req - 1;
+  pkthdr_0->pkt_num_ = num_pkts_in_req - 1;
+  rpc_->process_large_req_one_st(srv_sslot_0, pkthdr_0);
+  ASSERT_EQ(num_req_handler_calls_, 0);
+
+  const pkthdr_t resp_pkthdr = pkthdr_tx_queue_->pop();
+  ASSERT_TRUE(resp_pkthdr.matches(PktType::kResp, num_pkts_in_req - 1));
+  ASSERT_EQ(resp_pkthdr.msg_size_, 0);
+  ASSERT_EQ(resp_pkthdr.expired_, 1);
+  ASSERT_FALSE(srv_sslot_0->server_info_.expired_);
+
+  // A client receiving an expired response
+  Session *clt_session = create_client_session_connected(server, client);
+  SSlot *clt_sslot_0 = &clt_session->sslot_arr_[0];
+  MsgBuffer clt_req = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+  MsgBuffer clt_resp = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+  rpc_->enable_completion_queue(nullptr);
+
+  rpc_->faults_.hard_wheel_bypass_ = true;
+  rpc_->enqueue_request(clt_session->local_session_num_, kTestReqType,
+                        &clt_req, &clt_resp, nullptr, kTestTag, 1000);
+  pkthdr_tx_queue_->pop();
+
+  uint8_t remote_resp[sizeof(pkthdr_t)];
+  auto *resp_pkthdr_0 = reinterpret_cast<pkthdr_t *>(remote_resp);
+  resp_pkthdr_0->format(kTestReqType, 0, clt_session->local_session_num_,
+                        PktType::kResp, 0 /* pkt_num */,
+                        clt_sslot_0->cur_req_num_);
+  resp_pkthdr_0->expired_ = 1;
+  rpc_->process_resp_one_st(clt_sslot_0, resp_pkthdr_0, rdtsc());
+
+  completion_t comp;
+  ASSERT_EQ(rpc_->poll_completions(&comp, 1), 1);
+  ASSERT_EQ(comp.status_, -ETIMEDOUT);
+  ASSERT_EQ(clt_resp.get_data_size(), 0);
+}
+
+}  // namespace erpc
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
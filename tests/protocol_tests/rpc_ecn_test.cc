@@ -0,0 +1,127 @@
+#include "protocol_tests.h"
+
+namespace erpc {
+
+/// A server echoes CE marks on request packets in the credit return or
+/// response for the marked packet
+TEST_F(RpcTest, ecn_echo_server) {
+  const auto server = get_local_endpoint();
+  const auto client = get_remote_endpoint();
+  Session *srv_session = create_server_session_init(client, server);
+  SSlot *sslot_0 = &srv_session->sslot_arr_[0];
+
+  uint8_t req[CTransport::kMTU];
+  auto *req_pkthdr = reinterpret_cast<pkthdr_t *>(req);
+  req_pkthdr->format(kTestReqType, CTransport::kMaxDataPerPkt * 3,
+                     server.session_num_, PktType::kReq, 0 /* pkt_num */,
+                     kSessionReqWindow);
+
+  // Expect: The credit return for a marked packet echoes the mark
+  req_pkthdr->ecn_ce_ = 1;
+  rpc_->process_large_req_one_st(sslot_0, req_pkthdr);
+  pkthdr_t cr_pkthdr = pkthdr_tx_queue_->pop();
+  ASSERT_TRUE(cr_pkthdr.matches(PktType::kExplCR, 0));
+  ASSERT_EQ(cr_pkthdr.ecn_echo_, 1);
+
+  // Expect: The credit return for an unmarked packet doesn't
+  req_pkthdr->ecn_ce_ = 0;
+  req_pkthdr->pkt_num_ = 1;
+  rpc_->process_large_req_one_st(sslot_0, req_pkthdr);
+  cr_pkthdr = pkthdr_tx_queue_->pop();
+  ASSERT_TRUE(cr_pkthdr.matches(PktType::kExplCR, 1));
+  ASSERT_EQ(cr_pkthdr.ecn_echo_, 0);
+
+  // Expect: The response for a marked last packet echoes the mark
+  req_pkthdr->ecn_ce_ = 1;
+  req_pkthdr->pkt_num_ = 2;
+  rpc_->process_large_req_one_st(sslot_0, req_pkthdr);
+  ASSERT_EQ(num_req_handler_calls_, 1);
+  pkthdr_t resp_pkthdr = pkthdr_tx_queue_->pop();
+  ASSERT_TRUE(resp_pkthdr.matches(PktType::kResp, 2));
+  ASSERT_EQ(resp_pkthdr.ecn_echo_, 1);
+}
+
+/// A client with ECN enabled cuts its rate when a credit return echoes a CE
+/// mark, and ignores unmarked credit returns
+TEST_F(RpcTest, ecn_client_rate_cut) {
+  const auto client = get_local_endpoint();
+  const auto server = get_remote_endpoint();
+  Session *clt_session = create_client_session_connected(client, server);
+  SSlot *sslot_0 = &clt_session->sslot_arr_[0];
+  ASSERT_EQ(rpc_->enable_ecn(), 0);
+
+  MsgBuffer req = rpc_->alloc_msg_buffer(CTransport::kMaxDataPerPkt * 3);
+  MsgBuffer resp = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+  rpc_->faults_.hard_wheel_bypass_ = true;  // Don't place request pkts in wheel
+
+  rpc_->enqueue_request(0, kTestReqType, &req, &resp, cont_func, kTestTag);
+  pkthdr_tx_queue_->clear();
+
+  const auto *cc = &clt_session->client_info_.cc_.policy_;
+  const double rate = cc->get_rate(), cwnd = cc->get_cwnd();
+
+  // Use a short RTT sample, so the RTT alone doesn't cut the rate
+  const size_t rtt_tsc = us_to_cycles(1.0, rpc_->get_freq_ghz());
+  uint8_t cr[sizeof(pkthdr_t)];
+  auto *cr_pkthdr = reinterpret_cast<pkthdr_t *>(cr);
+  cr_pkthdr->format(kTestReqType, 0, client.session_num_, PktType::kExplCR,
+                    0 /* pkt_num */, sslot_0->cur_req_num_);
+  size_t rx_tsc = rdtsc();
+  sslot_0->client_info_.tx_ts_[0] = rx_tsc - rtt_tsc;
+  rpc_->process_expl_cr_st(sslot_0, cr_pkthdr, rx_tsc);
+  ASSERT_EQ(cc->get_rate(), rate);
+  ASSERT_EQ(cc->get_cwnd(), cwnd);
+
+  // After more than a smoothed RTT, the marked credit return ends the
+  // policy's ECN window
+  while (rdtsc() - rx_tsc < 2 * rtt_tsc) {
+  }
+  cr_pkthdr->pkt_num_ = 1;
+  cr_pkthdr->ecn_echo_ = 1;
+  rx_tsc = rdtsc();
+  sslot_0->client_info_.tx_ts_[1] = rx_tsc - rtt_tsc;
+  rpc_->process_expl_cr_st(sslot_0, cr_pkthdr, rx_tsc);
+  ASSERT_TRUE(cc->get_rate() < rate || cc->get_cwnd() < cwnd);
+}
+
+/// A request in a MsgBuffer that last held an ECN-marked response doesn't
+/// carry the response's marks
+TEST_F(RpcTest, ecn_reused_resp_msgbuf) {
+  const auto client = get_local_endpoint();
+  const auto server = get_remote_endpoint();
+  Session *clt_session = create_client_session_connected(client, server);
+  SSlot *sslot_0 = &clt_session->sslot_arr_[0];
+
+  MsgBuffer req = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+  MsgBuffer resp = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+  rpc_->faults_.hard_wheel_bypass_ = true;  // Don't place request pkt in wheel
+
+  rpc_->enqueue_request(0, kTestReqType, &req, &resp, cont_func, kTestTag);
+  pkthdr_tx_queue_->pop();
+
+  uint8_t remote_resp[sizeof(pkthdr_t) + kTestSmallMsgSize] = {};
+  auto *resp_pkthdr_0 = reinterpret_cast<pkthdr_t *>(remote_resp);
+  resp_pkthdr_0->format(kTestReqType, kTestSmallMsgSize, client.session_num_,
+                        PktType::kResp, 0 /* pkt_num */, kSessionReqWindow);
+  resp_pkthdr_0->ecn_ce_ = 1;
+  resp_pkthdr_0->ecn_echo_ = 1;
+  rpc_->process_resp_one_st(sslot_0, resp_pkthdr_0, rdtsc());
+  ASSERT_EQ(num_cont_func_calls_, 1);
+  ASSERT_EQ(resp.get_pkthdr_0()->ecn_ce_, 1);
+
+  // Expect: The request sent from the response MsgBuffer has no marks
+  rpc_->enqueue_request(0, kTestReqType, &resp, &req, cont_func, kTestTag);
+  const pkthdr_t req_pkthdr = pkthdr_tx_queue_->pop();
+  ASSERT_TRUE(req_pkthdr.matches(PktType::kReq, 0));
+  ASSERT_EQ(req_pkthdr.ecn_ce_, 0);
+  ASSERT_EQ(req_pkthdr.ecn_echo_, 0);
+  ASSERT_EQ(req_pkthdr.overloaded_, 0);
+  ASSERT_EQ(req_pkthdr.reserved_, 0);
+}
+
+}  // namespace erpc
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,127 @@
+#include <arpa/inet.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <thread>
+
+#include "protocol_tests.h"
+#include "util/test_printf.h"
+
+namespace erpc {
+
+/// An idle event loop parks instead of polling when parking is enabled
+TEST_F(RpcTest, run_event_loop_idle_park) {
+  static constexpr size_t kTestEvLoopMs = 100;
+  const auto &park_stats = rpc_->park_stats_;
+
+  // Expect: The event loop never parks by default
+  rpc_->run_event_loop(1);
+  ASSERT_EQ(park_stats.num_parks_, 0);
+
+  ASSERT_EQ(rpc_->set_idle_spin_us(0), 0);
+  ASSERT_TRUE(rpc_->is_idle_st());
+
+  // Expect: Without an idle spin, every idle iteration parks
+  rpc_->run_event_loop(kTestEvLoopMs);
+  test_printf("A %zu ms idle event loop parked %zu times\n", kTestEvLoopMs,
+              park_stats.num_parks_);
+  ASSERT_GT(park_stats.num_parks_, 0);
+  ASSERT_EQ(park_stats.num_parks_, park_stats.num_idle_iters_);
+  ASSERT_EQ(park_stats.num_rx_wakeups_, 0);
+
+  // Expect: Disabling parking always succeeds
+  ASSERT_EQ(rpc_->set_idle_spin_us(SIZE_MAX), 0);
+}
+
+/// A parked event loop wakes up when a packet is received
+TEST_F(RpcTest, park_wakeup_on_rx) {
+  static constexpr size_t kTestParkUs = 5000000;  // Much longer than the test
+
+  std::thread sender([this]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    addr.sin_port = htons(rpc_->transport_->local_port_);
+
+    uint8_t pkt[sizeof(pkthdr_t)] = {0};
+    sendto(fd, pkt, sizeof(pkt), 0, reinterpret_cast<struct sockaddr *>(&addr),
+           sizeof(addr));
+    close(fd);
+  });
+
+  const size_t start_tsc = rdtsc();
+  rpc_->park_st(kTestParkUs);
+  const double park_ms = to_msec(rdtsc() - start_tsc, rpc_->freq_ghz_);
+  sender.join();
+
+  test_printf("Parked for %.2f ms\n", park_ms);
+  ASSERT_EQ(rpc_->park_stats_.num_parks_, 1);
+  ASSERT_EQ(rpc_->park_stats_.num_rx_wakeups_, 1);
+  ASSERT_EQ(rpc_->transport_->rx_burst(), 1);
+  rpc_->transport_->post_recvs(1);
+}
+
+/// Return true iff \p fd becomes readable within \p timeout_ms
+static bool fd_readable(int fd, int timeout_ms) {
+  struct pollfd pfd;
+  pfd.fd = fd;
+  pfd.events = POLLIN;
+  return poll(&pfd, 1, timeout_ms) == 1;
+}
+
+/// The event descriptor becomes readable when another thread queues work
+TEST_F(RpcTest, event_fd_notify) {
+  const int event_fd = rpc_->get_event_fd();
+  ASSERT_GE(event_fd, 0);
+  ASSERT_EQ(rpc_->get_event_fd(), event_fd);  // Created only once
+
+  // Expect: No deadline without outstanding requests
+  ASSERT_EQ(rpc_->next_deadline_ns(), SIZE_MAX);
+
+  ASSERT_TRUE(rpc_->arm_event_fd());
+  ASSERT_FALSE(fd_readable(event_fd, 0));
+
+  std::thread notifier([this]() { rpc_->notify_event_fd(); });
+  notifier.join();
+  ASSERT_TRUE(fd_readable(event_fd, 1000));
+
+  // Expect: Re-arming clears the notification
+  ASSERT_TRUE(rpc_->arm_event_fd());
+  ASSERT_FALSE(fd_readable(event_fd, 0));
+
+  // Expect: Queued SM packets make arming fail, and have deadline zero
+  SmPkt sm_pkt;
+  sm_pkt.pkt_type_ = SmPktType::kDisconnectResp;
+  ASSERT_TRUE(rpc_->nexus_hook_.sm_rx_queue_.try_push(sm_pkt));
+  ASSERT_FALSE(rpc_->arm_event_fd());
+  ASSERT_EQ(rpc_->next_deadline_ns(), 0);
+}
+
+/// Outstanding requests impose a packet loss detection deadline
+TEST_F(RpcTest, next_deadline_ns) {
+  const auto client = get_local_endpoint();
+  const auto server = get_remote_endpoint();
+  create_client_session_connected(client, server);
+
+  MsgBuffer req = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+  MsgBuffer resp = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+  rpc_->faults_.hard_wheel_bypass_ = true;  // Don't place request pkt in wheel
+  rpc_->enqueue_request(0, kTestReqType, &req, &resp, cont_func, kTestTag);
+  ASSERT_EQ(rpc_->next_deadline_ns(), 0);  // The request packet is queued
+
+  rpc_->do_tx_burst_st();
+
+  const size_t deadline_ns = rpc_->next_deadline_ns();
+  ASSERT_GT(deadline_ns, 0);
+  ASSERT_LE(deadline_ns, to_nsec(rpc_->rpc_pkt_loss_scan_cycles_,
+                                 rpc_->freq_ghz_));
+}
+
+}  // namespace erpc
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,123 @@
+#include "protocol_tests.h"
+
+namespace erpc {
+
+static constexpr size_t kTestNumPkts = 3;
+static constexpr size_t kTestMsgSize =
+    (kTestNumPkts - 1) * CTransport::kMaxDataPerPkt + 100;
+
+/// Common setup code for fragmented reception tests
+class RpcFragRxTest : public RpcTest {
+ public:
+  RpcFragRxTest() {
+    rt_assert(rpc_->enable_frag_rx() == 0, "Failed to enable frag RX");
+    for (size_t i = 0; i < kTestMsgSize; i++) {
+      msg_[i] = static_cast<uint8_t>(i);
+    }
+  }
+
+  /// Place packet pkt_num of a kTestMsgSize message in the RX ring as if it
+  /// was just received, and return it
+  pkthdr_t *rx_pkt(PktType pkt_type, size_t pkt_num, size_t pkt_idx) {
+    auto *pkthdr = static_cast<pkthdr_t *>(malloc(CTransport::kMTU));
+    pkthdr->format(kTestReqType, kTestMsgSize, 0, pkt_type, pkt_num,
+                   kSessionReqWindow);
+
+    const size_t offset = pkt_idx * CTransport::kMaxDataPerPkt;
+    const size_t size =
+        (std::min)(CTransport::kMaxDataPerPkt, kTestMsgSize - offset);
+    memcpy(pkthdr + 1, &msg_[offset], size);
+
+    rpc_->rx_ring_[rpc_->rx_ring_head_] = reinterpret_cast<uint8_t *>(pkthdr);
+    rpc_->rx_ring_head_++;
+    return pkthdr;
+  }
+
+  uint8_t msg_[kTestMsgSize];
+};
+
+/// A multi-packet request is passed to the request handler as fragments that
+/// point into the RX ring, and released on enqueue_response()
+TEST_F(RpcFragRxTest, process_large_req_frag_rx) {
+  const auto server = get_local_endpoint();
+  const auto client = get_remote_endpoint();
+  Session *srv_session = create_server_session_init(client, server);
+  SSlot *sslot_0 = &srv_session->sslot_arr_[0];
+
+  for (size_t i = 0; i < kTestNumPkts; i++) {
+    pkthdr_t *pkthdr = rx_pkt(PktType::kReq, i, i);
+    rpc_->process_large_req_one_st(sslot_0, pkthdr);
+
+    if (i < kTestNumPkts - 1) {
+      // Expect: The request is held in place, and a credit return is sent
+      MsgBuffer &req_msgbuf = sslot_0->server_info_.req_msgbuf_;
+      ASSERT_TRUE(req_msgbuf.is_fragmented());
+      ASSERT_EQ(req_msgbuf.get_frag(i).buf_,
+                reinterpret_cast<uint8_t *>(pkthdr + 1));
+      ASSERT_EQ(rpc_->rx_pkts_held_, kTestNumPkts);
+      ASSERT_EQ(pkthdr_tx_queue_->pop().pkt_type_, PktType::kExplCR);
+    }
+  }
+
+  // Expect: The request handler saw the whole request, and enqueue_response()
+  // released the held packets
+  ASSERT_EQ(num_req_handler_calls_, 1);
+  ASSERT_EQ(pkthdr_tx_queue_->pop().pkt_type_, PktType::kResp);
+  ASSERT_EQ(memcmp(sslot_0->dyn_resp_msgbuf_.buf_, msg_, kTestMsgSize), 0);
+  ASSERT_EQ(rpc_->rx_pkts_held_, 0);
+}
+
+/// A multi-packet response is delivered as fragments, which the application
+/// releases with release_msg_frags()
+TEST_F(RpcFragRxTest, process_resp_frag_rx) {
+  const auto client = get_local_endpoint();
+  const auto server = get_remote_endpoint();
+  Session *clt_session = create_client_session_connected(client, server);
+  SSlot *sslot_0 = &clt_session->sslot_arr_[0];
+
+  MsgBuffer req = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+  MsgBuffer resp = rpc_->alloc_msg_buffer(kTestMsgSize);
+  uint8_t *resp_buf = resp.buf_;
+
+  rpc_->faults_.hard_wheel_bypass_ = true;  // Don't place request pkt in wheel
+  rpc_->enqueue_request(0, kTestReqType, &req, &resp, cont_func, kTestTag);
+  pkthdr_tx_queue_->pop();
+
+  for (size_t i = 0; i < kTestNumPkts; i++) {
+    // Response packet i has pkt_num i for a single-packet request
+    pkthdr_t *pkthdr = rx_pkt(PktType::kResp, i, i);
+    rpc_->process_resp_one_st(sslot_0, pkthdr, rdtsc());
+    while (pkthdr_tx_queue_->size() > 0) pkthdr_tx_queue_->pop();  // RFRs
+  }
+
+  ASSERT_EQ(num_cont_func_calls_, 1);
+  ASSERT_TRUE(resp.is_fragmented());
+  ASSERT_EQ(resp.get_num_frags(), kTestNumPkts);
+  ASSERT_EQ(resp.get_data_size(), kTestMsgSize);
+
+  // Expect: buf points to the first fragment, with the response's header
+  ASSERT_EQ(resp.buf_, resp.get_frag(0).buf_);
+  ASSERT_EQ(resp.get_req_type(), kTestReqType);
+
+  // Expect: The iovecs describe the response
+  struct iovec iov[kTestNumPkts];
+  ASSERT_EQ(resp.get_iovec(iov, kTestNumPkts), kTestNumPkts);
+  size_t offset = 0;
+  for (const struct iovec &v : iov) {
+    ASSERT_EQ(memcmp(v.iov_base, &msg_[offset], v.iov_len), 0);
+    offset += v.iov_len;
+  }
+  ASSERT_EQ(offset, kTestMsgSize);
+
+  rpc_->release_msg_frags(&resp);
+  ASSERT_FALSE(resp.is_fragmented());
+  ASSERT_EQ(resp.buf_, resp_buf);
+  ASSERT_EQ(rpc_->rx_pkts_held_, 0);
+}
+
+}  // namespace erpc
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
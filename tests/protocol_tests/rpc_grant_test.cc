@@ -0,0 +1,109 @@
+#include "protocol_tests.h"
+
+namespace erpc {
+
+/// With grant CC, a client sends the unscheduled prefix of a request, and
+/// then one packet per credit return
+TEST_F(RpcTest, grant_cc_client) {
+  const auto client = get_local_endpoint();
+  const auto server = get_remote_endpoint();
+  Session *clt_session = create_client_session_connected(client, server);
+  SSlot *sslot_0 = &clt_session->sslot_arr_[0];
+  rpc_->enable_grant_cc(4 /* unsched_pkts */, 8 /* max_granted_pkts */);
+
+  MsgBuffer req = rpc_->alloc_msg_buffer(CTransport::kMaxDataPerPkt * 10);
+  MsgBuffer resp = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+  rpc_->faults_.hard_wheel_bypass_ = true;  // Don't place request pkts in wheel
+
+  // Expect: Only the unscheduled prefix is sent
+  rpc_->enqueue_request(0, kTestReqType, &req, &resp, cont_func, kTestTag);
+  for (size_t i = 0; i < 4; i++) {
+    ASSERT_TRUE(pkthdr_tx_queue_->pop().matches(PktType::kReq, i));
+  }
+  ASSERT_EQ(pkthdr_tx_queue_->size(), 0);
+  ASSERT_EQ(clt_session->client_info_.credits_, kSessionCredits - 4);
+
+  // Expect: A credit return grants one more packet
+  uint8_t cr[sizeof(pkthdr_t)];
+  auto *cr_pkthdr = reinterpret_cast<pkthdr_t *>(cr);
+  cr_pkthdr->format(kTestReqType, 0, client.session_num_, PktType::kExplCR,
+                    0 /* pkt_num */, sslot_0->cur_req_num_);
+  rpc_->process_expl_cr_st(sslot_0, cr_pkthdr, rdtsc());
+  ASSERT_TRUE(pkthdr_tx_queue_->pop().matches(PktType::kReq, 4));
+  ASSERT_EQ(pkthdr_tx_queue_->size(), 0);
+}
+
+/// With grant CC, a server grants packets to the request with the fewest
+/// packets left, within the budget of granted packets in flight
+TEST_F(RpcTest, grant_cc_server) {
+  const auto server = get_local_endpoint();
+  const auto client = get_remote_endpoint();
+  Session *srv_session = create_server_session_init(client, server);
+  SSlot *large_sslot = &srv_session->sslot_arr_[0];
+  SSlot *small_sslot = &srv_session->sslot_arr_[1];
+  rpc_->enable_grant_cc(2 /* unsched_pkts */, 1 /* max_granted_pkts */);
+
+  uint8_t large_req[CTransport::kMTU], small_req[CTransport::kMTU];
+  auto *large_pkthdr = reinterpret_cast<pkthdr_t *>(large_req);
+  large_pkthdr->format(kTestReqType, CTransport::kMaxDataPerPkt * 10,
+                       server.session_num_, PktType::kReq, 0 /* pkt_num */,
+                       kSessionReqWindow);
+  auto *small_pkthdr = reinterpret_cast<pkthdr_t *>(small_req);
+  small_pkthdr->format(kTestReqType, CTransport::kMaxDataPerPkt * 4,
+                       server.session_num_, PktType::kReq, 0 /* pkt_num */,
+                       kSessionReqWindow + 1);
+
+  // Receive the first packet of both requests
+  // Expect: Only the small request is granted its next packet
+  rpc_->process_large_req_one_st(large_sslot, large_pkthdr);
+  rpc_->process_large_req_one_st(small_sslot, small_pkthdr);
+  ASSERT_EQ(pkthdr_tx_queue_->size(), 0);
+  rpc_->process_grants_st();
+  pkthdr_t cr_pkthdr = pkthdr_tx_queue_->pop();
+  ASSERT_TRUE(cr_pkthdr.matches(PktType::kExplCR, 0));
+  ASSERT_EQ(cr_pkthdr.req_num_, small_sslot->cur_req_num_);
+  ASSERT_EQ(pkthdr_tx_queue_->size(), 0);
+
+  // Receive the small request's unscheduled packet 1
+  // Expect: No grant, since the granted packet 2 is in flight
+  small_pkthdr->pkt_num_ = 1;
+  rpc_->process_large_req_one_st(small_sslot, small_pkthdr);
+  rpc_->process_grants_st();
+  ASSERT_EQ(pkthdr_tx_queue_->size(), 0);
+
+  // Receive packet 1 again
+  // Expect: Its credit return is still pending, so it's dropped
+  rpc_->process_large_req_one_st(small_sslot, small_pkthdr);
+  ASSERT_EQ(pkthdr_tx_queue_->size(), 0);
+
+  // Receive the granted packet 2
+  // Expect: The small request gets the budget again. The credit return for
+  // packet 2 grants no packet, so it's sent too.
+  small_pkthdr->pkt_num_ = 2;
+  rpc_->process_large_req_one_st(small_sslot, small_pkthdr);
+  rpc_->process_grants_st();
+  ASSERT_TRUE(pkthdr_tx_queue_->pop().matches(PktType::kExplCR, 1));
+  ASSERT_TRUE(pkthdr_tx_queue_->pop().matches(PktType::kExplCR, 2));
+  ASSERT_EQ(pkthdr_tx_queue_->size(), 0);
+
+  // Receive the small request's last packet
+  // Expect: The response is sent, and then the large request is granted a
+  // packet
+  small_pkthdr->pkt_num_ = 3;
+  rpc_->process_large_req_one_st(small_sslot, small_pkthdr);
+  ASSERT_EQ(num_req_handler_calls_, 1);
+  ASSERT_TRUE(pkthdr_tx_queue_->pop().matches(PktType::kResp, 3));
+
+  rpc_->process_grants_st();
+  cr_pkthdr = pkthdr_tx_queue_->pop();
+  ASSERT_TRUE(cr_pkthdr.matches(PktType::kExplCR, 0));
+  ASSERT_EQ(cr_pkthdr.req_num_, large_sslot->cur_req_num_);
+  ASSERT_EQ(rpc_->grant_.sslot_vec_.size(), 1);
+}
+
+}  // namespace erpc
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
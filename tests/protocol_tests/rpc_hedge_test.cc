@@ -0,0 +1,186 @@
+#include "protocol_tests.h"
+
+namespace erpc {
+
+class RpcHedgeTest : public RpcTest {
+ public:
+  RpcHedgeTest() {
+    const auto client = get_local_endpoint();
+    auto server = get_remote_endpoint();
+    primary_ = create_client_session_connected(client, server);
+    server.session_num_++;
+    backup_ = create_client_session_connected(client, server);
+
+    req_ = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+    resp_ = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+    for (size_t i = 0; i < kTestSmallMsgSize; i++) req_.buf_[i] = i % 256;
+    rpc_->faults_.hard_wheel_bypass_ = true;  // Don't place pkts in the wheel
+  }
+
+  /// Receive a single-packet response with data \p val on client sslot
+  /// \p sslot. An overloaded server's response is empty.
+  void recv_resp(SSlot *sslot, uint8_t val, bool overloaded = false) {
+    uint8_t remote_resp[sizeof(pkthdr_t) + kTestSmallMsgSize] = {};
+    auto *pkthdr_0 = reinterpret_cast<pkthdr_t *>(remote_resp);
+    pkthdr_0->format(kTestReqType, overloaded ? 0 : kTestSmallMsgSize,
+                     sslot->session_->local_session_num_, PktType::kResp,
+                     0 /* pkt_num */, sslot->cur_req_num_);
+    pkthdr_0->overloaded_ = overloaded;
+    memset(remote_resp + sizeof(pkthdr_t), val, kTestSmallMsgSize);
+    rpc_->process_resp_one_st(sslot, pkthdr_0, rdtsc());
+  }
+
+  Session *primary_, *backup_;
+  MsgBuffer req_, resp_;
+};
+
+/// A backup copy that responds first completes the request, and the primary
+/// copy is cancelled. The primary copy moves to the backup's request copy.
+TEST_F(RpcHedgeTest, backup_wins) {
+  SSlot *primary_sslot = &primary_->sslot_arr_[0];
+  SSlot *backup_sslot = &backup_->sslot_arr_[0];
+  const MsgBuffer req_before = req_;
+  rpc_->set_hedge_policy(0.95, 0 /* initial_delay_us */);
+
+  ASSERT_EQ(rpc_->enqueue_hedged_request(0, 1, kTestReqType, &req_, &resp_,
+                                         cont_func, kTestTag),
+            0);
+  ASSERT_EQ(pkthdr_tx_queue_->pop().dest_session_num_,
+            primary_->remote_session_num_);
+
+  // Expect: The backup copy sends an eRPC-owned copy of the request
+  rpc_->ev_loop_tsc_ = rdtsc();
+  rpc_->process_hedges_st();
+  ASSERT_EQ(pkthdr_tx_queue_->pop().dest_session_num_,
+            backup_->remote_session_num_);
+  const MsgBuffer *own_req = backup_sslot->tx_msgbuf_;
+  ASSERT_NE(own_req, &req_);
+  ASSERT_NE(own_req->buf_, req_.buf_);
+  ASSERT_EQ(memcmp(own_req->buf_, req_.buf_, kTestSmallMsgSize), 0);
+  ASSERT_TRUE(rpc_->hedge_pending_vec_.empty());
+
+  // Expect: The continuation is invoked with the backup's response
+  recv_resp(backup_sslot, 42);
+  ASSERT_EQ(num_cont_func_calls_, 1);
+  ASSERT_EQ(resp_.get_data_size(), kTestSmallMsgSize);
+  ASSERT_EQ(resp_.buf_[0], 42);
+  ASSERT_TRUE(primary_sslot->client_info_.cancelled_);
+
+  // Expect: The primary copy uses the request copy with its own headers, and
+  // the app's request MsgBuffer is unchanged
+  ASSERT_EQ(primary_sslot->tx_msgbuf_, own_req);
+  ASSERT_EQ(own_req->get_pkthdr_0()->dest_session_num_,
+            primary_->remote_session_num_);
+  ASSERT_EQ(own_req->get_pkthdr_0()->deadline_us_, 1);
+  ASSERT_EQ(req_.buf_, req_before.buf_);
+  ASSERT_EQ(req_.get_data_size(), kTestSmallMsgSize);
+
+  // Expect: The primary's late response is ignored, and the hedge is freed
+  const size_t num_free_hedges = rpc_->hedge_free_vec_.size();
+  recv_resp(primary_sslot, 7);
+  ASSERT_EQ(num_cont_func_calls_, 1);
+  ASSERT_EQ(resp_.buf_[0], 42);
+  ASSERT_EQ(primary_sslot->tx_msgbuf_, nullptr);
+  ASSERT_EQ(rpc_->hedge_free_vec_.size(), num_free_hedges + 1);
+}
+
+/// A primary copy that responds first cancels the backup copy, which keeps
+/// its request copy until its response arrives
+TEST_F(RpcHedgeTest, primary_wins_backup_in_flight) {
+  SSlot *primary_sslot = &primary_->sslot_arr_[0];
+  SSlot *backup_sslot = &backup_->sslot_arr_[0];
+  const MsgBuffer req_before = req_;
+  rpc_->set_hedge_policy(0.95, 0 /* initial_delay_us */);
+
+  ASSERT_EQ(rpc_->enqueue_hedged_request(0, 1, kTestReqType, &req_, &resp_,
+                                         cont_func, kTestTag),
+            0);
+  rpc_->ev_loop_tsc_ = rdtsc();
+  rpc_->process_hedges_st();
+  ASSERT_EQ(pkthdr_tx_queue_->size(), 2);
+  pkthdr_tx_queue_->pop();
+  pkthdr_tx_queue_->pop();
+
+  recv_resp(primary_sslot, 7);
+  ASSERT_EQ(num_cont_func_calls_, 1);
+  ASSERT_EQ(resp_.buf_[0], 7);
+  ASSERT_TRUE(backup_sslot->client_info_.cancelled_);
+  ASSERT_NE(backup_sslot->tx_msgbuf_, &req_);
+  ASSERT_EQ(backup_sslot->tx_msgbuf_->get_pkthdr_0()->deadline_us_, 1);
+  ASSERT_EQ(req_.buf_, req_before.buf_);
+
+  // Expect: The hedge is freed after the backup's late response
+  const size_t num_free_hedges = rpc_->hedge_free_vec_.size();
+  recv_resp(backup_sslot, 42);
+  ASSERT_EQ(num_cont_func_calls_, 1);
+  ASSERT_EQ(resp_.buf_[0], 7);
+  ASSERT_EQ(backup_sslot->tx_msgbuf_, nullptr);
+  ASSERT_EQ(rpc_->hedge_free_vec_.size(), num_free_hedges + 1);
+}
+
+/// A primary copy that responds before the hedge delay needs no backup copy
+TEST_F(RpcHedgeTest, primary_wins) {
+  rpc_->set_hedge_policy(0.95, 1000 /* initial_delay_us */);
+  rpc_->enable_completion_queue(nullptr);
+
+  ASSERT_EQ(rpc_->enqueue_hedged_request(0, 1, kTestReqType, &req_, &resp_,
+                                         nullptr, kTestTag),
+            0);
+  pkthdr_tx_queue_->pop();
+  recv_resp(&primary_->sslot_arr_[0], 7);
+
+  completion_t comp;
+  ASSERT_EQ(rpc_->poll_completions(&comp, 1), 1);
+  ASSERT_EQ(comp.tag_, kTestTag);
+  ASSERT_EQ(comp.status_, 0);
+  ASSERT_EQ(resp_.buf_[0], 7);
+  ASSERT_EQ(rpc_->hedge_latency_.count(), 1);
+
+  // Expect: The completed hedge is freed when its hedge delay passes
+  const size_t num_free_hedges = rpc_->hedge_free_vec_.size();
+  rpc_->ev_loop_tsc_ = rdtsc() + us_to_cycles(2000, rpc_->get_freq_ghz());
+  rpc_->process_hedges_st();
+  ASSERT_EQ(pkthdr_tx_queue_->size(), 0);
+  ASSERT_EQ(rpc_->hedge_free_vec_.size(), num_free_hedges + 1);
+  ASSERT_EQ(rpc_->next_hedge_tsc_, SIZE_MAX);
+}
+
+/// A failed primary copy sends the backup copy at once
+TEST_F(RpcHedgeTest, primary_fails) {
+  rpc_->set_hedge_policy(0.95, 1000 /* initial_delay_us */);
+  rpc_->enable_completion_queue(nullptr);
+
+  ASSERT_EQ(rpc_->enqueue_hedged_request(0, 1, kTestReqType, &req_, &resp_,
+                                         nullptr, kTestTag),
+            0);
+  pkthdr_tx_queue_->pop();
+  recv_resp(&primary_->sslot_arr_[0], 7, true /* overloaded */);
+
+  completion_t comp;
+  ASSERT_EQ(rpc_->poll_completions(&comp, 1), 0);
+  ASSERT_EQ(pkthdr_tx_queue_->pop().dest_session_num_,
+            backup_->remote_session_num_);
+
+  recv_resp(&backup_->sslot_arr_[0], 42);
+  ASSERT_EQ(rpc_->poll_completions(&comp, 1), 1);
+  ASSERT_EQ(comp.status_, 0);
+  ASSERT_EQ(comp.resp_size_, kTestSmallMsgSize);
+  ASSERT_EQ(resp_.buf_[0], 42);
+}
+
+TEST_F(RpcHedgeTest, invalid_sessions) {
+  ASSERT_EQ(rpc_->enqueue_hedged_request(0, 0, kTestReqType, &req_, &resp_,
+                                         cont_func, kTestTag),
+            -EINVAL);
+  ASSERT_EQ(rpc_->enqueue_hedged_request(0, 5, kTestReqType, &req_, &resp_,
+                                         cont_func, kTestTag),
+            -EINVAL);
+  ASSERT_EQ(pkthdr_tx_queue_->size(), 0);
+}
+
+}  // namespace erpc
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -26,7 +26,7 @@ class RpcClientKickTest : public RpcTest {
 
 /// Transmit all sslots in a wheel. Return number of packets transmitted.
 size_t wheel_tx_all(Rpc<CTransport> *rpc) {
-  for (size_t i = 0; i < kWheelNumWslots; i++) rpc->wheel_->reap_wslot(i);
+  rpc->wheel_->reap_all();
   size_t ret = rpc->wheel_->ready_queue_.size();
   rpc->process_wheel_st();
   return ret;
@@ -0,0 +1,94 @@
+#include "protocol_tests.h"
+
+namespace erpc {
+
+/// A request's priority comes from enqueue_request() or from its request type,
+/// and is carried in its packet headers
+TEST_F(RpcTest, enqueue_request_priority) {
+  const auto client = get_local_endpoint();
+  const auto server = get_remote_endpoint();
+  create_client_session_connected(client, server);
+
+  MsgBuffer req = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+  MsgBuffer resp = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+  rpc_->faults_.hard_wheel_bypass_ = true;  // Don't place request pkt in wheel
+
+  rpc_->enqueue_request(0, kTestReqType, &req, &resp, cont_func, kTestTag);
+  ASSERT_EQ(pkthdr_tx_queue_->pop().priority_, kPriorityNormal);
+
+  rpc_->set_req_type_priority(kTestReqType, kPriorityLow);
+  rpc_->enqueue_request(0, kTestReqType, &req, &resp, cont_func, kTestTag);
+  ASSERT_EQ(pkthdr_tx_queue_->pop().priority_, kPriorityLow);
+
+  // Expect: A high-priority packet doesn't wait for the TX batch to fill
+  rpc_->enqueue_request(0, kTestReqType, &req, &resp, cont_func, kTestTag,
+                        0 /* deadline_us */, kPriorityHigh);
+  ASSERT_EQ(pkthdr_tx_queue_->pop().priority_, kPriorityHigh);
+  ASSERT_EQ(rpc_->tx_batch_i_, 0);
+}
+
+/// Higher-priority requests get credits before older lower-priority requests
+TEST_F(RpcTest, stall_queue_priority) {
+  const auto client = get_local_endpoint();
+  const auto server = get_remote_endpoint();
+  Session *clt_session = create_client_session_connected(client, server);
+
+  MsgBuffer req[4], resp[4];  // The stalled requests' headers must differ
+  rpc_->faults_.hard_wheel_bypass_ = true;  // Don't place request pkt in wheel
+
+  clt_session->client_info_.credits_ = 0;  // Stall the requests for credits
+  const uint8_t prios[] = {kPriorityLow, kPriorityNormal, kPriorityHigh,
+                           kPriorityNormal};
+  for (size_t i = 0; i < 4; i++) {
+    req[i] = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+    resp[i] = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+    rpc_->enqueue_request(0, kTestReqType, &req[i], &resp[i], cont_func,
+                          kTestTag, 0 /* deadline_us */, prios[i]);
+  }
+
+  ASSERT_EQ(rpc_->stallq_.size(), 4);
+  for (size_t i = 1; i < rpc_->stallq_.size(); i++) {
+    ASSERT_GE(rpc_->stallq_[i - 1]->priority_, rpc_->stallq_[i]->priority_);
+  }
+
+  // Expect: Each credit goes to the highest-priority, oldest request
+  const auto &sslot_arr = clt_session->sslot_arr_;
+  const size_t expected_sslots[] = {2, 1, 3, 0};
+  for (size_t sslot_i : expected_sslots) {
+    clt_session->client_info_.credits_ = 1;
+    rpc_->process_credit_stall_queue_st();
+    const pkthdr_t pkthdr = pkthdr_tx_queue_->pop();
+    ASSERT_EQ(pkthdr.req_num_, sslot_arr[sslot_i].cur_req_num_);
+    ASSERT_EQ(pkthdr.priority_, sslot_arr[sslot_i].priority_);
+    ASSERT_EQ(pkthdr_tx_queue_->size(), 0);
+  }
+  ASSERT_TRUE(rpc_->stallq_.empty());
+}
+
+/// The server sends the response with the request's priority
+TEST_F(RpcTest, response_priority) {
+  const auto server = get_local_endpoint();
+  const auto client = get_remote_endpoint();
+  Session *srv_session = create_server_session_init(client, server);
+  SSlot *sslot_0 = &srv_session->sslot_arr_[0];
+
+  uint8_t req[sizeof(pkthdr_t) + kTestSmallMsgSize];
+  auto *pkthdr_0 = reinterpret_cast<pkthdr_t *>(req);
+  pkthdr_0->format(kTestReqType, kTestSmallMsgSize, server.session_num_,
+                   PktType::kReq, 0 /* pkt_num */, kSessionReqWindow);
+  pkthdr_0->priority_ = kPriorityHigh;
+
+  rpc_->process_small_req_st(sslot_0, pkthdr_0);
+  ASSERT_EQ(num_req_handler_calls_, 1);
+  const pkthdr_t resp_pkthdr = pkthdr_tx_queue_->pop();
+  ASSERT_TRUE(resp_pkthdr.matches(PktType::kResp, 0));
+  ASSERT_EQ(resp_pkthdr.priority_, kPriorityHigh);
+  ASSERT_EQ(rpc_->tx_batch_i_, 0);
+}
+
+}  // namespace erpc
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
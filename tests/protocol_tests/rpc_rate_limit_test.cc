@@ -0,0 +1,97 @@
+#include "protocol_tests.h"
+
+namespace erpc {
+
+static constexpr double kTestRateLimit = 1.0 * 1000 * 1000 * 1000 / 8;
+
+/// Rate limits are accepted only for client sessions, and only above
+/// kMinRateLimit
+TEST_F(RpcTest, rate_limit_api) {
+  const auto client = get_local_endpoint();
+  const auto server = get_remote_endpoint();
+  Session *clt_session = create_client_session_connected(client, server);
+  const int session_num = static_cast<int>(clt_session->local_session_num_);
+
+  ASSERT_EQ(rpc_->set_session_rate_limit(session_num + 1, kTestRateLimit),
+            -EINVAL);
+  ASSERT_EQ(rpc_->set_session_rate_limit(session_num, 1.0), -EINVAL);
+  ASSERT_EQ(rpc_->set_total_rate_limit(1.0), -EINVAL);
+
+  ASSERT_EQ(rpc_->set_session_rate_limit(session_num,
+                                         CCongestionControl::kMinRate / 2),
+            0);
+  ASSERT_EQ(rpc_->set_session_rate_limit(session_num, kTestRateLimit), 0);
+  ASSERT_TRUE(clt_session->is_rate_limited());
+  ASSERT_EQ(rpc_->set_session_rate_limit(session_num, 0.0), 0);
+  ASSERT_FALSE(clt_session->is_rate_limited());
+}
+
+/// A capped session is paced at the cap even if its policy allows more, and
+/// the total cap paces packets across sessions
+TEST_F(RpcTest, rate_limit_pacing) {
+  const auto client = get_local_endpoint();
+  const auto server = get_remote_endpoint();
+  Session *session_0 = create_client_session_connected(client, server);
+  Session *session_1 = create_client_session_connected(client, server);
+  const double freq_ghz = rpc_->get_freq_ghz();
+  const size_t pkt_size = CTransport::kMTU;
+
+  // Expect: Packets of a session capped at 1 Gbps are spaced by 1 Gbps
+  const double rate = kTestRateLimit;
+  const auto gap_tsc = static_cast<size_t>(
+      ns_to_cycles(1000000000 * (pkt_size / rate), freq_ghz));
+  ASSERT_EQ(rpc_->set_session_rate_limit(
+                static_cast<int>(session_0->local_session_num_), rate),
+            0);
+
+  size_t ref_tsc = rdtsc();
+  const size_t tsc_0 = session_0->cc_getupdate_tx_tsc(ref_tsc, pkt_size);
+  const size_t tsc_1 = session_0->cc_getupdate_tx_tsc(ref_tsc, pkt_size);
+  ASSERT_NEAR(tsc_1 - tsc_0, gap_tsc, 1);
+
+  // Expect: With a total cap, an uncapped session's packet is scheduled after
+  // the capped session's packet
+  ASSERT_EQ(rpc_->set_total_rate_limit(rate), 0);
+  ref_tsc = rdtsc();
+  const size_t tsc_2 =
+      rpc_->get_desired_tx_tsc(&session_0->sslot_arr_[0], ref_tsc, pkt_size);
+  const size_t tsc_3 =
+      rpc_->get_desired_tx_tsc(&session_1->sslot_arr_[0], ref_tsc, pkt_size);
+  ASSERT_GE(tsc_3 - tsc_2, gap_tsc - 1);
+}
+
+/// Time that a packet spends paced in the wheel doesn't count toward the RTO
+TEST_F(RpcTest, rate_limit_no_spurious_retransmit) {
+  const auto client = get_local_endpoint();
+  const auto server = get_remote_endpoint();
+  Session *clt_session = create_client_session_connected(client, server);
+  const int session_num = static_cast<int>(clt_session->local_session_num_);
+  ASSERT_EQ(rpc_->set_session_rate_limit(session_num, kMinRateLimit), 0);
+
+  MsgBuffer req = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+  MsgBuffer resp = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+  rpc_->enqueue_request(session_num, kTestReqType, &req, &resp, cont_func,
+                        kTestTag);
+  SSlot *sslot_0 = &clt_session->sslot_arr_[0];
+  ASSERT_EQ(sslot_0->client_info_.wheel_count_, 1);
+
+  // The packet leaves the wheel after more than one RTO
+  rpc_->ev_loop_tsc_ += 2 * rpc_->rpc_rto_cycles_;
+  rpc_->pkt_loss_scan_st();
+  rpc_->wheel_->reap_all();
+  rpc_->process_wheel_st();
+  ASSERT_EQ(sslot_0->client_info_.wheel_count_, 0);
+  ASSERT_EQ(pkthdr_tx_queue_->size(), 1);
+
+  // Expect: The packet isn't retransmitted right after it leaves the wheel
+  rpc_->pkt_loss_scan_st();
+  ASSERT_EQ(rpc_->pkt_loss_stats_.num_re_tx_, 0);
+  ASSERT_EQ(pkthdr_tx_queue_->size(), 1);
+}
+
+}  // namespace erpc
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
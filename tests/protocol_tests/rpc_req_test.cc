@@ -133,6 +133,52 @@ TEST_F(RpcTest, process_large_req_one_st) {
   ASSERT_EQ(rpc_->transport_->testing_.tx_flush_count_, 0);
 }
 
+static constexpr uint8_t kTestBatchReqType = kTestReqType + 1;
+static size_t num_batch_handler_calls = 0;
+static size_t num_batched_reqs = 0;
+
+/// A batch request handler that responds to each request with req_handler()
+static void batch_req_handler(ReqHandle *const *req_handles, size_t num_reqs,
+                              void *context) {
+  num_batch_handler_calls++;
+  num_batched_reqs += num_reqs;
+  for (size_t i = 0; i < num_reqs; i++) req_handler(req_handles[i], context);
+}
+
+/// Requests for a batch handler are collected, and the handler is invoked once
+/// for all of them at the end of the RX burst
+TEST_F(RpcTest, process_small_req_batch) {
+  const auto server = get_local_endpoint();
+  const auto client = get_remote_endpoint();
+  Session *srv_session = create_server_session_init(client, server);
+
+  const_cast<ReqFunc &>(rpc_->req_func_arr_[kTestBatchReqType]) =
+      ReqFunc(batch_req_handler);
+
+  // One request for each of the first three sslots
+  const size_t num_reqs = 3;
+  uint8_t req[num_reqs][sizeof(pkthdr_t) + kTestSmallMsgSize];
+  for (size_t i = 0; i < num_reqs; i++) {
+    auto *pkthdr = reinterpret_cast<pkthdr_t *>(req[i]);
+    pkthdr->format(kTestBatchReqType, kTestSmallMsgSize, server.session_num_,
+                   PktType::kReq, 0 /* pkt_num */, kSessionReqWindow + i);
+    rpc_->process_small_req_st(&srv_session->sslot_arr_[i], pkthdr);
+  }
+
+  // Expect: The handler is not invoked until the end of the burst
+  ASSERT_EQ(num_batch_handler_calls, 0);
+  ASSERT_EQ(rpc_->batch_req_vec_.size(), num_reqs);
+
+  rpc_->process_batch_reqs_st();
+  ASSERT_EQ(num_batch_handler_calls, 1);
+  ASSERT_EQ(num_batched_reqs, num_reqs);
+  ASSERT_EQ(num_req_handler_calls_, num_reqs);
+  ASSERT_TRUE(rpc_->batch_req_vec_.empty());
+  for (size_t i = 0; i < num_reqs; i++) {
+    ASSERT_EQ(pkthdr_tx_queue_->pop().pkt_type_, PktType::kResp);
+  }
+}
+
 }  // namespace erpc
 
 int main(int argc, char **argv) {
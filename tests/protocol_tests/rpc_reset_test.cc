@@ -0,0 +1,40 @@
+#include "protocol_tests.h"
+
+namespace erpc {
+
+/// Resetting a client session fails its active requests, and leaves its idle
+/// session slots alone
+TEST_F(RpcTest, reset_client_session) {
+  const auto client = get_local_endpoint();
+  const auto server = get_remote_endpoint();
+  Session *clt_session = create_client_session_connected(client, server);
+
+  MsgBuffer req = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+  MsgBuffer resp[2];
+  for (auto &r : resp) r = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+
+  rpc_->faults_.hard_wheel_bypass_ = true;  // Don't place request pkts in wheel
+  for (size_t i = 0; i < 2; i++) {
+    rpc_->enqueue_request(0, kTestReqType, &req, &resp[i], cont_func,
+                          kTestTag);
+  }
+  while (pkthdr_tx_queue_->size() > 0) pkthdr_tx_queue_->pop();
+  ASSERT_EQ(clt_session->client_info_.sslot_free_vec_.size(),
+            kSessionReqWindow - 2);
+
+  // Expect: Only the two active requests fail, and the session is buried
+  rpc_->handle_reset_client_st(clt_session);
+  ASSERT_EQ(num_cont_func_calls_, 2);
+  for (auto &r : resp) ASSERT_EQ(r.get_data_size(), 0);
+  ASSERT_EQ(rpc_->session_vec_[0], nullptr);
+
+  rpc_->free_msg_buffer(req);
+  for (auto &r : resp) rpc_->free_msg_buffer(r);
+}
+
+}  // namespace erpc
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
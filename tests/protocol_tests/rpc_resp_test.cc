@@ -56,6 +56,78 @@ TEST_F(RpcTest, process_resp_one_SMALL_st) {
   ASSERT_EQ(num_cont_func_calls_, 0);
 }
 
+/// A batch of requests is enqueued in order. Requests beyond the session's
+/// request window are backlogged, and the rest share one TX burst.
+TEST_F(RpcTest, enqueue_request_batch) {
+  const auto client = get_local_endpoint();
+  const auto server = get_remote_endpoint();
+  Session *clt_session = create_client_session_connected(client, server);
+
+  const size_t num_reqs = kSessionReqWindow + 2;
+  std::vector<MsgBuffer> req(num_reqs), resp(num_reqs);
+  std::vector<enq_req_args_t> req_args;
+  for (size_t i = 0; i < num_reqs; i++) {
+    req[i] = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+    resp[i] = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+    req_args.emplace_back(0, kTestReqType, &req[i], &resp[i], cont_func,
+                          reinterpret_cast<void *>(i));
+  }
+
+  rpc_->faults_.hard_wheel_bypass_ = true;  // Don't place request pkts in wheel
+  rpc_->enqueue_request_batch(req_args.data(), num_reqs);
+
+  auto &ci = clt_session->client_info_;
+  ASSERT_EQ(ci.sslot_free_vec_.size(), 0);
+  ASSERT_EQ(ci.enq_req_backlog_.size(), num_reqs - kSessionReqWindow);
+  ASSERT_EQ(ci.credits_, kSessionCredits - kSessionReqWindow);
+
+  // Expect: The requests wait in one TX burst, in enqueue order
+  static_assert(kSessionReqWindow < CTransport::kPostlist, "");
+  ASSERT_EQ(rpc_->tx_batch_i_, kSessionReqWindow);
+  for (size_t i = 0; i < kSessionReqWindow; i++) {
+    pkthdr_t pkthdr = pkthdr_tx_queue_->pop();
+    ASSERT_EQ(pkthdr.pkt_type_, PktType::kReq);
+    ASSERT_EQ(pkthdr.msg_size_, kTestSmallMsgSize);
+    ASSERT_EQ(req[i].get_pkthdr_0()->req_num_, pkthdr.req_num_);
+  }
+  ASSERT_EQ(ci.enq_req_backlog_.front().tag_,
+            reinterpret_cast<void *>(kSessionReqWindow));
+}
+
+/// In completion-queue mode, a received response queues a completion instead
+/// of invoking the continuation
+TEST_F(RpcTest, process_resp_completion_queue) {
+  const auto client = get_local_endpoint();
+  const auto server = get_remote_endpoint();
+  Session *clt_session = create_client_session_connected(client, server);
+  SSlot *sslot_0 = &clt_session->sslot_arr_[0];
+
+  rpc_->enable_completion_queue(nullptr);
+
+  MsgBuffer req = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+  MsgBuffer local_resp = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+  void *tag = reinterpret_cast<void *>(0xabc);
+
+  rpc_->faults_.hard_wheel_bypass_ = true;  // Don't place request pkt in wheel
+  rpc_->enqueue_request(0, kTestReqType, &req, &local_resp, nullptr, tag);
+
+  uint8_t remote_resp[sizeof(pkthdr_t) + kTestSmallMsgSize];
+  auto *pkthdr_0 = reinterpret_cast<pkthdr_t *>(remote_resp);
+  pkthdr_0->format(kTestReqType, kTestSmallMsgSize / 2, client.session_num_,
+                   PktType::kResp, 0 /* pkt_num */, kSessionReqWindow);
+  rpc_->process_resp_one_st(sslot_0, pkthdr_0, rdtsc());
+  ASSERT_EQ(num_cont_func_calls_, 0);
+  ASSERT_EQ(sslot_0->tx_msgbuf_, nullptr);  // Response received
+
+  // Expect: One completion with the request's tag and response size
+  completion_t comps[4];
+  ASSERT_EQ(rpc_->poll_completions(comps, 4), 1);
+  ASSERT_EQ(comps[0].tag_, tag);
+  ASSERT_EQ(comps[0].status_, 0);
+  ASSERT_EQ(comps[0].resp_size_, kTestSmallMsgSize / 2);
+  ASSERT_EQ(rpc_->poll_completions(comps, 4), 0);
+}
+
 TEST_F(RpcTest, process_resp_one_LARGE_st) {
   // TODO
 }
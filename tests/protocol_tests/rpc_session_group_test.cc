@@ -0,0 +1,70 @@
+#include "protocol_tests.h"
+
+namespace erpc {
+
+TEST_F(RpcTest, create_session_group) {
+  const auto client = get_local_endpoint();
+  const auto server = get_remote_endpoint();
+  create_client_session_connected(client, server);
+
+  ASSERT_EQ(rpc_->create_session_group({}), -EINVAL);
+  ASSERT_EQ(rpc_->create_session_group({0, 1}), -EINVAL);
+  ASSERT_EQ(rpc_->create_session_group({0}), 0);
+  ASSERT_EQ(rpc_->get_group_session_num(0), 0);
+}
+
+/// Sessions are picked by load, skipping unusable sessions
+TEST_F(RpcTest, get_group_session_num) {
+  const auto client = get_local_endpoint();
+  auto server = get_remote_endpoint();
+  Session *session_0 = create_client_session_connected(client, server);
+  server.session_num_++;
+  Session *session_1 = create_client_session_connected(client, server);
+  const int group_id = rpc_->create_session_group({0, 1});
+  ASSERT_EQ(group_id, 0);
+
+  // Make session 0 busier than session 1
+  MsgBuffer req = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+  MsgBuffer resp = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+  rpc_->faults_.hard_wheel_bypass_ = true;  // Don't place request pkt in wheel
+  rpc_->enqueue_request(0, kTestReqType, &req, &resp, cont_func, kTestTag);
+  pkthdr_tx_queue_->pop();
+
+  // Expect: With two members, power-of-two-choices compares both
+  for (size_t i = 0; i < 10; i++) {
+    ASSERT_EQ(rpc_->get_group_session_num(group_id), 1);
+  }
+
+  // Expect: A slower session loses even with fewer outstanding requests
+  session_0->client_info_.cc_.policy_.srtt_tsc_ = 1000.0;
+  session_1->client_info_.cc_.policy_.srtt_tsc_ = 100000.0;
+  ASSERT_EQ(rpc_->get_group_session_num(group_id), 0);
+
+  // Expect: Congested sessions are skipped while others are usable
+  session_0->client_info_.cc_.policy_.rate_ = CCongestionControl::kMinRate;
+  ASSERT_EQ(rpc_->get_group_session_num(group_id), 1);
+
+  // Expect: Sessions that are not connected are always skipped
+  session_1->state_ = SessionState::kResetInProgress;
+  ASSERT_EQ(rpc_->get_group_session_num(group_id), 0);
+
+  session_0->state_ = SessionState::kDisconnectInProgress;
+  ASSERT_EQ(rpc_->get_group_session_num(group_id), -ENOTCONN);
+}
+
+/// The first RTT sample initializes the smoothed RTT used for session load
+TEST_F(RpcTest, timely_srtt_first_sample) {
+  Timely timely(rpc_->get_freq_ghz(), rpc_->get_bandwidth());
+  timely.update_rate(rdtsc(), 5000);
+  ASSERT_EQ(timely.get_srtt_tsc(), 5000.0);
+
+  timely.update_rate(rdtsc(), 13000);
+  ASSERT_EQ(timely.get_srtt_tsc(), 5000.0 + Timely::kSrttAlpha * 8000);
+}
+
+}  // namespace erpc
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
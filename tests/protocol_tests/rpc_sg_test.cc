@@ -0,0 +1,183 @@
+#include "protocol_tests.h"
+
+namespace erpc {
+
+static constexpr size_t kTestMaxData = CTransport::kMaxDataPerPkt;
+
+/// Gather the data of packet pkt_idx of a scatter-gather MsgBuffer
+static std::vector<uint8_t> gather_pkt(const MsgBuffer *sg_msgbuf,
+                                       size_t pkt_idx) {
+  msg_frag_t pieces[CTransport::kMaxFragsPerPkt];
+  size_t num_pieces =
+      sg_msgbuf->get_pkt_frags<kTestMaxData>(pkt_idx, pieces);
+
+  std::vector<uint8_t> ret;
+  for (size_t i = 0; i < num_pieces; i++) {
+    ret.insert(ret.end(), pieces[i].buf_, pieces[i].buf_ + pieces[i].size_);
+  }
+  return ret;
+}
+
+TEST_F(RpcTest, alloc_sg_msg_buffer) {
+  MsgBuffer backing = rpc_->alloc_msg_buffer(3 * kTestMaxData);
+  for (size_t i = 0; i < backing.get_data_size(); i++) {
+    backing.buf_[i] = static_cast<uint8_t>(i);
+  }
+
+  // A small header fragment, a fragment that spans a packet boundary, and a
+  // fragment that ends exactly at the end of the second packet
+  const size_t sz_0 = 16, sz_1 = kTestMaxData, sz_2 = kTestMaxData - sz_0;
+  msg_frag_t frags[3];
+  frags[0] = rpc_->make_msg_frag(&backing, 2 * kTestMaxData, sz_0);
+  frags[1] = rpc_->make_msg_frag(&backing, 0, sz_1);
+  frags[2] = rpc_->make_msg_frag(&backing, 100, sz_2);
+
+  std::vector<uint8_t> expected;
+  for (const msg_frag_t &frag : frags) {
+    expected.insert(expected.end(), frag.buf_, frag.buf_ + frag.size_);
+  }
+
+  int err = 0;
+  MsgBuffer *sg_msgbuf = rpc_->alloc_sg_msg_buffer(frags, 3, &err);
+  ASSERT_NE(sg_msgbuf, nullptr);
+  ASSERT_TRUE(sg_msgbuf->is_fragmented());
+  ASSERT_EQ(sg_msgbuf->get_data_size(), expected.size());
+  ASSERT_EQ(sg_msgbuf->num_pkts_, 2);
+  ASSERT_EQ(sg_msgbuf->get_pkthdr_n(1), sg_msgbuf->get_pkthdr_0() + 1);
+
+  // Expect: Gathering each packet's pieces reconstructs the message
+  std::vector<uint8_t> pkt_0 = gather_pkt(sg_msgbuf, 0);
+  std::vector<uint8_t> pkt_1 = gather_pkt(sg_msgbuf, 1);
+  ASSERT_EQ(pkt_0.size(), kTestMaxData);
+  ASSERT_EQ(pkt_1.size(), expected.size() - kTestMaxData);
+  pkt_0.insert(pkt_0.end(), pkt_1.begin(), pkt_1.end());
+  ASSERT_EQ(pkt_0, expected);
+
+  rpc_->free_sg_msg_buffer(sg_msgbuf);
+  rpc_->free_msg_buffer(backing);
+}
+
+TEST_F(RpcTest, alloc_sg_msg_buffer_invalid) {
+  MsgBuffer backing = rpc_->alloc_msg_buffer(kTestMaxData);
+  int err = 0;
+
+  // More fragments in one packet than the transport can gather
+  std::vector<msg_frag_t> frags;
+  for (size_t i = 0; i <= CTransport::kMaxFragsPerPkt; i++) {
+    frags.push_back(rpc_->make_msg_frag(&backing, i, 1));
+  }
+  ASSERT_EQ(rpc_->alloc_sg_msg_buffer(frags.data(), frags.size(), &err),
+            nullptr);
+  ASSERT_EQ(err, -EINVAL);
+
+  // Zero-size fragment
+  msg_frag_t frag = rpc_->make_msg_frag(&backing, 0, 0);
+  ASSERT_EQ(rpc_->alloc_sg_msg_buffer(&frag, 1, &err), nullptr);
+  ASSERT_EQ(err, -EINVAL);
+
+  rpc_->free_msg_buffer(backing);
+}
+
+/// A scatter-gather request is transmitted like a regular request, and its
+/// eRPC-owned MsgBuffer is freed when the response is received
+TEST_F(RpcTest, enqueue_request_sg) {
+  const auto client = get_local_endpoint();
+  const auto server = get_remote_endpoint();
+  Session *clt_session = create_client_session_connected(client, server);
+  SSlot *sslot_0 = &clt_session->sslot_arr_[0];
+
+  MsgBuffer backing = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+  MsgBuffer local_resp = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+  const size_t alloc_tot_before = rpc_->get_stat_user_alloc_tot();
+
+  msg_frag_t frags[2];
+  frags[0] = rpc_->make_msg_frag(&backing, kTestSmallMsgSize / 2,
+                                 kTestSmallMsgSize / 2);
+  frags[1] = rpc_->make_msg_frag(&backing, 0, kTestSmallMsgSize / 2);
+
+  rpc_->faults_.hard_wheel_bypass_ = true;  // Don't place request pkt in wheel
+  ASSERT_EQ(rpc_->enqueue_request_sg(0, kTestReqType, frags, 2, &local_resp,
+                                     cont_func, kTestTag),
+            0);
+  ASSERT_TRUE(sslot_0->tx_msgbuf_->is_fragmented());
+  ASSERT_GT(rpc_->get_stat_user_alloc_tot(), alloc_tot_before);
+
+  pkthdr_t req_pkthdr = pkthdr_tx_queue_->pop();
+  ASSERT_EQ(req_pkthdr.pkt_type_, PktType::kReq);
+  ASSERT_EQ(req_pkthdr.msg_size_, kTestSmallMsgSize);
+
+  // Receive the response
+  // Expect: Continuation is invoked, and the SG request MsgBuffer is freed
+  uint8_t remote_resp[sizeof(pkthdr_t) + kTestSmallMsgSize];
+  auto *pkthdr_0 = reinterpret_cast<pkthdr_t *>(remote_resp);
+  pkthdr_0->format(kTestReqType, kTestSmallMsgSize, client.session_num_,
+                   PktType::kResp, 0 /* pkt_num */, kSessionReqWindow);
+  rpc_->process_resp_one_st(sslot_0, pkthdr_0, rdtsc());
+  ASSERT_EQ(num_cont_func_calls_, 1);
+  ASSERT_EQ(sslot_0->tx_msgbuf_, nullptr);
+  ASSERT_EQ(rpc_->get_stat_user_alloc_tot(), alloc_tot_before);
+}
+
+/// Release callback that counts invocations in the size_t pointed to by tag
+static void release_func(void *, void *tag) {
+  (*static_cast<size_t *>(tag))++;
+}
+
+/// A response sent from registered application memory is transmitted without
+/// copying, and the application memory is released when the response is
+/// buried, i.e., when it cannot be retransmitted anymore
+TEST_F(RpcTest, enqueue_response_sg_app_mem) {
+  const auto server = get_local_endpoint();
+  const auto client = get_remote_endpoint();
+  Session *srv_session = create_server_session_init(client, server);
+  SSlot *sslot_0 = &srv_session->sslot_arr_[0];
+
+  // A value store that the response points into
+  std::vector<uint8_t> app_store(3 * kTestMaxData);
+  app_mem_t app_mem;
+  ASSERT_EQ(rpc_->register_app_mem(nullptr, 0, &app_mem), -EINVAL);
+  ASSERT_EQ(rpc_->register_app_mem(app_store.data(), app_store.size(),
+                                   &app_mem),
+            0);
+
+  const size_t resp_size = kTestMaxData + 1;  // Two packets
+  msg_frag_t frag =
+      rpc_->make_app_msg_frag(&app_mem, &app_store[kTestMaxData], resp_size);
+
+  // Pretend that a request was received on sslot_0
+  sslot_0->server_info_.req_type_ = kTestReqType;
+  sslot_0->server_info_.req_msgbuf_.buf_ = nullptr;
+
+  size_t num_releases = 0;
+  ReqHandle *req_handle = static_cast<ReqHandle *>(sslot_0);
+  ASSERT_EQ(rpc_->enqueue_response_sg(req_handle, &frag, 1, release_func,
+                                      &num_releases),
+            0);
+  ASSERT_EQ(sslot_0->tx_msgbuf_, &sslot_0->dyn_resp_msgbuf_);
+  ASSERT_TRUE(sslot_0->tx_msgbuf_->is_fragmented());
+
+  // Expect: The response references the application memory in place
+  const msg_frag_t stored_frag = sslot_0->tx_msgbuf_->get_frag(0);
+  ASSERT_EQ(stored_frag.buf_, &app_store[kTestMaxData]);
+  ASSERT_EQ(stored_frag.size_, resp_size);
+
+  pkthdr_t resp_pkthdr = pkthdr_tx_queue_->pop();
+  ASSERT_EQ(resp_pkthdr.pkt_type_, PktType::kResp);
+  ASSERT_EQ(resp_pkthdr.msg_size_, resp_size);
+  ASSERT_EQ(num_releases, 0);
+
+  // Expect: The release callback is invoked exactly once on burial
+  rpc_->bury_resp_msgbuf_server_st(sslot_0);
+  ASSERT_EQ(num_releases, 1);
+  ASSERT_EQ(sslot_0->tx_msgbuf_, nullptr);
+
+  rpc_->deregister_app_mem(&app_mem);
+  ASSERT_EQ(app_mem.buf_, nullptr);
+}
+
+}  // namespace erpc
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,90 @@
+#include "protocol_tests.h"
+
+namespace erpc {
+
+class RpcSrptTest : public RpcTest {
+ public:
+  RpcSrptTest() {
+    const auto client = get_local_endpoint();
+    const auto server = get_remote_endpoint();
+    session_ = create_client_session_connected(client, server);
+
+    for (size_t i = 0; i < 2; i++) {
+      resp_[i] = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+    }
+    rpc_->faults_.hard_wheel_bypass_ = true;  // Don't place pkts in the wheel
+    rpc_->ev_loop_tsc_ = rdtsc();
+  }
+
+  /// Allocate request \p i with \p num_pkts packets, and enqueue it
+  void enqueue_req(size_t i, size_t num_pkts) {
+    req_[i] = rpc_->alloc_msg_buffer(CTransport::kMaxDataPerPkt * num_pkts);
+    rpc_->enqueue_request(0, kTestReqType, &req_[i], &resp_[i], cont_func,
+                          kTestTag);
+  }
+
+  Session *session_;
+  MsgBuffer req_[2], resp_[2];
+};
+
+/// A session's credits go to the request with the fewest packets left
+TEST_F(RpcSrptTest, shortest_first) {
+  SSlot *large_sslot = &session_->sslot_arr_[0];
+  SSlot *small_sslot = &session_->sslot_arr_[1];
+  rpc_->enable_srpt_scheduling(0 /* aging_us */);
+
+  enqueue_req(0, 40);
+  enqueue_req(1, 2);
+  ASSERT_EQ(rpc_->stallq_.size(), 2);
+  ASSERT_EQ(pkthdr_tx_queue_->size(), 0);
+
+  // Expect: The small request goes first, and the large one gets the rest
+  rpc_->process_credit_stall_queue_st();
+  for (size_t i = 0; i < 2; i++) {
+    ASSERT_EQ(pkthdr_tx_queue_->pop().req_num_, small_sslot->cur_req_num_);
+  }
+  for (size_t i = 0; i < kSessionCredits - 2; i++) {
+    ASSERT_EQ(pkthdr_tx_queue_->pop().req_num_, large_sslot->cur_req_num_);
+  }
+  ASSERT_EQ(session_->client_info_.credits_, 0);
+  ASSERT_EQ(rpc_->stallq_.size(), 1);
+  ASSERT_TRUE(large_sslot->client_info_.stalled_);
+  ASSERT_FALSE(small_sslot->client_info_.stalled_);
+
+  // Expect: A returned credit is handed out by the stall queue
+  uint8_t cr[sizeof(pkthdr_t)];
+  auto *cr_pkthdr = reinterpret_cast<pkthdr_t *>(cr);
+  cr_pkthdr->format(kTestReqType, 0, get_local_endpoint().session_num_,
+                    PktType::kExplCR, 0 /* pkt_num */,
+                    large_sslot->cur_req_num_);
+  rpc_->process_expl_cr_st(large_sslot, cr_pkthdr, rdtsc());
+  ASSERT_EQ(pkthdr_tx_queue_->size(), 0);
+
+  rpc_->process_credit_stall_queue_st();
+  ASSERT_TRUE(pkthdr_tx_queue_->pop().matches(PktType::kReq,
+                                              kSessionCredits - 2));
+}
+
+/// A request that waited long enough goes before a shorter, newer request
+TEST_F(RpcSrptTest, aging) {
+  SSlot *large_sslot = &session_->sslot_arr_[0];
+  rpc_->enable_srpt_scheduling(1 /* aging_us */);
+
+  enqueue_req(0, 5);
+  large_sslot->client_info_.enqueue_tsc_ -=
+      us_to_cycles(10, rpc_->get_freq_ghz());
+  enqueue_req(1, 2);
+
+  session_->client_info_.credits_ = 1;
+  rpc_->process_credit_stall_queue_st();
+  ASSERT_EQ(pkthdr_tx_queue_->pop().req_num_, large_sslot->cur_req_num_);
+  ASSERT_EQ(pkthdr_tx_queue_->size(), 0);
+  ASSERT_EQ(rpc_->stallq_.size(), 2);
+}
+
+}  // namespace erpc
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,60 @@
+#include <thread>
+
+#include "protocol_tests.h"
+
+namespace erpc {
+
+static constexpr size_t kTestRxDelayMs = 20;  ///< Delay before rx_burst()
+
+/// With packet timestamps, a packet's RX TSC is when the kernel received it,
+/// not when the event loop saw it, and its TX TSC is replaced by the kernel's
+TEST_F(RpcTest, pkt_timestamps) {
+  ASSERT_EQ(rpc_->enable_pkt_timestamps(), 0);
+  const double freq_ghz = rpc_->get_freq_ghz();
+
+  // Send one packet to this Rpc's socket
+  SessionEndpoint self = get_local_endpoint();
+  ASSERT_TRUE(rpc_->transport_->resolve_remote_routing_info(
+      &self.routing_info_));
+  MsgBuffer msgbuf = rpc_->alloc_msg_buffer(kTestSmallMsgSize);
+  msgbuf.get_pkthdr_0()->format(kTestReqType, kTestSmallMsgSize, 0,
+                                PktType::kReq, 0, kSessionReqWindow);
+
+  size_t tx_ts = rdtsc();
+  const size_t rpc_tx_ts = tx_ts;
+  Transport::tx_burst_item_t item;
+  item.routing_info_ = &self.routing_info_;
+  item.msg_buffer_ = &msgbuf;
+  item.pkt_idx_ = 0;
+  item.tx_ts_ = &tx_ts;
+  item.drop_ = false;
+  rpc_->transport_->tx_burst(&item, 1);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(kTestRxDelayMs));
+  const size_t ring_idx = rpc_->rx_ring_head_;
+  size_t num_pkts = 0;
+  while (num_pkts == 0) num_pkts = rpc_->transport_->rx_burst();
+  ASSERT_EQ(num_pkts, 1);
+  const size_t rx_burst_tsc = rdtsc();
+
+  // Expect: The kernel's TX timestamp replaced the Rpc's
+  ASSERT_GT(tx_ts, rpc_tx_ts);
+
+  // Expect: The RX timestamp is between the send and rx_burst(), and it
+  // excludes the delay before rx_burst()
+  const size_t rx_tsc = rpc_->transport_->get_rx_tsc(ring_idx);
+  ASSERT_GE(rx_tsc, tx_ts);
+  ASSERT_LE(rx_tsc, rx_burst_tsc);
+  ASSERT_GE(to_msec(rx_burst_tsc - rx_tsc, freq_ghz), kTestRxDelayMs / 2.0);
+  ASSERT_EQ(rpc_->get_rx_tsc_st(ring_idx, rx_burst_tsc), rx_tsc);
+
+  rpc_->transport_->post_recvs(1);
+  rpc_->free_msg_buffer(msgbuf);
+}
+
+}  // namespace erpc
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
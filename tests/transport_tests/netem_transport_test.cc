@@ -0,0 +1,296 @@
+/**
+ * @file netem_transport_test.cc
+ * @brief Tests for the network emulation shim, over the simulated transport
+ * so that delays are exact
+ */
+
+#include <gtest/gtest.h>
+
+#define private public
+#include "rpc.h"
+#include "util/huge_alloc.h"
+#include "util/timer.h"
+
+namespace erpc {
+
+typedef NetemTransport<SimTransport> TestTransport;
+
+static constexpr uint16_t kTestSmUdpPort = kBaseSmUdpPort;
+static constexpr size_t kTestNumaNode = 0;
+static constexpr uint8_t kTestReqType = 1;
+static constexpr size_t kTestTickTsc = 100;  ///< Max step of the clock
+static constexpr size_t kTestPktSize = 100;  ///< Including the header
+static constexpr size_t kTestDataSize = kTestPktSize - sizeof(pkthdr_t);
+
+/// A NetemTransport with the impairments in \p spec, and the structures that
+/// its Rpc would provide
+struct netem_host_t {
+  TestTransport *transport_;
+  HugeAlloc *huge_alloc_;
+  uint8_t *rx_ring_[Transport::kNumRxRingEntries];
+  size_t num_rx_ = 0;  ///< Packets received so far
+
+  netem_host_t(uint8_t rpc_id, const std::string &spec) {
+    set_netem_config(parse_netem_spec(spec));
+    transport_ =
+        new TestTransport(kTestSmUdpPort, rpc_id, 0, kTestNumaNode, nullptr);
+    set_netem_config(netem_config_t());
+
+    huge_alloc_ = new HugeAlloc(MB(2), kTestNumaNode, transport_->reg_mr_func_,
+                                transport_->dereg_mr_func_);
+    transport_->init_hugepage_structures(huge_alloc_, rx_ring_);
+  }
+
+  ~netem_host_t() {
+    delete huge_alloc_;
+    delete transport_;
+  }
+
+  /// Send the first packet of \p msgbuf to \p dst
+  void send(netem_host_t &dst, MsgBuffer *msgbuf) {
+    Transport::routing_info_t ri;
+    dst.transport_->fill_local_routing_info(&ri);
+    EXPECT_TRUE(transport_->resolve_remote_routing_info(&ri));
+
+    Transport::tx_burst_item_t item;
+    item.routing_info_ = &ri;
+    item.msg_buffer_ = msgbuf;
+    item.pkt_idx_ = 0;
+    item.tx_ts_ = nullptr;
+    item.drop_ = false;
+    transport_->tx_burst(&item, 1);
+  }
+
+  /// Receive one burst, and return the request numbers of its packets
+  std::vector<size_t> recv() {
+    const size_t num_pkts = transport_->rx_burst();
+    std::vector<size_t> ret;
+    for (size_t i = 0; i < num_pkts; i++) {
+      auto *pkthdr = reinterpret_cast<pkthdr_t *>(
+          rx_ring_[(num_rx_ + i) % Transport::kNumRxRingEntries]);
+      EXPECT_EQ(pkthdr->msg_size_, kTestDataSize);
+      ret.push_back(pkthdr->req_num_);
+    }
+
+    transport_->post_recvs(num_pkts);
+    num_rx_ += num_pkts;
+    return ret;
+  }
+};
+
+/// Return a single-packet MsgBuffer with request number \p req_num
+static MsgBuffer alloc_pkt(HugeAlloc *huge_alloc, size_t req_num) {
+  Buffer buffer = huge_alloc->alloc(kTestDataSize + 2 * sizeof(pkthdr_t));
+  MsgBuffer msgbuf(buffer, kTestDataSize, 1);
+  msgbuf.get_pkthdr_0()->format(kTestReqType, kTestDataSize, 0, PktType::kReq,
+                                0, req_num);
+  return msgbuf;
+}
+
+/// Run \p a and \p b until the fabric and both shims are idle, and return the
+/// request numbers that \p b received, in order
+static std::vector<size_t> run(SimFabric &fabric, netem_host_t &a,
+                               netem_host_t &b) {
+  std::vector<size_t> ret;
+  do {
+    fabric.advance(kTestTickTsc);
+    a.recv();
+    std::vector<size_t> burst = b.recv();
+    ret.insert(ret.end(), burst.begin(), burst.end());
+  } while (!fabric.is_idle() || !a.transport_->is_idle() ||
+           !b.transport_->is_idle());
+  return ret;
+}
+
+TEST(NetemTransportTest, parse_spec) {
+  netem_config_t config = parse_netem_spec(
+      "delay_us=20,jitter_us=5,dist=pareto,rx_loss=0.5,tx_rate_gbps=10,"
+      "loss_p=0.1,seed=7");
+  ASSERT_EQ(config.tx_.delay_us_, 20.0);
+  ASSERT_EQ(config.rx_.jitter_us_, 5.0);
+  ASSERT_TRUE(config.tx_.dist_ == NetemDist::kPareto);
+  ASSERT_EQ(config.tx_.loss_, 0.0);
+  ASSERT_EQ(config.rx_.loss_, 0.5);
+  ASSERT_EQ(config.tx_.rate_gbps_, 10.0);
+  ASSERT_EQ(config.rx_.rate_gbps_, 0.0);
+  ASSERT_EQ(config.rx_.loss_p_, 0.1);
+  ASSERT_EQ(config.seed_, 7);
+  ASSERT_FALSE(parse_netem_spec("").tx_.enabled());
+
+  ASSERT_THROW(parse_netem_spec("delay_us"), std::runtime_error);
+  ASSERT_THROW(parse_netem_spec("delay=5"), std::runtime_error);
+  ASSERT_THROW(parse_netem_spec("delay_us=abc"), std::runtime_error);
+  ASSERT_THROW(parse_netem_spec("loss=-1"), std::runtime_error);
+  ASSERT_THROW(parse_netem_spec("dist=cauchy"), std::runtime_error);
+}
+
+/// The TX and RX delays add to the fabric's delay, and the RX timestamp
+/// includes the RX delay
+TEST(NetemTransportTest, delay) {
+  sim_fabric_config_t config;
+  config.link_gbps_ = 8.0;  // One byte per ns
+  SimFabric fabric(config);
+
+  netem_host_t a(0, "tx_delay_us=10"), b(1, "rx_delay_us=5");
+  ASSERT_TRUE(b.transport_->enable_timestamps(kSimFreqGhz));
+
+  MsgBuffer msgbuf = alloc_pkt(a.huge_alloc_, 1);
+  a.send(b, &msgbuf);
+
+  const size_t expected_tsc =
+      SimFabric::kStartTsc + 10000 + 2 * (kTestPktSize + 1000) + 5000;
+  while (rdtsc() < expected_tsc) {
+    a.recv();
+    ASSERT_TRUE(b.recv().empty());
+    fabric.advance(kTestTickTsc);
+  }
+
+  ASSERT_EQ(rdtsc(), expected_tsc);
+  ASSERT_EQ(b.transport_->rx_burst(), 1);
+  ASSERT_EQ(b.transport_->get_rx_tsc(0), expected_tsc);
+  b.transport_->post_recvs(1);
+  ASSERT_TRUE(fabric.is_idle() && b.transport_->is_idle());
+}
+
+/// The TX bandwidth limit spaces packets by their serialization time
+TEST(NetemTransportTest, rate) {
+  sim_fabric_config_t config;
+  config.link_gbps_ = 8.0;
+  SimFabric fabric(config);
+
+  netem_host_t a(0, "tx_rate_gbps=0.5"), b(1, "");  // 16 ns per byte
+  ASSERT_EQ(a.transport_->get_bandwidth(), 500000000 / 8);
+
+  static constexpr size_t kNumPkts = 10;
+  MsgBuffer msgbuf = alloc_pkt(a.huge_alloc_, 1);
+  for (size_t i = 0; i < kNumPkts; i++) a.send(b, &msgbuf);
+
+  size_t num_rx = 0;
+  while (num_rx < kNumPkts) {
+    a.recv();
+    num_rx += b.recv().size();
+    fabric.advance(kTestTickTsc);
+  }
+
+  const size_t expected_tsc = SimFabric::kStartTsc +
+                              kNumPkts * kTestPktSize * 16 +
+                              2 * (kTestPktSize + 1000);
+  ASSERT_EQ(rdtsc(), expected_tsc + kTestTickTsc);
+}
+
+/// Duplicated packets are delivered twice, and lost packets never
+TEST(NetemTransportTest, loss_and_dup) {
+  SimFabric fabric(sim_fabric_config_t{});
+  netem_host_t a(0, "tx_loss=0.2"), b(1, "rx_dup=0.3");
+
+  static constexpr size_t kNumPkts = 2000;
+  std::vector<size_t> received;
+  for (size_t i = 0; i < kNumPkts; i++) {
+    MsgBuffer msgbuf = alloc_pkt(a.huge_alloc_, i);
+    a.send(b, &msgbuf);
+    std::vector<size_t> burst = run(fabric, a, b);
+    received.insert(received.end(), burst.begin(), burst.end());
+    a.huge_alloc_->free_buf(msgbuf.buffer_);
+  }
+
+  const auto &tx_stats = a.transport_->get_tx_stats();
+  const auto &rx_stats = b.transport_->get_rx_stats();
+  ASSERT_EQ(tx_stats.num_pkts_, kNumPkts);
+  ASSERT_NEAR(tx_stats.num_losses_, kNumPkts * 0.2, kNumPkts * 0.05);
+  ASSERT_EQ(rx_stats.num_pkts_, kNumPkts - tx_stats.num_losses_);
+  ASSERT_NEAR(rx_stats.num_dups_, rx_stats.num_pkts_ * 0.3, kNumPkts * 0.05);
+  ASSERT_EQ(received.size(), rx_stats.num_pkts_ + rx_stats.num_dups_);
+}
+
+/// Gilbert-Elliott losses come in bursts, and a seed gives the same losses
+TEST(NetemTransportTest, bursty_loss_deterministic) {
+  static constexpr size_t kNumPkts = 3000;
+  std::vector<size_t> first_received;
+  for (size_t run_i = 0; run_i < 2; run_i++) {
+    SimFabric fabric(sim_fabric_config_t{});
+    netem_host_t a(0, "loss_p=0.05,loss_r=0.25,seed=3"), b(1, "");
+
+    std::vector<size_t> received;
+    for (size_t i = 0; i < kNumPkts; i++) {
+      MsgBuffer msgbuf = alloc_pkt(a.huge_alloc_, i);
+      a.send(b, &msgbuf);
+      std::vector<size_t> burst = run(fabric, a, b);
+      received.insert(received.end(), burst.begin(), burst.end());
+      a.huge_alloc_->free_buf(msgbuf.buffer_);
+    }
+
+    // Expect: A loss rate of p / (p + r), with bursts of mean length 1 / r
+    const size_t num_losses = kNumPkts - received.size();
+    ASSERT_NEAR(num_losses, kNumPkts / 6, kNumPkts * 0.05);
+
+    size_t num_bursts = 0;
+    for (size_t i = 0; i < received.size(); i++) {
+      const size_t expected = i == 0 ? 0 : received[i - 1] + 1;
+      if (received[i] != expected) num_bursts++;
+    }
+    ASSERT_NEAR(num_losses / static_cast<double>(num_bursts), 4.0, 1.0);
+
+    if (run_i == 0) {
+      first_received = received;
+    } else {
+      ASSERT_EQ(received, first_received);
+    }
+  }
+}
+
+/// Packets that skip the delay overtake delayed ones
+TEST(NetemTransportTest, reorder) {
+  SimFabric fabric(sim_fabric_config_t{});
+  netem_host_t a(0, "tx_delay_us=20,tx_jitter_us=5,dist=normal,reorder=0.25"),
+      b(1, "");
+
+  static constexpr size_t kNumPkts = 100;
+  std::vector<MsgBuffer> msgbufs;
+  for (size_t i = 0; i < kNumPkts; i++) {
+    msgbufs.push_back(alloc_pkt(a.huge_alloc_, i));
+    a.send(b, &msgbufs.back());
+  }
+
+  std::vector<size_t> received = run(fabric, a, b);
+  ASSERT_EQ(received.size(), kNumPkts);
+  ASSERT_FALSE(std::is_sorted(received.begin(), received.end()));
+
+  // Expect: Reordered packets arrive before all delayed packets
+  const size_t num_reorders = a.transport_->get_tx_stats().num_reorders_;
+  ASSERT_GT(num_reorders, 0);
+  std::sort(received.begin(), received.end());
+  for (size_t i = 0; i < kNumPkts; i++) ASSERT_EQ(received[i], i);
+}
+
+/// The Rpc can hold packets from the shim's RX queue, including duplicates
+TEST(NetemTransportTest, rx_hold) {
+  SimFabric fabric(sim_fabric_config_t{});
+  netem_host_t a(0, ""), b(1, "rx_delay_us=1,rx_dup=1");
+  ASSERT_GT(b.transport_->enable_rx_hold(), 0);
+
+  MsgBuffer msgbuf = alloc_pkt(a.huge_alloc_, 1);
+  a.send(b, &msgbuf);
+
+  size_t num_pkts = 0;
+  while (num_pkts == 0) {
+    fabric.advance(kTestTickTsc);
+    num_pkts = b.transport_->rx_burst();
+  }
+
+  // Expect: Both copies arrive together, as one packet
+  ASSERT_EQ(num_pkts, 2);
+  ASSERT_EQ(b.rx_ring_[0], b.rx_ring_[1]);
+
+  uint8_t *held = b.transport_->hold_rx_pkt(0);
+  b.transport_->post_recvs(2);
+  ASSERT_EQ(reinterpret_cast<pkthdr_t *>(held)->req_num_, 1);
+  b.transport_->release_rx_pkt(held);
+  ASSERT_TRUE(b.transport_->rx_dup_refs_.empty());
+}
+
+}  // namespace erpc
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
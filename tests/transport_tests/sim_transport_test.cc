@@ -0,0 +1,305 @@
+/**
+ * @file sim_transport_test.cc
+ * @brief Tests for the simulated fabric and transport, and for Rpcs that run
+ * in virtual time
+ */
+
+#include <gtest/gtest.h>
+
+#define private public
+#include "rpc.h"
+#include "util/huge_alloc.h"
+#include "util/timer.h"
+
+namespace erpc {
+
+static constexpr uint16_t kTestSmUdpPort = kBaseSmUdpPort;
+static constexpr size_t kTestNumaNode = 0;
+static constexpr uint8_t kTestReqType = 1;
+static constexpr size_t kTestTickTsc = 100;  ///< Max step of the clock
+
+static const std::string kTestUri =
+    "127.0.0.1:" + std::to_string(kTestSmUdpPort);
+
+/// A SimTransport with the structures that its Rpc would provide
+struct sim_host_t {
+  SimTransport *transport_;
+  HugeAlloc *huge_alloc_;
+  uint8_t *rx_ring_[Transport::kNumRxRingEntries];
+
+  sim_host_t(uint8_t rpc_id) {
+    transport_ =
+        new SimTransport(kTestSmUdpPort, rpc_id, 0, kTestNumaNode, nullptr);
+    huge_alloc_ = new HugeAlloc(MB(2), kTestNumaNode, transport_->reg_mr_func_,
+                                transport_->dereg_mr_func_);
+    transport_->init_hugepage_structures(huge_alloc_, rx_ring_);
+  }
+
+  ~sim_host_t() {
+    delete huge_alloc_;
+    delete transport_;
+  }
+
+  /// Send the first packet of \p msgbuf to \p dst
+  void send(sim_host_t &dst, MsgBuffer *msgbuf) {
+    Transport::routing_info_t ri;
+    dst.transport_->fill_local_routing_info(&ri);
+    EXPECT_TRUE(transport_->resolve_remote_routing_info(&ri));
+
+    Transport::tx_burst_item_t item;
+    item.routing_info_ = &ri;
+    item.msg_buffer_ = msgbuf;
+    item.pkt_idx_ = 0;
+    item.drop_ = false;
+    transport_->tx_burst(&item, 1);
+  }
+};
+
+/// Return a single-packet MsgBuffer with \p data_size bytes
+static MsgBuffer alloc_pkt(HugeAlloc *huge_alloc, size_t data_size) {
+  Buffer buffer = huge_alloc->alloc(data_size + 2 * sizeof(pkthdr_t));
+  MsgBuffer msgbuf(buffer, data_size, 1);
+  msgbuf.get_pkthdr_0()->format(kTestReqType, data_size, 0, PktType::kReq, 0,
+                                0);
+  return msgbuf;
+}
+
+TEST(SimTransportTest, virtual_clock) {
+  const size_t real_tsc = rdtsc();
+  {
+    SimFabric fabric(sim_fabric_config_t{});
+    ASSERT_EQ(rdtsc(), SimFabric::kStartTsc);
+    ASSERT_EQ(dpath_rdtsc(), SimFabric::kStartTsc);
+
+    // Expect: Without events, the clock advances by the maximum step
+    ASSERT_EQ(fabric.advance(kTestTickTsc), SimFabric::kStartTsc + kTestTickTsc);
+    ASSERT_EQ(rdtsc(), SimFabric::kStartTsc + kTestTickTsc);
+  }
+
+  // Expect: The thread gets the real TSC back with the fabric
+  ASSERT_GT(rdtsc(), real_tsc);
+}
+
+/// A packet takes two serialization and propagation delays, and arrives with
+/// the virtual arrival time as its RX timestamp
+TEST(SimTransportTest, delivery) {
+  sim_fabric_config_t config;
+  config.link_gbps_ = 8.0;  // One byte per ns
+  config.link_delay_us_ = 1.0;
+  SimFabric fabric(config);
+
+  sim_host_t a(0), b(1);
+  ASSERT_TRUE(b.transport_->enable_timestamps(kSimFreqGhz));
+
+  const size_t data_size = 100;
+  MsgBuffer msgbuf = alloc_pkt(a.huge_alloc_, data_size);
+  memset(msgbuf.buf_, 7, data_size);
+  a.send(b, &msgbuf);
+
+  const size_t pkt_size = sizeof(pkthdr_t) + data_size;
+  const size_t expected_tsc = SimFabric::kStartTsc + 2 * (pkt_size + 1000);
+  while (rdtsc() < expected_tsc) {
+    ASSERT_EQ(b.transport_->rx_burst(), 0);
+    fabric.advance(SIZE_MAX);
+  }
+
+  ASSERT_EQ(rdtsc(), expected_tsc);
+  ASSERT_EQ(b.transport_->rx_burst(), 1);
+  ASSERT_EQ(b.transport_->get_rx_tsc(0), expected_tsc);
+  ASSERT_EQ(b.rx_ring_[0][sizeof(pkthdr_t)], 7);
+  ASSERT_EQ(fabric.get_stats().num_delivered_, 1);
+  b.transport_->post_recvs(1);
+  ASSERT_TRUE(fabric.is_idle());
+}
+
+/// An incast fills the receiver's switch port, which marks ECN-capable
+/// packets above the threshold and drops packets that overflow its buffer
+TEST(SimTransportTest, incast_ecn_and_drops) {
+  sim_fabric_config_t config;
+  config.port_buffer_bytes_ = KB(16);
+  config.ecn_threshold_bytes_ = KB(4);
+  SimFabric fabric(config);
+
+  static constexpr size_t kNumSenders = 8;
+  static constexpr size_t kPktsPerSender = 4;
+  sim_host_t rx(0);
+  std::vector<sim_host_t *> senders;
+  for (size_t i = 0; i < kNumSenders; i++) {
+    senders.push_back(new sim_host_t(static_cast<uint8_t>(i + 1)));
+    ASSERT_TRUE(senders[i]->transport_->enable_ecn());
+  }
+
+  MsgBuffer msgbuf = alloc_pkt(rx.huge_alloc_, SimTransport::kMaxDataPerPkt);
+  for (size_t i = 0; i < kPktsPerSender; i++) {
+    for (sim_host_t *sender : senders) sender->send(rx, &msgbuf);
+  }
+
+  size_t num_rx = 0, num_ce = 0;
+  while (!fabric.is_idle()) {
+    fabric.advance(SIZE_MAX);
+    size_t num_pkts = rx.transport_->rx_burst();
+    for (size_t i = 0; i < num_pkts; i++) {
+      auto *pkthdr = reinterpret_cast<pkthdr_t *>(
+          rx.rx_ring_[(num_rx + i) % Transport::kNumRxRingEntries]);
+      if (pkthdr->ecn_ce_ == 1) num_ce++;
+    }
+    rx.transport_->post_recvs(num_pkts);
+    num_rx += num_pkts;
+  }
+
+  const SimFabric::stats_t &stats = fabric.get_stats();
+  ASSERT_EQ(stats.num_pkts_, kNumSenders * kPktsPerSender);
+  ASSERT_GT(stats.num_drops_, 0);
+  ASSERT_GT(stats.num_ecn_marks_, 0);
+  ASSERT_EQ(stats.num_drops_ + num_rx, stats.num_pkts_);
+  ASSERT_EQ(stats.num_ecn_marks_, num_ce);
+  ASSERT_LE(stats.max_queue_bytes_, config.port_buffer_bytes_);
+
+  for (sim_host_t *sender : senders) delete sender;
+}
+
+/// Context of one Rpc in an Rpc-level simulation
+struct sim_rpc_ctx_t {
+  Rpc<CTransport> *rpc_;
+  int session_num_ = -1;
+  MsgBuffer req_, resp_;
+  size_t num_resps_ = 0;
+  size_t max_reqs_ = 0;
+};
+
+static void req_handler(ReqHandle *req_handle, void *_context) {
+  auto *ctx = static_cast<sim_rpc_ctx_t *>(_context);
+  const MsgBuffer *req = req_handle->get_req_msgbuf();
+  for (size_t i = 0; i < req->get_data_size(); i++) {
+    rt_assert(req->buf_[i] == static_cast<uint8_t>(i), "Corrupted request");
+  }
+
+  ctx->rpc_->resize_msg_buffer(&req_handle->pre_resp_msgbuf_, 8);
+  ctx->rpc_->enqueue_response(req_handle, &req_handle->pre_resp_msgbuf_);
+}
+
+static void cont_func(void *_context, void *) {
+  auto *ctx = static_cast<sim_rpc_ctx_t *>(_context);
+  ctx->num_resps_++;
+  if (ctx->num_resps_ < ctx->max_reqs_) {
+    ctx->rpc_->enqueue_request(ctx->session_num_, kTestReqType, &ctx->req_,
+                               &ctx->resp_, cont_func, nullptr);
+  }
+}
+
+static void sm_handler(int, SmEventType, SmErrType, void *) {}
+
+/// Result of run_incast()
+struct incast_result_t {
+  size_t duration_tsc_;  ///< Virtual time until all responses arrived
+  SimFabric::stats_t stats_;
+};
+
+/// Client Rpcs send requests to one server Rpc in virtual time
+static incast_result_t run_incast(size_t num_clients, size_t req_size,
+                                  size_t reqs_per_client) {
+  Nexus nexus(kTestUri, kTestNumaNode, 0);
+  nexus.register_req_func(kTestReqType, req_handler);
+
+  sim_fabric_config_t config;
+  config.port_buffer_bytes_ = KB(64);
+  config.ecn_threshold_bytes_ = KB(16);
+  SimFabric fabric(config);
+
+  std::vector<sim_rpc_ctx_t> ctx_vec(num_clients + 1);
+  for (size_t i = 0; i <= num_clients; i++) {
+    ctx_vec[i].rpc_ = new Rpc<CTransport>(&nexus, &ctx_vec[i],
+                                          static_cast<uint8_t>(i), sm_handler);
+  }
+
+  // Connect in real time, without advancing the virtual clock
+  for (size_t i = 1; i <= num_clients; i++) {
+    sim_rpc_ctx_t &c = ctx_vec[i];
+    c.session_num_ = c.rpc_->create_session(kTestUri, 0);
+    rt_assert(c.session_num_ >= 0, "Failed to create session");
+  }
+
+  const size_t connect_start_tsc = rdtsc();
+  ChronoTimer connect_timer;
+  size_t num_connected = 0;
+  while (num_connected < num_clients) {
+    rt_assert(connect_timer.get_ms() < 5000, "Sessions failed to connect");
+    num_connected = 0;
+    for (sim_rpc_ctx_t &c : ctx_vec) c.rpc_->run_event_loop_once();
+    for (size_t i = 1; i <= num_clients; i++) {
+      if (ctx_vec[i].rpc_->is_connected(ctx_vec[i].session_num_)) {
+        num_connected++;
+      }
+    }
+  }
+  rt_assert(rdtsc() == connect_start_tsc, "Virtual clock advanced");
+
+  const size_t start_tsc = rdtsc();
+  for (size_t i = 1; i <= num_clients; i++) {
+    sim_rpc_ctx_t &c = ctx_vec[i];
+    c.max_reqs_ = reqs_per_client;
+    c.req_ = c.rpc_->alloc_msg_buffer_or_die(req_size);
+    for (size_t j = 0; j < req_size; j++) {
+      c.req_.buf_[j] = static_cast<uint8_t>(j);
+    }
+    c.resp_ = c.rpc_->alloc_msg_buffer_or_die(8);
+    c.rpc_->enable_ecn();
+    c.rpc_->enqueue_request(c.session_num_, kTestReqType, &c.req_, &c.resp_,
+                            cont_func, nullptr);
+  }
+
+  size_t num_done = 0;
+  while (num_done < num_clients) {
+    rt_assert(rdtsc() - start_tsc < ms_to_cycles(1000, kSimFreqGhz),
+              "Simulation timed out");
+    for (sim_rpc_ctx_t &c : ctx_vec) c.rpc_->run_event_loop_once();
+    fabric.advance(kTestTickTsc);
+
+    num_done = 0;
+    for (size_t i = 1; i <= num_clients; i++) {
+      if (ctx_vec[i].num_resps_ == reqs_per_client) num_done++;
+    }
+  }
+
+  incast_result_t result;
+  result.duration_tsc_ = rdtsc() - start_tsc;
+  result.stats_ = fabric.get_stats();
+
+  for (size_t i = 1; i <= num_clients; i++) {
+    ctx_vec[i].rpc_->free_msg_buffer(ctx_vec[i].req_);
+    ctx_vec[i].rpc_->free_msg_buffer(ctx_vec[i].resp_);
+  }
+  for (sim_rpc_ctx_t &c : ctx_vec) delete c.rpc_;
+  return result;
+}
+
+/// Many Rpcs on one thread complete an incast that overflows the switch, and
+/// replaying it gives the same result
+TEST(SimTransportTest, rpc_incast_deterministic) {
+  static constexpr size_t kNumClients = 16;
+  static constexpr size_t kReqSize = KB(32);
+  static constexpr size_t kReqsPerClient = 4;
+
+  const incast_result_t r1 = run_incast(kNumClients, kReqSize, kReqsPerClient);
+  const incast_result_t r2 = run_incast(kNumClients, kReqSize, kReqsPerClient);
+
+  // Expect: The incast took at least as long as serializing the requests at
+  // the server's port
+  const size_t min_bytes = kNumClients * kReqsPerClient * kReqSize;
+  ASSERT_GE(to_sec(r1.duration_tsc_, kSimFreqGhz),
+            min_bytes / (sim_fabric_config_t().link_gbps_ * 1e9 / 8));
+  ASSERT_GT(r1.stats_.num_ecn_marks_, 0);
+
+  ASSERT_EQ(r1.duration_tsc_, r2.duration_tsc_);
+  ASSERT_EQ(r1.stats_.num_pkts_, r2.stats_.num_pkts_);
+  ASSERT_EQ(r1.stats_.num_drops_, r2.stats_.num_drops_);
+  ASSERT_EQ(r1.stats_.num_ecn_marks_, r2.stats_.num_ecn_marks_);
+  ASSERT_EQ(r1.stats_.max_queue_bytes_, r2.stats_.max_queue_bytes_);
+}
+
+}  // namespace erpc
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
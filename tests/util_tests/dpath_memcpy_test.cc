@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "util/dpath_memcpy.h"
+#include "util/rand.h"
+#include "util/test_printf.h"
+#include "util/timer.h"
+
+using namespace erpc;
+
+static constexpr size_t kTestMTUDataSize = 1024 - 56;  // ~kMaxDataPerPkt
+static constexpr size_t kTestNumRingBufs = 4096;       // Like the RX ring
+static constexpr size_t kTestIters = 20;
+
+/// Fill a buffer with a sequence that depends on seed
+static void fill(uint8_t *buf, size_t n, uint8_t seed) {
+  for (size_t i = 0; i < n; i++) buf[i] = static_cast<uint8_t>(seed + i);
+}
+
+TEST(DpathMemcpyTest, Correctness) {
+  std::vector<uint8_t> src(KB(16) + 128), dst(KB(16) + 128);
+  FastRand fast_rand;
+
+  for (size_t iter = 0; iter < 2000; iter++) {
+    const size_t n = fast_rand.next_u32() % KB(16);
+    const size_t src_off = fast_rand.next_u32() % 64;
+    const size_t dst_off = fast_rand.next_u32() % 64;
+
+    fill(&src[src_off], n, static_cast<uint8_t>(iter));
+    memset(dst.data(), 0, dst.size());
+    dpath_memcpy(&dst[dst_off], &src[src_off], n);
+    ASSERT_EQ(memcmp(&dst[dst_off], &src[src_off], n), 0);
+    ASSERT_EQ(dst[dst_off + n], 0);  // No overrun
+
+    memset(dst.data(), 0, dst.size());
+    dpath_memcpy_nt(&dst[dst_off], &src[src_off], n);
+    dpath_memcpy_fence();
+    ASSERT_EQ(memcmp(&dst[dst_off], &src[src_off], n), 0);
+    ASSERT_EQ(dst[dst_off + n], 0);
+  }
+}
+
+/// Copy one MTU-sized packet payload repeatedly into a cache-resident buffer
+TEST(DpathMemcpyTest, MTUBench) {
+  const double freq_ghz = measure_rdtsc_freq();
+  std::vector<uint8_t> src(kTestMTUDataSize), dst(kTestMTUDataSize);
+  fill(src.data(), src.size(), 0);
+
+  const size_t num_copies = 1000000;
+  for (size_t kernel = 0; kernel < 2; kernel++) {
+    size_t start_tsc = rdtsc();
+    for (size_t i = 0; i < num_copies; i++) {
+      if (kernel == 0) {
+        memcpy(dst.data(), src.data(), kTestMTUDataSize);
+      } else {
+        dpath_memcpy(dst.data(), src.data(), kTestMTUDataSize);
+      }
+      asm volatile("" : : "r"(dst.data()) : "memory");
+    }
+    double ns = to_nsec(rdtsc() - start_tsc, freq_ghz) / num_copies;
+    test_printf("MTU copy (%zu B), %s: %.1f ns per copy, %.2f GB/s\n",
+                kTestMTUDataSize, kernel == 0 ? "memcpy" : "dpath_memcpy", ns,
+                kTestMTUDataSize / ns);
+  }
+}
+
+/// Reassemble multi-megabyte messages from packets spread over an RX ring,
+/// like copy_data_to_msgbuf() does for large messages
+TEST(DpathMemcpyTest, ReassemblyBench) {
+  const double freq_ghz = measure_rdtsc_freq();
+  std::vector<uint8_t> ring(kTestNumRingBufs * 1024);
+  fill(ring.data(), ring.size(), 0);
+
+  for (size_t msg_size : {MB(1) / 4, MB(2), MB(8)}) {
+    std::vector<uint8_t> msg(msg_size);
+    const size_t num_pkts = (msg_size + kTestMTUDataSize - 1) / kTestMTUDataSize;
+
+    for (size_t kernel = 0; kernel < 3; kernel++) {
+      size_t start_tsc = rdtsc();
+      for (size_t iter = 0; iter < kTestIters; iter++) {
+        for (size_t pkt_i = 0; pkt_i < num_pkts; pkt_i++) {
+          const size_t offset = pkt_i * kTestMTUDataSize;
+          const size_t n = (std::min)(kTestMTUDataSize, msg_size - offset);
+          const uint8_t *pkt = &ring[(pkt_i % kTestNumRingBufs) * 1024];
+
+          switch (kernel) {
+            case 0: memcpy(&msg[offset], pkt, n); break;
+            case 1: dpath_memcpy(&msg[offset], pkt, n); break;
+            case 2: dpath_memcpy_nt(&msg[offset], pkt, n); break;
+          }
+        }
+        if (kernel == 2) dpath_memcpy_fence();
+      }
+
+      double sec = to_sec(rdtsc() - start_tsc, freq_ghz);
+      const char *name[] = {"memcpy", "dpath_memcpy", "dpath_memcpy_nt"};
+      test_printf("Reassembly of %zu KB, %s: %.2f GB/s\n", msg_size / KB(1),
+                  name[kernel], msg_size * kTestIters / (sec * 1e9));
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
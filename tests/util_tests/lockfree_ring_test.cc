@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+#include "util/mpsc_ring.h"
+#include "util/spsc_ring.h"
+
+static constexpr size_t kTestNumProducers = 4;
+static constexpr size_t kTestItemsPerProducer = 100000;
+
+TEST(LockfreeRingTest, SpscRingBasic) {
+  erpc::SpscRing<size_t, 4> ring;
+  ASSERT_TRUE(ring.empty());
+
+  for (size_t i = 0; i < 4; i++) ASSERT_TRUE(ring.try_push(i));
+  ASSERT_FALSE(ring.try_push(4));  // Full
+
+  size_t out[8];
+  ASSERT_EQ(ring.pop_burst(out, 3), 3);
+  for (size_t i = 0; i < 3; i++) ASSERT_EQ(out[i], i);
+
+  // Wrap around
+  ASSERT_TRUE(ring.try_push(4));
+  ASSERT_EQ(ring.pop_burst(out, 8), 2);
+  ASSERT_EQ(out[0], 3);
+  ASSERT_EQ(out[1], 4);
+  ASSERT_TRUE(ring.empty());
+}
+
+TEST(LockfreeRingTest, MpscRingBasic) {
+  erpc::MpscRing<size_t, 4> ring;
+  ASSERT_TRUE(ring.empty());
+
+  for (size_t i = 0; i < 4; i++) ASSERT_TRUE(ring.try_push(i));
+  ASSERT_FALSE(ring.try_push(4));  // Full
+  ASSERT_EQ(ring.num_pushed(), 4);  // Failed pushes are not counted
+
+  size_t out[8];
+  ASSERT_EQ(ring.pop_burst(out, 8), 4);
+  for (size_t i = 0; i < 4; i++) ASSERT_EQ(out[i], i);
+  ASSERT_TRUE(ring.empty());
+}
+
+/// Concurrent producers: Every item is received exactly once, and items from
+/// the same producer are received in order
+TEST(LockfreeRingTest, MpscRingConcurrent) {
+  auto *ring = new erpc::MpscRing<size_t, 64>();
+
+  std::vector<std::thread> producers;
+  for (size_t p = 0; p < kTestNumProducers; p++) {
+    producers.emplace_back([ring, p]() {
+      for (size_t i = 0; i < kTestItemsPerProducer; i++) {
+        // Yield instead of spinning since the test machine may have few cores
+        while (!ring->try_push(p * kTestItemsPerProducer + i)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  std::vector<size_t> next_expected(kTestNumProducers, 0);
+  size_t num_received = 0;
+  size_t out[16];
+  while (num_received < kTestNumProducers * kTestItemsPerProducer) {
+    const size_t num_popped = ring->pop_burst(out, 16);
+    for (size_t i = 0; i < num_popped; i++) {
+      const size_t p = out[i] / kTestItemsPerProducer;
+      ASSERT_EQ(out[i] % kTestItemsPerProducer, next_expected[p]);
+      next_expected[p]++;
+    }
+    num_received += num_popped;
+    if (num_popped == 0) std::this_thread::yield();
+  }
+
+  for (auto &producer : producers) producer.join();
+  ASSERT_TRUE(ring->empty());
+  delete ring;
+}
+
+int main(int argc, char **argv) {
+  testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,254 @@
+/**
+ * @file timing_wheel_bench.cc
+ * @brief Compare the insert/reap cost and pacing accuracy of the hierarchical
+ * timing wheel against the previous single-level wheel
+ */
+
+#include <algorithm>
+#include <queue>
+#include <vector>
+
+#include "cc/timing_wheel.h"
+#include "util/huge_alloc.h"
+#include "util/rand.h"
+
+using namespace erpc;
+
+static constexpr size_t kTestPktSize = 1024;
+static constexpr size_t kCostIters = 200000;      ///< Entries in the cost test
+static constexpr size_t kCostBatch = 16;          ///< Inserts between reaps
+static constexpr double kCostMaxDelayUs = 100.0;  ///< Max delay of an entry
+static constexpr size_t kPacingPkts = 20000;      ///< Packets per pacing test
+
+namespace legacy {
+
+/// The single-level wheel that TimingWheel replaced. Its horizon is sized for
+/// a window of packets at the minimum rate, and reaped entries wait in a
+/// std::queue.
+static constexpr double kWheelHorizonUs =
+    1000000 * (kSessionCredits * CTransport::kMTU) /
+    CCongestionControl::kMinRate;
+static constexpr size_t kWheelNumWslots =
+    1 + erpc::ceil(kWheelHorizonUs / kWheelSlotWidthUs);
+
+struct wheel_bkt_t {
+  size_t num_entries_ : 3;
+  size_t tx_tsc_ : 61;
+  wheel_bkt_t *last_;
+  wheel_bkt_t *next_;
+  wheel_ent_t entry_[kWheelBucketCap];
+};
+
+class TimingWheel {
+ public:
+  TimingWheel(timing_wheel_args_t args)
+      : wslot_width_tsc_(us_to_cycles(kWheelSlotWidthUs, args.freq_ghz_)),
+        bkt_pool_(args.huge_alloc_) {
+    Buffer wheel_buffer = args.huge_alloc_->alloc_raw(
+        kWheelNumWslots * sizeof(wheel_bkt_t), DoRegister::kFalse);
+    rt_assert(wheel_buffer.buf_ != nullptr, "Failed to allocate wheel");
+
+    size_t base_tsc = rdtsc();
+    wheel_ = reinterpret_cast<wheel_bkt_t *>(wheel_buffer.buf_);
+    for (size_t ws_i = 0; ws_i < kWheelNumWslots; ws_i++) {
+      reset_bkt(&wheel_[ws_i]);
+      wheel_[ws_i].tx_tsc_ = base_tsc + (ws_i + 1) * wslot_width_tsc_;
+      wheel_[ws_i].last_ = &wheel_[ws_i];
+    }
+  }
+
+  void catchup() {
+    while (wheel_[cur_wslot_].tx_tsc_ < rdtsc()) reap(rdtsc());
+  }
+
+  void reap(size_t reap_tsc) {
+    while (wheel_[cur_wslot_].tx_tsc_ <= reap_tsc) {
+      reap_wslot(cur_wslot_);
+      wheel_[cur_wslot_].tx_tsc_ += (wslot_width_tsc_ * kWheelNumWslots);
+      cur_wslot_++;
+      if (cur_wslot_ == kWheelNumWslots) cur_wslot_ = 0;
+    }
+  }
+
+  void insert(const wheel_ent_t &ent, size_t ref_tsc, size_t desired_tx_tsc) {
+    reap(ref_tsc);
+
+    size_t dst_wslot;
+    if (desired_tx_tsc <= wheel_[cur_wslot_].tx_tsc_) {
+      dst_wslot = cur_wslot_;
+    } else {
+      size_t wslot_delta =
+          1 + (desired_tx_tsc - wheel_[cur_wslot_].tx_tsc_) / wslot_width_tsc_;
+      dst_wslot = cur_wslot_ + wslot_delta;
+      if (dst_wslot >= kWheelNumWslots) dst_wslot -= kWheelNumWslots;
+    }
+
+    wheel_bkt_t *last_bkt = wheel_[dst_wslot].last_;
+    last_bkt->entry_[last_bkt->num_entries_] = ent;
+    last_bkt->num_entries_++;
+    if (last_bkt->num_entries_ == kWheelBucketCap) {
+      wheel_bkt_t *new_bkt = bkt_pool_.alloc();
+      reset_bkt(new_bkt);
+      last_bkt->next_ = new_bkt;
+      wheel_[dst_wslot].last_ = new_bkt;
+    }
+  }
+
+  std::queue<wheel_ent_t> ready_queue_;
+
+ private:
+  void reap_wslot(size_t ws_i) {
+    wheel_bkt_t *bkt = &wheel_[ws_i];
+    while (bkt != nullptr) {
+      for (size_t i = 0; i < bkt->num_entries_; i++) {
+        ready_queue_.push(bkt->entry_[i]);
+      }
+      wheel_bkt_t *tmp_next = bkt->next_;
+      reset_bkt(bkt);
+      if (bkt != &wheel_[ws_i]) bkt_pool_.free(bkt);
+      bkt = tmp_next;
+    }
+    wheel_[ws_i].last_ = &wheel_[ws_i];
+  }
+
+  void reset_bkt(wheel_bkt_t *bkt) {
+    bkt->next_ = nullptr;
+    bkt->num_entries_ = 0;
+  }
+
+  const size_t wslot_width_tsc_;
+  wheel_bkt_t *wheel_;
+  size_t cur_wslot_ = 0;
+  MemPool<wheel_bkt_t> bkt_pool_;
+};
+
+}  // namespace legacy
+
+// Dummy registration and deregistration functions
+Transport::mem_reg_info reg_mr_wrapper(void *, size_t) {
+  return Transport::mem_reg_info(0, 0);
+}
+
+void dereg_mr_wrapper(Transport::mem_reg_info) {}
+
+/// Return the entry with ID \p id, which is stored in place of the sslot
+static wheel_ent_t id_ent(size_t id) {
+  return wheel_ent_t(reinterpret_cast<SSlot *>(id), 0);
+}
+
+/// Measure the cycles per insert and per reaped entry with a synthetic clock,
+/// with entries spread randomly over kCostMaxDelayUs
+template <class TWheel>
+void bench_cost(const char *name, TWheel &wheel, double freq_ghz) {
+  const size_t max_delay_tsc = us_to_cycles(kCostMaxDelayUs, freq_ghz);
+  const size_t step_tsc = us_to_cycles(kWheelSlotWidthUs, freq_ghz);
+  FastRand fast_rand;
+
+  size_t now = rdtsc();
+  size_t insert_cycles = 0, reap_cycles = 0, num_reaped = 0;
+
+  for (size_t i = 0; i < kCostIters; i += kCostBatch) {
+    size_t start = rdtsc();
+    for (size_t j = 0; j < kCostBatch; j++) {
+      const size_t delay = fast_rand.next_u32() % max_delay_tsc;
+      wheel.insert(id_ent(i + j), now, now + delay);
+    }
+    insert_cycles += rdtsc() - start;
+
+    now += step_tsc;
+    start = rdtsc();
+    wheel.reap(now);
+    while (!wheel.ready_queue_.empty()) {
+      wheel.ready_queue_.pop();
+      num_reaped++;
+    }
+    reap_cycles += rdtsc() - start;
+  }
+
+  printf("%s: %.1f ns/insert, %.1f ns/reaped entry\n", name,
+         insert_cycles / (freq_ghz * kCostIters),
+         num_reaped == 0 ? 0.0 : reap_cycles / (freq_ghz * num_reaped));
+}
+
+/// Pace one session at \p gbps in real time, and measure how late packets
+/// leave the wheel and the achieved rate
+template <class TWheel>
+void bench_pacing(const char *name, TWheel &wheel, double freq_ghz,
+                  double gbps) {
+  const double rate = gbps * 1000 * 1000 * 1000 / 8;
+  const size_t cycles_per_pkt =
+      erpc::ceil(freq_ghz * 1000000000 * (kTestPktSize / rate));
+
+  std::vector<size_t> desired_tsc(kPacingPkts);
+  std::vector<double> lateness_ns;
+  lateness_ns.reserve(kPacingPkts);
+
+  wheel.catchup();
+  const size_t start_tsc = rdtsc();
+  size_t abs_tx_tsc = start_tsc;
+  size_t num_inserted = 0, num_reaped = 0;
+
+  auto send_window = [&](size_t num_pkts) {
+    size_t ref_tsc = rdtsc();
+    for (size_t i = 0; i < num_pkts && num_inserted < kPacingPkts; i++) {
+      abs_tx_tsc = (std::max)(ref_tsc, abs_tx_tsc + cycles_per_pkt);
+      desired_tsc[num_inserted] = abs_tx_tsc;
+      wheel.insert(id_ent(num_inserted), ref_tsc, abs_tx_tsc);
+      num_inserted++;
+    }
+  };
+
+  send_window(kSessionCredits);
+  while (num_reaped < kPacingPkts) {
+    const size_t cur_tsc = rdtsc();
+    wheel.reap(cur_tsc);
+
+    size_t num_ready = 0;
+    while (!wheel.ready_queue_.empty()) {
+      const size_t id = wheel.ready_queue_.front().sslot_;
+      lateness_ns.push_back(to_nsec(cur_tsc - desired_tsc[id], freq_ghz));
+      wheel.ready_queue_.pop();
+      num_ready++;
+    }
+
+    num_reaped += num_ready;
+    if (num_ready > 0) send_window(num_ready);
+  }
+
+  const double seconds = to_sec(rdtsc() - start_tsc, freq_ghz);
+  std::sort(lateness_ns.begin(), lateness_ns.end());
+  printf("%s: %.1f Gbps target, %.2f Gbps achieved, lateness median %.0f ns, "
+         "99th %.0f ns\n",
+         name, gbps, kPacingPkts * kTestPktSize * 8 / (seconds * 1000000000),
+         lateness_ns[lateness_ns.size() / 2],
+         lateness_ns[lateness_ns.size() * 99 / 100]);
+}
+
+int main() {
+  using namespace std::placeholders;
+  auto reg_mr_func = std::bind(reg_mr_wrapper, _1, _2);
+  auto dereg_mr_func = std::bind(dereg_mr_wrapper, _1);
+  const double freq_ghz = measure_rdtsc_freq();
+
+  {
+    HugeAlloc alloc(MB(2), 0, reg_mr_func, dereg_mr_func);
+    timing_wheel_args_t args{freq_ghz, &alloc};
+    legacy::TimingWheel legacy_wheel(args);
+    auto *wheel = new TimingWheel(args);
+
+    bench_cost("single-level", legacy_wheel, freq_ghz);
+    bench_cost("hierarchical", *wheel, freq_ghz);
+    delete wheel;
+  }
+
+  for (double gbps : {1.0, 10.0, 40.0}) {
+    HugeAlloc alloc(MB(2), 0, reg_mr_func, dereg_mr_func);
+    timing_wheel_args_t args{freq_ghz, &alloc};
+    legacy::TimingWheel legacy_wheel(args);
+    auto *wheel = new TimingWheel(args);
+
+    bench_pacing("single-level", legacy_wheel, freq_ghz, gbps);
+    bench_pacing("hierarchical", *wheel, freq_ghz, gbps);
+    delete wheel;
+  }
+}
@@ -61,6 +61,63 @@ TEST_F(TimingWheelTest, Basic) {
   ASSERT_EQ(wheel_->ready_queue_.size(), 1);
 }
 
+// Entries reaped together leave the ready queue in priority order
+TEST_F(TimingWheelTest, ReadyQueuePriority) {
+  auto *sslot = reinterpret_cast<SSlot *>(0xdeadbeef);
+  size_t ref_tsc = rdtsc();
+  size_t abs_tx_tsc = ref_tsc + wheel_->wslot_width_tsc_;
+  wheel_->insert(wheel_ent_t(sslot, 1, kPriorityLow), ref_tsc, abs_tx_tsc);
+  wheel_->insert(wheel_ent_t(sslot, 2, kPriorityNormal), ref_tsc, abs_tx_tsc);
+  wheel_->insert(wheel_ent_t(sslot, 3, kPriorityHigh), ref_tsc, abs_tx_tsc);
+  wheel_->insert(wheel_ent_t(sslot, 4, kPriorityHigh), ref_tsc, abs_tx_tsc);
+
+  wheel_->reap(abs_tx_tsc + wheel_->wslot_width_tsc_);
+  ASSERT_EQ(wheel_->ready_queue_.size(), 4);
+  for (size_t pkt_num : {3ul, 4ul, 2ul, 1ul}) {
+    ASSERT_EQ(wheel_->ready_queue_.front().pkt_num_, pkt_num);
+    wheel_->ready_queue_.pop();
+  }
+  ASSERT_TRUE(wheel_->ready_queue_.empty());
+}
+
+// Entries beyond level 0 are reaped at level-0 resolution, and entries of one
+// wheel slot leave in insertion order even if they were inserted at different
+// levels
+TEST_F(TimingWheelTest, MultiLevel) {
+  auto *sslot = reinterpret_cast<SSlot *>(0xdeadbeef);
+  const size_t wslot_width_tsc = wheel_->wslot_width_tsc_;
+  const size_t ref_tsc = rdtsc();
+  wheel_->reap(ref_tsc);
+
+  // Ten level-0 windows in the future, i.e., in level 1
+  const size_t far_tsc = ref_tsc + 10 * kWheelLevelSlots * wslot_width_tsc;
+  wheel_->insert(wheel_ent_t(sslot, 1), ref_tsc, far_tsc);
+  ASSERT_EQ(wheel_->level_entries_[1], 1);
+
+  // Insert another entry for the same wheel slot just before it's due
+  const size_t near_tsc = far_tsc - 2 * wslot_width_tsc;
+  wheel_->insert(wheel_ent_t(sslot, 2), near_tsc, far_tsc);
+  ASSERT_EQ(wheel_->get_num_wslot_entries(), 2);
+  ASSERT_EQ(wheel_->ready_queue_.size(), 0);
+
+  wheel_->reap(far_tsc + wslot_width_tsc);
+  ASSERT_EQ(wheel_->ready_queue_.size(), 2);
+  for (size_t pkt_num : {1ul, 2ul}) {
+    ASSERT_EQ(wheel_->ready_queue_.front().pkt_num_, pkt_num);
+    wheel_->ready_queue_.pop();
+  }
+
+  // An entry an hour away is reaped in one pass
+  const size_t hour_tsc = far_tsc + us_to_cycles(3600.0 * 1000000, freq_ghz_);
+  wheel_->insert(wheel_ent_t(sslot, 3), far_tsc, hour_tsc);
+  ASSERT_EQ(wheel_->get_num_wslot_entries(), 1);
+  wheel_->reap(hour_tsc - wslot_width_tsc);
+  ASSERT_EQ(wheel_->ready_queue_.size(), 0);
+  wheel_->reap(hour_tsc + wslot_width_tsc);
+  ASSERT_EQ(wheel_->ready_queue_.size(), 1);
+  ASSERT_EQ(wheel_->get_num_wslot_entries(), 0);
+}
+
 // This is not a fixture test because we use a different wheel for each rate
 TEST(TimingWheelRateTest, RateTest) {
   const std::vector<double> target_gbps = {1.0, 5.0, 10.0, 20.0, 40.0, 80.0};